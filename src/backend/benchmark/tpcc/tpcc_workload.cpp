@@ -288,6 +288,21 @@ bool RunNewOrder(){
   // BEGIN TRANSACTION
   /////////////////////////////////////////////////////////
   auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+  // the tables are partitioned on the warehouse, remote order lines make
+  // the txn span several partitions
+  if (concurrency::TransactionManagerFactory::GetProtocol() ==
+      CONCURRENCY_TYPE_PARTITION) {
+    auto &partition_txn_manager =
+        concurrency::PartitionTxnManager::GetInstance();
+    partition_txn_manager.DeclarePartition(
+        concurrency::PartitionTxnManager::GetPartition(warehouse_id));
+    for (auto ol_w_id : ol_w_ids) {
+      partition_txn_manager.DeclarePartition(
+          concurrency::PartitionTxnManager::GetPartition(ol_w_id));
+    }
+  }
+
   auto txn = txn_manager.BeginTransaction();
 
   std::unique_ptr<executor::ExecutorContext> context(
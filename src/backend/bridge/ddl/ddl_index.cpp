@@ -21,9 +21,11 @@
 #include "backend/common/logger.h"
 #include "backend/common/macros.h"
 #include "backend/index/index.h"
+#include "backend/index/index_builder.h"
 #include "backend/index/index_factory.h"
 #include "backend/storage/data_table.h"
 #include "backend/storage/database.h"
+#include "backend/storage/tile_group_header.h"
 
 #include "nodes/pg_list.h"
 #include "postgres.h"
@@ -140,6 +142,17 @@ bool DDLIndex::CreateIndex(IndexInfo index_info) {
       key_schema, unique_keys);
   index::Index *index = index::IndexFactory::GetInstance(metadata);
 
+  // Load the tuples already in the table, indexing the latest committed
+  // version of each of them
+  index::IndexBuilder::Build(
+      data_table, {index},
+      [](const storage::TileGroupHeader *tile_group_header, oid_t tuple_id) {
+        return tile_group_header->GetTransactionId(tuple_id) !=
+                   INVALID_TXN_ID &&
+               tile_group_header->GetBeginCommitId(tuple_id) != MAX_CID &&
+               tile_group_header->GetEndCommitId(tuple_id) == MAX_CID;
+      });
+
   // Record the built index in the table
   data_table->AddIndex(index);
 
@@ -44,6 +44,8 @@ executor::AbstractExecutor *BuildExecutorTree(
 
 void CleanExecutorTree(executor::AbstractExecutor *root);
 
+bool IsReadOnlyPlan(const planner::AbstractPlan *plan);
+
 /**
  * @brief Build a executor tree and execute it.
  * Use std::vector<Value> as params to make it more elegant for networking
@@ -70,7 +72,11 @@ peloton_status PlanExecutor::ExecutePlan(const planner::AbstractPlan *plan,
   // This happens for single statement queries in PG
   if (txn == nullptr) {
     single_statement_txn = true;
-    txn = txn_manager.BeginTransaction();
+    if (IsReadOnlyPlan(plan)) {
+      txn = txn_manager.BeginReadOnlyTransaction();
+    } else {
+      txn = txn_manager.BeginTransaction();
+    }
   }
   PL_ASSERT(txn);
 
@@ -188,7 +194,11 @@ int PlanExecutor::ExecutePlan(const planner::AbstractPlan *plan,
   // This happens for single statement queries in PG
   if (txn == nullptr) {
     single_statement_txn = true;
-    txn = txn_manager.BeginTransaction();
+    if (IsReadOnlyPlan(plan)) {
+      txn = txn_manager.BeginReadOnlyTransaction();
+    } else {
+      txn = txn_manager.BeginTransaction();
+    }
   }
   PL_ASSERT(txn);
 
@@ -286,6 +296,31 @@ void PlanExecutor::PrintPlan(const planner::AbstractPlan *plan,
   }
 }
 
+/**
+ * @brief Check whether a plan tree only reads.
+ * @param The plan tree
+ * @return true if no node of the tree modifies a table.
+ */
+bool IsReadOnlyPlan(const planner::AbstractPlan *plan) {
+  if (plan == nullptr) return true;
+
+  switch (plan->GetPlanNodeType()) {
+    case PLAN_NODE_TYPE_INSERT:
+    case PLAN_NODE_TYPE_DELETE:
+    case PLAN_NODE_TYPE_UPDATE:
+      return false;
+
+    default:
+      break;
+  }
+
+  for (auto &child : plan->GetChildren()) {
+    if (IsReadOnlyPlan(child.get()) == false) return false;
+  }
+
+  return true;
+}
+
 /**
  * @brief Build Executor Context
  */
@@ -42,6 +42,7 @@ void VarlenPool::Init() {
       storage_manager.Allocate(backend_type, allocation_size));
 
   chunks.push_back(Chunk(allocation_size, storage));
+  chunk_offsets[storage] = 0;
 }
 
 VarlenPool::~VarlenPool() {
@@ -51,8 +52,8 @@ VarlenPool::~VarlenPool() {
     storage_manager.Release(backend_type, chunks[ii].chunk_data);
   }
 
-  for (std::size_t ii = 0; ii < oversize_chunks.size(); ii++) {
-    storage_manager.Release(backend_type, oversize_chunks[ii].chunk_data);
+  for (auto &oversize_chunk : oversize_chunks) {
+    storage_manager.Release(backend_type, oversize_chunk.second.chunk_data);
   }
 }
 
@@ -75,18 +76,21 @@ void *VarlenPool::Allocate(std::size_t size) {
         char *storage = reinterpret_cast<char *>(
             storage_manager.Allocate(backend_type, size));
 
-        oversize_chunks.push_back(Chunk(nexthigher(size), storage));
-        Chunk &newChunk = oversize_chunks.back();
-        newChunk.offset = size;
-        return newChunk.chunk_data;
+        Chunk &new_chunk = oversize_chunks[storage] =
+            Chunk(nexthigher(size), storage);
+        new_chunk.offset = size;
+        new_chunk.allocation_count = 1;
+        return new_chunk.chunk_data;
       }
 
       // Check if there is an already allocated chunk we can use.
-      current_chunk_index++;
+      if (empty_chunk_offsets.empty() == false) {
+        current_chunk_index = empty_chunk_offsets.back();
+        empty_chunk_offsets.pop_back();
 
-      if (current_chunk_index < chunks.size()) {
         current_chunk = &chunks[current_chunk_index];
         current_chunk->offset = size;
+        current_chunk->allocation_count = 1;
         return current_chunk->chunk_data;
       } else {
         // Need to allocate a new chunk
@@ -94,9 +98,12 @@ void *VarlenPool::Allocate(std::size_t size) {
         char *storage = reinterpret_cast<char *>(
             storage_manager.Allocate(backend_type, allocation_size));
 
+        current_chunk_index = chunks.size();
         chunks.push_back(Chunk(allocation_size, storage));
+        chunk_offsets[storage] = current_chunk_index;
         Chunk &new_chunk = chunks.back();
         new_chunk.offset = size;
+        new_chunk.allocation_count = 1;
         return new_chunk.chunk_data;
       }
     }
@@ -105,6 +112,7 @@ void *VarlenPool::Allocate(std::size_t size) {
     // offset counter by the amount being allocated.
     retval = current_chunk->chunk_data + current_chunk->offset;
     current_chunk->offset += size;
+    current_chunk->allocation_count++;
 
     // Ensure 8 byte alignment of future allocations
     current_chunk->offset += (8 - (current_chunk->offset % 8));
@@ -128,10 +136,9 @@ void VarlenPool::Purge() {
     std::lock_guard<std::mutex> pool_lock(pool_mutex);
 
     // Erase any oversize chunks that were allocated
-    const std::size_t numOversizeChunks = oversize_chunks.size();
-    for (std::size_t ii = 0; ii < numOversizeChunks; ii++) {
+    for (auto &oversize_chunk : oversize_chunks) {
       auto &storage_manager = storage::StorageManager::GetInstance();
-      storage_manager.Release(backend_type, oversize_chunks[ii].chunk_data);
+      storage_manager.Release(backend_type, oversize_chunk.second.chunk_data);
     }
     oversize_chunks.clear();
 
@@ -143,23 +150,67 @@ void VarlenPool::Purge() {
     if (num_chunks > max_chunk_count) {
       for (std::size_t ii = max_chunk_count; ii < num_chunks; ii++) {
         auto &storage_manager = storage::StorageManager::GetInstance();
+        chunk_offsets.erase(chunks[ii].chunk_data);
         storage_manager.Release(backend_type, chunks[ii].chunk_data);
       }
       chunks.resize(max_chunk_count);
     }
 
+    // The other chunks are taken in order once the first one is full
     num_chunks = chunks.size();
+    empty_chunk_offsets.clear();
     for (std::size_t ii = 0; ii < num_chunks; ii++) {
       chunks[ii].offset = 0;
+      chunks[ii].allocation_count = 0;
+      if (ii > 0) {
+        empty_chunk_offsets.push_back(num_chunks - ii);
+      }
     }
   }
 }
 
+void VarlenPool::Free(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> pool_lock(pool_mutex);
+  char *location = static_cast<char *>(ptr);
+
+  // An oversize chunk holds a single block
+  auto oversize_itr = oversize_chunks.find(location);
+  if (oversize_itr != oversize_chunks.end()) {
+    auto &storage_manager = storage::StorageManager::GetInstance();
+    storage_manager.Release(backend_type, location);
+    oversize_chunks.erase(oversize_itr);
+    return;
+  }
+
+  auto chunk_itr = chunk_offsets.upper_bound(location);
+  PL_ASSERT(chunk_itr != chunk_offsets.begin());
+  chunk_itr--;
+
+  auto chunk_offset = chunk_itr->second;
+  Chunk &chunk = chunks[chunk_offset];
+  PL_ASSERT(location < chunk.chunk_data + chunk.size);
+  PL_ASSERT(chunk.allocation_count > 0);
+
+  if (--chunk.allocation_count > 0) {
+    return;
+  }
+
+  // Allocations go on from the start of the chunk
+  chunk.offset = 0;
+  if (chunk_offset != current_chunk_index) {
+    empty_chunk_offsets.push_back(chunk_offset);
+  }
+}
+
 int64_t VarlenPool::GetAllocatedMemory() {
   int64_t total = 0;
   total += chunks.size() * allocation_size;
-  for (uint32_t i = 0; i < oversize_chunks.size(); i++) {
-    total += oversize_chunks[i].getSize();
+  for (auto &oversize_chunk : oversize_chunks) {
+    total += oversize_chunk.second.getSize();
   }
   return total;
 }
@@ -13,6 +13,8 @@
 #pragma once
 
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <iostream>
 #include <stdint.h>
 #include <errno.h>
@@ -30,15 +32,22 @@ namespace peloton {
 
 class Chunk {
  public:
-  Chunk() : offset(0), size(0), chunk_data(NULL) {}
+  Chunk() : offset(0), size(0), allocation_count(0), chunk_data(NULL) {}
 
   inline Chunk(uint64_t size, void *chunkData)
-      : offset(0), size(size), chunk_data(static_cast<char *>(chunkData)) {}
+      : offset(0),
+        size(size),
+        allocation_count(0),
+        chunk_data(static_cast<char *>(chunkData)) {}
 
   int64_t getSize() const { return static_cast<int64_t>(size); }
 
   uint64_t offset;
   uint64_t size;
+
+  // Blocks allocated from the chunk and not freed yet
+  uint64_t allocation_count;
+
   char *chunk_data;
 };
 
@@ -56,9 +65,10 @@ inline T nexthigher(T k) {
 //===--------------------------------------------------------------------===//
 
 /**
- * A memory pool that provides fast allocation and deallocation. The
- * only way to release memory is to free all memory in the pool by
- * calling purge.
+ * A memory pool that provides fast allocation and deallocation. Memory is
+ * released either all at once by calling purge, or block by block by
+ * calling free. A chunk whose blocks are all freed is reused for the next
+ * allocations, and an oversize chunk is released right away.
  */
 class VarlenPool {
   VarlenPool(const VarlenPool &) = delete;
@@ -83,6 +93,9 @@ class VarlenPool {
   // initialized to 0s
   void *AllocateZeroes(std::size_t size);
 
+  // Free a block returned by Allocate
+  void Free(void *ptr);
+
   void Purge();
 
   int64_t GetAllocatedMemory();
@@ -96,8 +109,14 @@ class VarlenPool {
   std::size_t current_chunk_index;
   std::vector<Chunk> chunks;
 
-  // Oversize chunks that will be freed and not reused.
-  std::vector<Chunk> oversize_chunks;
+  // Chunks by their address, so freed blocks find their chunk
+  std::map<char *, std::size_t> chunk_offsets;
+
+  // Chunks that are not in use, to take before allocating new ones
+  std::vector<std::size_t> empty_chunk_offsets;
+
+  // Oversize chunks that will be freed and not reused, by their address
+  std::unordered_map<char *, Chunk> oversize_chunks;
 
   std::mutex pool_mutex;
 };
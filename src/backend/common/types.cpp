@@ -700,6 +700,12 @@ std::string IndexTypeToString(IndexType type) {
     case INDEX_TYPE_HASH: {
       return "HASH";
     }
+    case INDEX_TYPE_OLCBTREE: {
+      return "OLCBTREE";
+    }
+    case INDEX_TYPE_ART: {
+      return "ART";
+    }
   }
   return "INVALID";
 }
@@ -711,6 +717,12 @@ IndexType StringToIndexType(std::string str) {
     return INDEX_TYPE_BTREE;
   } else if (str == "BWTREE") {
     return INDEX_TYPE_BWTREE;
+  } else if (str == "HASH") {
+    return INDEX_TYPE_HASH;
+  } else if (str == "OLCBTREE") {
+    return INDEX_TYPE_OLCBTREE;
+  } else if (str == "ART") {
+    return INDEX_TYPE_ART;
   }
   return INDEX_TYPE_INVALID;
 }
@@ -59,7 +59,8 @@ enum CheckpointType {
 
 enum GCType {
   GC_TYPE_OFF = 0,
-  GC_TYPE_ON = 1
+  GC_TYPE_ON = 1,
+  GC_TYPE_COOPERATIVE = 2  // workers reclaim their own garbage
 };
 
 //===--------------------------------------------------------------------===//
@@ -382,7 +383,8 @@ enum ConcurrencyType {
   CONCURRENCY_TYPE_EAGER_WRITE = 3,       // pessimistic + eager write
   CONCURRENCY_TYPE_TO = 4,                // timestamp ordering
   CONCURRENCY_TYPE_SSI = 5,               // serializable snapshot isolation
-  CONCURRENCY_TYPE_OCC_RB = 6             // optimistic + rollback segment
+  CONCURRENCY_TYPE_OCC_RB = 6,            // optimistic + rollback segment
+  CONCURRENCY_TYPE_PARTITION = 7          // serial txns per partition
 };
 
 enum IsolationLevelType {
@@ -391,6 +393,14 @@ enum IsolationLevelType {
   ISOLATION_LEVEL_TYPE_REPEATABLE_READ = 2  // repeatable read
 };
 
+// How pessimistic txns deal with locks held by other txns
+enum DeadlockHandlingType {
+  DEADLOCK_HANDLING_TYPE_NO_WAIT = 0,    // abort instead of waiting
+  DEADLOCK_HANDLING_TYPE_DETECTION = 1,  // wait, break waits-for cycles
+  DEADLOCK_HANDLING_TYPE_WAIT_DIE = 2,   // older txns wait, younger ones die
+  DEADLOCK_HANDLING_TYPE_WOUND_WAIT = 3  // older txns wound, younger ones wait
+};
+
 enum BackendType {
   BACKEND_TYPE_INVALID = 0,  // invalid backend type
 
@@ -405,11 +415,13 @@ enum BackendType {
 //===--------------------------------------------------------------------===//
 
 enum IndexType {
-  INDEX_TYPE_INVALID = 0,  // invalid index type
+  INDEX_TYPE_INVALID = 0,   // invalid index type
 
-  INDEX_TYPE_BTREE = 1,   // btree
-  INDEX_TYPE_BWTREE = 2,  // bwtree
-  INDEX_TYPE_HASH = 3     // hash
+  INDEX_TYPE_BTREE = 1,     // btree
+  INDEX_TYPE_BWTREE = 2,    // bwtree
+  INDEX_TYPE_HASH = 3,      // hash
+  INDEX_TYPE_OLCBTREE = 4,  // optimistic lock coupling btree
+  INDEX_TYPE_ART = 5        // adaptive radix tree
 };
 
 enum IndexConstraintType {
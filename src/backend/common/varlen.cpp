@@ -38,6 +38,14 @@ Varlen *Varlen::Clone(const Varlen &src, VarlenPool *data_pool) {
   return rv;
 }
 
+void Varlen::Destroy(Varlen *varlen, VarlenPool *data_pool) {
+  PL_ASSERT(varlen->varlen_temp_pool == false);
+
+  data_pool->Free(varlen->varlen_string_ptr);
+  varlen->~Varlen();
+  data_pool->Free(varlen);
+}
+
 // Construct varlen in heap
 Varlen::Varlen(size_t size) {
   varlen_size = size + sizeof(Varlen *);
@@ -52,6 +52,15 @@ class Varlen {
    */
   static Varlen *Clone(const Varlen &src, VarlenPool *data_pool = NULL);
 
+  /// Free the memory of a Varlen created in the given pool, including the
+  /// memory of the Varlen object itself, back to the pool.
+  static void Destroy(Varlen *varlen, VarlenPool *data_pool);
+
+  /// Bytes taken up by the Varlen in its pool
+  std::size_t GetAllocatedSize() const {
+    return varlen_size + sizeof(Varlen);
+  }
+
   char *Get();
   const char *Get() const;
 
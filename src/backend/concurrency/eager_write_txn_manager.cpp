@@ -97,18 +97,18 @@ void EagerWriteTxnManager::RemoveReader() {
   auto &rw_set = txn->GetRWSet();
 
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     if (tile_group == nullptr) continue;
 
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
 
       // we don't have reader lock on insert
-      if (tuple_entry.second == RW_TYPE_INSERT ||
-          tuple_entry.second == RW_TYPE_INS_DEL) {
+      if (tuple_entry.type == RW_TYPE_INSERT ||
+          tuple_entry.type == RW_TYPE_INS_DEL) {
         continue;
       }
 
@@ -199,6 +199,11 @@ bool EagerWriteTxnManager::AcquireOwnership(
 }
 
 bool EagerWriteTxnManager::PerformRead(const ItemPointer &location) {
+  // snapshot reads need no read set or read locks
+  if (current_txn->IsReadOnlySnapshot()) {
+    return true;
+  }
+
   oid_t tile_group_id = location.block;
   oid_t tuple_id = location.offset;
 
@@ -207,13 +212,9 @@ bool EagerWriteTxnManager::PerformRead(const ItemPointer &location) {
   auto tile_group = manager.GetTileGroup(tile_group_id);
   auto tile_group_header = tile_group->GetHeader();
 
-  auto &rw_set = current_txn->GetRWSet();
-  auto tuple_map = rw_set.find(tile_group_id);
-  if (tuple_map != rw_set.end()) {
-    if (tuple_map->second.find(tuple_id) != tuple_map->second.end()) {
-      // It was already accessed, don't acquire read lock again
-      return true;
-    }
+  if (current_txn->IsAccessed(tile_group_id, tuple_id)) {
+    // It was already accessed, don't acquire read lock again
+    return true;
   }
 
   if (IsOwner(tile_group_header, tuple_id)) {
@@ -386,6 +387,10 @@ void EagerWriteTxnManager::PerformDelete(const ItemPointer &location) {
 Result EagerWriteTxnManager::CommitTransaction() {
   LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
 
+  if (current_txn->IsReadOnlySnapshot()) {
+    return EndReadOnlyTransaction(current_txn->GetResult());
+  }
+
   auto &manager = catalog::Manager::GetInstance();
 
   auto &rw_set = current_txn->GetRWSet();
@@ -405,12 +410,13 @@ Result EagerWriteTxnManager::CommitTransaction() {
   //*****************************************************
 
   // generate transaction id.
-  cid_t end_commit_id = GetNextCommitId();
+  cid_t end_commit_id = BeginCommit();
   current_txn->SetEndCommitId(end_commit_id);
 
   // Check if we cause dead lock
   if (CauseDeadLock()) {
     // Abort
+    EndCommit();
     return AbortTransaction();
   }
 
@@ -431,12 +437,12 @@ Result EagerWriteTxnManager::CommitTransaction() {
 
   // install everything.
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
         // we must guarantee that, at any time point, only one version is
         // visible.
         ItemPointer new_version =
@@ -464,7 +470,7 @@ Result EagerWriteTxnManager::CommitTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
         ItemPointer delete_location(tile_group_id, tuple_slot);
@@ -490,7 +496,7 @@ Result EagerWriteTxnManager::CommitTransaction() {
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         // set the begin commit id to persist insert
         ItemPointer insert_location(tile_group_id, tuple_slot);
         log_manager.LogInsert(end_commit_id, insert_location);
@@ -502,7 +508,7 @@ Result EagerWriteTxnManager::CommitTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
 
@@ -514,6 +520,7 @@ Result EagerWriteTxnManager::CommitTransaction() {
     }
   }
   log_manager.LogCommitTransaction(end_commit_id);
+  EndCommit();
 
   EndTransaction();
 
@@ -522,18 +529,22 @@ Result EagerWriteTxnManager::CommitTransaction() {
 
 Result EagerWriteTxnManager::AbortTransaction() {
   LOG_TRACE("Aborting peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsReadOnlySnapshot()) {
+    return EndReadOnlyTransaction(Result::RESULT_ABORTED);
+  }
   auto &manager = catalog::Manager::GetInstance();
 
   auto &rw_set = current_txn->GetRWSet();
 
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
 
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
         auto new_tile_group_header =
@@ -556,7 +567,7 @@ Result EagerWriteTxnManager::AbortTransaction() {
         // AtomicSetOnlyTxnId(tile_group_header, tuple_slot, INITIAL_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
 
@@ -581,14 +592,14 @@ Result EagerWriteTxnManager::AbortTransaction() {
         // AtomicSetOnlyTxnId(tile_group_header, tuple_slot, INITIAL_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
 
         COMPILER_MEMORY_FENCE;
 
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
 
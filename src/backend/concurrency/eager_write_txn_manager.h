@@ -90,7 +90,7 @@ class EagerWriteTxnManager : public TransactionManager {
   virtual Transaction *BeginTransaction() {
     txn_id_t txn_id = GetNextTransactionId();
     cid_t begin_cid = GetNextCommitId();
-    Transaction *txn = new Transaction(txn_id, begin_cid);
+    Transaction *txn = AllocateTransaction(txn_id, begin_cid);
     current_txn = txn;
 
     EagerWriteTxnContext *txn_ctx = new EagerWriteTxnContext();
@@ -132,7 +132,7 @@ class EagerWriteTxnManager : public TransactionManager {
 
     EpochManagerFactory::GetInstance().ExitEpoch(current_txn->GetEpochId());
 
-    delete current_txn;
+    ReleaseTransaction(current_txn);
     delete current_txn_ctx;
     current_txn = nullptr;
     current_txn_ctx = nullptr;
@@ -11,12 +11,197 @@
 //===----------------------------------------------------------------------===//
 
 
-#include "epoch_manager.h"
+#include "backend/common/exception.h"
+#include "backend/common/logger.h"
+#include "backend/concurrency/epoch_manager.h"
 
 namespace peloton {
 namespace concurrency {
 
-//  volatile cid_t EpochManager::curr_epoch_ = 1;
+#define INVALID_WORKER_ID EPOCH_MAX_WORKER_COUNT
 
+namespace {
+
+// The slot the calling thread holds, given back when the thread exits
+struct WorkerRegistration {
+  EpochManager *manager_ = nullptr;
+  size_t worker_id_ = INVALID_WORKER_ID;
+
+  ~WorkerRegistration() {
+    if (manager_ != nullptr) {
+      manager_->DeregisterWorker();
+    }
+  }
+};
+
+thread_local WorkerRegistration worker_registration;
+
+}  // End anonymous namespace
+
+EpochManager::EpochManager()
+    : slot_high_water_(0),
+      worker_count_(0),
+      retired_max_begin_cid_(0),
+      last_max_begin_cid_(0),
+      max_dead_cid_(0),
+      finish_(false) {
+  ts_thread_ = std::thread(&EpochManager::Start, this);
+}
+
+EpochManager::~EpochManager() {
+  finish_ = true;
+  ts_thread_.join();
+
+  if (worker_registration.manager_ == this) {
+    worker_registration.manager_ = nullptr;
+    worker_registration.worker_id_ = INVALID_WORKER_ID;
+  }
+}
+
+void EpochManager::Reset() {
+  finish_ = true;
+  ts_thread_.join();
+
+  retired_max_begin_cid_ = 0;
+  last_max_begin_cid_ = 0;
+  max_dead_cid_ = 0;
+  auto slot_count = slot_high_water_.load();
+  for (size_t worker_id = 0; worker_id < slot_count; worker_id++) {
+    local_epochs_[worker_id].max_begin_cid_ = 0;
+  }
+
+  finish_ = false;
+  ts_thread_ = std::thread(&EpochManager::Start, this);
+}
+
+size_t EpochManager::RegisterWorker() {
+  if (worker_registration.manager_ == this) {
+    return worker_registration.worker_id_;
+  }
+
+  // A thread holds at most one slot
+  if (worker_registration.manager_ != nullptr) {
+    worker_registration.manager_->DeregisterWorker();
+  }
+
+  for (size_t worker_id = 0; worker_id < EPOCH_MAX_WORKER_COUNT;
+       worker_id++) {
+    bool expected = false;
+    auto &local_epoch = local_epochs_[worker_id];
+    if (local_epoch.in_use_.load() == true ||
+        local_epoch.in_use_.compare_exchange_strong(expected, true) == false) {
+      continue;
+    }
+
+    local_epoch.txn_count_ = 0;
+    local_epoch.begin_cid_ = MAX_CID;
+    local_epoch.commit_cid_ = MAX_CID;
+
+    auto high_water = slot_high_water_.load();
+    while (high_water <= worker_id &&
+           !slot_high_water_.compare_exchange_weak(high_water, worker_id + 1)) {
+    }
+    worker_count_++;
+
+    worker_registration.manager_ = this;
+    worker_registration.worker_id_ = worker_id;
+
+    LOG_TRACE("Registered epoch worker %lu", worker_id);
+    return worker_id;
+  }
+
+  throw TransactionException("Exceeded the maximum number of epoch workers " +
+                             std::to_string(EPOCH_MAX_WORKER_COUNT));
+}
+
+void EpochManager::DeregisterWorker() {
+  if (worker_registration.manager_ != this) {
+    return;
+  }
+
+  auto worker_id = worker_registration.worker_id_;
+  worker_registration.manager_ = nullptr;
+  worker_registration.worker_id_ = INVALID_WORKER_ID;
+
+  ReleaseSlot(worker_id);
+}
+
+size_t EpochManager::GetWorkerId() {
+  if (worker_registration.manager_ == this) {
+    return worker_registration.worker_id_;
+  }
+  return RegisterWorker();
+}
+
+void EpochManager::ReleaseSlot(size_t worker_id) {
+  auto &local_epoch = local_epochs_[worker_id];
+
+  // txns still running on the thread can no longer exit their epoch
+  if (local_epoch.txn_count_ != 0) {
+    LOG_TRACE("Epoch worker %lu leaves with %lu running txns", worker_id,
+              local_epoch.txn_count_);
+    local_epoch.txn_count_ = 0;
+  }
+  local_epoch.begin_cid_ = MAX_CID;
+  local_epoch.commit_cid_ = MAX_CID;
+
+  AtomicMax(retired_max_begin_cid_, local_epoch.max_begin_cid_.load());
+  local_epoch.in_use_ = false;
+  worker_count_--;
+
+  LOG_TRACE("Deregistered epoch worker %lu", worker_id);
+}
+
+void EpochManager::Start() {
+  while (!finish_) {
+    // the max dead cid is recomputed every 40 milliseconds.
+    std::this_thread::sleep_for(std::chrono::milliseconds(EPOCH_LENGTH));
+
+    ComputeMaxDeadTxnCid();
+  }
+}
+
+void EpochManager::WaitForCommitsBelow(cid_t cid) {
+  auto slot_count = slot_high_water_.load();
+  for (size_t worker_id = 0; worker_id < slot_count; worker_id++) {
+    auto &local_epoch = local_epochs_[worker_id];
+    while (local_epoch.commit_cid_.load(std::memory_order_acquire) < cid) {
+      _mm_pause();
+    }
+  }
+}
+
+void EpochManager::ComputeMaxDeadTxnCid() {
+  // Read the retired workers first, so that a worker deregistering during
+  // the scan is seen either here or in its slot
+  cid_t max_begin_cid = retired_max_begin_cid_.load();
+  cid_t min_running_cid = MAX_CID;
+
+  auto slot_count = slot_high_water_.load();
+  for (size_t worker_id = 0; worker_id < slot_count; worker_id++) {
+    auto &local_epoch = local_epochs_[worker_id];
+
+    auto begin_cid = local_epoch.begin_cid_.load();
+    if (begin_cid < min_running_cid) {
+      min_running_cid = begin_cid;
+    }
+
+    auto worker_max_begin_cid = local_epoch.max_begin_cid_.load();
+    if (worker_max_begin_cid > max_begin_cid) {
+      max_begin_cid = worker_max_begin_cid;
+    }
+  }
+
+  // Only cids published by the previous scan are trusted to be dead, a txn
+  // may have taken a larger one without having entered its epoch yet
+  cid_t max_dead_cid = last_max_begin_cid_;
+  if (min_running_cid <= max_dead_cid) {
+    max_dead_cid = (min_running_cid == 0) ? 0 : min_running_cid - 1;
+  }
+  last_max_begin_cid_ = max_begin_cid;
+
+  AtomicMax(max_dead_cid_, max_dead_cid);
+}
+
+}
 }
-}
\ No newline at end of file
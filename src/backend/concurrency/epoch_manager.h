@@ -11,8 +11,8 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
 #include <thread>
-#include <vector>
 
 #include "backend/common/macros.h"
 #include "backend/common/types.h"
@@ -23,212 +23,156 @@ namespace concurrency {
 
 #define EPOCH_LENGTH 40
 
-struct Epoch {
-  std::atomic<int> txn_ref_count_;
-  cid_t max_cid_;
+// Upper bound on the number of concurrently registered worker threads
+#define EPOCH_MAX_WORKER_COUNT 1024
 
-  Epoch() :txn_ref_count_(0), max_cid_(0){}
+//===--------------------------------------------------------------------===//
+// Local epoch of one worker thread
+//===--------------------------------------------------------------------===//
 
-  void Init() {
-    txn_ref_count_ = 0;
-    max_cid_ = 0;
-  }
-};
-
-class EpochManager {
- public:
-  EpochManager()
- : epoch_queue_(epoch_queue_size_), queue_tail_(0), current_epoch_(0), queue_tail_gc(true), max_cid(0), finish_(false) {
-    //ts_thread_.reset(new std::thread(&EpochManager::Start, this));
-    //ts_thread_->detach();
-    ts_thread_ = std::thread(&EpochManager::Start, this);
-  }
-
-  void Reset() {
-    finish_ = true;
-    ts_thread_.join();
-
-    queue_tail_ = 0;
-    current_epoch_ = 0;
-    epoch_queue_[0].Init();
-    queue_tail_gc = true;
-    max_cid = 0;
-
-    finish_ = false;
-    ts_thread_ = std::thread(&EpochManager::Start, this);
-  }
+// Every slot sits on its own cache lines, so a worker entering and exiting
+// epochs only ever writes to memory that no other worker writes to.
+struct LocalEpoch {
+  // Begin cid of the oldest running txn of the worker, MAX_CID when idle
+  std::atomic<cid_t> begin_cid_;
 
-  ~EpochManager() {
-    finish_ = true;
-    ts_thread_.join();
-  }
-
-  //    static uint64_t GetEpoch() {
-  //
-  //      COMPILER_MEMORY_FENCE;
-  //
-  //      uint64_t ret_ts = curr_epoch_;
-  //
-  //      COMPILER_MEMORY_FENCE;
-  //
-  //      return ret_ts;
-  //    }
+  // Largest begin cid the worker has ever entered with
+  std::atomic<cid_t> max_begin_cid_;
 
+  // End cid of the commit the worker is installing, MAX_CID otherwise
+  std::atomic<cid_t> commit_cid_;
 
-  size_t EnterEpoch(cid_t begin_cid) {
-    auto epoch = current_epoch_.load();
+  // Number of running txns of the worker, only touched by its owner
+  size_t txn_count_;
 
-    size_t epoch_idx = epoch % epoch_queue_size_;
-    epoch_queue_[epoch_idx].txn_ref_count_++;
+  std::atomic<bool> in_use_;
 
-    // Set the max cid in the tuple
-    auto max_cid_ptr = &(epoch_queue_[epoch_idx].max_cid_);
-    AtomicMax(max_cid_ptr, begin_cid);
+  CACHE_PADOUT;
 
-    return epoch;
-  }
+  LocalEpoch()
+      : begin_cid_(MAX_CID),
+        max_begin_cid_(0),
+        commit_cid_(MAX_CID),
+        txn_count_(0),
+        in_use_(false) {}
+};
 
-  void ExitEpoch(size_t epoch) {
-    PL_ASSERT(epoch >= queue_tail_);
-    PL_ASSERT(epoch <= current_epoch_);
+//===--------------------------------------------------------------------===//
+// Epoch Manager
+//===--------------------------------------------------------------------===//
+
+/**
+ * Tracks the oldest running transaction without a shared counter.
+ *
+ * Worker threads register for a local epoch slot the first time they begin
+ * a txn and give it back when they exit. A background thread scans the
+ * slots every EPOCH_LENGTH ms and publishes the max dead txn cid: the
+ * largest cid below every running txn that has also been observed one scan
+ * earlier. The one-scan lag covers a txn that got its begin cid but has
+ * not yet published it in its slot.
+ */
+class EpochManager {
+ public:
+  EpochManager();
 
-    auto epoch_idx = epoch % epoch_queue_size_;
+  ~EpochManager();
 
+  void Reset();
 
+  // Enter and exit the local epoch of the calling thread. The returned id
+  // is the slot of the thread and must be passed back on exit, from the
+  // same thread.
+  size_t EnterEpoch(cid_t begin_cid) {
+    auto worker_id = GetWorkerId();
+    auto &local_epoch = local_epochs_[worker_id];
 
-    epoch_queue_[epoch_idx].txn_ref_count_--;
-  }
-  // assume we store epoch_store max_store previously
-  cid_t GetMaxDeadTxnCid() {
-    // TODO:
-    // change to:
-    // increase tail
-    // return max
-    auto tail = queue_tail_.load();
-    auto head = current_epoch_.load();
-    if (head > 0) {
-      head--;
-    }
-    auto res = max_cid;
-
-    auto dead_num = 0;
-    while (tail < head) {
-      auto idx = tail % epoch_queue_size_;
-      // break when meeting running txn
-      if (epoch_queue_[idx].txn_ref_count_ > 0) {
-        break;
-      }
-
-      if(epoch_queue_[idx].max_cid_ > res) {
-        res = epoch_queue_[idx].max_cid_;
-      }
-      tail++;
-      dead_num++;
-    }
-    if (res > max_cid) {
-      AtomicMax(&max_cid, res);
+    // txns of a thread may nest; the oldest one pins the slot
+    if (local_epoch.txn_count_++ == 0) {
+      local_epoch.begin_cid_ = begin_cid;
     }
 
-    if (dead_num > 32) {
-      IncreaseTail();
+    if (begin_cid > local_epoch.max_begin_cid_.load(std::memory_order_relaxed)) {
+      local_epoch.max_begin_cid_.store(begin_cid, std::memory_order_relaxed);
     }
-    return max_cid;
-  }
-
- private:
-  void Start() {
-    while (!finish_) {
-      // the epoch advances every 40 milliseconds.
-      std::this_thread::sleep_for(std::chrono::milliseconds(EPOCH_LENGTH));
-
 
+    return worker_id;
+  }
 
-      auto next_idx = (current_epoch_.load() + 1) % epoch_queue_size_;
-      auto tail_idx = queue_tail_.load() % epoch_queue_size_;
-      if(next_idx  == tail_idx) {
-        // overflow
-        // in this case, just increase tail
-        IncreaseTail();
-        continue;
-      }
-
-      // we have to init it first, then increase current epoch
-      // otherwise may read dirty data
-      epoch_queue_[next_idx].Init();
-      current_epoch_++;
-
+  void ExitEpoch(size_t worker_id) {
+    PL_ASSERT(worker_id < EPOCH_MAX_WORKER_COUNT);
+    auto &local_epoch = local_epochs_[worker_id];
+    PL_ASSERT(local_epoch.txn_count_ > 0);
 
-      IncreaseTail();
+    if (--local_epoch.txn_count_ == 0) {
+      local_epoch.begin_cid_.store(MAX_CID, std::memory_order_release);
     }
   }
 
+  // All txns that began at or before this cid are finished
+  cid_t GetMaxDeadTxnCid() { return max_dead_cid_.load(); }
 
-  void IncreaseTail() {
-    bool expect = true, desired = false;
-    if(!queue_tail_gc.compare_exchange_weak(expect, desired)){
-      // someone now is increasing tail
-      return;
-    }
+  // Announce that the worker installs the versions of a commit with the
+  // given end cid, or a lower bound of it until the cid is known
+  void EnterCommit(size_t worker_id, cid_t commit_cid) {
+    PL_ASSERT(worker_id < EPOCH_MAX_WORKER_COUNT);
+    local_epochs_[worker_id].commit_cid_.store(commit_cid);
+  }
 
-    auto current = current_epoch_.load();
-    auto tail = queue_tail_.load();
+  void ExitCommit(size_t worker_id) {
+    PL_ASSERT(worker_id < EPOCH_MAX_WORKER_COUNT);
+    local_epochs_[worker_id].commit_cid_.store(MAX_CID,
+                                               std::memory_order_release);
+  }
 
-    while(true) {
-      if(tail + 1 == current) {
-        break;
-      }
+  // Wait until no worker installs a commit with an end cid below the given
+  // one. Commits announce themselves before taking their end cid, so every
+  // commit that took a lower cid is waited for.
+  void WaitForCommitsBelow(cid_t cid);
 
-      auto idx = tail % epoch_queue_size_;
+  // Explicitly (de)register the calling thread. Threads are otherwise
+  // registered on their first EnterEpoch and deregistered when they exit.
+  size_t RegisterWorker();
 
-      // inc tail until we find an epoch that has running txn
-      if(epoch_queue_[idx].txn_ref_count_ > 0) {
-        break;
-      }
+  void DeregisterWorker();
 
-      // save max cid
-      auto max = epoch_queue_[idx].max_cid_;
-      AtomicMax(&max_cid, max);
-      tail++;
-    }
+  size_t GetWorkerCount() const { return worker_count_.load(); }
 
-    queue_tail_ = tail;
+ private:
+  size_t GetWorkerId();
 
-    expect = false;
-    desired = true;
+  void ReleaseSlot(size_t worker_id);
 
-    queue_tail_gc.compare_exchange_weak(expect, desired);
-    return;
-  }
+  void Start();
 
+  void ComputeMaxDeadTxnCid();
 
-  void AtomicMax(cid_t* addr, cid_t max) {
-    while(true) {
-      auto old = *addr;
-      if(old > max) {
-        return;
-      }else if ( __sync_bool_compare_and_swap(addr, old, max) ) {
-        return;
-      }
+  static void AtomicMax(std::atomic<cid_t> &addr, cid_t max) {
+    auto old = addr.load();
+    while (old < max && !addr.compare_exchange_weak(old, max)) {
     }
   }
 
  private:
-  // queue size
-  static const size_t epoch_queue_size_ = 2048;
+  LocalEpoch local_epochs_[EPOCH_MAX_WORKER_COUNT];
+
+  // One past the highest slot ever handed out, bounds the scan
+  std::atomic<size_t> slot_high_water_;
 
+  std::atomic<size_t> worker_count_;
 
-  // Epoch vector
-  std::vector<Epoch> epoch_queue_;
-  std::atomic<size_t> queue_tail_;
-  std::atomic<size_t> current_epoch_;
-  std::atomic<bool> queue_tail_gc;
-  cid_t max_cid;
-  bool finish_;
+  // Largest begin cid of the workers that already deregistered
+  std::atomic<cid_t> retired_max_begin_cid_;
+
+  // Largest begin cid seen by the previous scan
+  cid_t last_max_begin_cid_;
+
+  std::atomic<cid_t> max_dead_cid_;
+
+  std::atomic<bool> finish_;
 
   std::thread ts_thread_;
 };
 
-
 class EpochManagerFactory {
  public:
   static EpochManager &GetInstance() {
@@ -0,0 +1,329 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// lock_manager.cpp
+//
+// Identification: src/backend/concurrency/lock_manager.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>
+#include <unordered_set>
+
+#include "backend/common/logger.h"
+#include "backend/concurrency/lock_manager.h"
+
+namespace peloton {
+namespace concurrency {
+
+namespace {
+
+typedef std::unordered_map<txn_id_t, std::vector<txn_id_t>> WaitsForGraph;
+
+// Depth-first search for cycles from the txn. Every cycle found is broken
+// by choosing its youngest txn as victim, which leaves the graph.
+void FindCycles(const txn_id_t txn_id, const WaitsForGraph &waits_for,
+                const std::unordered_map<txn_id_t, cid_t> &begin_cids,
+                std::unordered_map<txn_id_t, int> &states,
+                std::vector<txn_id_t> &path,
+                std::unordered_set<txn_id_t> &victims) {
+  enum { VISITING = 1, VISITED = 2 };
+
+  states[txn_id] = VISITING;
+  path.push_back(txn_id);
+
+  auto edges = waits_for.find(txn_id);
+  if (edges != waits_for.end()) {
+    for (auto holder_id : edges->second) {
+      if (victims.count(txn_id) != 0) {
+        break;
+      }
+      if (victims.count(holder_id) != 0) {
+        continue;
+      }
+
+      auto state = states.find(holder_id);
+      if (state == states.end()) {
+        FindCycles(holder_id, waits_for, begin_cids, states, path, victims);
+      } else if (state->second == VISITING) {
+        // the cycle is the path from the holder on
+        auto cycle_begin = path.size() - 1;
+        while (path[cycle_begin] != holder_id) {
+          cycle_begin--;
+        }
+
+        txn_id_t victim_id = path[cycle_begin];
+        for (auto itr = cycle_begin; itr < path.size(); itr++) {
+          if (begin_cids.at(path[itr]) > begin_cids.at(victim_id)) {
+            victim_id = path[itr];
+          }
+        }
+        LOG_TRACE("Deadlock detected, abort txn %lu", victim_id);
+        victims.insert(victim_id);
+      }
+    }
+  }
+
+  path.pop_back();
+  states[txn_id] = VISITED;
+}
+
+}  // End anonymous namespace
+
+LockManager::LockManager()
+    : deadlock_handling_(DEADLOCK_HANDLING_TYPE_NO_WAIT),
+      detector_stopped_(true) {}
+
+LockManager::~LockManager() { StopDetector(); }
+
+LockManager &LockManager::GetInstance() {
+  static LockManager lock_manager;
+  return lock_manager;
+}
+
+void LockManager::Configure(DeadlockHandlingType deadlock_handling) {
+  StopDetector();
+
+  deadlock_handling_ = deadlock_handling;
+  victims_.clear();
+
+  if (deadlock_handling_ == DEADLOCK_HANDLING_TYPE_DETECTION) {
+    StartDetector();
+  }
+}
+
+bool LockManager::IsBlockedBy(const LockQueue &queue,
+                              const size_t request_offset,
+                              const size_t blocker_offset) {
+  auto &request = queue.requests[request_offset];
+  auto &blocker = queue.requests[blocker_offset];
+
+  // granted locks and the requests that queued up first go ahead
+  if (blocker.txn_id == request.txn_id ||
+      (blocker.granted == false && blocker_offset > request_offset)) {
+    return false;
+  }
+  return IsCompatible(request.mode, blocker.mode) == false;
+}
+
+bool LockManager::IsGrantable(const LockQueue &queue,
+                              const size_t request_offset) {
+  for (size_t blocker_offset = 0; blocker_offset < queue.requests.size();
+       blocker_offset++) {
+    if (IsBlockedBy(queue, request_offset, blocker_offset)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LockManager::Lock(const txn_id_t txn_id, const cid_t begin_cid,
+                       const ItemPointer &location, const LockMode mode) {
+  if (IsVictim(txn_id)) {
+    return false;
+  }
+
+  auto key = GetKey(location);
+  auto &partition = GetPartition(key);
+  std::unique_lock<std::mutex> latch(partition.mutex_);
+
+  // the queue stays in place while the txn has a request in it
+  auto &queue = partition.queues_[key];
+  auto &requests = queue.requests;
+
+  size_t first_waiting_offset = requests.size();
+  bool upgrade = false;
+  for (size_t offset = 0; offset < requests.size(); offset++) {
+    if (requests[offset].granted == false) {
+      if (first_waiting_offset == requests.size()) {
+        first_waiting_offset = offset;
+      }
+      continue;
+    }
+    if (requests[offset].txn_id == txn_id) {
+      // the held lock covers the request
+      if (requests[offset].mode == LOCK_MODE_EXCLUSIVE ||
+          mode == LOCK_MODE_SHARED) {
+        return true;
+      }
+      upgrade = true;
+    }
+  }
+
+  // an upgrade goes ahead of the other waiters
+  LockRequest request = {txn_id, begin_cid, mode, false};
+  if (upgrade) {
+    requests.insert(requests.begin() + first_waiting_offset, request);
+  } else {
+    requests.push_back(request);
+  }
+
+  for (;;) {
+    size_t request_offset = 0;
+    while (requests[request_offset].txn_id != txn_id ||
+           requests[request_offset].granted == true) {
+      request_offset++;
+    }
+
+    if (IsGrantable(queue, request_offset)) {
+      requests[request_offset].granted = true;
+
+      // the exclusive lock replaces the shared one
+      if (upgrade) {
+        for (auto itr = requests.begin(); itr != requests.end(); itr++) {
+          if (itr->txn_id == txn_id && itr->mode == LOCK_MODE_SHARED) {
+            requests.erase(itr);
+            break;
+          }
+        }
+      }
+      return true;
+    }
+
+    bool should_abort = IsVictim(txn_id);
+    for (size_t blocker_offset = 0;
+         should_abort == false && blocker_offset < requests.size();
+         blocker_offset++) {
+      if (IsBlockedBy(queue, request_offset, blocker_offset) == false) {
+        continue;
+      }
+      auto &blocker = requests[blocker_offset];
+
+      switch (deadlock_handling_) {
+        case DEADLOCK_HANDLING_TYPE_NO_WAIT:
+          should_abort = true;
+          break;
+
+        case DEADLOCK_HANDLING_TYPE_WAIT_DIE:
+          // a younger txn does not wait for an older one
+          should_abort = (blocker.begin_cid < begin_cid);
+          break;
+
+        case DEADLOCK_HANDLING_TYPE_WOUND_WAIT:
+          // an older txn aborts the younger ones in its way
+          if (blocker.begin_cid > begin_cid) {
+            LOG_TRACE("Txn %lu wounds txn %lu", txn_id, blocker.txn_id);
+            SetVictim(blocker.txn_id);
+          }
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    if (should_abort) {
+      LOG_TRACE("Txn %lu gives up its lock request", txn_id);
+      requests.erase(requests.begin() + request_offset);
+      if (requests.empty()) {
+        partition.queues_.erase(key);
+      }
+
+      // the waiters behind the request may go ahead now
+      partition.cv_.notify_all();
+      return false;
+    }
+
+    partition.cv_.wait_for(
+        latch, std::chrono::microseconds(LOCK_WAIT_POLL_INTERVAL));
+  }
+}
+
+void LockManager::Unlock(const txn_id_t txn_id, const ItemPointer &location) {
+  auto key = GetKey(location);
+  auto &partition = GetPartition(key);
+  std::lock_guard<std::mutex> latch(partition.mutex_);
+
+  auto queue = partition.queues_.find(key);
+  if (queue == partition.queues_.end()) {
+    return;
+  }
+
+  auto &requests = queue->second.requests;
+  for (auto itr = requests.begin(); itr != requests.end(); itr++) {
+    if (itr->txn_id == txn_id && itr->granted == true) {
+      requests.erase(itr);
+      break;
+    }
+  }
+
+  if (requests.empty()) {
+    partition.queues_.erase(queue);
+  } else {
+    partition.cv_.notify_all();
+  }
+}
+
+void LockManager::StartDetector() {
+  detector_stopped_ = false;
+  detector_ = std::thread([this] {
+    while (detector_stopped_ == false) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(DEADLOCK_DETECTION_INTERVAL));
+      DetectDeadlocks();
+    }
+  });
+}
+
+void LockManager::StopDetector() {
+  if (detector_stopped_ == false) {
+    detector_stopped_ = true;
+    detector_.join();
+  }
+}
+
+void LockManager::DetectDeadlocks() {
+  WaitsForGraph waits_for;
+  std::unordered_map<txn_id_t, cid_t> begin_cids;
+
+  // The partitions are scanned one at a time, so the graph may hold edges
+  // that are gone by now. A cycle through them costs a needless abort.
+  for (auto &partition : partitions_) {
+    std::lock_guard<std::mutex> latch(partition.mutex_);
+    for (auto &queue_entry : partition.queues_) {
+      auto &queue = queue_entry.second;
+      for (size_t request_offset = 0; request_offset < queue.requests.size();
+           request_offset++) {
+        auto &request = queue.requests[request_offset];
+        if (request.granted == true) {
+          continue;
+        }
+
+        begin_cids[request.txn_id] = request.begin_cid;
+        for (size_t blocker_offset = 0;
+             blocker_offset < queue.requests.size(); blocker_offset++) {
+          if (IsBlockedBy(queue, request_offset, blocker_offset)) {
+            waits_for[request.txn_id].push_back(
+                queue.requests[blocker_offset].txn_id);
+          }
+        }
+      }
+    }
+  }
+
+  std::unordered_map<txn_id_t, int> states;
+  std::vector<txn_id_t> path;
+  std::unordered_set<txn_id_t> victims;
+  for (auto &edges : waits_for) {
+    if (states.count(edges.first) == 0) {
+      FindCycles(edges.first, waits_for, begin_cids, states, path, victims);
+    }
+  }
+
+  if (victims.empty()) {
+    return;
+  }
+
+  for (auto victim_id : victims) {
+    SetVictim(victim_id);
+  }
+  for (auto &partition : partitions_) {
+    partition.cv_.notify_all();
+  }
+}
+
+}  // End concurrency namespace
+}  // End peloton namespace
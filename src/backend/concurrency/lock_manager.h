@@ -0,0 +1,173 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// lock_manager.h
+//
+// Identification: src/backend/concurrency/lock_manager.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "backend/common/macros.h"
+#include "backend/common/types.h"
+#include "libcuckoo/cuckoohash_map.hh"
+
+namespace peloton {
+namespace concurrency {
+
+// Number of partitions of the lock table
+#define LOCK_TABLE_PARTITION_COUNT 256
+
+// A waiting txn wakes up at least this often (in microseconds) to see
+// whether it was chosen as a victim
+#define LOCK_WAIT_POLL_INTERVAL 1000
+
+// The waits-for graph is checked for cycles every this many milliseconds
+#define DEADLOCK_DETECTION_INTERVAL 10
+
+enum LockMode {
+  LOCK_MODE_SHARED,
+  LOCK_MODE_EXCLUSIVE
+};
+
+struct LockRequest {
+  txn_id_t txn_id;
+
+  // begin cid of the txn, a smaller one means an older txn
+  cid_t begin_cid;
+
+  LockMode mode;
+
+  bool granted;
+};
+
+// Requests on one tuple, granted ones first and waiters in arrival order
+struct LockQueue {
+  std::vector<LockRequest> requests;
+};
+
+struct LockPartition {
+  std::mutex mutex_;
+
+  std::condition_variable cv_;
+
+  std::unordered_map<uint64_t, LockQueue> queues_;
+
+  CACHE_PADOUT;
+};
+
+//===--------------------------------------------------------------------===//
+// Lock Manager
+//===--------------------------------------------------------------------===//
+
+/**
+ * Tuple locks with wait queues for pessimistic concurrency control.
+ *
+ * Locks are kept in a table hashed from the tuple location and split into
+ * partitions, each with its own latch. A request that conflicts with the
+ * granted locks queues up behind them; how a txn waits is set by the
+ * deadlock handling type:
+ *
+ *  - NO_WAIT: never wait, the request fails. The pessimistic txn manager
+ *    does not use the lock manager then.
+ *  - DETECTION: wait; a background thread builds the waits-for graph
+ *    and aborts the youngest txn of every cycle.
+ *  - WAIT_DIE: an older txn waits, a younger one fails.
+ *  - WOUND_WAIT: an older txn aborts the younger holders and waits, a
+ *    younger one waits.
+ *
+ * A txn aborted by another one finds out the next time it requests or
+ * waits for a lock.
+ */
+class LockManager {
+  LockManager(LockManager const &) = delete;
+
+ public:
+  LockManager();
+
+  ~LockManager();
+
+  static LockManager &GetInstance();
+
+  void Configure(DeadlockHandlingType deadlock_handling);
+
+  DeadlockHandlingType GetDeadlockHandling() const {
+    return deadlock_handling_;
+  }
+
+  // Lock the tuple for the txn, waiting as long as the deadlock handling
+  // allows. A shared lock the txn holds is upgraded to an exclusive one.
+  // Returns false if the txn must abort.
+  bool Lock(const txn_id_t txn_id, const cid_t begin_cid,
+            const ItemPointer &location, const LockMode mode);
+
+  // Release the lock of the txn on the tuple, if it holds one
+  void Unlock(const txn_id_t txn_id, const ItemPointer &location);
+
+  // Forget that the txn was aborted by another txn, once it finished
+  void EndTransaction(const txn_id_t txn_id) {
+    if (deadlock_handling_ != DEADLOCK_HANDLING_TYPE_NO_WAIT) {
+      victims_.erase(txn_id);
+    }
+  }
+
+  // Whether another txn aborted the txn to break or avoid a deadlock
+  bool IsVictim(const txn_id_t txn_id) const {
+    return victims_.contains(txn_id);
+  }
+
+ private:
+  static uint64_t GetKey(const ItemPointer &location) {
+    return ((uint64_t)location.block << 32) | location.offset;
+  }
+
+  LockPartition &GetPartition(const uint64_t key) {
+    return partitions_[(key * 0x9E3779B97F4A7C15ULL >> 32) %
+                       LOCK_TABLE_PARTITION_COUNT];
+  }
+
+  static bool IsCompatible(const LockMode lhs, const LockMode rhs) {
+    return lhs == LOCK_MODE_SHARED && rhs == LOCK_MODE_SHARED;
+  }
+
+  // Whether the request must wait for the request at the given offset
+  static bool IsBlockedBy(const LockQueue &queue, const size_t request_offset,
+                          const size_t blocker_offset);
+
+  // Whether no request the one at the given offset must wait for is left
+  static bool IsGrantable(const LockQueue &queue, const size_t request_offset);
+
+  void SetVictim(const txn_id_t txn_id) { victims_.insert(txn_id, true); }
+
+  void StartDetector();
+
+  void StopDetector();
+
+  void DetectDeadlocks();
+
+ private:
+  LockPartition partitions_[LOCK_TABLE_PARTITION_COUNT];
+
+  DeadlockHandlingType deadlock_handling_;
+
+  // Txns aborted by other txns, that have not finished yet
+  cuckoohash_map<txn_id_t, bool> victims_;
+
+  std::atomic<bool> detector_stopped_;
+
+  std::thread detector_;
+};
+
+}  // End concurrency namespace
+}  // End peloton namespace
@@ -19,6 +19,7 @@
 #include "backend/catalog/manager.h"
 #include "backend/common/exception.h"
 #include "backend/common/logger.h"
+#include "backend/gc/gc_manager_factory.h"
 #include "backend/storage/tile_group.h"
 #include "backend/storage/rollback_segment.h"
 
@@ -168,6 +169,7 @@ void OptimisticRbTxnManager::PerformUpdateWithRb(const ItemPointer &location, ch
   // First link it to the old roolback segment
   auto old_rb_seg = GetRbSeg(tile_group_header, tuple_id);
   storage::RollbackSegmentPool::SetNextPtr(new_rb_seg, old_rb_seg);
+  storage::RollbackSegmentPool::GetPool(new_rb_seg)->AddReference();
 
   COMPILER_MEMORY_FENCE;
 
@@ -175,6 +177,8 @@ void OptimisticRbTxnManager::PerformUpdateWithRb(const ItemPointer &location, ch
   // Note that since we are holding the write lock, we don't need atomic update here
   SetRbSeg(tile_group_header, tuple_id, new_rb_seg);
 
+  TruncateRollbackSegments(old_rb_seg);
+
   // Add the location to the update set
   current_txn->RecordUpdate(location);
 }
@@ -214,6 +218,7 @@ void OptimisticRbTxnManager::RollbackTuple(std::shared_ptr<storage::TileGroup> t
 
   auto rb_seg = GetRbSeg(tile_group_header, tuple_id);
   // Follow the RB chain, rollback if needed, stop when first unreadable RB
+  auto head_rb_seg = rb_seg;
   while (IsRBVisible(rb_seg, txn_begin_cid) == true) {
 
     // Copy the content of the rollback segment onto the tuple
@@ -227,6 +232,41 @@ void OptimisticRbTxnManager::RollbackTuple(std::shared_ptr<storage::TileGroup> t
 
   // Set the tile group header's rollback segment header to next rollback segment
   SetRbSeg(tile_group_header, tuple_id, rb_seg);
+
+  // The segments rolled back are unlinked now
+  while (head_rb_seg != rb_seg) {
+    auto next_rb_seg = storage::RollbackSegmentPool::GetNextPtr(head_rb_seg);
+    ReleaseSegmentPool(storage::RollbackSegmentPool::GetPool(head_rb_seg));
+    head_rb_seg = next_rb_seg;
+  }
+}
+
+void OptimisticRbTxnManager::ReleaseSegmentPool(
+    storage::RollbackSegmentPool *segment_pool) {
+  if (segment_pool->ReleaseReference() == true) {
+    gc::GCManagerFactory::GetInstance().RetireSegmentPool(segment_pool);
+  }
+}
+
+void OptimisticRbTxnManager::TruncateRollbackSegments(RBSegType rb_seg) {
+  // Every running txn began after the max dead cid
+  auto max_cid = GetMaxCommittedCid();
+  while (rb_seg != nullptr &&
+         storage::RollbackSegmentPool::GetTimeStamp(rb_seg) > max_cid) {
+    rb_seg = storage::RollbackSegmentPool::GetNextPtr(rb_seg);
+  }
+  if (rb_seg == nullptr) {
+    return;
+  }
+
+  auto garbage_rb_seg = storage::RollbackSegmentPool::GetNextPtr(rb_seg);
+  storage::RollbackSegmentPool::SetNextPtr(rb_seg, nullptr);
+
+  while (garbage_rb_seg != nullptr) {
+    auto next_rb_seg = storage::RollbackSegmentPool::GetNextPtr(garbage_rb_seg);
+    ReleaseSegmentPool(storage::RollbackSegmentPool::GetPool(garbage_rb_seg));
+    garbage_rb_seg = next_rb_seg;
+  }
 }
 
 void OptimisticRbTxnManager::InstallRollbackSegments(storage::TileGroupHeader *tile_group_header,
@@ -285,39 +325,40 @@ Result OptimisticRbTxnManager::CommitTransaction() {
   // we can optimize read-only transaction.
   if (current_txn->IsReadOnly() == true) {
     // validate read set.
+    cid_t begin_cid = current_txn->GetBeginCommitId();
     for (auto &tile_group_entry : rw_set) {
-      oid_t tile_group_id = tile_group_entry.first;
+      oid_t tile_group_id = tile_group_entry.GetTileGroupId();
       auto tile_group = manager.GetTileGroup(tile_group_id);
       auto tile_group_header = tile_group->GetHeader();
-      for (auto &tuple_entry : tile_group_entry.second) {
-        auto tuple_slot = tuple_entry.first;
-        // if this tuple is not newly inserted.
-        if (tuple_entry.second == RW_TYPE_READ) {
-          // No one should be writting, I can still read it and the begin commit
-          // id still fall before the end commit id of the tuple
-          //
-          // To give an example why tile_group_header->GetEndCommitId(tuple_slot) >=
-          //    current_txn->GetBeginCommitId() is needed
-          //
-          // T0 begin at 1, delete a tuple, then get end commit 2, but not commit yet
-          // T1 begin at 3, read the same tuple, it should read the master version
-          // T0 now commit, master version has been changed to be visible for (0, 2)
-          // Now the master version is no longer visible for T0.
-          if (tile_group_header->GetTransactionId(tuple_slot) == INITIAL_TXN_ID &&
-              GetActivatedEvidence(tile_group_header, tuple_slot) != nullptr &&
-              tile_group_header->GetEndCommitId(tuple_slot) >=
-              current_txn->GetBeginCommitId()) {
-            // the version is not owned by other txns and is still visible.
-            continue;
-          }
-          LOG_TRACE("Abort in read only txn");
-          // otherwise, validation fails. abort transaction.
-          return AbortTransaction();
-        } else {
-          // It must be a deleted
-          PL_ASSERT(tuple_entry.second == RW_TYPE_INS_DEL);
-          PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) == INVALID_TXN_ID);
-        }
+      bool valid = ValidateTileGroupAccess(
+          tile_group_header, tile_group_entry,
+          [this, tile_group_header, begin_cid](const RWSetEntry &tuple_entry) {
+            auto tuple_slot = tuple_entry.tuple_id;
+            // if this tuple is not newly inserted.
+            if (tuple_entry.type != RW_TYPE_READ) {
+              // It must be a deleted
+              PL_ASSERT(tuple_entry.type == RW_TYPE_INS_DEL);
+              PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) == INVALID_TXN_ID);
+              return true;
+            }
+            // No one should be writting, I can still read it and the begin commit
+            // id still fall before the end commit id of the tuple
+            //
+            // To give an example why tile_group_header->GetEndCommitId(tuple_slot) >=
+            //    current_txn->GetBeginCommitId() is needed
+            //
+            // T0 begin at 1, delete a tuple, then get end commit 2, but not commit yet
+            // T1 begin at 3, read the same tuple, it should read the master version
+            // T0 now commit, master version has been changed to be visible for (0, 2)
+            // Now the master version is no longer visible for T0.
+            return tile_group_header->GetTransactionId(tuple_slot) == INITIAL_TXN_ID &&
+                   GetActivatedEvidence(tile_group_header, tuple_slot) != nullptr &&
+                   tile_group_header->GetEndCommitId(tuple_slot) >= begin_cid;
+          });
+      if (valid == false) {
+        LOG_TRACE("Abort in read only txn");
+        // otherwise, validation fails. abort transaction.
+        return AbortTransaction();
       }
     }
 
@@ -331,28 +372,35 @@ Result OptimisticRbTxnManager::CommitTransaction() {
 
   // validate read set.
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      // if this tuple is not newly inserted. Meaning this is either read,
-      // update or deleted.
-      if (tuple_entry.second != RW_TYPE_INSERT &&
-          tuple_entry.second != RW_TYPE_INS_DEL) {
-
-        if (ValidateRead(tile_group_header, tuple_slot, end_commit_id)) {
-          continue;
-        }
-        LOG_TRACE("transaction id=%lu",
-                  tile_group_header->GetTransactionId(tuple_slot));
-        LOG_TRACE("begin commit id=%lu",
-                  tile_group_header->GetBeginCommitId(tuple_slot));
-        LOG_TRACE("end commit id=%lu",
-                  tile_group_header->GetEndCommitId(tuple_slot));
-        // otherwise, validation fails. abort transaction.
-        return AbortTransaction();
-      }
+    bool valid = ValidateTileGroupAccess(
+        tile_group_header, tile_group_entry,
+        [this, tile_group_header, end_commit_id](
+            const RWSetEntry &tuple_entry) {
+          auto tuple_slot = tuple_entry.tuple_id;
+          // if this tuple is newly inserted. Otherwise this is either read,
+          // update or deleted.
+          if (tuple_entry.type == RW_TYPE_INSERT ||
+              tuple_entry.type == RW_TYPE_INS_DEL) {
+            return true;
+          }
+
+          if (ValidateRead(tile_group_header, tuple_slot, end_commit_id)) {
+            return true;
+          }
+          LOG_TRACE("transaction id=%lu",
+                    tile_group_header->GetTransactionId(tuple_slot));
+          LOG_TRACE("begin commit id=%lu",
+                    tile_group_header->GetBeginCommitId(tuple_slot));
+          LOG_TRACE("end commit id=%lu",
+                    tile_group_header->GetEndCommitId(tuple_slot));
+          return false;
+        });
+    if (valid == false) {
+      // otherwise, validation fails. abort transaction.
+      return AbortTransaction();
     }
   }
   //////////////////////////////////////////////////////////
@@ -361,12 +409,12 @@ Result OptimisticRbTxnManager::CommitTransaction() {
   //  log_manager.LogBeginTransaction(end_commit_id);
   // install everything.
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
         //        // logging.
         //        ItemPointer new_version =
         //          tile_group_header->GetNextItemPointer(tuple_slot);
@@ -389,7 +437,7 @@ Result OptimisticRbTxnManager::CommitTransaction() {
         // Finally we release the write lock on the original tuple
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         //        ItemPointer new_version =
         //          tile_group_header->GetNextItemPointer(tuple_slot);
         //        ItemPointer delete_location(tile_group_id, tuple_slot);
@@ -419,7 +467,7 @@ Result OptimisticRbTxnManager::CommitTransaction() {
         // FIXME: need to delete them in index and free the tuple --jiexi
         // RecycleTupleSlot(tile_group_id, tuple_slot, START_OID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
             current_txn->GetTransactionId());
         // set the begin commit id to persist insert
@@ -433,7 +481,7 @@ Result OptimisticRbTxnManager::CommitTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) == INVALID_TXN_ID);
         // Do nothing for INS_DEL
       }
@@ -454,13 +502,13 @@ Result OptimisticRbTxnManager::AbortTransaction() {
   auto &rw_set = current_txn->GetRWSet();
 
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
 
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
 
         // We do not have new version now, no need to mantain it
         PL_ASSERT(tile_group_header->GetNextItemPointer(tuple_slot).IsNull());
@@ -475,7 +523,7 @@ Result OptimisticRbTxnManager::AbortTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
 
         // We do not have new version now, no need to mantain it
         PL_ASSERT(tile_group_header->GetNextItemPointer(tuple_slot).IsNull());
@@ -492,7 +540,7 @@ Result OptimisticRbTxnManager::AbortTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
 
@@ -502,7 +550,7 @@ Result OptimisticRbTxnManager::AbortTransaction() {
         // FIXME: need to delete them in index and free the tuple --jiexi
         // RecycleTupleSlot(tile_group_id, tuple_slot, START_OID);
 
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) == INVALID_TXN_ID);
         // Do nothing for INS_DEL
         // GC this tuple
@@ -566,7 +614,7 @@ Transaction *OptimisticRbTxnManager::BeginTransaction() {
   LOG_TRACE("Beginning transaction %lu", txn_id);
 
 
-  Transaction *txn = new Transaction(txn_id, begin_cid);
+  Transaction *txn = AllocateTransaction(txn_id, begin_cid);
   current_txn = txn;
 
   auto eid = EpochManagerFactory::GetInstance().EnterEpoch(begin_cid);
@@ -596,20 +644,20 @@ void OptimisticRbTxnManager::EndTransaction() {
       // read only txn, just delete the segment pool because it's empty
       delete current_segment_pool;
     } else {
-      // It's not read only txn
+      // It's not read only txn, the pool lives on with the segments
+      // that are still linked
       current_segment_pool->SetPoolTimestamp(end_cid);
-      living_pools_[end_cid] = std::shared_ptr<peloton::storage::RollbackSegmentPool>(current_segment_pool);
+      ReleaseSegmentPool(current_segment_pool);
     }
   } else {
-    // Aborted
-    // TODO: Add coperative GC
+    // Aborted, the segments were unlinked by the rollback
     current_segment_pool->MarkedAsGarbage();
-    garbage_pools_[current_txn->GetBeginCommitId()] = std::shared_ptr<peloton::storage::RollbackSegmentPool>(current_segment_pool);
+    ReleaseSegmentPool(current_segment_pool);
   }
 
   EpochManagerFactory::GetInstance().ExitEpoch(current_txn->GetEpochId());
 
-  delete current_txn;
+  ReleaseTransaction(current_txn);
   current_txn = nullptr;
   current_segment_pool = nullptr;
 }
@@ -125,6 +125,10 @@ class OptimisticRbTxnManager : public TransactionManager {
 
   virtual Transaction *BeginTransaction();
 
+  // Rollback segments are reclaimed by the running txn table, so read-only
+  // txns have to be registered there and take the regular path
+  virtual Transaction *BeginReadOnlyTransaction() { return BeginTransaction(); }
+
   virtual void EndTransaction();
 
   // Init reserved area of a tuple
@@ -151,11 +155,13 @@ class OptimisticRbTxnManager : public TransactionManager {
   static const size_t rb_seg_offset  = lock_offset + sizeof(oid_t);
   static const size_t delete_flag_offset = rb_seg_offset + sizeof(char*);
   cuckoohash_map<txn_id_t, cid_t> running_txn_buckets_[RUNNING_TXN_BUCKET_NUM];
-  // TODO: add cooperative GC
-  // The RB segment pool that is activlely being used
-  cuckoohash_map<cid_t, std::shared_ptr<storage::RollbackSegmentPool>> living_pools_;
-  // The RB segment pool that has been marked as garbage
-  cuckoohash_map<cid_t, std::shared_ptr<storage::RollbackSegmentPool>> garbage_pools_;
+
+  // Drop a reference to the pool, and hand it to the GC if it was the last
+  void ReleaseSegmentPool(storage::RollbackSegmentPool *segment_pool);
+
+  // Unlink the rollback segments behind the first one that is older than
+  // every running txn. Readers stop at that one, so none can reach them.
+  void TruncateRollbackSegments(RBSegType rb_seg);
 
   inline void SetRbSeg(const storage::TileGroupHeader *tile_group_header, const oid_t tuple_id,
                        const RBSegType seg_ptr) {
@@ -19,6 +19,7 @@
 #include "backend/catalog/manager.h"
 #include "backend/common/exception.h"
 #include "backend/common/logger.h"
+#include "backend/storage/data_table.h"
 
 namespace peloton {
 namespace concurrency {
@@ -120,6 +121,11 @@ bool OptimisticTxnManager::AcquireOwnership(
 }
 
 bool OptimisticTxnManager::PerformRead(const ItemPointer &location) {
+  // snapshot reads need no read set or read locks
+  if (current_txn->IsReadOnlySnapshot()) {
+    return true;
+  }
+
   current_txn->RecordRead(location);
   return true;
 }
@@ -258,9 +264,167 @@ void OptimisticTxnManager::PerformDelete(const ItemPointer &location) {
   }
 }
 
+bool OptimisticTxnManager::ApplyEscrowOperations(
+    const storage::DataTable *table) {
+  if (current_txn == nullptr || current_txn->HasEscrowOperations() == false) {
+    return true;
+  }
+
+  auto escrow_operations = current_txn->TakeEscrowOperations(table);
+  for (auto &escrow_operation : escrow_operations) {
+    if (ApplyEscrowOperation(escrow_operation, escrow_operations) == false) {
+      LOG_TRACE("Fail to apply an escrow operation. Set txn failure.");
+      SetTransactionResult(Result::RESULT_FAILURE);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OptimisticTxnManager::IsEscrowReadValid(
+    const EscrowOperation &escrow_operation, const ItemPointer &location,
+    const std::vector<EscrowOperation> &escrow_operations) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto &read_location = escrow_operation.location;
+  auto read_tile_group = manager.GetTileGroup(read_location.block);
+  auto tile_group = manager.GetTileGroup(location.block);
+
+  std::vector<bool> escrow_columns(
+      escrow_operation.table->GetSchema()->GetColumnCount(), false);
+  for (auto &other : escrow_operations) {
+    if (other.location.block == read_location.block &&
+        other.location.offset == read_location.offset) {
+      escrow_columns[other.column_id] = true;
+    }
+  }
+
+  for (oid_t column_id = 0; column_id < escrow_columns.size(); column_id++) {
+    if (escrow_columns[column_id] == true) {
+      continue;
+    }
+    if (read_tile_group->GetValue(read_location.offset, column_id) !=
+        tile_group->GetValue(location.offset, column_id)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OptimisticTxnManager::ApplyEscrowOperation(
+    const EscrowOperation &escrow_operation,
+    const std::vector<EscrowOperation> &escrow_operations) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto txn_id = current_txn->GetTransactionId();
+  auto table = escrow_operation.table;
+  auto column_id = escrow_operation.column_id;
+
+  ItemPointer location = escrow_operation.location;
+  size_t retry_count = 0;
+
+  for (;;) {
+    auto tile_group = manager.GetTileGroup(location.block);
+    auto tile_group_header = tile_group->GetHeader();
+    auto tuple_id = location.offset;
+    auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+
+    if (tuple_txn_id == txn_id) {
+      // the txn has its own version already, the delta goes into it
+      ItemPointer own_location = tile_group_header->GetNextItemPointer(tuple_id);
+      PL_ASSERT(own_location.IsNull() == false);
+
+      auto own_tile_group = manager.GetTileGroup(own_location.block);
+      if (own_tile_group->GetHeader()->GetEndCommitId(own_location.offset) ==
+          INVALID_CID) {
+        // the txn deleted the tuple
+        return false;
+      }
+
+      std::unique_ptr<storage::Tuple> tuple(
+          new storage::Tuple(table->GetSchema(), true));
+      own_tile_group->CopyTuple(own_location.offset, tuple.get());
+      tuple->SetValue(column_id,
+                      tuple->GetValue(column_id).OpAdd(escrow_operation.delta),
+                      nullptr);
+      own_tile_group->CopyTuple(tuple.get(), own_location.offset);
+      return true;
+    }
+
+    if (tuple_txn_id == INVALID_TXN_ID) {
+      // the tuple was deleted
+      return false;
+    }
+
+    if (tile_group_header->GetEndCommitId(tuple_id) != MAX_CID) {
+      // a newer version was committed
+      location = tile_group_header->GetNextItemPointer(tuple_id);
+      if (location.IsNull() == true) {
+        return false;
+      }
+      continue;
+    }
+
+    if (tuple_txn_id != INITIAL_TXN_ID ||
+        tile_group_header->SetAtomicTransactionId(tuple_id, txn_id) == false) {
+      // another txn is writing the tuple, wait a little for it to finish
+      if (++retry_count > ESCROW_ACQUIRE_RETRY_COUNT) {
+        return false;
+      }
+      _mm_pause();
+      continue;
+    }
+
+    if (tile_group_header->GetEndCommitId(tuple_id) != MAX_CID) {
+      // a newer version was committed before the version was taken
+      tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+      continue;
+    }
+
+    if (escrow_operation.scan_read == true &&
+        (location.block != escrow_operation.location.block ||
+         location.offset != escrow_operation.location.offset)) {
+      // the statement's predicate was evaluated on an older version. It
+      // still holds if the newer versions only changed the columns the txn
+      // adds to, which the predicate does not read.
+      if (IsEscrowReadValid(escrow_operation, location, escrow_operations) ==
+          false) {
+        tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+        return false;
+      }
+      // the txn owns the newest version, nobody can change it any more
+      current_txn->EraseRead(escrow_operation.location);
+    }
+
+    // the version is the newest and owned by the txn now
+    std::unique_ptr<storage::Tuple> tuple(
+        new storage::Tuple(table->GetSchema(), true));
+    tile_group->CopyTuple(tuple_id, tuple.get());
+    tuple->SetValue(column_id,
+                    tuple->GetValue(column_id).OpAdd(escrow_operation.delta),
+                    nullptr);
+
+    ItemPointer new_location = table->InsertVersion(tuple.get());
+    if (new_location.IsNull() == true) {
+      tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+      return false;
+    }
+
+    PerformUpdate(location, new_location);
+    return true;
+  }
+}
+
 Result OptimisticTxnManager::CommitTransaction() {
   LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
 
+  if (current_txn->IsReadOnlySnapshot()) {
+    return EndReadOnlyTransaction(current_txn->GetResult());
+  }
+
+  // the deltas become regular updates of the newest versions
+  if (ApplyEscrowOperations(nullptr) == false) {
+    return AbortTransaction();
+  }
+
   auto &manager = catalog::Manager::GetInstance();
 
   auto &rw_set = current_txn->GetRWSet();
@@ -269,28 +433,31 @@ Result OptimisticTxnManager::CommitTransaction() {
   // we can optimize read-only transaction.
   if (current_txn->IsReadOnly() == true) {
     // validate read set.
+    cid_t begin_cid = current_txn->GetBeginCommitId();
     for (auto &tile_group_entry : rw_set) {
-      oid_t tile_group_id = tile_group_entry.first;
+      oid_t tile_group_id = tile_group_entry.GetTileGroupId();
       auto tile_group = manager.GetTileGroup(tile_group_id);
       auto tile_group_header = tile_group->GetHeader();
-      for (auto &tuple_entry : tile_group_entry.second) {
-        auto tuple_slot = tuple_entry.first;
-        // if this tuple is not newly inserted.
-        if (tuple_entry.second == RW_TYPE_READ) {
-          if (tile_group_header->GetTransactionId(tuple_slot) ==
-                  INITIAL_TXN_ID &&
-              tile_group_header->GetBeginCommitId(tuple_slot) <=
-                  current_txn->GetBeginCommitId() &&
-              tile_group_header->GetEndCommitId(tuple_slot) >=
-                  current_txn->GetBeginCommitId()) {
-            // the version is not owned by other txns and is still visible.
-            continue;
-          }
-          // otherwise, validation fails. abort transaction.
-          return AbortTransaction();
-        } else {
-          PL_ASSERT(tuple_entry.second == RW_TYPE_INS_DEL);
-        }
+      bool valid = ValidateTileGroupAccess(
+          tile_group_header, tile_group_entry,
+          [tile_group_header, begin_cid](const RWSetEntry &tuple_entry) {
+            auto tuple_slot = tuple_entry.tuple_id;
+            // if this tuple is not newly inserted.
+            if (tuple_entry.type != RW_TYPE_READ) {
+              PL_ASSERT(tuple_entry.type == RW_TYPE_INS_DEL);
+              return true;
+            }
+            // the version must not be owned by other txns and still be
+            // visible.
+            return tile_group_header->GetTransactionId(tuple_slot) ==
+                       INITIAL_TXN_ID &&
+                   tile_group_header->GetBeginCommitId(tuple_slot) <=
+                       begin_cid &&
+                   tile_group_header->GetEndCommitId(tuple_slot) >= begin_cid;
+          });
+      if (valid == false) {
+        // otherwise, validation fails. abort transaction.
+        return AbortTransaction();
       }
     }
     // is it always true???
@@ -303,44 +470,49 @@ Result OptimisticTxnManager::CommitTransaction() {
   auto &log_manager = logging::LogManager::GetInstance();
   log_manager.PrepareLogging();
   // generate transaction id.
-  cid_t end_commit_id = GetNextCommitId();
+  cid_t end_commit_id = BeginCommit();
   current_txn->SetEndCommitId(end_commit_id);
 
   // validate read set.
+  txn_id_t txn_id = current_txn->GetTransactionId();
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      // if this tuple is not newly inserted.
-      if (tuple_entry.second != RW_TYPE_INSERT &&
-          tuple_entry.second != RW_TYPE_INS_DEL) {
-        // if this tuple is owned by this txn, then it is safe.
-        if (tile_group_header->GetTransactionId(tuple_slot) ==
-            current_txn->GetTransactionId()) {
-          // the version is owned by the transaction.
-          continue;
-        } else {
-          if (tile_group_header->GetTransactionId(tuple_slot) ==
-                  INITIAL_TXN_ID &&
+    bool valid = ValidateTileGroupAccess(
+        tile_group_header, tile_group_entry,
+        [tile_group_header, txn_id, end_commit_id](
+            const RWSetEntry &tuple_entry) {
+          auto tuple_slot = tuple_entry.tuple_id;
+          // if this tuple is newly inserted.
+          if (tuple_entry.type == RW_TYPE_INSERT ||
+              tuple_entry.type == RW_TYPE_INS_DEL) {
+            return true;
+          }
+          auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_slot);
+          // if this tuple is owned by this txn, then it is safe.
+          if (tuple_txn_id == txn_id) {
+            return true;
+          }
+          if (tuple_txn_id == INITIAL_TXN_ID &&
               tile_group_header->GetBeginCommitId(tuple_slot) <=
                   end_commit_id &&
               tile_group_header->GetEndCommitId(tuple_slot) >= end_commit_id) {
             // the version is not owned by other txns and is still visible.
-            continue;
+            return true;
           }
-        }
-        LOG_TRACE("transaction id=%lu",
-                  tile_group_header->GetTransactionId(tuple_slot));
-        LOG_TRACE("begin commit id=%lu",
-                  tile_group_header->GetBeginCommitId(tuple_slot));
-        LOG_TRACE("end commit id=%lu",
-                  tile_group_header->GetEndCommitId(tuple_slot));
-        // otherwise, validation fails. abort transaction.
-        log_manager.DoneLogging();
-        return AbortTransaction();
-      }
+          LOG_TRACE("transaction id=%lu", tuple_txn_id);
+          LOG_TRACE("begin commit id=%lu",
+                    tile_group_header->GetBeginCommitId(tuple_slot));
+          LOG_TRACE("end commit id=%lu",
+                    tile_group_header->GetEndCommitId(tuple_slot));
+          return false;
+        });
+    if (valid == false) {
+      // otherwise, validation fails. abort transaction.
+      log_manager.DoneLogging();
+      EndCommit();
+      return AbortTransaction();
     }
   }
   //////////////////////////////////////////////////////////
@@ -348,12 +520,12 @@ Result OptimisticTxnManager::CommitTransaction() {
   log_manager.LogBeginTransaction(end_commit_id);
   // install everything.
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
         // logging.
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
@@ -382,7 +554,7 @@ Result OptimisticTxnManager::CommitTransaction() {
                                                 INITIAL_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
         ItemPointer delete_location(tile_group_id, tuple_slot);
@@ -408,7 +580,7 @@ Result OptimisticTxnManager::CommitTransaction() {
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
                current_txn->GetTransactionId());
         // set the begin commit id to persist insert
@@ -422,7 +594,7 @@ Result OptimisticTxnManager::CommitTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
                current_txn->GetTransactionId());
 
@@ -437,6 +609,7 @@ Result OptimisticTxnManager::CommitTransaction() {
     }
   }
   log_manager.LogCommitTransaction(end_commit_id);
+  EndCommit();
   EndTransaction();
 
   return Result::RESULT_SUCCESS;
@@ -444,18 +617,22 @@ Result OptimisticTxnManager::CommitTransaction() {
 
 Result OptimisticTxnManager::AbortTransaction() {
   LOG_TRACE("Aborting peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsReadOnlySnapshot()) {
+    return EndReadOnlyTransaction(Result::RESULT_ABORTED);
+  }
   auto &manager = catalog::Manager::GetInstance();
 
   auto &rw_set = current_txn->GetRWSet();
 
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
 
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
         // we do not set begin cid for old tuple.
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
@@ -482,7 +659,7 @@ Result OptimisticTxnManager::AbortTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
 
@@ -509,7 +686,7 @@ Result OptimisticTxnManager::AbortTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
 
@@ -517,7 +694,7 @@ Result OptimisticTxnManager::AbortTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
 
@@ -18,6 +18,10 @@
 namespace peloton {
 namespace concurrency {
 
+// Times a committing txn retries to take the newest version of a tuple it
+// adds to, before it gives up and aborts
+#define ESCROW_ACQUIRE_RETRY_COUNT 1000
+
 //===--------------------------------------------------------------------===//
 // optimistic concurrency control
 //===--------------------------------------------------------------------===//
@@ -59,6 +63,10 @@ class OptimisticTxnManager : public TransactionManager {
 
   virtual void PerformDelete(const ItemPointer &location);
 
+  virtual bool IsEscrowSupported() const { return true; }
+
+  virtual bool ApplyEscrowOperations(const storage::DataTable *table);
+
   virtual Result CommitTransaction();
 
   virtual Result AbortTransaction();
@@ -66,7 +74,7 @@ class OptimisticTxnManager : public TransactionManager {
   virtual Transaction *BeginTransaction() {
     txn_id_t txn_id = GetNextTransactionId();
     cid_t begin_cid = GetNextCommitId();
-    Transaction *txn = new Transaction(txn_id, begin_cid);
+    Transaction *txn = AllocateTransaction(txn_id, begin_cid);
 
     auto eid = EpochManagerFactory::GetInstance().EnterEpoch(begin_cid);
     txn->SetEpochId(eid);
@@ -80,10 +88,22 @@ class OptimisticTxnManager : public TransactionManager {
 
     EpochManagerFactory::GetInstance().ExitEpoch(current_txn->GetEpochId());
 
-    delete current_txn;
+    ReleaseTransaction(current_txn);
     current_txn = nullptr;
   }
 
+ private:
+  // Take the newest version of the tuple the txn adds to and install a copy
+  // with the delta applied. Returns false if the txn must abort.
+  bool ApplyEscrowOperation(
+      const EscrowOperation &escrow_operation,
+      const std::vector<EscrowOperation> &escrow_operations);
+
+  // Whether the version the ADD's statement read and the newest version
+  // agree on every column the txn does not add to
+  bool IsEscrowReadValid(
+      const EscrowOperation &escrow_operation, const ItemPointer &location,
+      const std::vector<EscrowOperation> &escrow_operations);
 };
 }
 }
\ No newline at end of file
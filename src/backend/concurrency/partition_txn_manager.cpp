@@ -0,0 +1,469 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// partition_txn_manager.cpp
+//
+// Identification: src/backend/concurrency/partition_txn_manager.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "partition_txn_manager.h"
+
+#include <algorithm>
+
+#include "backend/common/platform.h"
+#include "backend/logging/log_manager.h"
+#include "backend/logging/records/transaction_record.h"
+#include "backend/concurrency/transaction.h"
+#include "backend/catalog/manager.h"
+#include "backend/common/exception.h"
+#include "backend/common/logger.h"
+
+namespace peloton {
+namespace concurrency {
+
+// Partitions declared for the next txn of the thread, and held by the
+// running one once it began
+thread_local std::vector<oid_t> txn_partitions;
+
+PartitionTxnManager &PartitionTxnManager::GetInstance() {
+  static PartitionTxnManager txn_manager;
+  return txn_manager;
+}
+
+void PartitionTxnManager::DeclarePartition(const oid_t partition) {
+  PL_ASSERT(current_txn == nullptr);
+  PL_ASSERT(partition < PARTITION_COUNT);
+  txn_partitions.push_back(partition);
+}
+
+Transaction *PartitionTxnManager::BeginTransaction() {
+  if (txn_partitions.empty() == true) {
+    for (oid_t partition = 0; partition < PARTITION_COUNT; partition++) {
+      txn_partitions.push_back(partition);
+    }
+  } else {
+    // take the partitions in one global order
+    std::sort(txn_partitions.begin(), txn_partitions.end());
+    txn_partitions.erase(
+        std::unique(txn_partitions.begin(), txn_partitions.end()),
+        txn_partitions.end());
+  }
+
+  for (auto partition : txn_partitions) {
+    partitions_[partition].latch_.Lock();
+  }
+
+  // the begin cid is taken inside the partitions, so it follows the commit
+  // cids of all txns that held them before
+  txn_id_t txn_id = GetNextTransactionId();
+  cid_t begin_cid = GetNextCommitId();
+  Transaction *txn = AllocateTransaction(txn_id, begin_cid);
+
+  auto eid = EpochManagerFactory::GetInstance().EnterEpoch(begin_cid);
+  txn->SetEpochId(eid);
+
+  current_txn = txn;
+
+  return txn;
+}
+
+void PartitionTxnManager::EndTransaction() {
+  EpochManagerFactory::GetInstance().ExitEpoch(current_txn->GetEpochId());
+
+  for (auto partition = txn_partitions.rbegin();
+       partition != txn_partitions.rend(); partition++) {
+    partitions_[*partition].latch_.Unlock();
+  }
+  txn_partitions.clear();
+
+  ReleaseTransaction(current_txn);
+  current_txn = nullptr;
+}
+
+// Visibility check
+// check whether a tuple is visible to current transaction.
+// no other txn writes the partitions of the current txn, so the versions
+// it accesses are either committed or its own.
+bool PartitionTxnManager::IsVisible(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  if (tuple_txn_id == INVALID_TXN_ID || CidIsInDirtyRange(tuple_begin_cid)) {
+    // the tuple is not available.
+    return false;
+  }
+  bool own = (current_txn->GetTransactionId() == tuple_txn_id);
+
+  // there are exactly two versions that can be owned by a transaction.
+  // unless it is an insertion.
+  if (own == true) {
+    if (tuple_begin_cid == MAX_CID && tuple_end_cid != INVALID_CID) {
+      PL_ASSERT(tuple_end_cid == MAX_CID);
+      // the only version that is visible is the newly inserted one.
+      return true;
+    } else {
+      // the older version is not visible.
+      return false;
+    }
+  } else {
+    if (tuple_begin_cid == MAX_CID) {
+      // never read an uncommitted version.
+      return false;
+    }
+    bool activated = (current_txn->GetBeginCommitId() >= tuple_begin_cid);
+    bool invalidated = (current_txn->GetBeginCommitId() >= tuple_end_cid);
+    return activated && !invalidated;
+  }
+}
+
+// check whether the current transaction owns the tuple.
+// this function is called by update/delete executors.
+bool PartitionTxnManager::IsOwner(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+
+  return tuple_txn_id == current_txn->GetTransactionId();
+}
+
+// if the tuple is not owned by any transaction and is visible to current
+// transaction.
+// this function is called by update/delete executors.
+bool PartitionTxnManager::IsOwnable(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  auto tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  return tuple_txn_id == INITIAL_TXN_ID && tuple_end_cid == MAX_CID;
+}
+
+// take a tuple for update/delete.
+// the partition is held by the current txn, so no other txn competes for it.
+bool PartitionTxnManager::AcquireOwnership(
+    const storage::TileGroupHeader *const tile_group_header UNUSED_ATTRIBUTE,
+    const oid_t &tile_group_id, const oid_t &tuple_id) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto writable_header = manager.GetTileGroup(tile_group_id)->GetHeader();
+
+  PL_ASSERT(writable_header->GetTransactionId(tuple_id) == INITIAL_TXN_ID);
+  writable_header->SetTransactionId(tuple_id, current_txn->GetTransactionId());
+  return true;
+}
+
+// reads are not tracked, there is nothing to validate at commit.
+bool PartitionTxnManager::PerformRead(const ItemPointer &location
+                                      UNUSED_ATTRIBUTE) {
+  return true;
+}
+
+bool PartitionTxnManager::PerformInsert(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group_header = manager.GetTileGroup(tile_group_id)->GetHeader();
+  auto transaction_id = current_txn->GetTransactionId();
+
+  // Set MVCC info
+  PL_ASSERT(tile_group_header->GetTransactionId(tuple_id) == INVALID_TXN_ID);
+  PL_ASSERT(tile_group_header->GetBeginCommitId(tuple_id) == MAX_CID);
+  PL_ASSERT(tile_group_header->GetEndCommitId(tuple_id) == MAX_CID);
+
+  tile_group_header->SetTransactionId(tuple_id, transaction_id);
+
+  // Add the new tuple into the insert set
+  current_txn->RecordInsert(location);
+  return true;
+}
+
+// this function is invoked when it is the first time to update the tuple.
+// the tuple passed into this function is the global version.
+void PartitionTxnManager::PerformUpdate(const ItemPointer &old_location,
+                                        const ItemPointer &new_location) {
+  auto transaction_id = current_txn->GetTransactionId();
+
+  auto tile_group_header = catalog::Manager::GetInstance()
+                               .GetTileGroup(old_location.block)
+                               ->GetHeader();
+  auto new_tile_group_header = catalog::Manager::GetInstance()
+                                   .GetTileGroup(new_location.block)
+                                   ->GetHeader();
+
+  PL_ASSERT(tile_group_header->GetTransactionId(old_location.offset) ==
+         transaction_id);
+  PL_ASSERT(new_tile_group_header->GetTransactionId(new_location.offset) ==
+         INVALID_TXN_ID);
+
+  // Set double linked list
+  tile_group_header->SetNextItemPointer(old_location.offset, new_location);
+  new_tile_group_header->SetPrevItemPointer(new_location.offset, old_location);
+
+  new_tile_group_header->SetTransactionId(new_location.offset, transaction_id);
+
+  // Add the old tuple into the update set
+  current_txn->RecordUpdate(old_location);
+}
+
+// this function is invoked when it is NOT the first time to update the tuple.
+// the tuple passed into this function is the local version created by this txn.
+void PartitionTxnManager::PerformUpdate(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group_header = manager.GetTileGroup(tile_group_id)->GetHeader();
+
+  PL_ASSERT(tile_group_header->GetTransactionId(tuple_id) ==
+         current_txn->GetTransactionId());
+  PL_ASSERT(tile_group_header->GetEndCommitId(tuple_id) == MAX_CID);
+
+  // the older version is in the update set already, unless the tuple was
+  // inserted by the txn
+  auto old_location = tile_group_header->GetPrevItemPointer(tuple_id);
+  if (old_location.IsNull() == false) {
+    current_txn->RecordUpdate(old_location);
+  }
+}
+
+void PartitionTxnManager::PerformDelete(const ItemPointer &old_location,
+                                        const ItemPointer &new_location) {
+  auto transaction_id = current_txn->GetTransactionId();
+
+  auto tile_group_header = catalog::Manager::GetInstance()
+                               .GetTileGroup(old_location.block)
+                               ->GetHeader();
+  auto new_tile_group_header = catalog::Manager::GetInstance()
+                                   .GetTileGroup(new_location.block)
+                                   ->GetHeader();
+
+  PL_ASSERT(tile_group_header->GetTransactionId(old_location.offset) ==
+         transaction_id);
+  PL_ASSERT(new_tile_group_header->GetTransactionId(new_location.offset) ==
+         INVALID_TXN_ID);
+
+  // Set up double linked list
+  tile_group_header->SetNextItemPointer(old_location.offset, new_location);
+  new_tile_group_header->SetPrevItemPointer(new_location.offset, old_location);
+
+  new_tile_group_header->SetTransactionId(new_location.offset, transaction_id);
+  new_tile_group_header->SetEndCommitId(new_location.offset, INVALID_CID);
+
+  // reads are not tracked, so the tuple enters the rw set here
+  current_txn->RecordRead(old_location);
+  current_txn->RecordDelete(old_location);
+}
+
+void PartitionTxnManager::PerformDelete(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group_header = manager.GetTileGroup(tile_group_id)->GetHeader();
+
+  PL_ASSERT(tile_group_header->GetTransactionId(tuple_id) ==
+         current_txn->GetTransactionId());
+  PL_ASSERT(tile_group_header->GetBeginCommitId(tuple_id) == MAX_CID);
+
+  tile_group_header->SetEndCommitId(tuple_id, INVALID_CID);
+
+  // Add the old tuple into the delete set
+  auto old_location = tile_group_header->GetPrevItemPointer(tuple_id);
+  if (old_location.IsNull() == false) {
+    // if this version is not newly inserted.
+    current_txn->RecordDelete(old_location);
+  } else {
+    // if this version is newly inserted.
+    current_txn->RecordDelete(location);
+  }
+}
+
+Result PartitionTxnManager::CommitTransaction() {
+  LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsReadOnlySnapshot()) {
+    return EndReadOnlyTransaction(current_txn->GetResult());
+  }
+
+  // nothing to validate, a txn that wrote nothing is done.
+  if (current_txn->IsReadOnly() == true) {
+    Result ret = current_txn->GetResult();
+    EndTransaction();
+    return ret;
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+
+  auto &rw_set = current_txn->GetRWSet();
+
+  // must tell the log manager we are going to log
+  auto &log_manager = logging::LogManager::GetInstance();
+  log_manager.PrepareLogging();
+  // generate transaction id.
+  cid_t end_commit_id = GetNextCommitId();
+  current_txn->SetEndCommitId(end_commit_id);
+
+  log_manager.LogBeginTransaction(end_commit_id);
+  // install everything.
+  for (auto &tile_group_entry : rw_set) {
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
+    auto tile_group = manager.GetTileGroup(tile_group_id);
+    auto tile_group_header = tile_group->GetHeader();
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
+        ItemPointer new_version =
+            tile_group_header->GetNextItemPointer(tuple_slot);
+        ItemPointer old_version(tile_group_id, tuple_slot);
+
+        // logging.
+        log_manager.LogUpdate(end_commit_id, old_version, new_version);
+
+        // we must guarantee that, at any time point, AT LEAST ONE version is
+        // visible.
+        // we do not change begin cid for old tuple.
+        auto new_tile_group_header =
+            manager.GetTileGroup(new_version.block)->GetHeader();
+
+        new_tile_group_header->SetEndCommitId(new_version.offset, MAX_CID);
+        new_tile_group_header->SetBeginCommitId(new_version.offset,
+                                                end_commit_id);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetEndCommitId(tuple_slot, end_commit_id);
+
+        COMPILER_MEMORY_FENCE;
+
+        new_tile_group_header->SetTransactionId(new_version.offset,
+                                                INITIAL_TXN_ID);
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
+        ItemPointer new_version =
+            tile_group_header->GetNextItemPointer(tuple_slot);
+        ItemPointer delete_location(tile_group_id, tuple_slot);
+
+        // logging.
+        log_manager.LogDelete(end_commit_id, delete_location);
+
+        // we do not change begin cid for old tuple.
+        auto new_tile_group_header =
+            manager.GetTileGroup(new_version.block)->GetHeader();
+
+        new_tile_group_header->SetEndCommitId(new_version.offset, MAX_CID);
+        new_tile_group_header->SetBeginCommitId(new_version.offset,
+                                                end_commit_id);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetEndCommitId(tuple_slot, end_commit_id);
+
+        COMPILER_MEMORY_FENCE;
+
+        new_tile_group_header->SetTransactionId(new_version.offset,
+                                                INVALID_TXN_ID);
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
+        PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
+               current_txn->GetTransactionId());
+        // set the begin commit id to persist insert
+        ItemPointer insert_location(tile_group_id, tuple_slot);
+        log_manager.LogInsert(end_commit_id, insert_location);
+
+        tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
+        tile_group_header->SetBeginCommitId(tuple_slot, end_commit_id);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
+        PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
+               current_txn->GetTransactionId());
+
+        tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
+        tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
+      }
+    }
+  }
+  log_manager.LogCommitTransaction(end_commit_id);
+  EndTransaction();
+
+  return Result::RESULT_SUCCESS;
+}
+
+Result PartitionTxnManager::AbortTransaction() {
+  LOG_TRACE("Aborting peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsReadOnlySnapshot()) {
+    return EndReadOnlyTransaction(Result::RESULT_ABORTED);
+  }
+  auto &manager = catalog::Manager::GetInstance();
+
+  auto &rw_set = current_txn->GetRWSet();
+
+  for (auto &tile_group_entry : rw_set) {
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
+    auto tile_group = manager.GetTileGroup(tile_group_id);
+    auto tile_group_header = tile_group->GetHeader();
+
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE ||
+          tuple_entry.type == RW_TYPE_DELETE) {
+        // we do not set begin cid for old tuple.
+        ItemPointer new_version =
+            tile_group_header->GetNextItemPointer(tuple_slot);
+
+        auto new_tile_group_header =
+            manager.GetTileGroup(new_version.block)->GetHeader();
+        new_tile_group_header->SetBeginCommitId(new_version.offset, MAX_CID);
+        new_tile_group_header->SetEndCommitId(new_version.offset, MAX_CID);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
+
+        COMPILER_MEMORY_FENCE;
+
+        new_tile_group_header->SetTransactionId(new_version.offset,
+                                                INVALID_TXN_ID);
+
+        // reset the item pointers.
+        tile_group_header->SetNextItemPointer(tuple_slot, INVALID_ITEMPOINTER);
+        new_tile_group_header->SetPrevItemPointer(new_version.offset,
+                                                  INVALID_ITEMPOINTER);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+
+      } else if (tuple_entry.type == RW_TYPE_INSERT ||
+                 tuple_entry.type == RW_TYPE_INS_DEL) {
+        tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
+        tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
+      }
+    }
+  }
+
+  EndTransaction();
+  return Result::RESULT_ABORTED;
+}
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// partition_txn_manager.h
+//
+// Identification: src/backend/concurrency/partition_txn_manager.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "backend/concurrency/transaction_manager.h"
+#include "backend/storage/tile_group.h"
+
+namespace peloton {
+namespace concurrency {
+
+// Number of partitions the values of the partitioning key are hashed to
+#define PARTITION_COUNT 64
+
+// A partition is held by at most one txn at a time
+struct Partition {
+  Spinlock latch_;
+
+  CACHE_PADOUT;
+};
+
+//===--------------------------------------------------------------------===//
+// partition serial execution
+//===--------------------------------------------------------------------===//
+
+/**
+ * Tables are partitioned on a key, e.g. the warehouse id, and a txn declares
+ * the partitions it accesses before it begins. It then holds these
+ * partitions until it ends, so txns on a partition run one after another
+ * and need no concurrency control: reads are not tracked, versions are taken
+ * without atomic operations and nothing is validated at commit.
+ *
+ * Txns that touch several partitions take them in ascending order, so they
+ * cannot deadlock. Txns that declare no partition take all of them.
+ */
+class PartitionTxnManager : public TransactionManager {
+ public:
+  PartitionTxnManager() {}
+
+  virtual ~PartitionTxnManager() {}
+
+  static PartitionTxnManager &GetInstance();
+
+  // Map a value of the partitioning key to its partition
+  static oid_t GetPartition(const int64_t key) {
+    return std::hash<int64_t>()(key) % PARTITION_COUNT;
+  }
+
+  // Declare a partition the next txn of the calling thread accesses
+  void DeclarePartition(const oid_t partition);
+
+  virtual bool IsVisible(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual bool IsOwner(const storage::TileGroupHeader *const tile_group_header,
+                       const oid_t &tuple_id);
+
+  virtual bool IsOwnable(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual bool AcquireOwnership(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tile_group_id, const oid_t &tuple_id);
+
+  virtual bool PerformInsert(const ItemPointer &location);
+
+  virtual bool PerformRead(const ItemPointer &location);
+
+  virtual void PerformUpdate(const ItemPointer &old_location,
+                             const ItemPointer &new_location);
+
+  virtual void PerformDelete(const ItemPointer &old_location,
+                             const ItemPointer &new_location);
+
+  virtual void PerformUpdate(const ItemPointer &location);
+
+  virtual void PerformDelete(const ItemPointer &location);
+
+  virtual Result CommitTransaction();
+
+  virtual Result AbortTransaction();
+
+  virtual Transaction *BeginTransaction();
+
+  // Snapshot reads of a partition would race with its holder, which writes
+  // without any concurrency control, so read-only txns take it as well
+  virtual Transaction *BeginReadOnlyTransaction() { return BeginTransaction(); }
+
+  virtual void EndTransaction();
+
+ private:
+  Partition partitions_[PARTITION_COUNT];
+};
+}
+}
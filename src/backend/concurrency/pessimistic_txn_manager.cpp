@@ -16,6 +16,7 @@
 #include "backend/logging/log_manager.h"
 #include "backend/logging/records/transaction_record.h"
 #include "backend/concurrency/transaction.h"
+#include "backend/concurrency/lock_manager.h"
 #include "backend/catalog/manager.h"
 #include "backend/common/exception.h"
 #include "backend/common/logger.h"
@@ -29,6 +30,13 @@ namespace concurrency {
 thread_local std::unordered_map<oid_t, std::unordered_set<oid_t>>
     pessimistic_released_rdlock;
 
+// Whether txns wait for locks in the lock manager, instead of taking them
+// in the txn id field of the tuple header and aborting on a conflict
+static inline bool UseLockManager() {
+  return LockManager::GetInstance().GetDeadlockHandling() !=
+         DEADLOCK_HANDLING_TYPE_NO_WAIT;
+}
+
 PessimisticTxnManager &PessimisticTxnManager::GetInstance() {
   static PessimisticTxnManager txn_manager;
   return txn_manager;
@@ -63,8 +71,8 @@ bool PessimisticTxnManager::IsVisible(
       return false;
     }
   } else {
-    bool activated = (current_txn->GetBeginCommitId() >= tuple_begin_cid);
-    bool invalidated = (current_txn->GetBeginCommitId() >= tuple_end_cid);
+    bool activated = (current_txn->GetReadCommitId() >= tuple_begin_cid);
+    bool invalidated = (current_txn->GetReadCommitId() >= tuple_end_cid);
     if (EXTRACT_TXNID(tuple_txn_id) != INITIAL_TXN_ID) {
       // if the tuple is owned by other transactions.
       if (tuple_begin_cid == MAX_CID) {
@@ -119,6 +127,29 @@ bool PessimisticTxnManager::AcquireOwnership(
   LOG_TRACE("AcquireOwnership");
   PL_ASSERT(IsOwner(tile_group_header, tuple_id) == false);
 
+  if (UseLockManager()) {
+    auto &lock_manager = LockManager::GetInstance();
+    auto current_txn_id = current_txn->GetTransactionId();
+    ItemPointer location(tile_group_id, tuple_id);
+
+    // upgrade the read lock
+    if (lock_manager.Lock(current_txn_id, current_txn->GetBeginCommitId(),
+                          location, LOCK_MODE_EXCLUSIVE) == false) {
+      LOG_TRACE("Fail to acquire write lock. Set txn failure.");
+      return false;
+    }
+
+    // The read lock the txn took in PerformRead kept writers off the
+    // version while it waited, so it is still the newest one
+    PL_ASSERT(IsOwnable(tile_group_header, tuple_id));
+    if (tile_group_header->SetAtomicTransactionId(tuple_id, current_txn_id) ==
+        false) {
+      lock_manager.Unlock(current_txn_id, location);
+      return false;
+    }
+    return true;
+  }
+
   // First release read lock that is acquired before, the executor will always
   // read the tuple before calling AcquireOwnership().
   ReleaseReadLock(tile_group_header, tuple_id);
@@ -131,12 +162,38 @@ bool PessimisticTxnManager::AcquireOwnership(
   bool res = tile_group_header->SetAtomicTransactionId(
       tuple_id, PACK_TXNID(current_txn_id, 0));
 
-  if (res) {
-    return true;
-  } else {
+  if (res == false) {
     LOG_TRACE("Fail to acquire write lock. Set txn failure.");
     return false;
   }
+
+  // A writer may have taken the tuple and committed a newer version once the
+  // read lock was gone. Aborting would then revive the replaced version.
+  if (tile_group_header->GetEndCommitId(tuple_id) != MAX_CID) {
+    LOG_TRACE("Tuple was replaced. Set txn failure.");
+    tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+    return false;
+  }
+  return true;
+}
+
+void PessimisticTxnManager::ReleaseReadLock(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tile_group_id, const oid_t &tuple_id) {
+  if (UseLockManager()) {
+    LockManager::GetInstance().Unlock(current_txn->GetTransactionId(),
+                                      ItemPointer(tile_group_id, tuple_id));
+    return;
+  }
+
+  // the lock is gone if the txn upgraded it
+  if (pessimistic_released_rdlock.find(tile_group_id) ==
+          pessimistic_released_rdlock.end() ||
+      pessimistic_released_rdlock[tile_group_id].find(tuple_id) ==
+          pessimistic_released_rdlock[tile_group_id].end()) {
+    ReleaseReadLock(tile_group_header, tuple_id);
+    pessimistic_released_rdlock[tile_group_id].insert(tuple_id);
+  }
 }
 
 void PessimisticTxnManager::ReleaseReadLock(
@@ -172,6 +229,11 @@ void PessimisticTxnManager::ReleaseReadLock(
 }
 
 bool PessimisticTxnManager::PerformRead(const ItemPointer &location) {
+  // snapshot reads need no read set or read locks
+  if (current_txn->IsReadOnlySnapshot()) {
+    return true;
+  }
+
   oid_t tile_group_id = location.block;
   oid_t tuple_id = location.offset;
 
@@ -180,19 +242,38 @@ bool PessimisticTxnManager::PerformRead(const ItemPointer &location) {
   auto tile_group = manager.GetTileGroup(tile_group_id);
   auto tile_group_header = tile_group->GetHeader();
 
-  auto &rw_set = current_txn->GetRWSet();
-  auto tuple_map = rw_set.find(tile_group_id);
-  if (tuple_map != rw_set.end()) {
-    if (tuple_map->second.find(tuple_id) != tuple_map->second.end()) {
-      // It was already accessed, don't acquire read lock again
-      return true;
-    }
+  if (current_txn->IsAccessed(tile_group_id, tuple_id)) {
+    // It was already accessed, don't acquire read lock again
+    return true;
   }
 
   if (IsOwner(tile_group_header, tuple_id)) {
     return true;
   }
 
+  if (UseLockManager()) {
+    if (LockManager::GetInstance().Lock(
+            current_txn->GetTransactionId(), current_txn->GetBeginCommitId(),
+            location, LOCK_MODE_SHARED) == false) {
+      return false;
+    }
+
+    // A writer replaced the version and committed before the txn got the
+    // lock. The locks the txn holds keep what it read so far current, so it
+    // moves its read point past the writer instead of aborting: the version
+    // turns invisible and the scan reads the newer one in the chain.
+    auto end_cid = tile_group_header->GetEndCommitId(tuple_id);
+    if (end_cid != MAX_CID) {
+      LockManager::GetInstance().Unlock(current_txn->GetTransactionId(),
+                                        location);
+      current_txn->AdvanceReadCommitId(end_cid);
+      return false;
+    }
+
+    current_txn->RecordRead(location);
+    return true;
+  }
+
   // Try to acquire read lock.
   auto old_txn_id = tile_group_header->GetTransactionId(tuple_id);
   // No one is holding the write lock
@@ -224,6 +305,14 @@ bool PessimisticTxnManager::PerformRead(const ItemPointer &location) {
     return false;
   }
 
+  // A writer may have committed a newer version since the scan checked
+  // the visibility of this one
+  if (current_txn->GetReadCommitId() >=
+      tile_group_header->GetEndCommitId(tuple_id)) {
+    ReleaseReadLock(tile_group_header, tuple_id);
+    return false;
+  }
+
   current_txn->RecordRead(location);
 
   return true;
@@ -370,6 +459,10 @@ void PessimisticTxnManager::PerformDelete(const ItemPointer &location) {
 Result PessimisticTxnManager::CommitTransaction() {
   LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
 
+  if (current_txn->IsReadOnlySnapshot()) {
+    return EndReadOnlyTransaction(current_txn->GetResult());
+  }
+
   auto &manager = catalog::Manager::GetInstance();
 
   auto &rw_set = current_txn->GetRWSet();
@@ -379,23 +472,17 @@ Result PessimisticTxnManager::CommitTransaction() {
   if (current_txn->IsReadOnly() == true) {
     // validate read set.
     for (auto &tile_group_entry : rw_set) {
-      oid_t tile_group_id = tile_group_entry.first;
+      oid_t tile_group_id = tile_group_entry.GetTileGroupId();
       auto tile_group = manager.GetTileGroup(tile_group_id);
       auto tile_group_header = tile_group->GetHeader();
-      for (auto &tuple_entry : tile_group_entry.second) {
-        auto tuple_slot = tuple_entry.first;
+      for (auto &tuple_entry : tile_group_entry) {
+        auto tuple_slot = tuple_entry.tuple_id;
         // if this tuple is not newly inserted.
-        if (tuple_entry.second == RW_TYPE_READ) {
+        if (tuple_entry.type == RW_TYPE_READ) {
           // Release read locks
-          if (pessimistic_released_rdlock.find(tile_group_id) ==
-                  pessimistic_released_rdlock.end() ||
-              pessimistic_released_rdlock[tile_group_id].find(tuple_slot) ==
-                  pessimistic_released_rdlock[tile_group_id].end()) {
-            ReleaseReadLock(tile_group_header, tuple_slot);
-            pessimistic_released_rdlock[tile_group_id].insert(tuple_slot);
-          }
+          ReleaseReadLock(tile_group_header, tile_group_id, tuple_slot);
         } else {
-          PL_ASSERT(tuple_entry.second == RW_TYPE_INS_DEL);
+          PL_ASSERT(tuple_entry.type == RW_TYPE_INS_DEL);
         }
       }
     }
@@ -407,29 +494,26 @@ Result PessimisticTxnManager::CommitTransaction() {
   //*****************************************************
 
   // generate transaction id.
-  cid_t end_commit_id = GetNextCommitId();
+  cid_t end_commit_id = BeginCommit();
   current_txn->SetEndCommitId(end_commit_id);
 
   auto &log_manager = logging::LogManager::GetInstance();
   log_manager.LogBeginTransaction(end_commit_id);
 
+  auto &lock_manager = LockManager::GetInstance();
+  bool use_lock_manager = UseLockManager();
+
   // install everything.
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_READ) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_READ) {
         // Release read locks
-        if (pessimistic_released_rdlock.find(tile_group_id) ==
-                pessimistic_released_rdlock.end() ||
-            pessimistic_released_rdlock[tile_group_id].find(tuple_slot) ==
-                pessimistic_released_rdlock[tile_group_id].end()) {
-          ReleaseReadLock(tile_group_header, tuple_slot);
-          pessimistic_released_rdlock[tile_group_id].insert(tuple_slot);
-        }
-      } else if (tuple_entry.second == RW_TYPE_UPDATE) {
+        ReleaseReadLock(tile_group_header, tile_group_id, tuple_slot);
+      } else if (tuple_entry.type == RW_TYPE_UPDATE) {
         // we must guarantee that, at any time point, only one version is
         // visible.
         ItemPointer new_version =
@@ -456,7 +540,7 @@ Result PessimisticTxnManager::CommitTransaction() {
                                                 INITIAL_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
         ItemPointer delete_location(tile_group_id, tuple_slot);
@@ -482,7 +566,7 @@ Result PessimisticTxnManager::CommitTransaction() {
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
                current_txn->GetTransactionId());
         // set the begin commit id to persist insert
@@ -496,7 +580,7 @@ Result PessimisticTxnManager::CommitTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
                current_txn->GetTransactionId());
 
@@ -508,9 +592,16 @@ Result PessimisticTxnManager::CommitTransaction() {
         // set the begin commit id to persist insert
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
       }
+
+      if (use_lock_manager && (tuple_entry.type == RW_TYPE_UPDATE ||
+                               tuple_entry.type == RW_TYPE_DELETE)) {
+        lock_manager.Unlock(current_txn->GetTransactionId(),
+                            ItemPointer(tile_group_id, tuple_slot));
+      }
     }
   }
   log_manager.LogCommitTransaction(end_commit_id);
+  EndCommit();
 
   EndTransaction();
 
@@ -519,26 +610,26 @@ Result PessimisticTxnManager::CommitTransaction() {
 
 Result PessimisticTxnManager::AbortTransaction() {
   LOG_TRACE("Aborting peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsReadOnlySnapshot()) {
+    return EndReadOnlyTransaction(Result::RESULT_ABORTED);
+  }
   auto &manager = catalog::Manager::GetInstance();
+  auto &lock_manager = LockManager::GetInstance();
+  bool use_lock_manager = UseLockManager();
 
   auto &rw_set = current_txn->GetRWSet();
 
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
 
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_READ) {
-        if (pessimistic_released_rdlock.find(tile_group_id) ==
-                pessimistic_released_rdlock.end() ||
-            pessimistic_released_rdlock[tile_group_id].find(tuple_slot) ==
-                pessimistic_released_rdlock[tile_group_id].end()) {
-          ReleaseReadLock(tile_group_header, tuple_slot);
-          pessimistic_released_rdlock[tile_group_id].insert(tuple_slot);
-        }
-      } else if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_READ) {
+        ReleaseReadLock(tile_group_header, tile_group_id, tuple_slot);
+      } else if (tuple_entry.type == RW_TYPE_UPDATE) {
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
         auto new_tile_group_header =
@@ -560,7 +651,7 @@ Result PessimisticTxnManager::AbortTransaction() {
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
 
@@ -584,14 +675,14 @@ Result PessimisticTxnManager::AbortTransaction() {
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
 
         COMPILER_MEMORY_FENCE;
 
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
 
@@ -599,6 +690,12 @@ Result PessimisticTxnManager::AbortTransaction() {
 
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
       }
+
+      if (use_lock_manager && (tuple_entry.type == RW_TYPE_UPDATE ||
+                               tuple_entry.type == RW_TYPE_DELETE)) {
+        lock_manager.Unlock(current_txn->GetTransactionId(),
+                            ItemPointer(tile_group_id, tuple_slot));
+      }
     }
   }
 
@@ -13,6 +13,7 @@
 #pragma once
 
 #include "backend/concurrency/transaction_manager.h"
+#include "backend/concurrency/lock_manager.h"
 
 namespace peloton {
 namespace concurrency {
@@ -66,7 +67,7 @@ class PessimisticTxnManager : public TransactionManager {
   virtual Transaction *BeginTransaction() {
     txn_id_t txn_id = GetNextTransactionId();
     cid_t begin_cid = GetNextCommitId();
-    Transaction *txn = new Transaction(txn_id, begin_cid);
+    Transaction *txn = AllocateTransaction(txn_id, begin_cid);
     current_txn = txn;
 
     auto eid = EpochManagerFactory::GetInstance().EnterEpoch(begin_cid);
@@ -78,11 +79,11 @@ class PessimisticTxnManager : public TransactionManager {
   }
 
   virtual void EndTransaction() {
-
+    LockManager::GetInstance().EndTransaction(current_txn->GetTransactionId());
 
     EpochManagerFactory::GetInstance().ExitEpoch(current_txn->GetEpochId());
 
-    delete current_txn;
+    ReleaseTransaction(current_txn);
     current_txn = nullptr;
 
     pessimistic_released_rdlock.clear();
@@ -102,6 +103,10 @@ class PessimisticTxnManager : public TransactionManager {
   void ReleaseReadLock(const storage::TileGroupHeader *const tile_group_header,
                        const oid_t &tuple_id);
 
+  // Release a read lock the txn still holds, in whichever way it was taken
+  void ReleaseReadLock(const storage::TileGroupHeader *const tile_group_header,
+                       const oid_t &tile_group_id, const oid_t &tuple_id);
+
 };
 }
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// read_write_set.cpp
+//
+// Identification: src/backend/concurrency/read_write_set.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+
+#include "backend/common/macros.h"
+#include "backend/concurrency/read_write_set.h"
+
+namespace peloton {
+namespace concurrency {
+
+namespace {
+
+// Set once the pool of the thread is gone, e.g. when a txn is destroyed
+// during thread exit
+thread_local bool buffer_pool_destroyed = false;
+
+// Released buffers of the thread, reused by its next txns
+class RWSetBufferPool {
+ public:
+  ~RWSetBufferPool() { buffer_pool_destroyed = true; }
+
+  RWSetBuffer *Acquire() {
+    if (buffers_.empty()) {
+      return new RWSetBuffer();
+    }
+    auto buffer = buffers_.back().release();
+    buffers_.pop_back();
+    return buffer;
+  }
+
+  void Release(RWSetBuffer *buffer) {
+    if (buffers_.size() >= RW_SET_POOL_SIZE ||
+        buffer->entries.capacity() > RW_SET_MAX_POOLED_ENTRIES) {
+      delete buffer;
+      return;
+    }
+
+    buffer->entries.clear();
+    buffer->slots.clear();
+    buffers_.emplace_back(buffer);
+  }
+
+ private:
+  std::vector<std::unique_ptr<RWSetBuffer>> buffers_;
+};
+
+thread_local RWSetBufferPool buffer_pool;
+
+bool EntryLess(const RWSetEntry &lhs, const RWSetEntry &rhs) {
+  if (lhs.tile_group_id != rhs.tile_group_id) {
+    return lhs.tile_group_id < rhs.tile_group_id;
+  }
+  return lhs.tuple_id < rhs.tuple_id;
+}
+
+}  // End anonymous namespace
+
+void ReadWriteSet::Iterator::Seek(const RWSetEntry *position) {
+  auto group_end = position;
+  while (group_end != end_ &&
+         group_end->tile_group_id == position->tile_group_id) {
+    group_end++;
+  }
+  access_ = TileGroupAccess(position, group_end);
+}
+
+ReadWriteSet::ReadWriteSet()
+    : buffer_(buffer_pool.Acquire()), sorted_(true), indexed_(false) {}
+
+ReadWriteSet::~ReadWriteSet() {
+  // the txn may be destroyed by another thread, e.g. the one cleaning up
+  // finished txns, whose pool then takes the buffer
+  if (buffer_pool_destroyed) {
+    delete buffer_;
+  } else {
+    buffer_pool.Release(buffer_);
+  }
+}
+
+RWSetEntry *ReadWriteSet::Find(const oid_t tile_group_id,
+                               const oid_t tuple_id) {
+  auto &entries = buffer_->entries;
+
+  if (entries.size() <= RW_SET_LINEAR_SEARCH_SIZE) {
+    for (auto &entry : entries) {
+      if (entry.tile_group_id == tile_group_id && entry.tuple_id == tuple_id) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  if (indexed_ == false) {
+    BuildIndex();
+  }
+
+  auto &slots = buffer_->slots;
+  size_t mask = slots.size() - 1;
+  size_t slot = Hash(tile_group_id, tuple_id) & mask;
+  while (slots[slot] != 0) {
+    auto &entry = entries[slots[slot] - 1];
+    if (entry.tile_group_id == tile_group_id && entry.tuple_id == tuple_id) {
+      return &entry;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return nullptr;
+}
+
+void ReadWriteSet::Insert(const oid_t tile_group_id, const oid_t tuple_id,
+                          const RWType type) {
+  PL_ASSERT(Find(tile_group_id, tuple_id) == nullptr);
+  auto &entries = buffer_->entries;
+
+  if (sorted_ == true && entries.empty() == false) {
+    auto &last = entries.back();
+    sorted_ = (last.tile_group_id < tile_group_id ||
+               (last.tile_group_id == tile_group_id &&
+                last.tuple_id < tuple_id));
+  }
+
+  entries.push_back({tile_group_id, tuple_id, type});
+
+  // keep the index up to date once lookups use it; grow it at half load
+  if (indexed_ == true) {
+    if (entries.size() * 2 > buffer_->slots.size()) {
+      BuildIndex();
+    } else {
+      IndexEntry(entries.size() - 1);
+    }
+  }
+}
+
+void ReadWriteSet::Erase(RWSetEntry *entry) {
+  auto &entries = buffer_->entries;
+  PL_ASSERT(entry >= entries.data() && entry < entries.data() + entries.size());
+
+  if (entry != &entries.back()) {
+    *entry = entries.back();
+    sorted_ = false;
+  }
+  entries.pop_back();
+
+  // the moved entry is indexed at its old offset, so the index is rebuilt
+  // on the next lookup
+  indexed_ = false;
+}
+
+void ReadWriteSet::Clear() {
+  auto &entries = buffer_->entries;
+
+  // do not let one large txn pin its storage
+  if (entries.capacity() > RW_SET_MAX_POOLED_ENTRIES) {
+    std::vector<RWSetEntry>().swap(entries);
+    std::vector<uint32_t>().swap(buffer_->slots);
+  } else {
+    entries.clear();
+    buffer_->slots.clear();
+  }
+
+  sorted_ = true;
+  indexed_ = false;
+}
+
+void ReadWriteSet::Sort() {
+  if (sorted_ == true) {
+    return;
+  }
+
+  auto &entries = buffer_->entries;
+  std::sort(entries.begin(), entries.end(), EntryLess);
+  sorted_ = true;
+
+  // entries moved, so the index is rebuilt on the next lookup
+  indexed_ = false;
+}
+
+ReadWriteSet::Iterator ReadWriteSet::begin() const {
+  PL_ASSERT(sorted_ == true);
+  auto &entries = buffer_->entries;
+  return Iterator(entries.data(), entries.data() + entries.size());
+}
+
+ReadWriteSet::Iterator ReadWriteSet::end() const {
+  auto &entries = buffer_->entries;
+  return Iterator(entries.data() + entries.size(),
+                  entries.data() + entries.size());
+}
+
+void ReadWriteSet::BuildIndex() {
+  auto &slots = buffer_->slots;
+  size_t slot_count = RW_SET_LINEAR_SEARCH_SIZE * 2;
+  while (slot_count < buffer_->entries.size() * 4) {
+    slot_count *= 2;
+  }
+
+  slots.assign(slot_count, 0);
+  for (uint32_t entry_offset = 0; entry_offset < buffer_->entries.size();
+       entry_offset++) {
+    IndexEntry(entry_offset);
+  }
+  indexed_ = true;
+}
+
+void ReadWriteSet::IndexEntry(const uint32_t entry_offset) {
+  auto &slots = buffer_->slots;
+  auto &entry = buffer_->entries[entry_offset];
+
+  size_t mask = slots.size() - 1;
+  size_t slot = Hash(entry.tile_group_id, entry.tuple_id) & mask;
+  while (slots[slot] != 0) {
+    slot = (slot + 1) & mask;
+  }
+  slots[slot] = entry_offset + 1;
+}
+
+}  // End concurrency namespace
+}  // End peloton namespace
@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// read_write_set.h
+//
+// Identification: src/backend/concurrency/read_write_set.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "backend/common/types.h"
+
+namespace peloton {
+namespace concurrency {
+
+enum RWType {
+  RW_TYPE_READ,
+  RW_TYPE_UPDATE,
+  RW_TYPE_INSERT,
+  RW_TYPE_DELETE,
+  RW_TYPE_INS_DEL  // delete after insert.
+};
+
+// Up to this many entries a lookup scans the entries instead of hashing
+#define RW_SET_LINEAR_SEARCH_SIZE 16
+
+// Number of released buffers a thread keeps for its next txns
+#define RW_SET_POOL_SIZE 4
+
+// Buffers that grew beyond this many entries are freed, not pooled
+#define RW_SET_MAX_POOLED_ENTRIES 4096
+
+//===--------------------------------------------------------------------===//
+// Read/Write Set
+//===--------------------------------------------------------------------===//
+
+struct RWSetEntry {
+  oid_t tile_group_id;
+  oid_t tuple_id;
+  RWType type;
+};
+
+// Storage of a read/write set, recycled across the txns of a thread
+struct RWSetBuffer {
+  std::vector<RWSetEntry> entries;
+
+  // Open-addressed index over the entries; a slot holds entry offset + 1,
+  // zero marks an empty slot
+  std::vector<uint32_t> slots;
+};
+
+/**
+ * The tuples a transaction accessed, as a flat array of
+ * (tile group, tuple, RWType) entries.
+ *
+ * Entries are appended as the txn runs and looked up through an
+ * open-addressed index once the set outgrows a linear scan. The arrays
+ * come from a per-thread pool and go back to it, cleared but not freed,
+ * when the set is destroyed, so a short txn does not allocate at all.
+ *
+ * Validation and commit iterate the set sorted by tile group and tuple,
+ * grouped by tile group so each tile group header is fetched once.
+ */
+class ReadWriteSet {
+  ReadWriteSet(ReadWriteSet const &) = delete;
+  ReadWriteSet &operator=(ReadWriteSet const &) = delete;
+
+ public:
+  // The entries of one tile group, in tuple order
+  class TileGroupAccess {
+   public:
+    TileGroupAccess() : begin_(nullptr), end_(nullptr) {}
+
+    TileGroupAccess(const RWSetEntry *begin, const RWSetEntry *end)
+        : begin_(begin), end_(end) {}
+
+    oid_t GetTileGroupId() const { return begin_->tile_group_id; }
+
+    const RWSetEntry *begin() const { return begin_; }
+
+    const RWSetEntry *end() const { return end_; }
+
+   private:
+    const RWSetEntry *begin_;
+    const RWSetEntry *end_;
+  };
+
+  class Iterator {
+   public:
+    Iterator(const RWSetEntry *position, const RWSetEntry *end)
+        : end_(end) {
+      Seek(position);
+    }
+
+    const TileGroupAccess &operator*() const { return access_; }
+
+    const TileGroupAccess *operator->() const { return &access_; }
+
+    Iterator &operator++() {
+      Seek(access_.end());
+      return *this;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return access_.begin() == other.access_.begin();
+    }
+
+    bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+   private:
+    void Seek(const RWSetEntry *position);
+
+    const RWSetEntry *end_;
+    TileGroupAccess access_;
+  };
+
+  ReadWriteSet();
+
+  ~ReadWriteSet();
+
+  // Entry of the tuple, nullptr if the txn has not accessed it
+  RWSetEntry *Find(const oid_t tile_group_id, const oid_t tuple_id);
+
+  // Add an entry for a tuple the txn has not accessed yet
+  void Insert(const oid_t tile_group_id, const oid_t tuple_id,
+              const RWType type);
+
+  // Drop the entry, the last entry takes its place
+  void Erase(RWSetEntry *entry);
+
+  // Offset of the entry. Until the set is sorted, an entry only moves when
+  // an earlier one is erased while it is the last.
+  size_t GetOffset(const RWSetEntry *entry) const {
+    return entry - buffer_->entries.data();
+  }
+
+  size_t GetSize() const { return buffer_->entries.size(); }
+
+  bool IsEmpty() const { return buffer_->entries.empty(); }
+
+  // Drop all entries but keep the storage for the next txn
+  void Clear();
+
+  // Order the entries by tile group and tuple for iteration
+  void Sort();
+
+  // Iterate over the tile groups, the set must be sorted
+  Iterator begin() const;
+
+  Iterator end() const;
+
+ private:
+  void BuildIndex();
+
+  void IndexEntry(const uint32_t entry_offset);
+
+  static uint64_t Hash(const oid_t tile_group_id, const oid_t tuple_id) {
+    uint64_t key = ((uint64_t)tile_group_id << 32) | tuple_id;
+    return (key * 0x9E3779B97F4A7C15ULL) >> 32;
+  }
+
+  RWSetBuffer *buffer_;
+
+  // Whether the entries are in tile group and tuple order
+  bool sorted_;
+
+  // Whether the slots index all the entries
+  bool indexed_;
+};
+
+}  // End concurrency namespace
+}  // End peloton namespace
@@ -101,10 +101,14 @@ class SpeculativeReadTxnManager : public TransactionManager {
 
   virtual void PerformDelete(const ItemPointer &location);
 
+  // Speculative reads register commit dependencies, so read-only txns
+  // take the regular path
+  virtual Transaction *BeginReadOnlyTransaction() { return BeginTransaction(); }
+
   virtual Transaction *BeginTransaction() {
     txn_id_t txn_id = GetNextTransactionId();
     cid_t begin_cid = GetNextCommitId();
-    Transaction *txn = new Transaction(txn_id, begin_cid);
+    Transaction *txn = AllocateTransaction(txn_id, begin_cid);
     current_txn = txn;
     spec_txn_context.SetBeginCid(begin_cid);
 
@@ -122,7 +126,7 @@ class SpeculativeReadTxnManager : public TransactionManager {
 
     spec_txn_context.Clear();
 
-    delete current_txn;
+    ReleaseTransaction(current_txn);
     current_txn = nullptr;
   }
 
@@ -103,7 +103,7 @@ bool SsiTxnManager::IsOwnable(
 
 bool SsiTxnManager::AcquireOwnership(
     const storage::TileGroupHeader *const tile_group_header,
-    const oid_t &tile_group_id UNUSED_ATTRIBUTE, const oid_t &tuple_id) {
+    const oid_t &tile_group_id, const oid_t &tuple_id) {
   auto txn_id = current_txn->GetTransactionId();
   LOG_TRACE("AcquireOwnership %lu", txn_id);
 
@@ -119,57 +119,67 @@ bool SsiTxnManager::AcquireOwnership(
     return false;
   }
 
-  {
-    GetReadLock(tile_group_header, tuple_id);
-    ReadList *header = GetReaderList(tile_group_header, tuple_id);
-
-    bool should_abort = false;
-    while (header != nullptr) {
-      // For all owner of siread lock on this version
-      auto owner_ctx = header->txn_ctx;
-
-      // Lock the transaction context
-      owner_ctx->lock_.Lock();
-
-      // Myself || owner is (or should be) aborted
-      // skip
-      if (owner_ctx == current_ssi_txn_ctx || owner_ctx->is_abort()) {
-        header = header->next;
-
-        // Unlock the transaction context
-        owner_ctx->lock_.Unlock();
-        continue;
-      }
+  // Readers of the version itself
+  GetReadLock(tile_group_header, tuple_id);
+  bool no_conflict =
+      AddReaderEdges(GetReaderList(tile_group_header, tuple_id));
+  ReleaseReadLock(tile_group_header, tuple_id);
+  if (no_conflict == false) return false;
+
+  // Readers that locked the whole tile group
+  auto &partition = GetSIReadPartition(tile_group_id);
+  partition.lock_.Lock();
+  auto itr = partition.readers_.find(tile_group_id);
+  if (itr != partition.readers_.end()) {
+    no_conflict = AddReaderEdges(itr->second);
+  }
+  partition.lock_.Unlock();
 
-      auto end_cid = owner_ctx->transaction_->GetEndCommitId();
+  return no_conflict;
+}
 
-      // Owner is running, then siread lock owner has an out edge to me
-      if (end_cid == MAX_CID) {
-        SetInConflict(current_ssi_txn_ctx);
-        SetOutConflict(owner_ctx);
-        LOG_TRACE("set %ld in, set %ld out", txn_id,
-                 owner_ctx->transaction_->GetTransactionId());
-      } else {
-        // Owner has commited and ownner commit after I start, then I must abort
-        if (end_cid > current_txn->GetBeginCommitId() &&
-            GetInConflict(owner_ctx) && !owner_ctx->is_abort()) {
-          should_abort = true;
-          LOG_TRACE("abort in acquire");
+bool SsiTxnManager::AddReaderEdges(ReadList *header) {
+  while (header != nullptr) {
+    // For all owner of siread lock on this version
+    auto owner_ctx = header->txn_ctx;
 
-          // Unlock the transaction context
-          owner_ctx->lock_.Unlock();
-          break;
-        }
-      }
+    // Lock the transaction context
+    owner_ctx->lock_.Lock();
 
+    // Myself || owner is (or should be) aborted
+    // skip
+    if (owner_ctx == current_ssi_txn_ctx || owner_ctx->is_abort()) {
       header = header->next;
 
       // Unlock the transaction context
       owner_ctx->lock_.Unlock();
+      continue;
     }
-    ReleaseReadLock(tile_group_header, tuple_id);
 
-    if (should_abort) return false;
+    auto end_cid = owner_ctx->transaction_->GetEndCommitId();
+
+    // Owner is running, then siread lock owner has an out edge to me
+    if (end_cid == MAX_CID) {
+      SetInConflict(current_ssi_txn_ctx);
+      SetOutConflict(owner_ctx);
+      LOG_TRACE("set %ld in, set %ld out", current_txn->GetTransactionId(),
+               owner_ctx->transaction_->GetTransactionId());
+    } else {
+      // Owner has commited and ownner commit after I start, then I must abort
+      if (end_cid > current_txn->GetBeginCommitId() &&
+          GetInConflict(owner_ctx) && !owner_ctx->is_abort()) {
+        LOG_TRACE("abort in acquire");
+
+        // Unlock the transaction context
+        owner_ctx->lock_.Unlock();
+        return false;
+      }
+    }
+
+    header = header->next;
+
+    // Unlock the transaction context
+    owner_ctx->lock_.Unlock();
   }
 
   return true;
@@ -193,13 +203,18 @@ bool SsiTxnManager::PerformRead(const ItemPointer &location){
 
   auto txn_id = current_txn->GetTransactionId();
 
-  auto &rw_set = current_txn->GetRWSet();
-  if (rw_set.count(tile_group_id) == 0 ||
-      rw_set.at(tile_group_id).count(tuple_id) == 0) {
+  if (current_txn->IsAccessed(tile_group_id, tuple_id) == false) {
     LOG_TRACE("Not read before");
     // Previously, this tuple hasn't been read, add the txn to the reader list
-    // of the tuple
-    AddSIReader(tile_group.get(), tuple_id);
+    // of the tuple, until it has read enough of the tile group to lock all
+    // of it instead
+    auto &read_count = current_ssi_txn_ctx->tile_group_reads_[tile_group_id];
+    if (read_count < SSI_SIREAD_ESCALATION_THRESHOLD) {
+      AddSIReader(tile_group.get(), tuple_id);
+      if (++read_count == SSI_SIREAD_ESCALATION_THRESHOLD) {
+        AddTileGroupSIReader(tile_group_id);
+      }
+    }
 
     auto writer = tile_group_header->GetTransactionId(tuple_id);
     // Another transaction is writting this tuple, add an edge
@@ -457,12 +472,12 @@ Result SsiTxnManager::CommitTransaction() {
   log_manager.LogBeginTransaction(end_commit_id);
   // install everything.
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
         // we must guarantee that, at any time point, only one version is
         // visible.
         // we do not change begin cid for old tuple.
@@ -483,7 +498,7 @@ Result SsiTxnManager::CommitTransaction() {
         new_tile_group_header->SetTransactionId(new_version.offset,
                                                 INITIAL_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         // we do not change begin cid for old tuple.
         tile_group_header->SetEndCommitId(tuple_slot, end_commit_id);
         ItemPointer new_version =
@@ -502,7 +517,7 @@ Result SsiTxnManager::CommitTransaction() {
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
                current_txn->GetTransactionId());
         // set the begin commit id to persist insert
@@ -515,7 +530,7 @@ Result SsiTxnManager::CommitTransaction() {
         COMPILER_MEMORY_FENCE;
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
                current_txn->GetTransactionId());
 
@@ -556,13 +571,13 @@ Result SsiTxnManager::AbortTransaction() {
   auto &rw_set = current_txn->GetRWSet();
 
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     auto tile_group_header = tile_group->GetHeader();
 
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
-      if (tuple_entry.second == RW_TYPE_UPDATE) {
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
+      if (tuple_entry.type == RW_TYPE_UPDATE) {
         // we do not set begin cid for old tuple.
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         ItemPointer new_version =
@@ -580,7 +595,7 @@ Result SsiTxnManager::AbortTransaction() {
                  tuple_slot);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
-      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+      } else if (tuple_entry.type == RW_TYPE_DELETE) {
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
         ItemPointer new_version =
             tile_group_header->GetNextItemPointer(tuple_slot);
@@ -594,14 +609,14 @@ Result SsiTxnManager::AbortTransaction() {
         new_tile_group_header->SetTransactionId(new_version.offset,
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
-      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+      } else if (tuple_entry.type == RW_TYPE_INSERT) {
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
 
         COMPILER_MEMORY_FENCE;
 
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
-      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+      } else if (tuple_entry.type == RW_TYPE_INS_DEL) {
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
         tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
 
@@ -613,7 +628,7 @@ Result SsiTxnManager::AbortTransaction() {
   }
 
 
-  RemoveReader(current_txn);
+  RemoveReader(current_ssi_txn_ctx);
 
   if(current_ssi_txn_ctx->transaction_->GetEndCommitId() == MAX_CID) {
     current_ssi_txn_ctx->transaction_->SetEndCommitId(GetNextCommitId());
@@ -630,30 +645,42 @@ Result SsiTxnManager::AbortTransaction() {
   return Result::RESULT_ABORTED;
 }
 
-void SsiTxnManager::RemoveReader(Transaction *txn) {
+void SsiTxnManager::RemoveReader(SsiTxnContext *txn_ctx) {
   LOG_TRACE("release SILock");
 
   // Remove from the read list of accessed tuples
-  auto &rw_set = txn->GetRWSet();
+  auto &rw_set = txn_ctx->transaction_->GetRWSet();
 
   for (auto &tile_group_entry : rw_set) {
-    oid_t tile_group_id = tile_group_entry.first;
+    oid_t tile_group_id = tile_group_entry.GetTileGroupId();
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tile_group_id);
     if (tile_group == nullptr) continue;
 
+    // after escalation the tuples read are not on the reader lists
+    auto read_count = txn_ctx->tile_group_reads_.find(tile_group_id);
+    bool escalated = (read_count != txn_ctx->tile_group_reads_.end() &&
+                      read_count->second >= SSI_SIREAD_ESCALATION_THRESHOLD);
+
     auto tile_group_header = tile_group->GetHeader();
-    for (auto &tuple_entry : tile_group_entry.second) {
-      auto tuple_slot = tuple_entry.first;
+    for (auto &tuple_entry : tile_group_entry) {
+      auto tuple_slot = tuple_entry.tuple_id;
 
       // we don't have reader lock on insert
-      if (tuple_entry.second == RW_TYPE_INSERT ||
-          tuple_entry.second == RW_TYPE_INS_DEL) {
+      if (tuple_entry.type == RW_TYPE_INSERT ||
+          tuple_entry.type == RW_TYPE_INS_DEL) {
         continue;
       }
-      RemoveSIReader(tile_group_header, tuple_slot, txn->GetTransactionId());
+      bool find = RemoveSIReader(tile_group_header, tuple_slot, txn_ctx);
+      if (find == false && escalated == false) {
+        PL_ASSERT(false);
+      }
     }
   }
+
+  for (auto tile_group_id : txn_ctx->siread_tile_groups_) {
+    RemoveTileGroupSIReader(tile_group_id, txn_ctx);
+  }
   LOG_TRACE("release SILock finish");
 }
 
@@ -675,8 +702,9 @@ void SsiTxnManager::CleanUp() {
       txn_table_.erase(ctx_ptr->transaction_->GetTransactionId());
       gc_cids.insert(it.first);
 
-      if (!ctx_ptr->is_abort()) {
-        RemoveReader(ctx_ptr->transaction_);
+      // aborted txns released their SIREAD locks in AbortTransaction
+      if (!ctx_ptr->is_abort_) {
+        RemoveReader(ctx_ptr);
       }
       delete ctx_ptr->transaction_;
       delete ctx_ptr;
@@ -707,8 +735,8 @@ void SsiTxnManager::CleanUpBg() {
 
       gc_cids.insert(gc_cid);
 
-      if(!ctx_ptr->is_abort()) {
-        RemoveReader(ctx_ptr->transaction_);
+      if (!ctx_ptr->is_abort_) {
+        RemoveReader(ctx_ptr);
       }
       delete ctx_ptr->transaction_;
       delete ctx_ptr;
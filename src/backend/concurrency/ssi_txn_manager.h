@@ -17,11 +17,22 @@
 #include "backend/catalog/manager.h"
 #include "libcuckoo/cuckoohash_map.hh"
 
-#include <map>
+#include <deque>
+#include <unordered_map>
+#include <vector>
 
 namespace peloton {
 namespace concurrency {
 
+// Reads of one tile group after which a txn takes a single SIREAD lock on
+// the whole tile group instead of one per tuple
+#define SSI_SIREAD_ESCALATION_THRESHOLD 32
+
+// Number of partitions of the tile group SIREAD lock table
+#define SSI_SIREAD_PARTITION_COUNT 64
+
+struct ReadList;
+
 struct SsiTxnContext {
   SsiTxnContext(Transaction *t)
       : transaction_(t),
@@ -42,6 +53,15 @@ struct SsiTxnContext {
   bool is_abort_;
   bool is_finish_;  // is commit finished
   Spinlock lock_;
+
+  // Nodes of the reader lists the txn is on, freed with the context
+  std::deque<ReadList> siread_nodes_;
+
+  // Number of tuples the txn read per tile group
+  std::unordered_map<oid_t, size_t> tile_group_reads_;
+
+  // Tile groups the txn holds a tile group SIREAD lock on
+  std::vector<oid_t> siread_tile_groups_;
 };
 
 extern thread_local SsiTxnContext *current_ssi_txn_ctx;
@@ -53,12 +73,12 @@ struct ReadList {
   ReadList(SsiTxnContext *t) : txn_ctx(t), next(nullptr) {}
 };
 
-struct SIReadLock {
-  SIReadLock() : list(nullptr) {}
-  ReadList *list;
-  Spinlock lock;
-  void Lock() { lock.Lock(); }
-  void Unlock() { lock.Unlock(); }
+// One partition of the tile group SIREAD lock table
+struct SIReadPartition {
+  Spinlock lock_;
+  std::unordered_map<oid_t, ReadList *> readers_;
+
+  CACHE_PADOUT;
 };
 
 class SsiTxnManager : public TransactionManager {
@@ -107,6 +127,10 @@ class SsiTxnManager : public TransactionManager {
 
   virtual void PerformDelete(const ItemPointer &location);
 
+  // A read-only txn on a plain snapshot can still close a dangerous
+  // structure, so its reads are tracked like any other
+  virtual Transaction *BeginReadOnlyTransaction() { return BeginTransaction(); }
+
   virtual Transaction *BeginTransaction() {
     // txn_manager_mutex_.WriteLock();
 
@@ -142,7 +166,7 @@ class SsiTxnManager : public TransactionManager {
   virtual Result AbortTransaction();
 
  private:
-  // Mutex to protect txn_table_ and sireadlocks
+  // Mutex to protect txn_table_
   // RWLock txn_manager_mutex_;
   // mutex to avoid re-enter clean up
   std::mutex clean_mutex_;
@@ -152,9 +176,9 @@ class SsiTxnManager : public TransactionManager {
   cuckoohash_map<cid_t, SsiTxnContext *> end_txn_table_;
 
   cid_t gc_cid;
-  // SIReadLocks
-  typedef std::map<oid_t, std::unique_ptr<SIReadLock>> TupleReadlocks;
-  std::map<std::pair<oid_t, oid_t>, std::unique_ptr<SIReadLock>> sireadlocks;
+  // SIREAD locks of txns that escalated to whole tile groups, partitioned
+  // by tile group id. Tuple SIREAD locks live in the tuple headers.
+  SIReadPartition siread_partitions_[SSI_SIREAD_PARTITION_COUNT];
   // Used to make the vacuum thread stop
   bool stopped;
   bool cleaned;
@@ -203,51 +227,110 @@ class SsiTxnManager : public TransactionManager {
     lock->Unlock();
   }
 
-  // Add the current txn into the reader list of a tuple
+  // Add the current txn into the reader list of a tuple. Readers push
+  // with a CAS and do not take the lock of the list, which only serializes
+  // the writers scanning the list and the txns leaving it.
   void AddSIReader(storage::TileGroup *tile_group, const oid_t &tuple_id) {
-    ReadList *reader = new ReadList(current_ssi_txn_ctx);
+    current_ssi_txn_ctx->siread_nodes_.emplace_back(current_ssi_txn_ctx);
+    ReadList *reader = &current_ssi_txn_ctx->siread_nodes_.back();
 
-    GetReadLock(tile_group->GetHeader(), tuple_id);
     ReadList **headp = (ReadList **)(
         tile_group->GetHeader()->GetReservedFieldRef(tuple_id) + LIST_OFFSET);
-    reader->next = *headp;
-    *headp = reader;
-    ReleaseReadLock(tile_group->GetHeader(), tuple_id);
+    ReadList *head;
+    do {
+      head = *(ReadList *volatile *)headp;
+      reader->next = head;
+    } while (__sync_bool_compare_and_swap(headp, head, reader) == false);
   }
 
   // Remove reader from the reader list of a tuple
-  void RemoveSIReader(storage::TileGroupHeader *tile_group_header,
-                      const oid_t &tuple_id, txn_id_t txn_id) {
+  bool RemoveSIReader(storage::TileGroupHeader *tile_group_header,
+                      const oid_t &tuple_id, SsiTxnContext *txn_ctx) {
     LOG_TRACE("Acquire read lock");
     GetReadLock(tile_group_header, tuple_id);
     LOG_TRACE("Acquired");
 
     ReadList **headp = (ReadList **)(
         tile_group_header->GetReservedFieldRef(tuple_id) + LIST_OFFSET);
-
-    ReadList fake_header;
-    fake_header.next = *headp;
-    auto prev = &fake_header;
-    auto next = prev->next;
     bool find = false;
 
-    while (next != nullptr) {
-      if (next->txn_ctx->transaction_->GetTransactionId() == txn_id) {
-        find = true;
-        prev->next = next->next;
-        delete next;
+    for (;;) {
+      ReadList *head = *(ReadList *volatile *)headp;
+      if (head == nullptr) {
         break;
       }
-      prev = next;
-      next = next->next;
-    }
 
-    *headp = fake_header.next;
+      // readers may push concurrently, so the head is swapped out
+      if (head->txn_ctx == txn_ctx) {
+        if (__sync_bool_compare_and_swap(headp, head, head->next)) {
+          find = true;
+          break;
+        }
+        continue;
+      }
+
+      // past the head the links only change under the lock
+      auto prev = head;
+      auto next = head->next;
+      while (next != nullptr) {
+        if (next->txn_ctx == txn_ctx) {
+          find = true;
+          prev->next = next->next;
+          break;
+        }
+        prev = next;
+        next = next->next;
+      }
+      break;
+    }
 
     ReleaseReadLock(tile_group_header, tuple_id);
-    if (find == false) {
-      PL_ASSERT(false);
+    return find;
+  }
+
+  SIReadPartition &GetSIReadPartition(const oid_t tile_group_id) {
+    return siread_partitions_[tile_group_id % SSI_SIREAD_PARTITION_COUNT];
+  }
+
+  // Add the current txn into the reader list of a whole tile group
+  void AddTileGroupSIReader(const oid_t tile_group_id) {
+    current_ssi_txn_ctx->siread_nodes_.emplace_back(current_ssi_txn_ctx);
+    ReadList *reader = &current_ssi_txn_ctx->siread_nodes_.back();
+
+    auto &partition = GetSIReadPartition(tile_group_id);
+    partition.lock_.Lock();
+    auto &head = partition.readers_[tile_group_id];
+    reader->next = head;
+    head = reader;
+    partition.lock_.Unlock();
+
+    current_ssi_txn_ctx->siread_tile_groups_.push_back(tile_group_id);
+  }
+
+  void RemoveTileGroupSIReader(const oid_t tile_group_id,
+                               SsiTxnContext *txn_ctx) {
+    auto &partition = GetSIReadPartition(tile_group_id);
+    partition.lock_.Lock();
+
+    auto itr = partition.readers_.find(tile_group_id);
+    PL_ASSERT(itr != partition.readers_.end());
+
+    ReadList fake_header;
+    fake_header.next = itr->second;
+    auto prev = &fake_header;
+    while (prev->next != nullptr && prev->next->txn_ctx != txn_ctx) {
+      prev = prev->next;
     }
+    PL_ASSERT(prev->next != nullptr);
+    prev->next = prev->next->next;
+
+    if (fake_header.next == nullptr) {
+      partition.readers_.erase(itr);
+    } else {
+      itr->second = fake_header.next;
+    }
+
+    partition.lock_.Unlock();
   }
 
   ReadList *GetReaderList(
@@ -275,7 +358,11 @@ class SsiTxnManager : public TransactionManager {
     txn_ctx->out_conflict_ = true;
   }
 
-  void RemoveReader(Transaction *txn);
+  // Add the rw-edges from the readers to the current txn, which is about
+  // to write the version they read. Returns false if it must abort.
+  bool AddReaderEdges(ReadList *readers);
+
+  void RemoveReader(SsiTxnContext *txn_ctx);
 
   // Free contexts for SSI manager
   void CleanUpBg();
@@ -28,26 +28,25 @@ void Transaction::RecordRead(const ItemPointer &location) {
   oid_t tile_group_id = location.block;
   oid_t tuple_id = location.offset;
 
-  if (rw_set_.find(tile_group_id) != rw_set_.end() &&
-      rw_set_.at(tile_group_id).find(tuple_id) !=
-          rw_set_.at(tile_group_id).end()) {
-    PL_ASSERT(rw_set_.at(tile_group_id).at(tuple_id) != RW_TYPE_DELETE &&
-           rw_set_.at(tile_group_id).at(tuple_id) != RW_TYPE_INS_DEL);
+  auto entry = rw_set_.Find(tile_group_id, tuple_id);
+  if (entry != nullptr) {
+    PL_ASSERT(entry->type != RW_TYPE_DELETE &&
+           entry->type != RW_TYPE_INS_DEL);
     return;
   } else {
-    rw_set_[tile_group_id][tuple_id] = RW_TYPE_READ;
+    rw_set_.Insert(tile_group_id, tuple_id, RW_TYPE_READ);
   }
 }
 
 void Transaction::RecordUpdate(const ItemPointer &location) {
+  PL_ASSERT(read_only_snapshot_ == false);
 
   oid_t tile_group_id = location.block;
   oid_t tuple_id = location.offset;
 
-  if (rw_set_.find(tile_group_id) != rw_set_.end() &&
-      rw_set_.at(tile_group_id).find(tuple_id) !=
-          rw_set_.at(tile_group_id).end()) {
-    RWType &type = rw_set_.at(tile_group_id).at(tuple_id);
+  auto entry = rw_set_.Find(tile_group_id, tuple_id);
+  if (entry != nullptr) {
+    RWType &type = entry->type;
     if (type == RW_TYPE_READ) {
       type = RW_TYPE_UPDATE;
       // record write.
@@ -65,33 +64,35 @@ void Transaction::RecordUpdate(const ItemPointer &location) {
       return;
     }
     PL_ASSERT(false);
+  } else {
+    // an escrow operation updates the newest version without reading it
+    rw_set_.Insert(tile_group_id, tuple_id, RW_TYPE_UPDATE);
+    is_written_ = true;
   }
 }
 
 void Transaction::RecordInsert(const ItemPointer &location) {
+  PL_ASSERT(read_only_snapshot_ == false);
 
   oid_t tile_group_id = location.block;
   oid_t tuple_id = location.offset;
 
-  if (rw_set_.find(tile_group_id) != rw_set_.end() &&
-      rw_set_.at(tile_group_id).find(tuple_id) !=
-          rw_set_.at(tile_group_id).end()) {
-    // RWType &type = rw_set_.at(tile_group_id).at(tuple_id);
+  if (rw_set_.Find(tile_group_id, tuple_id) != nullptr) {
     PL_ASSERT(false);
   } else {
-    rw_set_[tile_group_id][tuple_id] = RW_TYPE_INSERT;
+    rw_set_.Insert(tile_group_id, tuple_id, RW_TYPE_INSERT);
     ++insert_count_;
   }
 }
 
 bool Transaction::RecordDelete(const ItemPointer &location) {
+  PL_ASSERT(read_only_snapshot_ == false);
   oid_t tile_group_id = location.block;
   oid_t tuple_id = location.offset;
 
-  if (rw_set_.find(tile_group_id) != rw_set_.end() &&
-      rw_set_.at(tile_group_id).find(tuple_id) !=
-          rw_set_.at(tile_group_id).end()) {
-    RWType &type = rw_set_.at(tile_group_id).at(tuple_id);
+  auto entry = rw_set_.Find(tile_group_id, tuple_id);
+  if (entry != nullptr) {
+    RWType &type = entry->type;
     if (type == RW_TYPE_READ) {
       type = RW_TYPE_DELETE;
       // record write.
@@ -118,7 +119,53 @@ bool Transaction::RecordDelete(const ItemPointer &location) {
   return false;
 }
 
-const std::map<oid_t, std::map<oid_t, RWType>> &Transaction::GetRWSet() {
+void Transaction::RecordEscrowAdd(storage::DataTable *table,
+                                  const ItemPointer &location,
+                                  const oid_t column_id, const Value &delta,
+                                  const size_t access_count) {
+  PL_ASSERT(read_only_snapshot_ == false);
+
+  for (auto &escrow_operation : escrow_operations_) {
+    if (escrow_operation.location.block == location.block &&
+        escrow_operation.location.offset == location.offset &&
+        escrow_operation.column_id == column_id) {
+      escrow_operation.delta = escrow_operation.delta.OpAdd(delta);
+      return;
+    }
+  }
+
+  auto entry = rw_set_.Find(location.block, location.offset);
+  bool scan_read = entry != nullptr && entry->type == RW_TYPE_READ &&
+                   rw_set_.GetOffset(entry) >= access_count;
+
+  escrow_operations_.push_back({table, location, column_id, delta, scan_read});
+  is_written_ = true;
+}
+
+void Transaction::EraseRead(const ItemPointer &location) {
+  auto entry = rw_set_.Find(location.block, location.offset);
+  if (entry != nullptr && entry->type == RW_TYPE_READ) {
+    rw_set_.Erase(entry);
+  }
+}
+
+std::vector<EscrowOperation> Transaction::TakeEscrowOperations(
+    const storage::DataTable *table) {
+  std::vector<EscrowOperation> taken;
+  std::vector<EscrowOperation> kept;
+  for (auto &escrow_operation : escrow_operations_) {
+    if (table == nullptr || escrow_operation.table == table) {
+      taken.push_back(escrow_operation);
+    } else {
+      kept.push_back(escrow_operation);
+    }
+  }
+  escrow_operations_.swap(kept);
+  return taken;
+}
+
+const ReadWriteSet &Transaction::GetRWSet() {
+  rw_set_.Sort();
   return rw_set_;
 }
 
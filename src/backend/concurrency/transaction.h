@@ -22,22 +22,38 @@
 #include "backend/common/printable.h"
 #include "backend/common/types.h"
 #include "backend/common/exception.h"
+#include "backend/common/value.h"
+#include "backend/concurrency/read_write_set.h"
 
 namespace peloton {
+
+namespace storage {
+class DataTable;
+}
+
 namespace concurrency {
 
+// An ADD of a delta to a numeric column, applied to the newest version of
+// the tuple when the txn commits
+struct EscrowOperation {
+  storage::DataTable *table;
+
+  // the version the txn saw
+  ItemPointer location;
+
+  oid_t column_id;
+
+  Value delta;
+
+  // whether the statement's scan recorded the read of the version, which is
+  // validated against the newest version when the ADD is applied
+  bool scan_read;
+};
+
 //===--------------------------------------------------------------------===//
 // Transaction
 //===--------------------------------------------------------------------===//
 
-enum RWType {
-  RW_TYPE_READ,
-  RW_TYPE_UPDATE,
-  RW_TYPE_INSERT,
-  RW_TYPE_DELETE,
-  RW_TYPE_INS_DEL  // delete after insert.
-};
-
 class Transaction : public Printable {
   Transaction(Transaction const &) = delete;
 
@@ -45,6 +61,7 @@ class Transaction : public Printable {
   Transaction()
       : txn_id_(INVALID_TXN_ID),
         begin_cid_(INVALID_CID),
+        read_cid_(INVALID_CID),
         end_cid_(MAX_CID),
         is_written_(false),
         insert_count_(0) {}
@@ -52,6 +69,7 @@ class Transaction : public Printable {
   Transaction(const txn_id_t &txn_id)
       : txn_id_(txn_id),
         begin_cid_(INVALID_CID),
+        read_cid_(INVALID_CID),
         end_cid_(MAX_CID),
         is_written_(false),
         insert_count_(0) {}
@@ -59,12 +77,28 @@ class Transaction : public Printable {
   Transaction(const txn_id_t &txn_id, const cid_t &begin_cid)
       : txn_id_(txn_id),
         begin_cid_(begin_cid),
+        read_cid_(begin_cid),
         end_cid_(MAX_CID),
         is_written_(false),
         insert_count_(0) {}
 
   ~Transaction() {}
 
+  // Reuse the txn object for a new txn, keeping the rw set storage
+  void Reset(const txn_id_t &txn_id, const cid_t &begin_cid) {
+    txn_id_ = txn_id;
+    begin_cid_ = begin_cid;
+    read_cid_ = begin_cid;
+    end_cid_ = MAX_CID;
+    epoch_id_ = 0;
+    rw_set_.Clear();
+    escrow_operations_.clear();
+    result_ = peloton::RESULT_SUCCESS;
+    is_written_ = false;
+    insert_count_ = 0;
+    read_only_snapshot_ = false;
+  }
+
   //===--------------------------------------------------------------------===//
   // Mutators and Accessors
   //===--------------------------------------------------------------------===//
@@ -73,12 +107,23 @@ class Transaction : public Printable {
 
   inline cid_t GetBeginCommitId() const { return begin_cid_; }
 
+  // The txn sees the versions committed up to here. It starts out at the
+  // begin commit id, which stays the age of the txn.
+  inline cid_t GetReadCommitId() const { return read_cid_; }
+
   inline cid_t GetEndCommitId() const { return end_cid_; }
 
   inline size_t GetEpochId() const { return epoch_id_; }
 
   inline void SetEndCommitId(cid_t eid) { end_cid_ = eid; }
 
+  // Let a locking txn read the versions committed while it waited
+  inline void AdvanceReadCommitId(cid_t cid) {
+    if (cid > read_cid_) {
+      read_cid_ = cid;
+    }
+  }
+
   inline void SetEpochId(const size_t eid) { epoch_id_ = eid; }
 
   void RecordRead(const ItemPointer &);
@@ -90,7 +135,34 @@ class Transaction : public Printable {
   // Return true if we detect INS_DEL
   bool RecordDelete(const ItemPointer &);
 
-  const std::map<oid_t, std::map<oid_t, RWType>> &GetRWSet();
+  // Add the delta to the column at commit, merging it with an earlier ADD
+  // to the same column of the tuple. A read of the tuple recorded after the
+  // txn had accessed access_count tuples came from the statement's scan.
+  void RecordEscrowAdd(storage::DataTable *table, const ItemPointer &location,
+                       const oid_t column_id, const Value &delta,
+                       const size_t access_count);
+
+  // Drop the read of the tuple, once it has been validated
+  void EraseRead(const ItemPointer &location);
+
+  // Remove and return the ADDs to the table, or to all tables if nullptr
+  std::vector<EscrowOperation> TakeEscrowOperations(
+      const storage::DataTable *table);
+
+  bool HasEscrowOperations() const {
+    return escrow_operations_.empty() == false;
+  }
+
+  // Number of tuples the txn has accessed so far
+  size_t GetAccessCount() const { return rw_set_.GetSize(); }
+
+  // Whether the txn has already accessed the tuple
+  bool IsAccessed(const oid_t &tile_group_id, const oid_t &tuple_id) {
+    return rw_set_.Find(tile_group_id, tuple_id) != nullptr;
+  }
+
+  // The accessed tuples, sorted by tile group and tuple
+  const ReadWriteSet &GetRWSet();
 
   // Get a string representation for debugging
   const std::string GetInfo() const;
@@ -105,6 +177,11 @@ class Transaction : public Printable {
     return is_written_ == false && insert_count_ == 0;
   }
 
+  // A read-only snapshot txn reads as of its begin cid and records nothing
+  inline void SetReadOnlySnapshot() { read_only_snapshot_ = true; }
+
+  inline bool IsReadOnlySnapshot() const { return read_only_snapshot_; }
+
  private:
   //===--------------------------------------------------------------------===//
   // Data members
@@ -116,19 +193,27 @@ class Transaction : public Printable {
   // start commit id
   cid_t begin_cid_;
 
+  // commit id the txn reads as of
+  cid_t read_cid_;
+
   // end commit id
   cid_t end_cid_;
 
   // epoch id
   size_t epoch_id_;
 
-  std::map<oid_t, std::map<oid_t, RWType>> rw_set_;
+  ReadWriteSet rw_set_;
+
+  // ADDs applied at commit
+  std::vector<EscrowOperation> escrow_operations_;
 
   // result of the transaction
   Result result_ = peloton::RESULT_SUCCESS;
 
   bool is_written_;
   size_t insert_count_;
+
+  bool read_only_snapshot_ = false;
 };
 
 }  // End concurrency namespace
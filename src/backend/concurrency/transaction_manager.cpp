@@ -10,8 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <memory>
+#include <vector>
+
 #include "backend/concurrency/transaction_manager.h"
 #include "backend/expression/container_tuple.h"
+#include "backend/gc/gc_manager_factory.h"
 
 namespace peloton {
 namespace concurrency {
@@ -19,9 +23,158 @@ namespace concurrency {
 // Current transaction for the backend thread
 thread_local Transaction *current_txn;
 
+namespace {
+
+// Txn ids the backend thread may still hand out, [next_, end_)
+struct TxnIdLease {
+  const TransactionManager *txn_manager_ = nullptr;
+  size_t generation_ = 0;
+  txn_id_t next_ = 0;
+  txn_id_t end_ = 0;
+};
+
+thread_local TxnIdLease txn_id_lease;
+
+// Generations are unique across all txn managers and their resets, so a
+// lease never outlives the counter it was taken from
+std::atomic<size_t> next_lease_generation(1);
+
+// Set once the txn pool of the thread is gone
+thread_local bool txn_pool_destroyed = false;
+
+// Finished txn objects of the backend thread
+class TransactionPool {
+ public:
+  ~TransactionPool() { txn_pool_destroyed = true; }
+
+  Transaction *Acquire(const txn_id_t txn_id, const cid_t begin_cid) {
+    if (txns_.empty()) {
+      return new Transaction(txn_id, begin_cid);
+    }
+    auto txn = txns_.back().release();
+    txns_.pop_back();
+    txn->Reset(txn_id, begin_cid);
+    return txn;
+  }
+
+  void Release(Transaction *txn) {
+    if (txns_.size() >= TXN_POOL_SIZE) {
+      delete txn;
+      return;
+    }
+    txns_.emplace_back(txn);
+  }
+
+ private:
+  std::vector<std::unique_ptr<Transaction>> txns_;
+};
+
+thread_local TransactionPool txn_pool;
+
+}  // End anonymous namespace
+
+TransactionManager::TransactionManager() {
+  next_txn_id_ = ATOMIC_VAR_INIT(START_TXN_ID);
+  lease_generation_ = ATOMIC_VAR_INIT(next_lease_generation++);
+  next_cid_ = ATOMIC_VAR_INIT(START_CID);
+  maximum_grant_cid_ = ATOMIC_VAR_INIT(MAX_CID);
+}
+
+txn_id_t TransactionManager::GetNextTransactionId() {
+  auto &lease = txn_id_lease;
+  auto generation = lease_generation_.load();
+
+  if (lease.txn_manager_ != this || lease.generation_ != generation ||
+      lease.next_ == lease.end_) {
+    lease.txn_manager_ = this;
+    lease.generation_ = generation;
+    lease.next_ = next_txn_id_.fetch_add(TXN_ID_LEASE_SIZE);
+    lease.end_ = lease.next_ + TXN_ID_LEASE_SIZE;
+  }
+
+  return lease.next_++;
+}
+
+Transaction *TransactionManager::AllocateTransaction(const txn_id_t txn_id,
+                                                     const cid_t begin_cid) {
+  return txn_pool.Acquire(txn_id, begin_cid);
+}
+
+void TransactionManager::ReleaseTransaction(Transaction *txn) {
+  if (txn_pool_destroyed) {
+    delete txn;
+  } else {
+    txn_pool.Release(txn);
+  }
+
+  // under cooperative GC the worker reclaims its garbage between txns
+  gc::GCManagerFactory::GetInstance().CollectLocalGarbage();
+}
+
+Transaction *TransactionManager::BeginReadOnlyTransaction() {
+  txn_id_t txn_id = GetNextTransactionId();
+  cid_t begin_cid = GetNextCommitId();
+  Transaction *txn = AllocateTransaction(txn_id, begin_cid);
+  txn->SetReadOnlySnapshot();
+
+  // the epoch keeps the versions of the snapshot from being collected
+  auto &epoch_manager = EpochManagerFactory::GetInstance();
+  auto eid = epoch_manager.EnterEpoch(begin_cid);
+  txn->SetEpochId(eid);
+
+  // a commit below the snapshot may still be installing its versions, and
+  // the snapshot would see some of them but not others
+  epoch_manager.WaitForCommitsBelow(begin_cid);
+
+  current_txn = txn;
+
+  return txn;
+}
+
+Result TransactionManager::EndReadOnlyTransaction(const Result result) {
+  PL_ASSERT(current_txn->IsReadOnlySnapshot());
+  LOG_TRACE("Finishing read-only txn : %lu ",
+            current_txn->GetTransactionId());
+
+  EpochManagerFactory::GetInstance().ExitEpoch(current_txn->GetEpochId());
+
+  ReleaseTransaction(current_txn);
+  current_txn = nullptr;
+
+  return result;
+}
+
+cid_t TransactionManager::BeginCommit() {
+  auto &epoch_manager = EpochManagerFactory::GetInstance();
+  auto eid = current_txn->GetEpochId();
+
+  // announce a lower bound first, a snapshot may take the next cid between
+  // our taking the end cid and announcing it
+  epoch_manager.EnterCommit(eid, next_cid_.load());
+  cid_t end_commit_id = GetNextCommitId();
+  epoch_manager.EnterCommit(eid, end_commit_id);
+
+  return end_commit_id;
+}
+
+void TransactionManager::EndCommit() {
+  EpochManagerFactory::GetInstance().ExitCommit(current_txn->GetEpochId());
+}
+
+void TransactionManager::ResetStates() {
+  next_txn_id_ = START_TXN_ID;
+  next_cid_ = START_CID;
+  lease_generation_ = next_lease_generation++;
+}
+
 bool TransactionManager::IsOccupied(const ItemPointer &position) {
-  auto tile_group_header =
-      catalog::Manager::GetInstance().GetTileGroup(position.block)->GetHeader();
+  auto tile_group =
+      catalog::Manager::GetInstance().GetTileGroup(position.block);
+  // left by an aborted insert in a tile group that was compacted since
+  if (tile_group == nullptr) {
+    return false;
+  }
+  auto tile_group_header = tile_group->GetHeader();
   auto tuple_id = position.offset;
 
   txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <unordered_map>
 #include <list>
@@ -41,18 +42,29 @@ extern thread_local Transaction *current_txn;
 
 #define RUNNING_TXN_BUCKET_NUM 10
 
+// Number of txn ids a thread takes from the shared counter at once
+#define TXN_ID_LEASE_SIZE 64
+
+// Number of finished txn objects a thread keeps for reuse
+#define TXN_POOL_SIZE 4
+
+// Number of tuples whose header entries are prefetched together when a
+// read set is validated
+#define VALIDATION_BATCH_SIZE 32
+
 class TransactionManager {
  public:
-  TransactionManager() {
-    next_txn_id_ = ATOMIC_VAR_INIT(START_TXN_ID);
-    next_cid_ = ATOMIC_VAR_INIT(START_CID);
-    maximum_grant_cid_ = ATOMIC_VAR_INIT(MAX_CID);
-  }
+  TransactionManager();
 
   virtual ~TransactionManager() {}
 
-  txn_id_t GetNextTransactionId() { return next_txn_id_++; }
+  // Txn ids only have to be unique, so each thread hands them out from a
+  // private lease and touches the shared counter once per lease.
+  txn_id_t GetNextTransactionId();
 
+  // Commit ids order the txns of every protocol, so they keep coming from
+  // the one shared counter. The grant sits on the same cache line, which
+  // the increment has just pulled in.
   cid_t GetNextCommitId() {
 	  cid_t temp_cid = next_cid_++;
 	  // wait if we do not yet have a grant for this commit id
@@ -82,6 +94,8 @@ class TransactionManager {
 
   virtual bool PerformInsert(const ItemPointer &location) = 0;
 
+  // Returns false if the txn must abort, or if it moved its read commit id
+  // past the version while it waited and has to read a newer one instead.
   virtual bool PerformRead(const ItemPointer &location) = 0;
 
   virtual void PerformUpdate(const ItemPointer &old_location,
@@ -94,6 +108,27 @@ class TransactionManager {
 
   virtual void PerformDelete(const ItemPointer &location) = 0;
 
+  // Whether ADDs to numeric columns can be deferred to commit time, so
+  // txns adding to the same tuple do not conflict with each other
+  virtual bool IsEscrowSupported() const { return false; }
+
+  // Add the delta to the column of the tuple when the txn commits, on top
+  // of whatever version is the newest then. access_count is the number of
+  // tuples the txn had accessed before the statement's scan.
+  void PerformEscrowAdd(storage::DataTable *table, const ItemPointer &location,
+                        const oid_t &column_id, const Value &delta,
+                        const size_t access_count) {
+    PL_ASSERT(IsEscrowSupported() == true);
+    current_txn->RecordEscrowAdd(table, location, column_id, delta,
+                                 access_count);
+  }
+
+  // Apply the txn's pending ADDs to the table before the txn reads it, so
+  // it sees its own writes. Returns false if the txn must abort.
+  virtual bool ApplyEscrowOperations(
+      const storage::DataTable *table UNUSED_ATTRIBUTE) {
+    return true;
+  }
 
   // Txn manager may store related information in TileGroupHeader, so when
   // TileGroup is dropped, txn manager might need to be notified
@@ -113,16 +148,19 @@ class TransactionManager {
 
   virtual Transaction *BeginTransaction() = 0;
 
+  // Begin a txn that only reads, as of the snapshot of its begin cid. It
+  // records no accesses and commits without validation or log records.
+  // Protocols whose reads need bookkeeping to stay correct override this
+  // with their regular path.
+  virtual Transaction *BeginReadOnlyTransaction();
+
   virtual void EndTransaction() = 0;
 
   virtual Result CommitTransaction() = 0;
 
   virtual Result AbortTransaction() = 0;
 
-  void ResetStates() {
-    next_txn_id_ = START_TXN_ID;
-    next_cid_ = START_CID;
-  }
+  void ResetStates();
 
   // this function generates the maximum commit id of committed transactions.
   // please note that this function only returns a "safe" value instead of a
@@ -136,6 +174,48 @@ class TransactionManager {
   }
 
  protected:
+  // Txn objects come from a per-thread pool and are reset in place, so
+  // beginning a txn does not go to the allocator
+  Transaction *AllocateTransaction(const txn_id_t txn_id,
+                                   const cid_t begin_cid);
+
+  void ReleaseTransaction(Transaction *txn);
+
+  // Finish the current read-only snapshot txn with the given result
+  Result EndReadOnlyTransaction(const Result result);
+
+  // Take the end commit id of the current txn. Until EndCommit, read-only
+  // snapshots that could include the commit wait for it, as they do not
+  // validate their reads against versions installed meanwhile.
+  cid_t BeginCommit();
+
+  void EndCommit();
+
+  // Check the accessed tuples of one tile group in batches. The header
+  // entries of a batch are prefetched first, so their cache misses
+  // overlap, then the batch is checked in a tight loop. Returns false as
+  // soon as a check fails.
+  template <typename Check>
+  static bool ValidateTileGroupAccess(
+      const storage::TileGroupHeader *const tile_group_header,
+      const ReadWriteSet::TileGroupAccess &tile_group_access, Check check) {
+    auto batch_begin = tile_group_access.begin();
+    auto end = tile_group_access.end();
+    while (batch_begin != end) {
+      auto batch_end = batch_begin + std::min<ptrdiff_t>(
+                                         VALIDATION_BATCH_SIZE, end - batch_begin);
+      for (auto entry = batch_begin; entry != batch_end; entry++) {
+        tile_group_header->PrefetchTupleHeader(entry->tuple_id);
+      }
+      for (auto entry = batch_begin; entry != batch_end; entry++) {
+        if (check(*entry) == false) {
+          return false;
+        }
+      }
+      batch_begin = batch_end;
+    }
+    return true;
+  }
 
 
   inline bool CidIsInDirtyRange(cid_t cid){
@@ -147,10 +227,19 @@ class TransactionManager {
 
 
  private:
+  // The txn id and commit id counters live on separate cache lines
+  CACHE_PADOUT;
   std::atomic<txn_id_t> next_txn_id_;
+
+  // Identifies the txn id leases taken since the last reset
+  std::atomic<size_t> lease_generation_;
+
+  CACHE_PADOUT;
   std::atomic<cid_t> next_cid_;
   std::atomic<cid_t> maximum_grant_cid_;
 
+  CACHE_PADOUT;
+
 };
 }  // End storage namespace
 }  // End peloton namespace
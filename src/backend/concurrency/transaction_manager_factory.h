@@ -19,6 +19,8 @@
 #include "backend/concurrency/ts_order_txn_manager.h"
 #include "backend/concurrency/ssi_txn_manager.h"
 #include "backend/concurrency/optimistic_rb_txn_manager.h"
+#include "backend/concurrency/partition_txn_manager.h"
+#include "backend/concurrency/lock_manager.h"
 
 namespace peloton {
 namespace concurrency {
@@ -40,15 +42,20 @@ class TransactionManagerFactory {
        return TsOrderTxnManager::GetInstance();
       case CONCURRENCY_TYPE_OCC_RB:
         return OptimisticRbTxnManager::GetInstance();
+      case CONCURRENCY_TYPE_PARTITION:
+        return PartitionTxnManager::GetInstance();
       default:
         return OptimisticRbTxnManager::GetInstance();
     }
   }
 
   static void Configure(ConcurrencyType protocol,
-                        IsolationLevelType level = ISOLATION_LEVEL_TYPE_FULL) {
+                        IsolationLevelType level = ISOLATION_LEVEL_TYPE_FULL,
+                        DeadlockHandlingType deadlock_handling =
+                            DEADLOCK_HANDLING_TYPE_NO_WAIT) {
     protocol_ = protocol;
     isolation_level_ = level;
+    LockManager::GetInstance().Configure(deadlock_handling);
   }
 
   static ConcurrencyType GetProtocol() { return protocol_; }
@@ -63,10 +63,14 @@ class TsOrderTxnManager : public TransactionManager {
 
   virtual Result AbortTransaction();
 
+  // Writers commit at their begin cid, which may precede a snapshot taken
+  // later, so read-only txns take the regular path
+  virtual Transaction *BeginReadOnlyTransaction() { return BeginTransaction(); }
+
   virtual Transaction *BeginTransaction() {
     txn_id_t txn_id = GetNextTransactionId();
     cid_t begin_cid = GetNextCommitId();
-    Transaction *txn = new Transaction(txn_id, begin_cid);
+    Transaction *txn = AllocateTransaction(txn_id, begin_cid);
     current_txn = txn;
 
     auto eid = EpochManagerFactory::GetInstance().EnterEpoch(begin_cid);
@@ -80,7 +84,7 @@ class TsOrderTxnManager : public TransactionManager {
 
     EpochManagerFactory::GetInstance().ExitEpoch(current_txn->GetEpochId());
 
-    delete current_txn;
+    ReleaseTransaction(current_txn);
     current_txn = nullptr;
   }
 
@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "backend/common/types.h"
+#include "backend/concurrency/transaction_manager_factory.h"
 #include "backend/executor/logical_tile.h"
 #include "backend/executor/logical_tile_factory.h"
 #include "backend/expression/abstract_expression.h"
@@ -53,6 +54,14 @@ bool AbstractScanExecutor::DInit() {
 
   column_ids_ = std::move(node.GetColumnIds());
 
+  // The txn reads its own deferred ADDs to the table
+  auto &transaction_manager =
+      concurrency::TransactionManagerFactory::GetInstance();
+  if (node.GetTable() != nullptr &&
+      transaction_manager.ApplyEscrowOperations(node.GetTable()) == false) {
+    return false;
+  }
+
   return true;
 }
 
@@ -34,6 +34,7 @@
 #include "backend/storage/data_table.h"
 #include "backend/storage/tile_group_header.h"
 #include "backend/storage/tile.h"
+#include "backend/concurrency/transaction.h"
 #include "backend/concurrency/transaction_manager_factory.h"
 #include "backend/common/logger.h"
 
@@ -167,7 +168,11 @@ bool HybridScanExecutor::SeqScanUtil() {
   // Retrieve next tile group.
   while (current_tile_group_offset_ < table_tile_group_count_) {
     auto tile_group =
-      table_->GetTileGroup(current_tile_group_offset_++);
+      table_->GetTileGroupPointer(current_tile_group_offset_++);
+    // the tile group was compacted
+    if (tile_group == nullptr) {
+      continue;
+    }
     auto tile_group_header = tile_group->GetHeader();
 
     oid_t active_tuple_count = tile_group->GetNextTupleSlot();
@@ -200,7 +205,7 @@ bool HybridScanExecutor::SeqScanUtil() {
           position_list.push_back(tuple_id);
         } else {
           expression::ContainerTuple<storage::TileGroup> tuple(
-            tile_group.get(), tuple_id);
+            tile_group, tuple_id);
           auto eval = predicate_->Evaluate(&tuple, nullptr, executor_context_)
             .IsTrue();
           if (eval == true) {
@@ -209,7 +214,7 @@ bool HybridScanExecutor::SeqScanUtil() {
         }
       } else {
           expression::ContainerTuple<storage::TileGroup> tuple(
-            tile_group.get(), tuple_id);
+            tile_group, tuple_id);
           auto eval = predicate_->Evaluate(&tuple, nullptr, executor_context_)
             .IsTrue();
           if (eval == true) {
@@ -315,6 +320,7 @@ bool HybridScanExecutor::ExecPrimaryIndexLookup() {
 
   auto &transaction_manager =
     concurrency::TransactionManagerFactory::GetInstance();
+  auto current_txn = executor_context_->GetTransaction();
 
    if (tuple_location_ptrs.size() == 0) {
     index_done_ = true;
@@ -336,6 +342,10 @@ bool HybridScanExecutor::ExecPrimaryIndexLookup() {
 
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tuple_location.block);
+    // left by an aborted insert in a tile group that was compacted since
+    if (tile_group == nullptr) {
+      continue;
+    }
     auto tile_group_header = tile_group.get()->GetHeader();
 
     // perform transaction read
@@ -346,12 +356,17 @@ bool HybridScanExecutor::ExecPrimaryIndexLookup() {
 
       if (transaction_manager.IsVisible(tile_group_header,
                                         tuple_location.offset)) {
-        visible_tuples[tuple_location.block].push_back(tuple_location.offset);
+        cid_t read_cid = current_txn->GetReadCommitId();
         auto res = transaction_manager.PerformRead(tuple_location);
         if (!res) {
+          // read the newer version the txn moved on to
+          if (current_txn->GetReadCommitId() != read_cid) {
+            continue;
+          }
           transaction_manager.SetTransactionResult(RESULT_FAILURE);
           return res;
         }
+        visible_tuples[tuple_location.block].push_back(tuple_location.offset);
         break;
       } else {
         ItemPointer old_item = tuple_location;
@@ -394,7 +409,7 @@ bool HybridScanExecutor::ExecPrimaryIndexLookup() {
 
     std::unique_ptr<LogicalTile> logical_tile(LogicalTileFactory::GetTile());
     // Add relevant columns to logical tile
-    logical_tile->AddColumns(tile_group, full_column_ids_);
+    logical_tile->AddColumns(tile_group.get(), full_column_ids_);
     logical_tile->AddPositionList(std::move(tuples.second));
     if (column_ids_.size() != 0) {
       logical_tile->ProjectColumns(full_column_ids_, column_ids_);
@@ -12,20 +12,25 @@
 
 #include "backend/executor/index_scan_executor.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "backend/common/types.h"
+#include "backend/common/value_peeker.h"
 #include "backend/executor/logical_tile.h"
 #include "backend/executor/logical_tile_factory.h"
 #include "backend/executor/executor_context.h"
 #include "backend/expression/abstract_expression.h"
 #include "backend/expression/container_tuple.h"
 #include "backend/index/index.h"
+#include "backend/index/index_scan_cursor.h"
 #include "backend/storage/data_table.h"
 #include "backend/storage/tile_group.h"
 #include "backend/storage/tile_group_header.h"
+#include "backend/storage/tuple.h"
+#include "backend/concurrency/transaction.h"
 #include "backend/concurrency/transaction_manager_factory.h"
 #include "backend/common/logger.h"
 #include "backend/catalog/manager.h"
@@ -34,6 +39,14 @@
 namespace peloton {
 namespace executor {
 
+// The first batch is small so that LIMIT queries stop early, later batches
+// grow up to the maximum size
+#define INDEX_SCAN_INITIAL_BATCH_SIZE 64
+#define INDEX_SCAN_MAX_BATCH_SIZE 4096
+
+// Largest number of keys an IN predicate is expanded into
+#define INDEX_SCAN_MAX_KEY_LIST_SIZE 4096
+
 /**
  * @brief Constructor for indexscan executor.
  * @param node Indexscan node corresponding to this executor.
@@ -63,8 +76,10 @@ bool IndexScanExecutor::DInit() {
   index_ = node.GetIndex();
   PL_ASSERT(index_ != nullptr);
 
+  result_.clear();
   result_itr_ = START_OID;
   done_ = false;
+  cursor_.reset();
 
   column_ids_ = node.GetColumnIds();
   key_column_ids_ = node.GetKeyColumnIds();
@@ -101,12 +116,33 @@ bool IndexScanExecutor::DInit() {
 
 /**
  * @brief Creates logical tile(s) after scanning index.
+ * The index is scanned one batch at a time, so a parent that stops asking
+ * for tiles (e.g. a limit) stops the index scan as well.
  * @return true on success, false otherwise.
  */
 bool IndexScanExecutor::DExecute() {
   LOG_TRACE("Index Scan executor :: 0 child");
 
-  if (!done_) {
+  while (true) {
+    while (result_itr_ < result_.size()) {  // Avoid returning empty tiles
+      if (result_[result_itr_]->GetTupleCount() == 0) {
+        delete result_[result_itr_];
+        result_itr_++;
+        continue;
+      } else {
+        SetOutput(result_[result_itr_]);
+        result_itr_++;
+        return true;
+      }
+
+    }  // end while
+
+    if (done_) return false;
+
+    // Scan the next batch of the index
+    result_.clear();
+    result_itr_ = START_OID;
+
     if (index_->GetIndexType() == INDEX_CONSTRAINT_TYPE_PRIMARY_KEY) {
       auto status = ExecPrimaryIndexLookup();
       if (status == false) return false;
@@ -115,22 +151,159 @@ bool IndexScanExecutor::DExecute() {
       if (status == false) return false;
     }
   }
-  // Already performed the index lookup
-  PL_ASSERT(done_);
+}
 
-  while (result_itr_ < result_.size()) {  // Avoid returning empty tiles
-    if (result_[result_itr_]->GetTupleCount() == 0) {
-      result_itr_++;
-      continue;
+/**
+ * @brief Pull the next batch of locations from the index.
+ * @return false if the index scan is drained.
+ */
+bool IndexScanExecutor::ScanNextBatch(std::vector<ItemPointer *> &locations) {
+  if (cursor_ == nullptr) {
+    std::vector<ItemPointer *> key_list_locations;
+    if (ScanKeyList(key_list_locations) == true) {
+      cursor_.reset(
+          new index::MaterializedScanCursor(std::move(key_list_locations)));
     } else {
-      SetOutput(result_[result_itr_]);
-      result_itr_++;
-      return true;
+      cursor_ = index_->OpenScan(values_, key_column_ids_, expr_types_,
+                                 SCAN_DIRECTION_TYPE_FORWARD);
     }
+    batch_size_ = INDEX_SCAN_INITIAL_BATCH_SIZE;
+  }
 
-  }  // end while
+  if (cursor_->Next(batch_size_, locations) == false) {
+    done_ = true;
+    return false;
+  }
 
-  return false;
+  batch_size_ = std::min<size_t>(batch_size_ * 2, INDEX_SCAN_MAX_BATCH_SIZE);
+  return true;
+}
+
+/**
+ * @brief Probe the index with every key of an IN predicate in one batch.
+ * Only applies when every key column is bound by an equality or an IN list,
+ * e.g. A IN (1, 2, 3) AND B = 4 on an index over (A, B).
+ * @return false if the predicate is not such a list of keys.
+ */
+bool IndexScanExecutor::ScanKeyList(std::vector<ItemPointer *> &locations) {
+  auto key_schema = index_->GetKeySchema();
+  oid_t key_column_count = key_schema->GetColumnCount();
+
+  // The distinct values of every key column
+  std::vector<std::vector<Value>> column_values(key_column_count);
+  std::vector<bool> bound_columns(key_column_count, false);
+  bool has_list = false;
+
+  auto value_less = [](const Value &lhs, const Value &rhs) {
+    return lhs.Compare(rhs) == VALUE_COMPARE_LESSTHAN;
+  };
+  auto value_equal = [](const Value &lhs, const Value &rhs) {
+    return lhs.Compare(rhs) == VALUE_COMPARE_EQUAL;
+  };
+
+  for (size_t key_itr = 0; key_itr < key_column_ids_.size(); key_itr++) {
+    oid_t column_id = key_column_ids_[key_itr];
+    if (column_id >= key_column_count || bound_columns[column_id] == true) {
+      return false;
+    }
+    bound_columns[column_id] = true;
+
+    std::vector<Value> items;
+    bool is_list = expr_types_[key_itr] == EXPRESSION_TYPE_COMPARE_IN;
+    if (is_list == true) {
+      const Value &list = values_[key_itr];
+      if (list.GetValueType() != VALUE_TYPE_ARRAY) return false;
+      for (int item_itr = 0; item_itr < list.ArrayLength(); item_itr++) {
+        items.push_back(list.ItemAtIndex(item_itr));
+      }
+      has_list = true;
+    } else if (expr_types_[key_itr] == EXPRESSION_TYPE_COMPARE_EQUAL) {
+      items.push_back(values_[key_itr]);
+    } else {
+      return false;
+    }
+
+    auto column_type = key_schema->GetType(column_id);
+    int32_t column_length = key_schema->IsInlined(column_id)
+                                ? key_schema->GetLength(column_id)
+                                : key_schema->GetVariableLength(column_id);
+    for (auto &item : items) {
+      // Leave the casts to the regular scan
+      if (item.GetValueType() != column_type) return false;
+
+      // A null is never in the list, and a string that does not fit into
+      // the column is not in the index
+      if (is_list == true && item.IsNull() == true) continue;
+      if (column_type == VALUE_TYPE_VARCHAR && item.IsNull() == false &&
+          ValuePeeker::PeekObjectLengthWithoutNull(item) > column_length) {
+        continue;
+      }
+
+      column_values[column_id].push_back(item);
+    }
+
+    std::sort(column_values[column_id].begin(), column_values[column_id].end(),
+              value_less);
+    column_values[column_id].erase(
+        std::unique(column_values[column_id].begin(),
+                    column_values[column_id].end(), value_equal),
+        column_values[column_id].end());
+  }
+
+  if (has_list == false) return false;
+
+  size_t key_count = 1;
+  for (oid_t column_id = 0; column_id < key_column_count; column_id++) {
+    if (bound_columns[column_id] == false) return false;
+    key_count *= column_values[column_id].size();
+    if (key_count > INDEX_SCAN_MAX_KEY_LIST_SIZE) return false;
+  }
+
+  // Every combination of the column values is a key
+  std::vector<std::unique_ptr<storage::Tuple>> keys;
+  std::vector<const storage::Tuple *> key_ptrs;
+  for (size_t key_itr = 0; key_itr < key_count; key_itr++) {
+    std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+    size_t value_itr = key_itr;
+    for (oid_t column_id = 0; column_id < key_column_count; column_id++) {
+      auto &values = column_values[column_id];
+      key->SetValue(column_id, values[value_itr % values.size()],
+                    index_->GetPool());
+      value_itr /= values.size();
+    }
+
+    key_ptrs.push_back(key.get());
+    keys.push_back(std::move(key));
+  }
+
+  LOG_TRACE("Key list size : %lu", key_ptrs.size());
+
+  index_->ScanKeys(key_ptrs, locations);
+
+  return true;
+}
+
+/**
+ * @brief Build the logical tiles of the visible tuples, one per tile group.
+ */
+void IndexScanExecutor::BuildResultTiles(
+    std::map<oid_t, std::vector<oid_t>> &visible_tuples) {
+  for (auto &tuples : visible_tuples) {
+    auto &manager = catalog::Manager::GetInstance();
+    auto tile_group = manager.GetTileGroup(tuples.first);
+
+    std::unique_ptr<LogicalTile> logical_tile(LogicalTileFactory::GetTile());
+    // Add relevant columns to logical tile
+    logical_tile->AddColumns(tile_group.get(), full_column_ids_);
+    logical_tile->AddPositionList(std::move(tuples.second));
+    if (column_ids_.size() != 0) {
+      logical_tile->ProjectColumns(full_column_ids_, column_ids_);
+    }
+
+    result_.push_back(logical_tile.release());
+  }
+
+  LOG_TRACE("Result tiles : %lu", result_.size());
 }
 
 bool IndexScanExecutor::ExecPrimaryIndexLookup() {
@@ -140,18 +313,11 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
 
   PL_ASSERT(index_->GetIndexType() == INDEX_CONSTRAINT_TYPE_PRIMARY_KEY);
 
-  if (0 == key_column_ids_.size()) {
-    index_->ScanAllKeys(tuple_location_ptrs);
-  } else {
-    index_->Scan(values_, key_column_ids_, expr_types_,
-                 SCAN_DIRECTION_TYPE_FORWARD, tuple_location_ptrs);
-  }
-
-
-  if (tuple_location_ptrs.size() == 0) return false;
+  if (ScanNextBatch(tuple_location_ptrs) == false) return false;
 
   auto &transaction_manager =
       concurrency::TransactionManagerFactory::GetInstance();
+  auto current_txn = executor_context_->GetTransaction();
 
   std::map<oid_t, std::vector<oid_t>> visible_tuples;
   std::vector<ItemPointer> garbage_tuples;
@@ -162,6 +328,10 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
     
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tuple_location.block);
+    // left by an aborted insert in a tile group that was compacted since
+    if (tile_group == nullptr) {
+      continue;
+    }
     auto tile_group_header = tile_group.get()->GetHeader();
 
     size_t chain_length = 0;
@@ -179,27 +349,37 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
 
         // perform predicate evaluation.
         if (predicate_ == nullptr) {
-          visible_tuples[tuple_location.block].push_back(tuple_location.offset);
-
+          cid_t read_cid = current_txn->GetReadCommitId();
           auto res = transaction_manager.PerformRead(tuple_location);
           if (!res) {
+            // read the newer version the txn moved on to
+            if (current_txn->GetReadCommitId() != read_cid) {
+              continue;
+            }
             transaction_manager.SetTransactionResult(RESULT_FAILURE);
             return res;
           }
+
+          visible_tuples[tuple_location.block].push_back(tuple_location.offset);
         } else {
           expression::ContainerTuple<storage::TileGroup> tuple(
               tile_group.get(), tuple_location.offset);
           auto eval =
               predicate_->Evaluate(&tuple, nullptr, executor_context_).IsTrue();
           if (eval == true) {
-            visible_tuples[tuple_location.block]
-                .push_back(tuple_location.offset);
-
+            cid_t read_cid = current_txn->GetReadCommitId();
             auto res = transaction_manager.PerformRead(tuple_location);
             if (!res) {
+              // read the newer version the txn moved on to
+              if (current_txn->GetReadCommitId() != read_cid) {
+                continue;
+              }
               transaction_manager.SetTransactionResult(RESULT_FAILURE);
               return res;
             }
+
+            visible_tuples[tuple_location.block]
+                .push_back(tuple_location.offset);
           }
         }
         break;
@@ -273,24 +453,7 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
   }
 
   // Construct a logical tile for each block
-  for (auto tuples : visible_tuples) {
-    auto &manager = catalog::Manager::GetInstance();
-    auto tile_group = manager.GetTileGroup(tuples.first);
-
-    std::unique_ptr<LogicalTile> logical_tile(LogicalTileFactory::GetTile());
-    // Add relevant columns to logical tile
-    logical_tile->AddColumns(tile_group, full_column_ids_);
-    logical_tile->AddPositionList(std::move(tuples.second));
-    if (column_ids_.size() != 0) {
-      logical_tile->ProjectColumns(full_column_ids_, column_ids_);
-    }
-
-    result_.push_back(logical_tile.release());
-  }
-
-  done_ = true;
-
-  LOG_TRACE("Result tiles : %lu", result_.size());
+  BuildResultTiles(visible_tuples);
 
   return true;
 }
@@ -298,80 +461,125 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
 bool IndexScanExecutor::ExecSecondaryIndexLookup() {
   PL_ASSERT(!done_);
 
-  std::vector<ItemPointer> tuple_locations;
+  std::vector<ItemPointer *> tuple_location_ptrs;
 
   PL_ASSERT(index_->GetIndexType() != INDEX_CONSTRAINT_TYPE_PRIMARY_KEY);
 
-  if (0 == key_column_ids_.size()) {
-    index_->ScanAllKeys(tuple_locations);
-  } else {
-    index_->Scan(values_, key_column_ids_, expr_types_,
-                 SCAN_DIRECTION_TYPE_FORWARD, tuple_locations);
-  }
+  if (ScanNextBatch(tuple_location_ptrs) == false) return false;
 
-  LOG_TRACE("Tuple_locations.size(): %lu", tuple_locations.size());
-
-  if (tuple_locations.size() == 0) return false;
+  LOG_TRACE("Tuple_locations.size(): %lu", tuple_location_ptrs.size());
 
   auto &transaction_manager =
       concurrency::TransactionManagerFactory::GetInstance();
+  auto current_txn = executor_context_->GetTransaction();
 
   std::map<oid_t, std::vector<oid_t>> visible_tuples;
   // for every tuple that is found in the index.
-  for (auto tuple_location : tuple_locations) {
+  for (auto tuple_location_ptr : tuple_location_ptrs) {
+    ItemPointer tuple_location = *tuple_location_ptr;
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tuple_location.block);
+    // left by an aborted insert in a tile group that was compacted since
+    if (tile_group == nullptr) {
+      continue;
+    }
     auto tile_group_header = tile_group.get()->GetHeader();
-    auto tile_group_id = tuple_location.block;
-    auto tuple_id = tuple_location.offset;
+
+    // the version was read already by following the chain of an older one
+    if (chain_read_locations_.empty() == false &&
+        chain_read_locations_.count(tuple_location) != 0) {
+      continue;
+    }
 
     // if the tuple is visible.
-    if (transaction_manager.IsVisible(tile_group_header, tuple_id)) {
-      // perform predicate evaluation.
-      if (predicate_ == nullptr) {
-        visible_tuples[tile_group_id].push_back(tuple_id);
-        auto res = transaction_manager.PerformRead(tuple_location);
-        if (!res) {
-          transaction_manager.SetTransactionResult(RESULT_FAILURE);
-          return res;
-        }
-      } else {
-        expression::ContainerTuple<storage::TileGroup> tuple(tile_group.get(),
-                                                             tuple_id);
+    if (transaction_manager.IsVisible(tile_group_header,
+                                      tuple_location.offset) == false) {
+      continue;
+    }
+
+    // perform predicate evaluation.
+    if (predicate_ != nullptr) {
+      expression::ContainerTuple<storage::TileGroup> tuple(
+          tile_group.get(), tuple_location.offset);
+      auto eval =
+          predicate_->Evaluate(&tuple, nullptr, executor_context_).IsTrue();
+      if (eval == false) {
+        continue;
+      }
+    }
+
+    cid_t read_cid = current_txn->GetReadCommitId();
+    auto res = transaction_manager.PerformRead(tuple_location);
+    if (!res) {
+      if (current_txn->GetReadCommitId() == read_cid ||
+          ReadNewerVersion(tuple_location) == false) {
+        transaction_manager.SetTransactionResult(RESULT_FAILURE);
+        return false;
+      }
+
+      // the tuple was deleted
+      if (tuple_location.IsNull()) {
+        continue;
+      }
+      chain_read_locations_.insert(tuple_location);
+
+      if (predicate_ != nullptr) {
+        expression::ContainerTuple<storage::TileGroup> tuple(
+            manager.GetTileGroup(tuple_location.block).get(),
+            tuple_location.offset);
         auto eval =
             predicate_->Evaluate(&tuple, nullptr, executor_context_).IsTrue();
-        if (eval == true) {
-          visible_tuples[tile_group_id].push_back(tuple_id);
-          auto res = transaction_manager.PerformRead(tuple_location);
-          if (!res) {
-            transaction_manager.SetTransactionResult(RESULT_FAILURE);
-            return res;
-          }
+        if (eval == false) {
+          continue;
         }
       }
     }
+
+    visible_tuples[tuple_location.block].push_back(tuple_location.offset);
   }
   // Construct a logical tile for each block
-  for (auto tuples : visible_tuples) {
-    auto &manager = catalog::Manager::GetInstance();
-    auto tile_group = manager.GetTileGroup(tuples.first);
+  BuildResultTiles(visible_tuples);
 
-    std::unique_ptr<LogicalTile> logical_tile(LogicalTileFactory::GetTile());
-    // Add relevant columns to logical tile
-    logical_tile->AddColumns(tile_group, full_column_ids_);
-    logical_tile->AddPositionList(std::move(tuples.second));
-    if (column_ids_.size() != 0) {
-      logical_tile->ProjectColumns(full_column_ids_, column_ids_);
-    }
+  return true;
+}
 
-    result_.push_back(logical_tile.release());
-  }
+/**
+ * @brief Read the newest version of a tuple once the txn moved its read
+ * point past the version it found in the index. The index entry of the
+ * newer version may not be in the batches the scan pulled.
+ * @return false if the txn must abort. The location is null if the tuple
+ * was deleted.
+ */
+bool IndexScanExecutor::ReadNewerVersion(ItemPointer &location) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto &transaction_manager =
+      concurrency::TransactionManagerFactory::GetInstance();
+  auto current_txn = executor_context_->GetTransaction();
+
+  while (true) {
+    auto tile_group_header =
+        manager.GetTileGroup(location.block)->GetHeader();
+    location = tile_group_header->GetNextItemPointer(location.offset);
+    if (location.IsNull()) {
+      return true;
+    }
 
-  done_ = true;
+    tile_group_header = manager.GetTileGroup(location.block)->GetHeader();
+    if (transaction_manager.IsVisible(tile_group_header, location.offset) ==
+        false) {
+      continue;
+    }
 
-  LOG_TRACE("Result tiles : %lu", result_.size());
+    cid_t read_cid = current_txn->GetReadCommitId();
+    if (transaction_manager.PerformRead(location) == true) {
+      return true;
+    }
 
-  return true;
+    // unless the txn moved on once more while it waited
+    if (current_txn->GetReadCommitId() == read_cid) {
+      return false;
+    }
+  }
 }
 
 }  // namespace executor
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <set>
 #include <vector>
 
 #include "backend/executor/abstract_scan_executor.h"
@@ -19,6 +22,10 @@
 
 namespace peloton {
 
+namespace index {
+class IndexScanCursor;
+}
+
 namespace storage {
 class AbstractTable;
 }
@@ -47,6 +54,14 @@ class IndexScanExecutor : public AbstractScanExecutor {
   bool ExecPrimaryIndexLookup();
   bool ExecSecondaryIndexLookup();
 
+  bool ScanNextBatch(std::vector<ItemPointer *> &locations);
+
+  bool ReadNewerVersion(ItemPointer &location);
+
+  bool ScanKeyList(std::vector<ItemPointer *> &locations);
+
+  void BuildResultTiles(std::map<oid_t, std::vector<oid_t>> &visible_tuples);
+
   //===--------------------------------------------------------------------===//
   // Executor State
   //===--------------------------------------------------------------------===//
@@ -57,9 +72,18 @@ class IndexScanExecutor : public AbstractScanExecutor {
   /** @brief Result itr */
   oid_t result_itr_ = INVALID_OID;
 
-  /** @brief Computed the result */
+  /** @brief Drained the index scan */
   bool done_ = false;
 
+  /** @brief Cursor of the index scan, opened on the first batch. */
+  std::unique_ptr<index::IndexScanCursor> cursor_;
+
+  /** @brief Number of locations to pull from the cursor next time */
+  size_t batch_size_ = 0;
+
+  /** @brief Versions read by following the chain of an older version */
+  std::set<ItemPointer> chain_read_locations_;
+
   //===--------------------------------------------------------------------===//
   // Plan Info
   //===--------------------------------------------------------------------===//
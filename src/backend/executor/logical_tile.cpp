@@ -380,9 +380,8 @@ void LogicalTile::AddColumn(const std::shared_ptr<storage::Tile> &base_tile,
 /**
  * @brief Add the column specified in column_ids to this logical tile.
  */
-void LogicalTile::AddColumns(
-    const std::shared_ptr<storage::TileGroup> &tile_group,
-    const std::vector<oid_t> &column_ids) {
+void LogicalTile::AddColumns(storage::TileGroup *tile_group,
+                             const std::vector<oid_t> &column_ids) {
   const int position_list_idx = 0;
   for (oid_t origin_column_id : column_ids) {
     oid_t base_tile_offset, tile_column_id;
@@ -69,7 +69,7 @@ class LogicalTile : public Printable {
   void AddColumn(const std::shared_ptr<storage::Tile> &base_tile,
                  oid_t origin_column_id, oid_t position_list_idx);
 
-  void AddColumns(const std::shared_ptr<storage::TileGroup> &tile_group,
+  void AddColumns(storage::TileGroup *tile_group,
                   const std::vector<oid_t> &column_ids);
 
   void ProjectColumns(const std::vector<oid_t> &original_column_ids,
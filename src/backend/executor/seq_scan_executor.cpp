@@ -123,7 +123,11 @@ bool SeqScanExecutor::DExecute() {
     // Retrieve next tile group.
     while (current_tile_group_offset_ < table_tile_group_count_) {
       auto tile_group =
-          target_table_->GetTileGroup(current_tile_group_offset_++);
+          target_table_->GetTileGroupPointer(current_tile_group_offset_++);
+      // the tile group was compacted
+      if (tile_group == nullptr) {
+        continue;
+      }
       auto tile_group_header = tile_group->GetHeader();
 
       oid_t active_tuple_count = tile_group->GetNextTupleSlot();
@@ -148,7 +152,7 @@ bool SeqScanExecutor::DExecute() {
             }
           } else {
             expression::ContainerTuple<storage::TileGroup> tuple(
-                tile_group.get(), tuple_id);
+                tile_group, tuple_id);
             auto eval = predicate_->Evaluate(&tuple, nullptr, executor_context_)
                             .IsTrue();
             if (eval == true) {
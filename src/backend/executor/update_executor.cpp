@@ -11,22 +11,75 @@
 //===----------------------------------------------------------------------===//
 
 #include "backend/executor/update_executor.h"
+
+#include <set>
+
 #include "backend/planner/update_plan.h"
 #include "backend/common/logger.h"
 #include "backend/catalog/manager.h"
 #include "backend/executor/logical_tile.h"
 #include "backend/executor/executor_context.h"
 #include "backend/expression/container_tuple.h"
+#include "backend/expression/tuple_value_expression.h"
 #include "backend/concurrency/transaction.h"
 #include "backend/concurrency/transaction_manager_factory.h"
 #include "backend/storage/data_table.h"
 #include "backend/storage/tile_group_header.h"
 #include "backend/storage/tile.h"
 #include "backend/storage/rollback_segment.h"
+#include "backend/index/index.h"
+#include "backend/planner/abstract_scan_plan.h"
+#include "backend/planner/hybrid_scan_plan.h"
+#include "backend/planner/index_scan_plan.h"
 
 namespace peloton {
 namespace executor {
 
+// Collect the columns the predicate reads. Returns false if it has an
+// expression whose operands are not just its left and right children.
+static bool GetPredicateColumns(const expression::AbstractExpression *expr,
+                                std::set<oid_t> &column_ids) {
+  if (expr == nullptr) {
+    return true;
+  }
+
+  switch (expr->GetExpressionType()) {
+    case EXPRESSION_TYPE_VALUE_TUPLE:
+      column_ids.insert(
+          static_cast<const expression::TupleValueExpression *>(expr)
+              ->GetColumnId());
+      return true;
+    case EXPRESSION_TYPE_VALUE_CONSTANT:
+    case EXPRESSION_TYPE_VALUE_PARAMETER:
+    case EXPRESSION_TYPE_VALUE_NULL:
+      return true;
+    case EXPRESSION_TYPE_OPERATOR_PLUS:
+    case EXPRESSION_TYPE_OPERATOR_MINUS:
+    case EXPRESSION_TYPE_OPERATOR_MULTIPLY:
+    case EXPRESSION_TYPE_OPERATOR_DIVIDE:
+    case EXPRESSION_TYPE_OPERATOR_CONCAT:
+    case EXPRESSION_TYPE_OPERATOR_MOD:
+    case EXPRESSION_TYPE_OPERATOR_CAST:
+    case EXPRESSION_TYPE_OPERATOR_NOT:
+    case EXPRESSION_TYPE_OPERATOR_IS_NULL:
+    case EXPRESSION_TYPE_OPERATOR_UNARY_MINUS:
+    case EXPRESSION_TYPE_COMPARE_EQUAL:
+    case EXPRESSION_TYPE_COMPARE_NOTEQUAL:
+    case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+    case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+    case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO:
+    case EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO:
+    case EXPRESSION_TYPE_COMPARE_LIKE:
+    case EXPRESSION_TYPE_COMPARE_NOTLIKE:
+    case EXPRESSION_TYPE_CONJUNCTION_AND:
+    case EXPRESSION_TYPE_CONJUNCTION_OR:
+      return GetPredicateColumns(expr->GetLeft(), column_ids) &&
+             GetPredicateColumns(expr->GetRight(), column_ids);
+    default:
+      return false;
+  }
+}
+
 /**
  * @brief Constructor for update executor.
  * @param node Update node corresponding to this executor.
@@ -52,6 +105,97 @@ bool UpdateExecutor::DInit() {
   PL_ASSERT(target_table_);
   PL_ASSERT(project_info_);
 
+  auto &transaction_manager =
+      concurrency::TransactionManagerFactory::GetInstance();
+  escrow_update_ = transaction_manager.IsEscrowSupported() == true &&
+                   IsEscrowUpdate() && IsScanIndependentOfTargets();
+  if (escrow_update_ == true) {
+    access_count_ = executor_context_->GetTransaction()->GetAccessCount();
+  }
+
+  return true;
+}
+
+bool UpdateExecutor::IsEscrowUpdate() const {
+  auto schema = target_table_->GetSchema();
+  auto &target_list = project_info_->GetTargetList();
+  if (target_list.empty() == true) {
+    return false;
+  }
+
+  for (auto &target : target_list) {
+    switch (schema->GetType(target.first)) {
+      case VALUE_TYPE_TINYINT:
+      case VALUE_TYPE_SMALLINT:
+      case VALUE_TYPE_INTEGER:
+      case VALUE_TYPE_BIGINT:
+      case VALUE_TYPE_DOUBLE:
+      case VALUE_TYPE_DECIMAL:
+        break;
+      default:
+        return false;
+    }
+
+    auto expr = target.second;
+    if (expr->GetExpressionType() != EXPRESSION_TYPE_OPERATOR_PLUS ||
+        expr->GetLeft() == nullptr || expr->GetRight() == nullptr) {
+      return false;
+    }
+
+    auto left = expr->GetLeft();
+    if (left->GetExpressionType() != EXPRESSION_TYPE_VALUE_TUPLE) {
+      return false;
+    }
+    auto column = static_cast<const expression::TupleValueExpression *>(left);
+    if (column->GetTupleIdx() != 0 ||
+        (oid_t)column->GetColumnId() != target.first) {
+      return false;
+    }
+
+    auto right = expr->GetRight()->GetExpressionType();
+    if (right != EXPRESSION_TYPE_VALUE_CONSTANT &&
+        right != EXPRESSION_TYPE_VALUE_PARAMETER) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool UpdateExecutor::IsScanIndependentOfTargets() const {
+  auto scan_node =
+      dynamic_cast<const planner::AbstractScan *>(children_[0]->GetRawNode());
+  if (scan_node == nullptr) {
+    return false;
+  }
+
+  std::set<oid_t> column_ids;
+  if (GetPredicateColumns(scan_node->GetPredicate(), column_ids) == false) {
+    return false;
+  }
+
+  // An index scan also selects tuples by the columns of its index
+  index::Index *index = nullptr;
+  auto index_scan_node =
+      dynamic_cast<const planner::IndexScanPlan *>(scan_node);
+  if (index_scan_node != nullptr) {
+    index = index_scan_node->GetIndex();
+  }
+  auto hybrid_scan_node =
+      dynamic_cast<const planner::HybridScanPlan *>(scan_node);
+  if (hybrid_scan_node != nullptr) {
+    index = hybrid_scan_node->GetIndex();
+  }
+  if (index != nullptr) {
+    for (auto column_id : index->GetKeySchema()->GetIndexedColumns()) {
+      column_ids.insert(column_id);
+    }
+  }
+
+  for (auto &target : project_info_->GetTargetList()) {
+    if (column_ids.count(target.first) != 0) {
+      return false;
+    }
+  }
   return true;
 }
 
@@ -94,6 +238,23 @@ bool UpdateExecutor::DExecute() {
     LOG_TRACE("Visible Tuple id : %u, Physical Tuple id : %u ",
               visible_tuple_id, physical_tuple_id);
 
+    if (escrow_update_ == true &&
+        transaction_manager.IsOwner(tile_group_header, physical_tuple_id) ==
+            false) {
+      // Defer the ADDs to commit, where they go into the newest version.
+      // The scan's read is validated against that version then.
+      for (auto &target : project_info_->GetTargetList()) {
+        Value delta = target.second->GetRight()->Evaluate(nullptr, nullptr,
+                                                          executor_context_);
+        transaction_manager.PerformEscrowAdd(target_table_, old_location,
+                                             target.first, delta,
+                                             access_count_);
+      }
+
+      executor_context_->num_processed += 1;  // updated one
+      continue;
+    }
+
     if (transaction_manager.IsOwner(tile_group_header, physical_tuple_id) == true) {
 
       // Make a copy of the original tuple and allocate a new tuple
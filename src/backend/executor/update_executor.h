@@ -35,8 +35,22 @@ class UpdateExecutor : public AbstractExecutor {
   bool DExecute();
 
  private:
+  // Whether every target adds a value that does not depend on the tuple to
+  // a numeric column, i.e. SET col = col + ?
+  bool IsEscrowUpdate() const;
+
+  // Whether the child scan selects tuples without reading the target
+  // columns, so the ADDs cannot change which tuples it selects
+  bool IsScanIndependentOfTargets() const;
+
   storage::DataTable *target_table_ = nullptr;
   const planner::ProjectInfo *project_info_ = nullptr;
+
+  // The ADDs are recorded and applied when the txn commits
+  bool escrow_update_ = false;
+
+  // Tuples the txn had accessed before the update started
+  size_t access_count_ = 0;
 };
 
 }  // namespace executor
@@ -11,16 +11,57 @@
 //===----------------------------------------------------------------------===//
 
 #include "backend/common/types.h"
+#include "backend/common/pool.h"
+#include "backend/common/varlen.h"
 #include "backend/gc/gc_manager.h"
 #include "backend/gc/gc_manager_factory.h"
 #include "backend/index/index.h"
 #include "backend/concurrency/transaction_manager_factory.h"
-
+#include "backend/expression/container_tuple.h"
+#include "backend/storage/data_table.h"
+#include "backend/storage/rollback_segment.h"
+#include "backend/storage/tile.h"
+#include "backend/storage/tile_group.h"
+#include "backend/storage/tuple.h"
+
+#include <algorithm>
 #include <list>
+#include <memory>
 
 namespace peloton {
 namespace gc {
 
+namespace {
+
+// Set once the local garbage of the thread is gone
+thread_local bool local_garbage_destroyed = false;
+
+// Garbage of a worker thread under cooperative GC, and the tile groups it
+// takes free slots from
+struct LocalGarbage {
+  ~LocalGarbage() {
+    if (garbage_tuples_.empty() == false) {
+      GCManagerFactory::GetInstance().ReleaseLocalGarbage();
+    }
+    local_garbage_destroyed = true;
+  }
+
+  // Versions that become garbage once their end cid is dead
+  std::vector<TupleMetadata> garbage_tuples_;
+
+  // Tile group the worker takes the free slots of a table from, until it
+  // runs out of them
+  std::unordered_map<oid_t, std::weak_ptr<storage::TileGroup>>
+      free_slot_cursors_;
+
+  // Max dead txn cid at the last collection
+  cid_t last_max_cid_ = INVALID_CID;
+};
+
+thread_local LocalGarbage local_garbage;
+
+}  // End anonymous namespace
+
 GCBuffer::~GCBuffer(){
   auto &transaction_manager = concurrency::TransactionManagerFactory::GetInstance();
   // Add all garbage tuples to GC manager
@@ -34,13 +75,33 @@ GCBuffer::~GCBuffer(){
   }
 }
 
+void GCManager::Reconfigure(const GCType type,
+                            const size_t helper_thread_count) {
+  if (type == gc_type_ && helper_thread_count == helper_thread_count_) {
+    return;
+  }
+  StopGC();
+  gc_type_ = type;
+  helper_thread_count_ = helper_thread_count;
+  StartGC();
+}
+
 void GCManager::StartGC() {
   LOG_TRACE("Starting GC");
   if (this->gc_type_ == GC_TYPE_OFF) {
     return;
   }
   this->is_running_ = true;
-  gc_thread_.reset(new std::thread(&GCManager::Running, this));
+
+  // cooperative GC only needs helpers, if any, for the garbage the workers
+  // leave in the shared queue
+  size_t thread_count = 1;
+  if (this->gc_type_ == GC_TYPE_COOPERATIVE) {
+    thread_count = helper_thread_count_;
+  }
+  for (size_t thread_itr = 0; thread_itr < thread_count; thread_itr++) {
+    gc_threads_.emplace_back(new std::thread(&GCManager::Running, this));
+  }
 }
 
 void GCManager::StopGC() {
@@ -49,7 +110,11 @@ void GCManager::StopGC() {
     return;
   }
   this->is_running_ = false;
-  this->gc_thread_->join();
+  for (auto &gc_thread : gc_threads_) {
+    gc_thread->join();
+  }
+  gc_threads_.clear();
+  ReleaseLocalGarbage();
   ClearGarbage();
 }
 
@@ -75,6 +140,12 @@ bool GCManager::ResetTuple(const TupleMetadata &tuple_metadata) {
 
   auto tile_group_header = tile_group->GetHeader();
 
+  // The uninlined values of the version go back to the pools of the tiles
+  for (oid_t tile_itr = 0; tile_itr < tile_group->GetTileCount(); tile_itr++) {
+    tile_group->GetTile(tile_itr)->RetireUninlinedValues(
+        tuple_metadata.tuple_slot_id);
+  }
+
   // Reset the header
   tile_group_header->SetTransactionId(tuple_metadata.tuple_slot_id,
                                       INVALID_TXN_ID);
@@ -98,26 +169,114 @@ void GCManager::AddToRecycleMap(TupleMetadata tuple_metadata) {
   // If the tuple being reset no longer exists, just skip it
   if (ResetTuple(tuple_metadata) == false) return;
 
+  FreeTupleSlot(tuple_metadata);
+}
+
+std::shared_ptr<storage::TileGroup> GCManager::FreeTupleSlot(
+    const TupleMetadata &tuple_metadata) {
+  auto tile_group = catalog::Manager::GetInstance().GetTileGroup(
+      tuple_metadata.tile_group_id);
+  if (tile_group == nullptr) {
+    return nullptr;
+  }
+
+  // the tile group is already in the recycle queue if it had a free slot
+  if (tile_group->GetHeader()->FreeTupleSlot(tuple_metadata.tuple_slot_id) ==
+      false) {
+    return tile_group;
+  }
+
   // Add to the recycle map
-  std::shared_ptr<LockfreeQueue<TupleMetadata>> recycle_queue;
-  // if the entry for table_id exists.
+  std::shared_ptr<LockfreeQueue<oid_t>> recycle_queue;
+  // if the entry for table_id does not exist.
   if (recycle_queue_map_.find(tuple_metadata.table_id, recycle_queue) ==
-      true) {
-    // if the entry for tuple_metadata.table_id exists.
-    recycle_queue->Dequeue(tuple_metadata);
-  } else {
-    // if the entry for tuple_metadata.table_id does not exist.
-    recycle_queue.reset(
-      new LockfreeQueue<TupleMetadata>(MAX_QUEUE_LENGTH));
-    bool ret =
-      recycle_queue_map_.insert(tuple_metadata.table_id, recycle_queue);
-    if (ret == true) {
-      recycle_queue->Dequeue(tuple_metadata);
-    } else {
+      false) {
+    recycle_queue.reset(new LockfreeQueue<oid_t>(MAX_QUEUE_LENGTH));
+    if (recycle_queue_map_.insert(tuple_metadata.table_id, recycle_queue) ==
+        false) {
       recycle_queue_map_.find(tuple_metadata.table_id, recycle_queue);
-      recycle_queue->Dequeue(tuple_metadata);
     }
   }
+  recycle_queue->Enqueue(tuple_metadata.tile_group_id);
+
+  return tile_group;
+}
+
+void GCManager::UnlinkIndexEntries(
+    const std::vector<TupleMetadata> &garbage_tuples) {
+  auto &manager = catalog::Manager::GetInstance();
+
+  // The entries to delete from every index, with the keys they own
+  struct IndexGarbage {
+    std::vector<std::unique_ptr<storage::Tuple>> keys;
+    std::vector<const storage::Tuple *> key_ptrs;
+    std::vector<ItemPointer> locations;
+  };
+  std::map<index::Index *, IndexGarbage> index_garbage;
+
+  for (auto &tuple_metadata : garbage_tuples) {
+    auto tile_group = manager.GetTileGroup(tuple_metadata.tile_group_id);
+    if (tile_group == nullptr) {
+      continue;
+    }
+
+    auto table =
+        dynamic_cast<storage::DataTable *>(tile_group->GetAbstractTable());
+    if (table == nullptr) {
+      continue;
+    }
+
+    // The tuple is not reset yet, so its version still holds its keys
+    expression::ContainerTuple<storage::TileGroup> tuple(
+        tile_group.get(), tuple_metadata.tuple_slot_id);
+    ItemPointer location(tuple_metadata.tile_group_id,
+                         tuple_metadata.tuple_slot_id);
+
+    for (oid_t index_itr = 0; index_itr < table->GetIndexCount();
+         index_itr++) {
+      auto index = table->GetIndex(index_itr);
+
+      // The primary index entry was moved on to the newer version before
+      // this one became garbage
+      if (index->GetIndexType() == INDEX_CONSTRAINT_TYPE_PRIMARY_KEY) {
+        continue;
+      }
+
+      auto key_schema = index->GetKeySchema();
+      auto indexed_columns = key_schema->GetIndexedColumns();
+      std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+      for (oid_t column_itr = 0; column_itr < indexed_columns.size();
+           column_itr++) {
+        key->SetValue(column_itr, tuple.GetValue(indexed_columns[column_itr]),
+                      index->GetPool());
+      }
+
+      auto &garbage = index_garbage[index];
+      garbage.key_ptrs.push_back(key.get());
+      garbage.keys.push_back(std::move(key));
+      garbage.locations.push_back(location);
+    }
+  }
+
+  // No running transaction can see these versions anymore. Transactions
+  // that read an entry before its removal keep a valid location cell, as
+  // the index only reuses it once they are gone.
+  for (auto &entry : index_garbage) {
+    entry.first->DeleteEntries(entry.second.key_ptrs, entry.second.locations);
+    entry.first->Cleanup();
+
+    LOG_TRACE("Unlinked %lu garbage entries from index %s",
+              entry.second.locations.size(), entry.first->GetName().c_str());
+  }
+}
+
+void GCManager::RecycleGarbage(
+    const std::vector<TupleMetadata> &garbage_tuples) {
+  UnlinkIndexEntries(garbage_tuples);
+
+  for (auto &tuple_metadata : garbage_tuples) {
+    AddToRecycleMap(tuple_metadata);
+  }
 }
 
 void GCManager::Running() {
@@ -126,17 +285,25 @@ void GCManager::Running() {
   // We use a local buffer to store all possible garbage handled by this gc worker
   std::list<TupleMetadata> local_reclaim_queue;
 
+  // Whether the last round left garbage in the global reclaim queue
+  bool backlog = false;
+
   while (true) {
-    std::this_thread::sleep_for(
-        std::chrono::milliseconds(GC_PERIOD_MILLISECONDS));
+    // under load the thread keeps draining the queue without a pause
+    if (backlog == false) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(GC_PERIOD_MILLISECONDS));
+    }
 
     LOG_TRACE("reclaim tuple thread...");
 
     // First load every possible garbage into the list
     // This step move all garbage from the global reclaim queue to the worker's local queue
+    backlog = true;
     for (size_t i = 0; i < MAX_ATTEMPT_COUNT; ++i) {
       TupleMetadata tuple_metadata;
       if (reclaim_queue_.Dequeue(tuple_metadata) == false) {
+        backlog = false;
         break;
       }
       LOG_TRACE("Collect tuple (%u, %u) of table %u into local list",
@@ -150,39 +317,39 @@ void GCManager::Running() {
 
     assert(max_cid != MAX_CID);
 
-    int tuple_counter = 0;
     int attempt = 0;
     auto queue_itr = local_reclaim_queue.begin();
+    std::vector<TupleMetadata> garbage_tuples;
 
     while (queue_itr != local_reclaim_queue.end() && attempt < MAX_ATTEMPT_COUNT) {
       if (queue_itr->tuple_end_cid <= max_cid) {
         // add the tuple to recycle map
         LOG_TRACE("Add tuple(%u, %u) in table %u to recycle map", queue_itr->tile_group_id,
                  queue_itr->tuple_slot_id, queue_itr->table_id);
-        AddToRecycleMap(*queue_itr);
+        garbage_tuples.push_back(*queue_itr);
         queue_itr = local_reclaim_queue.erase(queue_itr);
-        tuple_counter++;
       } else {
         queue_itr++;
       }
       attempt++;
     }
 
-    LOG_TRACE("Marked %d tuples as garbage", tuple_counter);
-    if (is_running_ == false) {
-      // Clear all pending garbage
-      tuple_counter = 0;
-      queue_itr = local_reclaim_queue.begin();
+    RecycleGarbage(garbage_tuples);
 
-      while (queue_itr != local_reclaim_queue.end()) {
-        // In this case, we assume that no transaction is running
-        // so every possible garbage is actually garbage
-        AddToRecycleMap(*queue_itr);
-        queue_itr = local_reclaim_queue.erase(queue_itr);
-        tuple_counter ++;
-      }
+    ReleaseRetiredMemory(max_cid);
 
-      LOG_TRACE("GCThread recycle last %d tuples before exits", tuple_counter);
+    LOG_TRACE("Marked %lu tuples as garbage", garbage_tuples.size());
+    if (is_running_ == false) {
+      // Clear all pending garbage
+      // In this case, we assume that no transaction is running
+      // so every possible garbage is actually garbage
+      garbage_tuples.assign(local_reclaim_queue.begin(),
+                            local_reclaim_queue.end());
+      local_reclaim_queue.clear();
+      RecycleGarbage(garbage_tuples);
+
+      LOG_TRACE("GCThread recycle last %lu tuples before exits",
+                garbage_tuples.size());
       return;
     }
   }
@@ -203,6 +370,14 @@ void GCManager::RecycleTupleSlot(const oid_t &table_id,
   tuple_metadata.tuple_slot_id = tuple_id;
   tuple_metadata.tuple_end_cid = tuple_end_cid;
 
+  // the worker collects the garbage itself, unless it has too much already
+  if (this->gc_type_ == GC_TYPE_COOPERATIVE &&
+      local_garbage_destroyed == false &&
+      local_garbage.garbage_tuples_.size() < GC_LOCAL_GARBAGE_LIMIT) {
+    local_garbage.garbage_tuples_.push_back(tuple_metadata);
+    return;
+  }
+
   reclaim_queue_.Enqueue(tuple_metadata);
 
   LOG_TRACE("Marked tuple(%u, %u) in table %u as possible garbage",
@@ -217,18 +392,197 @@ ItemPointer GCManager::ReturnFreeSlot(const oid_t &table_id) {
     return INVALID_ITEMPOINTER;
   }
 
-  std::shared_ptr<LockfreeQueue<TupleMetadata>> recycle_queue;
-  // if there exists recycle_queue
-  if (recycle_queue_map_.find(table_id, recycle_queue) == true) {
-    TupleMetadata tuple_metadata;
-    if (recycle_queue->Dequeue(tuple_metadata) == true) {
-      LOG_TRACE("Reuse tuple(%u, %u) in table %u", tuple_metadata.tile_group_id,
-               tuple_metadata.tuple_slot_id, table_id);
-      return ItemPointer(tuple_metadata.tile_group_id,
-                         tuple_metadata.tuple_slot_id);
+  if (local_garbage_destroyed == true) {
+    return INVALID_ITEMPOINTER;
+  }
+
+  // keep filling the tile group we took the last free slot from
+  auto &free_slot_cursors = local_garbage.free_slot_cursors_;
+  auto cursor = free_slot_cursors.find(table_id);
+  if (cursor != free_slot_cursors.end()) {
+    auto tile_group = cursor->second.lock();
+    if (tile_group != nullptr) {
+      auto tuple_slot_id = tile_group->GetHeader()->TakeFreeTupleSlot();
+      if (tuple_slot_id != INVALID_OID) {
+        return ItemPointer(tile_group->GetTileGroupId(), tuple_slot_id);
+      }
     }
+    free_slot_cursors.erase(cursor);
+  }
+
+  // then look for another tile group with free slots
+  std::shared_ptr<LockfreeQueue<oid_t>> recycle_queue;
+  if (recycle_queue_map_.find(table_id, recycle_queue) == false) {
+    return INVALID_ITEMPOINTER;
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+  oid_t tile_group_id;
+  while (recycle_queue->Dequeue(tile_group_id) == true) {
+    auto tile_group = manager.GetTileGroup(tile_group_id);
+    if (tile_group == nullptr) {
+      continue;
+    }
+
+    // other threads may have taken its free slots in the meantime
+    auto tile_group_header = tile_group->GetHeader();
+    auto tuple_slot_id = tile_group_header->TakeFreeTupleSlot();
+    if (tuple_slot_id == INVALID_OID) {
+      continue;
+    }
+
+    // leave the tile group to other threads as well while it has free
+    // slots, it is only announced again once it ran out of them
+    if (tile_group_header->GetFreeTupleSlotCount() > 0) {
+      recycle_queue->Enqueue(tile_group_id);
+    }
+    free_slot_cursors[table_id] = tile_group;
+
+    LOG_TRACE("Reuse tuple(%u, %u) in table %u", tile_group_id, tuple_slot_id,
+              table_id);
+    return ItemPointer(tile_group_id, tuple_slot_id);
+  }
+
+  return INVALID_ITEMPOINTER;
+}
+
+void GCManager::CollectLocalGarbage() {
+  if (this->gc_type_ != GC_TYPE_COOPERATIVE ||
+      local_garbage_destroyed == true) {
+    return;
+  }
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto max_cid = txn_manager.GetMaxCommittedCid();
+
+  // nothing more can be garbage until the next epoch
+  if (max_cid == local_garbage.last_max_cid_) {
+    return;
+  }
+  local_garbage.last_max_cid_ = max_cid;
+
+  ReleaseRetiredMemory(max_cid);
+
+  auto &garbage_tuples = local_garbage.garbage_tuples_;
+
+  // help with the garbage other workers left in the shared queue
+  TupleMetadata tuple_metadata;
+  for (size_t i = 0; i < GC_ADOPT_BATCH_SIZE; ++i) {
+    if (reclaim_queue_.Dequeue(tuple_metadata) == false) {
+      break;
+    }
+    garbage_tuples.push_back(tuple_metadata);
+  }
+
+  auto garbage_end = std::partition(
+      garbage_tuples.begin(), garbage_tuples.end(),
+      [max_cid](const TupleMetadata &tuple_metadata) {
+        return tuple_metadata.tuple_end_cid > max_cid;
+      });
+  if (garbage_end == garbage_tuples.end()) {
+    return;
+  }
+  std::vector<TupleMetadata> reclaimed_tuples(garbage_end,
+                                              garbage_tuples.end());
+  garbage_tuples.erase(garbage_end, garbage_tuples.end());
+
+  UnlinkIndexEntries(reclaimed_tuples);
+
+  // the worker fills the slots it reclaimed first, they are still cached
+  for (auto &tuple_metadata : reclaimed_tuples) {
+    if (ResetTuple(tuple_metadata) == false) {
+      continue;
+    }
+    auto tile_group = FreeTupleSlot(tuple_metadata);
+    if (tile_group != nullptr) {
+      local_garbage.free_slot_cursors_[tuple_metadata.table_id] = tile_group;
+    }
+  }
+
+  LOG_TRACE("Worker reclaimed %lu tuples", reclaimed_tuples.size());
+}
+
+void GCManager::ReleaseLocalGarbage() {
+  if (local_garbage_destroyed == true) {
+    return;
+  }
+
+  for (auto &tuple_metadata : local_garbage.garbage_tuples_) {
+    reclaim_queue_.Enqueue(tuple_metadata);
+  }
+  local_garbage.garbage_tuples_.clear();
+}
+
+void GCManager::RetireVarlen(const std::shared_ptr<VarlenPool> &varlen_pool,
+                             Varlen *varlen) {
+  if (this->gc_type_ == GC_TYPE_OFF) {
+    return;
+  }
+
+  RetiredMemory retired_memory;
+  retired_memory.size = varlen->GetAllocatedSize();
+  retired_memory.varlen_pool = varlen_pool;
+  retired_memory.varlen = varlen;
+  RetireMemory(retired_memory);
+}
+
+void GCManager::RetireSegmentPool(storage::RollbackSegmentPool *segment_pool) {
+  // without GC the pool stays, like the versions do
+  if (this->gc_type_ == GC_TYPE_OFF) {
+    return;
+  }
+
+  RetiredMemory retired_memory;
+  retired_memory.size = segment_pool->GetAllocatedMemory();
+  retired_memory.segment_pool = segment_pool;
+  RetireMemory(retired_memory);
+}
+
+void GCManager::RetireTileGroup(
+    const std::shared_ptr<storage::TileGroup> &tile_group) {
+  // transforms are rare, so the tile group is queued even without GC
+  RetiredMemory retired_memory;
+  for (oid_t tile_itr = 0; tile_itr < tile_group->GetTileCount(); tile_itr++) {
+    retired_memory.size += tile_group->GetTile(tile_itr)->GetSize();
+  }
+  retired_memory.tile_group = tile_group;
+  RetireMemory(retired_memory);
+}
+
+void GCManager::RetireMemory(RetiredMemory &retired_memory) {
+  // every running txn began before the current commit id
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  retired_memory.retire_cid = txn_manager.GetCurrentCommitId();
+
+  reclaimable_bytes_ += retired_memory.size;
+  retired_memory_queue_.Enqueue(retired_memory);
+}
+
+void GCManager::ReleaseRetiredMemory(const cid_t &max_cid) {
+  size_t released_bytes = 0;
+  RetiredMemory retired_memory;
+  while (retired_memory_queue_.Dequeue(retired_memory) == true) {
+    // what follows was mostly retired later
+    if (retired_memory.retire_cid > max_cid) {
+      retired_memory_queue_.Enqueue(retired_memory);
+      break;
+    }
+
+    if (retired_memory.segment_pool != nullptr) {
+      delete retired_memory.segment_pool;
+    } else if (retired_memory.tile_group != nullptr) {
+      retired_memory.tile_group.reset();
+    } else {
+      Varlen::Destroy(retired_memory.varlen, retired_memory.varlen_pool.get());
+      retired_memory.varlen_pool.reset();
+    }
+    released_bytes += retired_memory.size;
+  }
+
+  if (released_bytes > 0) {
+    reclaimable_bytes_ -= released_bytes;
+    LOG_TRACE("Released %lu bytes of retired memory", released_bytes);
   }
-  return ItemPointer();
 }
 
 // this function can only be called after:
@@ -237,15 +591,17 @@ ItemPointer GCManager::ReturnFreeSlot(const oid_t &table_id) {
 void GCManager::ClearGarbage() {
   // iterate reclaim queue and reclaim every thing because it's the end of the world now.
   TupleMetadata tuple_metadata;
-  int counter = 0;
+  std::vector<TupleMetadata> garbage_tuples;
   while (reclaim_queue_.Dequeue(tuple_metadata) == true) {
     // In such case, we assume it's the end of the world and every possible
     // garbage is actually garbage
-    AddToRecycleMap(tuple_metadata);
-    counter++;
+    garbage_tuples.push_back(tuple_metadata);
   }
+  RecycleGarbage(garbage_tuples);
+
+  ReleaseRetiredMemory(MAX_CID);
 
-  LOG_TRACE("GCManager finally recyle %d tuples", counter);
+  LOG_TRACE("GCManager finally recyle %lu tuples", garbage_tuples.size());
 }
 
 }  // namespace gc
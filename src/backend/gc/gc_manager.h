@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <thread>
 #include <unordered_map>
 #include <map>
@@ -23,6 +25,15 @@
 #include "libcuckoo/cuckoohash_map.hh"
 
 namespace peloton {
+
+class Varlen;
+class VarlenPool;
+
+namespace storage {
+class TileGroup;
+class RollbackSegmentPool;
+}
+
 namespace gc {
 
 //===--------------------------------------------------------------------===//
@@ -33,6 +44,33 @@ namespace gc {
 #define MAX_QUEUE_LENGTH 100000
 
 #define GC_PERIOD_MILLISECONDS 100
+
+// Possible garbage a worker keeps for itself under cooperative GC, the rest
+// is left to the helper threads
+#define GC_LOCAL_GARBAGE_LIMIT 10000
+
+// Possible garbage a worker takes over from the shared queue when it
+// reclaims its own
+#define GC_ADOPT_BATCH_SIZE 64
+
+// Memory that txns which began before its retire cid may still read: either
+// a varlen in the pool of a tile, a whole rollback segment pool, or a tile
+// group replaced by a transformed one
+struct RetiredMemory {
+  cid_t retire_cid = MAX_CID;
+
+  // Bytes released with it
+  size_t size = 0;
+
+  // The pool stays alive until the varlen is freed into it, even if its
+  // tile is gone by then
+  std::shared_ptr<VarlenPool> varlen_pool;
+  Varlen *varlen = nullptr;
+
+  storage::RollbackSegmentPool *segment_pool = nullptr;
+
+  std::shared_ptr<storage::TileGroup> tile_group;
+};
 class GCBuffer {
 public:
   GCBuffer(oid_t tid):table_id(tid), garbage_tuples() {}
@@ -50,10 +88,13 @@ class GCManager {
   GCManager(GCManager &&) = delete;
   GCManager &operator=(GCManager &&) = delete;
 
-  GCManager(const GCType type)
+  GCManager(const GCType type, const size_t helper_thread_count = 0)
       : is_running_(true),
         gc_type_(type),
-        reclaim_queue_(MAX_QUEUE_LENGTH) {
+        helper_thread_count_(helper_thread_count),
+        reclaim_queue_(MAX_QUEUE_LENGTH),
+        retired_memory_queue_(MAX_QUEUE_LENGTH),
+        reclaimable_bytes_(0) {
     StartGC();
   }
 
@@ -62,6 +103,11 @@ class GCManager {
   // Get status of whether GC thread is running or not
   bool GetStatus() { return this->is_running_; }
 
+  GCType GetGCType() const { return gc_type_; }
+
+  // Switch the GC type, no txn may be running
+  void Reconfigure(const GCType type, const size_t helper_thread_count);
+
   void StartGC();
 
   void StopGC();
@@ -69,8 +115,36 @@ class GCManager {
   void RecycleTupleSlot(const oid_t &table_id, const oid_t &tile_group_id,
                         const oid_t &tuple_id, const cid_t &tuple_end_cid);
 
+  // Return a free slot of the table, from the tile group the calling thread
+  // took its last free slot from if it has any left
   ItemPointer ReturnFreeSlot(const oid_t &table_id);
 
+  // Under cooperative GC, reclaim the garbage of the calling worker that no
+  // running txn can see anymore. Called whenever the worker ends a txn,
+  // it only does work once per epoch.
+  void CollectLocalGarbage();
+
+  // Hand the garbage of the calling worker to the shared queue, when the
+  // worker exits
+  void ReleaseLocalGarbage();
+
+  // Hand over a varlen of a tuple whose slot is reset or overwritten in
+  // place. It is freed back to its pool once the txns running now are gone.
+  void RetireVarlen(const std::shared_ptr<VarlenPool> &varlen_pool,
+                    Varlen *varlen);
+
+  // Hand over a rollback segment pool none of whose segments is linked
+  // anymore. It is deleted once the txns running now are gone.
+  void RetireSegmentPool(storage::RollbackSegmentPool *segment_pool);
+
+  // Hand over a tile group that was replaced in the catalog. Txns may still
+  // hold it from the table directory, so the reference goes once they are
+  // gone.
+  void RetireTileGroup(const std::shared_ptr<storage::TileGroup> &tile_group);
+
+  // Bytes handed over to the GC that are not released yet
+  size_t GetReclaimableBytes() const { return reclaimable_bytes_.load(); }
+
  private:
   void Running();
 
@@ -84,19 +158,45 @@ class GCManager {
 
   void AddToRecycleMap(TupleMetadata tuple_metadata);
 
+  // Mark the slot of a reset tuple as free in its tile group. Return the tile
+  // group, or nullptr if it no longer exists.
+  std::shared_ptr<storage::TileGroup> FreeTupleSlot(
+      const TupleMetadata &tuple_metadata);
+
+  // Remove the index entries of reclaimed versions, in one batch per index,
+  // before their slots can be reused
+  void UnlinkIndexEntries(const std::vector<TupleMetadata> &garbage_tuples);
+
+  // Unlink and recycle a batch of reclaimed versions
+  void RecycleGarbage(const std::vector<TupleMetadata> &garbage_tuples);
+
+  void RetireMemory(RetiredMemory &retired_memory);
+
+  // Release the retired memory no running txn can read anymore, in one batch
+  void ReleaseRetiredMemory(const cid_t &max_cid);
+
   //===--------------------------------------------------------------------===//
   // Data members
   //===--------------------------------------------------------------------===//
   volatile bool is_running_;
   GCType gc_type_;
 
-  std::unique_ptr<std::thread> gc_thread_;
+  // Threads that drain the shared reclaim queue under cooperative GC
+  size_t helper_thread_count_;
+
+  std::vector<std::unique_ptr<std::thread>> gc_threads_;
 
   // TODO: use shared pointer to reduce memory copy
   LockfreeQueue<TupleMetadata> reclaim_queue_;
 
-  // TODO: use shared pointer to reduce memory copy
-  cuckoohash_map<oid_t, std::shared_ptr<LockfreeQueue<TupleMetadata>>>
+  // Retired memory, about in the order of the retire cids
+  LockfreeQueue<RetiredMemory> retired_memory_queue_;
+
+  std::atomic<size_t> reclaimable_bytes_;
+
+  // Tile groups of every table that got a free slot since they last ran
+  // out of them. Inserts take slots from the bitmap of these tile groups.
+  cuckoohash_map<oid_t, std::shared_ptr<LockfreeQueue<oid_t>>>
       recycle_queue_map_;
 };
 
@@ -20,11 +20,16 @@ namespace gc {
 class GCManagerFactory {
  public:
   static GCManager &GetInstance() {
-    static GCManager gc_manager(GC_TYPE_ON);
+    static GCManager gc_manager(gc_type_);
     return gc_manager;
   }
 
-  static void Configure(GCType gc_type) { gc_type_ = gc_type; }
+  // Helper threads only run under cooperative GC, the regular GC always has
+  // its one thread
+  static void Configure(GCType gc_type, size_t helper_thread_count = 0) {
+    gc_type_ = gc_type;
+    GetInstance().Reconfigure(gc_type, helper_thread_count);
+  }
 
   static GCType GetGCType() { return gc_type_; }
 
@@ -0,0 +1,453 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// tile_group_compactor.cpp
+//
+// Identification: src/backend/gc/tile_group_compactor.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "backend/gc/tile_group_compactor.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "backend/catalog/manager.h"
+#include "backend/common/logger.h"
+#include "backend/common/pool.h"
+#include "backend/concurrency/transaction_manager_factory.h"
+#include "backend/expression/container_tuple.h"
+#include "backend/gc/gc_manager_factory.h"
+#include "backend/index/index.h"
+#include "backend/storage/data_table.h"
+#include "backend/storage/database.h"
+#include "backend/storage/tile_group.h"
+#include "backend/storage/tile_group_header.h"
+#include "backend/storage/tuple.h"
+
+namespace peloton {
+namespace gc {
+
+namespace {
+
+// Number of committed versions of the tile group that are not replaced
+oid_t CountLiveTuples(storage::TileGroupHeader *tile_group_header) {
+  oid_t live_tuple_count = 0;
+  oid_t tuple_count = tile_group_header->GetCurrentNextTupleSlot();
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    if (tile_group_header->GetTransactionId(tuple_id) == INITIAL_TXN_ID &&
+        tile_group_header->GetEndCommitId(tuple_id) == MAX_CID) {
+      live_tuple_count++;
+    }
+  }
+  return live_tuple_count;
+}
+
+// Whether every used slot of the tile group is reset or was never committed
+bool IsEmpty(storage::TileGroupHeader *tile_group_header) {
+  oid_t tuple_count = tile_group_header->GetCurrentNextTupleSlot();
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    if (tile_group_header->GetTransactionId(tuple_id) != INVALID_TXN_ID ||
+        tile_group_header->GetBeginCommitId(tuple_id) != MAX_CID) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Build the key of an index from a version
+std::unique_ptr<storage::Tuple> BuildKey(index::Index *index,
+                                         storage::TileGroup *tile_group,
+                                         const oid_t &tuple_id) {
+  expression::ContainerTuple<storage::TileGroup> tuple(tile_group, tuple_id);
+  auto key_schema = index->GetKeySchema();
+  auto indexed_columns = key_schema->GetIndexedColumns();
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+  for (oid_t column_itr = 0; column_itr < indexed_columns.size();
+       column_itr++) {
+    key->SetValue(column_itr, tuple.GetValue(indexed_columns[column_itr]),
+                  index->GetPool());
+  }
+  return key;
+}
+
+}  // End anonymous namespace
+
+TileGroupCompactor &TileGroupCompactor::GetInstance() {
+  static TileGroupCompactor tile_group_compactor;
+  return tile_group_compactor;
+}
+
+void TileGroupCompactor::StartCompactor() {
+  if (is_running_ == true) {
+    return;
+  }
+  LOG_TRACE("Starting compactor");
+  is_running_ = true;
+  compactor_thread_.reset(
+      new std::thread(&TileGroupCompactor::Running, this));
+}
+
+void TileGroupCompactor::StopCompactor() {
+  if (is_running_ == false) {
+    return;
+  }
+  LOG_TRACE("Stopping compactor");
+  is_running_ = false;
+  compactor_thread_->join();
+  compactor_thread_.reset();
+}
+
+void TileGroupCompactor::Running() {
+  while (is_running_ == true) {
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(COMPACTION_PERIOD_MILLISECONDS));
+
+    auto &catalog_manager = catalog::Manager::GetInstance();
+    for (oid_t database_itr = 0;
+         database_itr < catalog_manager.GetDatabaseCount(); database_itr++) {
+      auto database = catalog_manager.GetDatabase(database_itr);
+      for (oid_t table_itr = 0; table_itr < database->GetTableCount();
+           table_itr++) {
+        CompactTable(database->GetTable(table_itr));
+      }
+    }
+
+    ReleaseTileGroups();
+  }
+}
+
+size_t TileGroupCompactor::CompactTable(storage::DataTable *table) {
+  if (GCManagerFactory::GetGCType() == GC_TYPE_OFF ||
+      concurrency::TransactionManagerFactory::GetProtocol() ==
+          CONCURRENCY_TYPE_OCC_RB) {
+    return 0;
+  }
+  for (oid_t index_itr = 0; index_itr < table->GetIndexCount(); index_itr++) {
+    if (table->GetIndex(index_itr)->GetIndexType() ==
+        INDEX_CONSTRAINT_TYPE_UNIQUE) {
+      return 0;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(compactor_mutex_);
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto max_cid = txn_manager.GetMaxCommittedCid();
+
+  // Pick the sparse tile groups first, so the tuples of one are not moved
+  // into another. The last tile group takes the appends.
+  std::vector<std::shared_ptr<storage::TileGroup>> compacted_tile_groups;
+  auto tile_group_count = table->GetTileGroupCount();
+  for (oid_t tile_group_offset = 0; tile_group_offset + 1 < tile_group_count;
+       tile_group_offset++) {
+    auto tile_group = table->GetTileGroup(tile_group_offset);
+    if (tile_group == nullptr) {
+      continue;
+    }
+
+    auto tile_group_header = tile_group->GetHeader();
+    if (tile_group_header->IsCompacting() == false) {
+      if (CountLiveTuples(tile_group_header) >=
+          COMPACTION_OCCUPANCY_THRESHOLD *
+              tile_group->GetAllocatedTupleCount()) {
+        continue;
+      }
+      tile_group_header->BeginCompaction(txn_manager.GetNextCommitId());
+      LOG_TRACE("Compacting tile group %u", tile_group->GetTileGroupId());
+    }
+    compacted_tile_groups.push_back(tile_group);
+  }
+
+  size_t unlinked_count = 0;
+  for (auto &tile_group : compacted_tile_groups) {
+    auto tile_group_header = tile_group->GetHeader();
+
+    if (CountLiveTuples(tile_group_header) > 0) {
+      RelocateTuples(table, tile_group.get());
+    }
+
+    ReclaimVersions(table, tile_group.get(), max_cid);
+
+    // txns that took a free slot before the compaction began may still
+    // insert into the tile group until they are gone
+    if (tile_group_header->GetCompactionBeginCid() > max_cid ||
+        IsEmpty(tile_group_header) == false) {
+      continue;
+    }
+
+    UnlinkIndexEntries(table, tile_group.get());
+    table->UnlinkTileGroup(tile_group->GetTileGroupId());
+
+    RetiredTileGroup retired_tile_group;
+    retired_tile_group.tile_group_id = tile_group->GetTileGroupId();
+    retired_tile_group.retire_cid = txn_manager.GetNextCommitId();
+    retired_tile_groups_.push_back(retired_tile_group);
+    unlinked_count++;
+
+    LOG_TRACE("Unlinked tile group %u from table %u",
+              retired_tile_group.tile_group_id, table->GetOid());
+  }
+
+  return unlinked_count;
+}
+
+size_t TileGroupCompactor::ReleaseTileGroups() {
+  std::lock_guard<std::mutex> lock(compactor_mutex_);
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto max_cid = txn_manager.GetMaxCommittedCid();
+
+  auto released_begin = std::partition(
+      retired_tile_groups_.begin(), retired_tile_groups_.end(),
+      [max_cid](const RetiredTileGroup &retired_tile_group) {
+        return retired_tile_group.retire_cid > max_cid;
+      });
+
+  // the catalog holds the last reference to the tile group, the storage
+  // manager gets the memory of its tiles back when it is dropped
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  for (auto retired_itr = released_begin;
+       retired_itr != retired_tile_groups_.end(); retired_itr++) {
+    catalog_manager.DropTileGroup(retired_itr->tile_group_id);
+    LOG_TRACE("Released tile group %u", retired_itr->tile_group_id);
+  }
+
+  size_t released_count = retired_tile_groups_.end() - released_begin;
+  retired_tile_groups_.erase(released_begin, retired_tile_groups_.end());
+  return released_count;
+}
+
+void TileGroupCompactor::RelocateTuples(storage::DataTable *table,
+                                        storage::TileGroup *tile_group) {
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto tile_group_header = tile_group->GetHeader();
+  auto tile_group_id = tile_group->GetTileGroupId();
+  auto schema = table->GetSchema();
+  std::unique_ptr<VarlenPool> pool(new VarlenPool(BACKEND_TYPE_MM));
+
+  txn_manager.BeginTransaction();
+
+  oid_t tuple_count = tile_group->GetNextTupleSlot();
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    // a newer version is already in another tile group, or on its way there
+    if (txn_manager.IsVisible(tile_group_header, tuple_id) == false ||
+        txn_manager.IsOwnable(tile_group_header, tuple_id) == false) {
+      continue;
+    }
+
+    // the tuple is read before it is updated, like the update executor does
+    ItemPointer old_location(tile_group_id, tuple_id);
+    if (txn_manager.PerformRead(old_location) == false) {
+      txn_manager.AbortTransaction();
+      return;
+    }
+
+    if (txn_manager.AcquireOwnership(tile_group_header, tile_group_id,
+                                     tuple_id) == false) {
+      txn_manager.AbortTransaction();
+      return;
+    }
+
+    expression::ContainerTuple<storage::TileGroup> old_tuple(tile_group,
+                                                             tuple_id);
+    std::unique_ptr<storage::Tuple> new_tuple(new storage::Tuple(schema, true));
+    for (oid_t column_itr = 0; column_itr < schema->GetColumnCount();
+         column_itr++) {
+      new_tuple->SetValue(column_itr, old_tuple.GetValue(column_itr),
+                          pool.get());
+    }
+
+    // the tile group hands out no free slots, so the new version goes
+    // elsewhere
+    ItemPointer new_location = table->InsertVersion(new_tuple.get());
+    if (new_location.IsNull() == true) {
+      txn_manager.AbortTransaction();
+      return;
+    }
+    txn_manager.PerformUpdate(old_location, new_location);
+
+    LOG_TRACE("Relocate tuple (%u, %u) to (%u, %u)", tile_group_id, tuple_id,
+              new_location.block, new_location.offset);
+  }
+
+  txn_manager.CommitTransaction();
+}
+
+void TileGroupCompactor::ReclaimVersions(storage::DataTable *table,
+                                         storage::TileGroup *tile_group,
+                                         const cid_t &max_cid) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group_header = tile_group->GetHeader();
+  auto tile_group_id = tile_group->GetTileGroupId();
+
+  oid_t tuple_count = tile_group->GetNextTupleSlot();
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    auto txn_id = tile_group_header->GetTransactionId(tuple_id);
+    auto begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+
+    // a replaced version no txn can see, or the empty version of a delete
+    bool dead_version = (txn_id == INITIAL_TXN_ID &&
+                         tile_group_header->GetEndCommitId(tuple_id) <= max_cid);
+    bool dead_delete = (txn_id == INVALID_TXN_ID && begin_cid != MAX_CID &&
+                        begin_cid <= max_cid);
+    if (dead_version == false && dead_delete == false) {
+      continue;
+    }
+
+    // the versions of the chain go in order, from the oldest one
+    ItemPointer head(tile_group_id, tuple_id);
+    while (true) {
+      auto head_tile_group = manager.GetTileGroup(head.block);
+      if (head_tile_group == nullptr) {
+        break;
+      }
+      auto prev = head_tile_group->GetHeader()->GetPrevItemPointer(head.offset);
+      if (prev.IsNull() == true) {
+        break;
+      }
+      head = prev;
+    }
+
+    CollapseVersionChain(table, head, max_cid);
+  }
+}
+
+void TileGroupCompactor::CollapseVersionChain(storage::DataTable *table,
+                                              ItemPointer head,
+                                              const cid_t &max_cid) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto &gc_manager = GCManagerFactory::GetInstance();
+
+  // the primary index points to the head of the chain
+  index::Index *primary_index = nullptr;
+  for (oid_t index_itr = 0; index_itr < table->GetIndexCount(); index_itr++) {
+    auto index = table->GetIndex(index_itr);
+    if (index->GetIndexType() == INDEX_CONSTRAINT_TYPE_PRIMARY_KEY) {
+      primary_index = index;
+    }
+  }
+  std::unique_ptr<storage::Tuple> key;
+  ItemPointer *head_location_ptr = nullptr;
+
+  while (true) {
+    auto tile_group = manager.GetTileGroup(head.block);
+    if (tile_group == nullptr) {
+      return;
+    }
+    auto tile_group_header = tile_group->GetHeader();
+
+    // An index scan may have moved the primary index entry on to the empty
+    // version of a delete. It holds no key, so the entry is left to the
+    // index scans, which skip it once the tile group is released.
+    if (tile_group_header->GetTransactionId(head.offset) == INVALID_TXN_ID) {
+      auto begin_cid = tile_group_header->GetBeginCommitId(head.offset);
+      if (begin_cid != MAX_CID && begin_cid <= max_cid &&
+          tile_group_header->GetNextItemPointer(head.offset).IsNull()) {
+        gc_manager.RecycleTupleSlot(table->GetOid(), head.block, head.offset,
+                                    txn_manager.GetNextCommitId());
+      }
+      return;
+    }
+
+    if (tile_group_header->GetTransactionId(head.offset) != INITIAL_TXN_ID ||
+        tile_group_header->GetEndCommitId(head.offset) > max_cid) {
+      return;
+    }
+
+    auto next = tile_group_header->GetNextItemPointer(head.offset);
+    if (next.IsNull() == true) {
+      return;
+    }
+    auto next_tile_group = manager.GetTileGroup(next.block);
+    if (next_tile_group == nullptr) {
+      return;
+    }
+    auto next_tile_group_header = next_tile_group->GetHeader();
+
+    if (primary_index != nullptr && head_location_ptr == nullptr) {
+      key = BuildKey(primary_index, tile_group.get(), head.offset);
+      std::vector<ItemPointer *> location_ptrs;
+      primary_index->ScanKey(key.get(), location_ptrs);
+      for (auto location_ptr : location_ptrs) {
+        if (location_ptr->block == head.block &&
+            location_ptr->offset == head.offset) {
+          head_location_ptr = location_ptr;
+        }
+      }
+      // the version is not at the head of its chain anymore
+      if (head_location_ptr == nullptr) {
+        return;
+      }
+    }
+
+    // index scans may collapse the chain at the same time
+    if (tile_group_header->SetAtomicTransactionId(head.offset,
+                                                  INVALID_TXN_ID) == false) {
+      return;
+    }
+    cid_t garbage_cid = txn_manager.GetNextCommitId();
+
+    // the tuple was deleted, the whole chain is garbage
+    auto next_begin_cid = next_tile_group_header->GetBeginCommitId(next.offset);
+    if (next_tile_group_header->GetTransactionId(next.offset) ==
+            INVALID_TXN_ID &&
+        next_begin_cid != MAX_CID && next_begin_cid <= max_cid) {
+      if (primary_index != nullptr) {
+        primary_index->DeleteEntry(key.get(), head);
+      }
+      gc_manager.RecycleTupleSlot(table->GetOid(), head.block, head.offset,
+                                  garbage_cid);
+      gc_manager.RecycleTupleSlot(table->GetOid(), next.block, next.offset,
+                                  garbage_cid);
+      return;
+    }
+
+    if (head_location_ptr != nullptr) {
+      AtomicUpdateItemPointer(head_location_ptr, next);
+    }
+    next_tile_group_header->SetPrevItemPointer(next.offset,
+                                               INVALID_ITEMPOINTER);
+    gc_manager.RecycleTupleSlot(table->GetOid(), head.block, head.offset,
+                                garbage_cid);
+
+    LOG_TRACE("Collapse version (%u, %u)", head.block, head.offset);
+    head = next;
+  }
+}
+
+void TileGroupCompactor::UnlinkIndexEntries(storage::DataTable *table,
+                                            storage::TileGroup *tile_group) {
+  auto tile_group_header = tile_group->GetHeader();
+  auto tile_group_id = tile_group->GetTileGroupId();
+  oid_t tuple_count = tile_group->GetNextTupleSlot();
+
+  for (oid_t index_itr = 0; index_itr < table->GetIndexCount(); index_itr++) {
+    auto index = table->GetIndex(index_itr);
+
+    std::vector<std::unique_ptr<storage::Tuple>> keys;
+    std::vector<const storage::Tuple *> key_ptrs;
+    std::vector<ItemPointer> locations;
+    for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+      // The gc unlinked the entries of a reset slot while its version still
+      // held the keys. Its uninlined values are gone, so the keys cannot be
+      // built again.
+      if (tile_group_header->IsFreeTupleSlot(tuple_id) == true) {
+        continue;
+      }
+      keys.push_back(BuildKey(index, tile_group, tuple_id));
+      key_ptrs.push_back(keys.back().get());
+      locations.push_back(ItemPointer(tile_group_id, tuple_id));
+    }
+
+    index->DeleteEntries(key_ptrs, locations);
+    index->Cleanup();
+  }
+}
+
+}  // namespace gc
+}  // namespace peloton
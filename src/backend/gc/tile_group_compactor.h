@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// tile_group_compactor.h
+//
+// Identification: src/backend/gc/tile_group_compactor.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "backend/common/types.h"
+
+namespace peloton {
+
+namespace storage {
+class DataTable;
+class TileGroup;
+}
+
+namespace gc {
+
+//===--------------------------------------------------------------------===//
+// Tile Group Compactor
+//===--------------------------------------------------------------------===//
+
+// Tile groups with fewer live tuples than this share of their slots are
+// compacted
+#define COMPACTION_OCCUPANCY_THRESHOLD 0.25
+
+#define COMPACTION_PERIOD_MILLISECONDS 1000
+
+/**
+ * Tables only ever grow by appending tile groups, and the GC only recycles
+ * slots, so a table keeps the tile groups it once needed. The compactor
+ * moves the live tuples out of sparse tile groups and releases them.
+ *
+ * A tile group goes through these steps, one compaction round each at least:
+ *  1. It stops handing out free slots.
+ *  2. A txn updates each live tuple to an identical version in another tile
+ *     group. The old versions forward to the new ones like after any update.
+ *  3. Once no txn can see them anymore, the old versions are unlinked from
+ *     the primary index like index scans do, and handed to the GC.
+ *  4. Once the GC has reset every slot, the tile group is removed from the
+ *     table and from the indexes.
+ *  5. Once the txns that might have found it before are gone, it is dropped
+ *     from the catalog, which releases its memory.
+ *
+ * Compaction needs the GC and out-of-place updates, so it does nothing under
+ * OCC_RB. Tables with unique secondary indexes are skipped, as the new
+ * versions would collide with the old ones.
+ */
+class TileGroupCompactor {
+ public:
+  TileGroupCompactor(const TileGroupCompactor &) = delete;
+  TileGroupCompactor &operator=(const TileGroupCompactor &) = delete;
+
+  TileGroupCompactor() : is_running_(false) {}
+
+  ~TileGroupCompactor() { StopCompactor(); }
+
+  static TileGroupCompactor &GetInstance();
+
+  // Compact the tables of all databases in the background
+  void StartCompactor();
+
+  void StopCompactor();
+
+  // Run one compaction round over the tile groups of the table. Return the
+  // number of tile groups removed from it.
+  size_t CompactTable(storage::DataTable *table);
+
+  // Drop the removed tile groups no txn can see anymore. Return the number
+  // of tile groups dropped.
+  size_t ReleaseTileGroups();
+
+ private:
+  void Running();
+
+  // Update the live tuples of the tile group to versions in other tile
+  // groups, in one txn
+  void RelocateTuples(storage::DataTable *table,
+                      storage::TileGroup *tile_group);
+
+  // Reclaim the dead versions of the tile group, with the dead versions that
+  // precede them in their version chains
+  void ReclaimVersions(storage::DataTable *table,
+                       storage::TileGroup *tile_group, const cid_t &max_cid);
+
+  // Unlink the dead versions at the head of a version chain
+  void CollapseVersionChain(storage::DataTable *table, ItemPointer head,
+                            const cid_t &max_cid);
+
+  // Remove the entries of all indexes that still point to versions the gc
+  // never reset, e.g. those of aborted inserts. The gc removes the entries
+  // of the versions it resets before it resets them.
+  void UnlinkIndexEntries(storage::DataTable *table,
+                          storage::TileGroup *tile_group);
+
+  // A tile group removed from its table
+  struct RetiredTileGroup {
+    oid_t tile_group_id;
+
+    // txns that began before may still see the tile group
+    cid_t retire_cid;
+  };
+
+  volatile bool is_running_;
+
+  std::unique_ptr<std::thread> compactor_thread_;
+
+  // one compaction round at a time
+  std::mutex compactor_mutex_;
+
+  std::vector<RetiredTileGroup> retired_tile_groups_;
+};
+
+}  // namespace gc
+}  // namespace peloton
@@ -0,0 +1,1383 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// art.h
+//
+// Identification: src/backend/index/art.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "backend/common/macros.h"
+#include "backend/common/platform.h"
+#include "backend/index/bwtree.h"
+#include "backend/index/olc_latch.h"
+
+namespace peloton {
+namespace index {
+
+//===--------------------------------------------------------------------===//
+// AdaptiveRadixTree
+//===--------------------------------------------------------------------===//
+
+/**
+ * Adaptive radix tree (Leis et al., ICDE 2013) synchronized with optimistic
+ * lock coupling (Leis et al., DaMoN 2016).
+ *
+ * The tree branches on one key byte per level. Inner nodes come in four
+ * sizes (4, 16, 48 and 256 children) and grow into the next size when they
+ * run out of room. Bytes shared by every key below a node are stored in the
+ * node itself (path compression), and a key gets a leaf as soon as no other
+ * key shares its path (lazy expansion).
+ *
+ * KeyType must have a fixed length and provide GetKeyByte(), such that keys
+ * compare like their byte strings. A leaf holds a key with all of its
+ * values and is never modified once linked: changing the values installs a
+ * new copy. Every inner node carries a version latch. Readers never write
+ * to shared memory and restart when a version changed under them; writers
+ * lock the node whose child pointer they change, plus the parent when the
+ * node itself is replaced. Replaced nodes and leaves are freed by the epoch
+ * manager once no reader can still follow a pointer to them.
+ *
+ * An inner node that would be left with a single child is merged into it,
+ * but nodes are not shrunk into a smaller size.
+ */
+template <typename KeyType, typename ValueType,
+          typename ValueEqualityChecker = std::equal_to<ValueType>>
+class AdaptiveRadixTree {
+  AdaptiveRadixTree(const AdaptiveRadixTree &) = delete;
+  AdaptiveRadixTree &operator=(const AdaptiveRadixTree &) = delete;
+
+ public:
+  AdaptiveRadixTree(ValueEqualityChecker value_equals = ValueEqualityChecker());
+
+  ~AdaptiveRadixTree();
+
+  // Add the <key, value> pair
+  void Insert(const KeyType &key, const ValueType &value);
+
+  // Build an empty tree bottom-up from pairs sorted in key order, with
+  // every node created at its final size. Must not run concurrently with
+  // other operations. Falls back to inserting the pairs if the tree is not
+  // empty.
+  void BulkLoad(const std::vector<std::pair<KeyType, ValueType>> &items);
+
+  // Add the <key, value> pair unless the predicate holds for a value that
+  // is already stored with the key. Return true if the pair was added.
+  bool ConditionalInsert(const KeyType &key, const ValueType &value,
+                         std::function<bool(const ValueType &)> predicate);
+
+  // Remove all copies of the <key, value> pair. Return true if any existed.
+  bool Delete(const KeyType &key, const ValueType &value);
+
+  // Append all values of the key
+  void GetValue(const KeyType &key, std::vector<ValueType> &result);
+
+  // Append all values of a batch of keys sorted in key order. Every lookup
+  // resumes below the deepest node that its key shares with the previous
+  // key, instead of descending from the root again.
+  void GetValues(const std::vector<KeyType> &keys,
+                 std::vector<ValueType> &result);
+
+  // Visit the pairs with low <= key <= high in key order, until the visitor
+  // returns false. A null bound is unbounded. Only the subtrees whose path
+  // lies between the bounds are visited, so bounds that share their leading
+  // bytes turn into a prefix scan.
+  void ScanRange(
+      const KeyType *low, const KeyType *high,
+      std::function<bool(const KeyType &, const ValueType &)> visitor);
+
+  void PerformGarbageCollection() {
+    epoch_manager_.PerformGarbageCollection();
+  }
+
+  size_t GetMemoryFootprint() const { return memory_footprint_.load(); }
+
+ private:
+  static const size_t KEY_LENGTH = sizeof(KeyType);
+
+  //===--------------------------------------------------------------------===//
+  // Nodes
+  //===--------------------------------------------------------------------===//
+
+  enum NodeType : uint8_t {
+    NODE_TYPE_4 = 0,
+    NODE_TYPE_16 = 1,
+    NODE_TYPE_48 = 2,
+    NODE_TYPE_256 = 3
+  };
+
+  struct Node {
+    Node(NodeType type) : type(type), count(0), prefix_length(0) {}
+
+    OLCLatch latch;
+    const NodeType type;
+
+    // number of children
+    uint16_t count;
+
+    // key bytes shared by every key below the node
+    uint8_t prefix_length;
+    uint8_t prefix[KEY_LENGTH];
+  };
+
+  // Children are sorted by key byte
+  struct Node4 : public Node {
+    Node4() : Node(NODE_TYPE_4) {}
+
+    uint8_t keys[4];
+    Node *children[4];
+  };
+
+  struct Node16 : public Node {
+    Node16() : Node(NODE_TYPE_16) {}
+
+    uint8_t keys[16];
+    Node *children[16];
+  };
+
+  // A key byte maps to a child slot plus one, zero means no child
+  struct Node48 : public Node {
+    Node48() : Node(NODE_TYPE_48) {
+      PL_MEMSET(child_index, 0, sizeof(child_index));
+      PL_MEMSET(children, 0, sizeof(children));
+    }
+
+    uint8_t child_index[256];
+    Node *children[48];
+  };
+
+  struct Node256 : public Node {
+    Node256() : Node(NODE_TYPE_256) {
+      PL_MEMSET(children, 0, sizeof(children));
+    }
+
+    Node *children[256];
+  };
+
+  // Leaves are stored in the child pointers with the lowest bit set
+  struct Leaf {
+    Leaf(const KeyType &key) : key(key) {}
+
+    KeyType key;
+    std::vector<ValueType> values;
+  };
+
+  //===--------------------------------------------------------------------===//
+  // Helpers
+  //===--------------------------------------------------------------------===//
+
+  static bool IsLeaf(const Node *node) {
+    return (reinterpret_cast<uintptr_t>(node) & 1) == 1;
+  }
+
+  static Leaf *GetLeaf(const Node *node) {
+    return reinterpret_cast<Leaf *>(reinterpret_cast<uintptr_t>(node) & ~1);
+  }
+
+  static Node *MakeLeafReference(const Leaf *leaf) {
+    return reinterpret_cast<Node *>(reinterpret_cast<uintptr_t>(leaf) | 1);
+  }
+
+  static bool KeyEqual(const KeyType &lhs, const KeyType &rhs) {
+    return CompareKeys(lhs, rhs) == 0;
+  }
+
+  // Compare two keys byte by byte
+  static int CompareKeys(const KeyType &lhs, const KeyType &rhs);
+
+  // Child of a node, or null. May be called concurrently with a writer.
+  static Node *FindChild(const Node *node, uint8_t key_byte);
+
+  // Children of a node in key byte order. Returns the number of children.
+  static size_t GetChildren(const Node *node, uint8_t *key_bytes,
+                            Node **children);
+
+  static bool IsFull(const Node *node);
+
+  // Modifications of a locked node
+  static void AddChild(Node *node, uint8_t key_byte, Node *child);
+
+  static void ChangeChild(Node *node, uint8_t key_byte, Node *child);
+
+  static void RemoveChild(Node *node, uint8_t key_byte);
+
+  // Copy of a full node with room for more children
+  Node *Grow(const Node *node);
+
+  // Insert the pair unless the predicate holds for a value of the key
+  bool InsertHelper(const KeyType &key, const ValueType &value,
+                    std::function<bool(const ValueType &)> *predicate);
+
+  // Subtree of the sorted pairs in [begin, end), which share the key bytes
+  // before the depth
+  Node *BuildSubtree(const std::vector<std::pair<KeyType, ValueType>> &items,
+                     size_t begin, size_t end, size_t depth);
+
+  // Add the subtrees of the pairs in [begin, end) to a new node, branching
+  // on the key byte at the depth
+  void BuildChildren(Node *node,
+                     const std::vector<std::pair<KeyType, ValueType>> &items,
+                     size_t begin, size_t end, size_t depth);
+
+  // An inner node on the path of a lookup, with the version it was read at
+  // and the depth of the key byte it starts at
+  struct PathEntry {
+    const Node *node;
+    uint64_t version;
+    size_t depth;
+  };
+
+  struct ScanState {
+    const KeyType *low;
+    const KeyType *high;
+
+    // the low bound itself is out of the range
+    bool low_exclusive;
+
+    // the last key handed to the visitor, where a restarted scan resumes
+    bool has_last_key;
+    KeyType last_key;
+
+    std::function<bool(const KeyType &, const ValueType &)> *visitor;
+
+    bool restart;
+  };
+
+  // Visit the subtree of a node read at the given version. Returns false
+  // once the scan is over or has to be restarted.
+  bool ScanNode(const Node *node, uint64_t node_version, size_t depth,
+                bool low_tight, bool high_tight, ScanState &state);
+
+  Leaf *NewLeaf(const KeyType &key, std::vector<ValueType> values);
+
+  Node4 *NewNode4();
+
+  void RetireLeaf(Leaf *leaf);
+
+  void RetireNode(Node *node);
+
+  static void DeleteLeaf(void *leaf);
+
+  static void DeleteNode(void *node);
+
+  // Free a subtree when the tree is destroyed
+  void FreeNode(Node *node);
+
+  static size_t GetNodeSize(const Node *node);
+
+  static size_t GetLeafSize(const Leaf *leaf) {
+    return sizeof(Leaf) + leaf->values.capacity() * sizeof(ValueType);
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Data members
+  //===--------------------------------------------------------------------===//
+
+  // The root is never replaced
+  Node256 *root_;
+
+  ValueEqualityChecker value_equals_;
+
+  std::atomic<size_t> memory_footprint_;
+
+  BWTreeEpochManager epoch_manager_;
+};
+
+//===--------------------------------------------------------------------===//
+// Implementation
+//===--------------------------------------------------------------------===//
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::AdaptiveRadixTree(
+    ValueEqualityChecker value_equals)
+    : root_(new Node256()),
+      value_equals_(value_equals),
+      memory_footprint_(sizeof(Node256)) {}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+AdaptiveRadixTree<KeyType, ValueType,
+                  ValueEqualityChecker>::~AdaptiveRadixTree() {
+  FreeNode(root_);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::FreeNode(
+    Node *node) {
+  if (IsLeaf(node)) {
+    delete GetLeaf(node);
+    return;
+  }
+
+  uint8_t key_bytes[256];
+  Node *children[256];
+  size_t count = GetChildren(node, key_bytes, children);
+  for (size_t child_itr = 0; child_itr < count; child_itr++) {
+    FreeNode(children[child_itr]);
+  }
+
+  DeleteNode(node);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+int AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::CompareKeys(
+    const KeyType &lhs, const KeyType &rhs) {
+  for (size_t byte_itr = 0; byte_itr < KEY_LENGTH; byte_itr++) {
+    uint8_t lhs_byte = lhs.GetKeyByte(byte_itr);
+    uint8_t rhs_byte = rhs.GetKeyByte(byte_itr);
+    if (lhs_byte != rhs_byte) {
+      return (lhs_byte < rhs_byte) ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+typename AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::Node *
+AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::FindChild(
+    const Node *node, uint8_t key_byte) {
+  switch (node->type) {
+    case NODE_TYPE_4: {
+      auto node4 = static_cast<const Node4 *>(node);
+      size_t count = std::min<size_t>(node4->count, 4);
+      for (size_t child_itr = 0; child_itr < count; child_itr++) {
+        if (node4->keys[child_itr] == key_byte) {
+          return node4->children[child_itr];
+        }
+      }
+      return nullptr;
+    }
+    case NODE_TYPE_16: {
+      auto node16 = static_cast<const Node16 *>(node);
+      size_t count = std::min<size_t>(node16->count, 16);
+      for (size_t child_itr = 0; child_itr < count; child_itr++) {
+        if (node16->keys[child_itr] == key_byte) {
+          return node16->children[child_itr];
+        }
+      }
+      return nullptr;
+    }
+    case NODE_TYPE_48: {
+      auto node48 = static_cast<const Node48 *>(node);
+      uint8_t slot = node48->child_index[key_byte];
+      if (slot == 0 || slot > 48) {
+        return nullptr;
+      }
+      return node48->children[slot - 1];
+    }
+    case NODE_TYPE_256:
+      return static_cast<const Node256 *>(node)->children[key_byte];
+  }
+  return nullptr;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+size_t AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::GetChildren(
+    const Node *node, uint8_t *key_bytes, Node **children) {
+  size_t count = 0;
+
+  switch (node->type) {
+    case NODE_TYPE_4: {
+      auto node4 = static_cast<const Node4 *>(node);
+      count = std::min<size_t>(node4->count, 4);
+      std::copy(node4->keys, node4->keys + count, key_bytes);
+      std::copy(node4->children, node4->children + count, children);
+      break;
+    }
+    case NODE_TYPE_16: {
+      auto node16 = static_cast<const Node16 *>(node);
+      count = std::min<size_t>(node16->count, 16);
+      std::copy(node16->keys, node16->keys + count, key_bytes);
+      std::copy(node16->children, node16->children + count, children);
+      break;
+    }
+    case NODE_TYPE_48: {
+      auto node48 = static_cast<const Node48 *>(node);
+      for (size_t key_byte = 0; key_byte < 256; key_byte++) {
+        uint8_t slot = node48->child_index[key_byte];
+        if (slot != 0 && slot <= 48 && node48->children[slot - 1] != nullptr) {
+          key_bytes[count] = key_byte;
+          children[count] = node48->children[slot - 1];
+          count++;
+        }
+      }
+      break;
+    }
+    case NODE_TYPE_256: {
+      auto node256 = static_cast<const Node256 *>(node);
+      for (size_t key_byte = 0; key_byte < 256; key_byte++) {
+        if (node256->children[key_byte] != nullptr) {
+          key_bytes[count] = key_byte;
+          children[count] = node256->children[key_byte];
+          count++;
+        }
+      }
+      break;
+    }
+  }
+
+  return count;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+bool AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::IsFull(
+    const Node *node) {
+  switch (node->type) {
+    case NODE_TYPE_4:
+      return node->count == 4;
+    case NODE_TYPE_16:
+      return node->count == 16;
+    case NODE_TYPE_48:
+      return node->count == 48;
+    case NODE_TYPE_256:
+      return false;
+  }
+  return false;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::AddChild(
+    Node *node, uint8_t key_byte, Node *child) {
+  PL_ASSERT(IsFull(node) == false);
+
+  switch (node->type) {
+    case NODE_TYPE_4: {
+      auto node4 = static_cast<Node4 *>(node);
+      size_t position = std::upper_bound(node4->keys,
+                                         node4->keys + node4->count, key_byte) -
+                        node4->keys;
+      std::copy_backward(node4->keys + position, node4->keys + node4->count,
+                         node4->keys + node4->count + 1);
+      std::copy_backward(node4->children + position,
+                         node4->children + node4->count,
+                         node4->children + node4->count + 1);
+      node4->keys[position] = key_byte;
+      node4->children[position] = child;
+      break;
+    }
+    case NODE_TYPE_16: {
+      auto node16 = static_cast<Node16 *>(node);
+      size_t position =
+          std::upper_bound(node16->keys, node16->keys + node16->count,
+                           key_byte) -
+          node16->keys;
+      std::copy_backward(node16->keys + position,
+                         node16->keys + node16->count,
+                         node16->keys + node16->count + 1);
+      std::copy_backward(node16->children + position,
+                         node16->children + node16->count,
+                         node16->children + node16->count + 1);
+      node16->keys[position] = key_byte;
+      node16->children[position] = child;
+      break;
+    }
+    case NODE_TYPE_48: {
+      auto node48 = static_cast<Node48 *>(node);
+      size_t slot = 0;
+      while (node48->children[slot] != nullptr) {
+        slot++;
+      }
+      node48->children[slot] = child;
+      node48->child_index[key_byte] = slot + 1;
+      break;
+    }
+    case NODE_TYPE_256:
+      static_cast<Node256 *>(node)->children[key_byte] = child;
+      break;
+  }
+
+  node->count++;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::ChangeChild(
+    Node *node, uint8_t key_byte, Node *child) {
+  switch (node->type) {
+    case NODE_TYPE_4: {
+      auto node4 = static_cast<Node4 *>(node);
+      for (size_t child_itr = 0; child_itr < node4->count; child_itr++) {
+        if (node4->keys[child_itr] == key_byte) {
+          node4->children[child_itr] = child;
+          return;
+        }
+      }
+      break;
+    }
+    case NODE_TYPE_16: {
+      auto node16 = static_cast<Node16 *>(node);
+      for (size_t child_itr = 0; child_itr < node16->count; child_itr++) {
+        if (node16->keys[child_itr] == key_byte) {
+          node16->children[child_itr] = child;
+          return;
+        }
+      }
+      break;
+    }
+    case NODE_TYPE_48: {
+      auto node48 = static_cast<Node48 *>(node);
+      PL_ASSERT(node48->child_index[key_byte] != 0);
+      node48->children[node48->child_index[key_byte] - 1] = child;
+      return;
+    }
+    case NODE_TYPE_256:
+      static_cast<Node256 *>(node)->children[key_byte] = child;
+      return;
+  }
+
+  PL_ASSERT(false);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::RemoveChild(
+    Node *node, uint8_t key_byte) {
+  switch (node->type) {
+    case NODE_TYPE_4: {
+      auto node4 = static_cast<Node4 *>(node);
+      size_t position =
+          std::find(node4->keys, node4->keys + node4->count, key_byte) -
+          node4->keys;
+      PL_ASSERT(position < node4->count);
+      std::copy(node4->keys + position + 1, node4->keys + node4->count,
+                node4->keys + position);
+      std::copy(node4->children + position + 1,
+                node4->children + node4->count, node4->children + position);
+      break;
+    }
+    case NODE_TYPE_16: {
+      auto node16 = static_cast<Node16 *>(node);
+      size_t position =
+          std::find(node16->keys, node16->keys + node16->count, key_byte) -
+          node16->keys;
+      PL_ASSERT(position < node16->count);
+      std::copy(node16->keys + position + 1, node16->keys + node16->count,
+                node16->keys + position);
+      std::copy(node16->children + position + 1,
+                node16->children + node16->count,
+                node16->children + position);
+      break;
+    }
+    case NODE_TYPE_48: {
+      auto node48 = static_cast<Node48 *>(node);
+      PL_ASSERT(node48->child_index[key_byte] != 0);
+      node48->children[node48->child_index[key_byte] - 1] = nullptr;
+      node48->child_index[key_byte] = 0;
+      break;
+    }
+    case NODE_TYPE_256:
+      static_cast<Node256 *>(node)->children[key_byte] = nullptr;
+      break;
+  }
+
+  node->count--;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+typename AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::Node *
+AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::Grow(
+    const Node *node) {
+  Node *grown = nullptr;
+  switch (node->type) {
+    case NODE_TYPE_4:
+      grown = new Node16();
+      break;
+    case NODE_TYPE_16:
+      grown = new Node48();
+      break;
+    case NODE_TYPE_48:
+      grown = new Node256();
+      break;
+    case NODE_TYPE_256:
+      PL_ASSERT(false);
+      break;
+  }
+  memory_footprint_ += GetNodeSize(grown);
+
+  grown->prefix_length = node->prefix_length;
+  PL_MEMCPY(grown->prefix, node->prefix, node->prefix_length);
+
+  uint8_t key_bytes[256];
+  Node *children[256];
+  size_t count = GetChildren(node, key_bytes, children);
+  for (size_t child_itr = 0; child_itr < count; child_itr++) {
+    AddChild(grown, key_bytes[child_itr], children[child_itr]);
+  }
+
+  return grown;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+typename AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::Leaf *
+AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::NewLeaf(
+    const KeyType &key, std::vector<ValueType> values) {
+  Leaf *leaf = new Leaf(key);
+  leaf->values.swap(values);
+  memory_footprint_ += GetLeafSize(leaf);
+  return leaf;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+typename AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::Node4 *
+AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::NewNode4() {
+  Node4 *node = new Node4();
+  memory_footprint_ += sizeof(Node4);
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::RetireLeaf(
+    Leaf *leaf) {
+  memory_footprint_ -= GetLeafSize(leaf);
+  epoch_manager_.Retire(leaf, &DeleteLeaf);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::RetireNode(
+    Node *node) {
+  memory_footprint_ -= GetNodeSize(node);
+  epoch_manager_.Retire(node, &DeleteNode);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::DeleteLeaf(
+    void *leaf) {
+  delete static_cast<Leaf *>(leaf);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::DeleteNode(
+    void *node) {
+  Node *inner = static_cast<Node *>(node);
+  switch (inner->type) {
+    case NODE_TYPE_4:
+      delete static_cast<Node4 *>(inner);
+      break;
+    case NODE_TYPE_16:
+      delete static_cast<Node16 *>(inner);
+      break;
+    case NODE_TYPE_48:
+      delete static_cast<Node48 *>(inner);
+      break;
+    case NODE_TYPE_256:
+      delete static_cast<Node256 *>(inner);
+      break;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+size_t AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::GetNodeSize(
+    const Node *node) {
+  switch (node->type) {
+    case NODE_TYPE_4:
+      return sizeof(Node4);
+    case NODE_TYPE_16:
+      return sizeof(Node16);
+    case NODE_TYPE_48:
+      return sizeof(Node48);
+    case NODE_TYPE_256:
+      return sizeof(Node256);
+  }
+  return 0;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::Insert(
+    const KeyType &key, const ValueType &value) {
+  InsertHelper(key, value, nullptr);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::BulkLoad(
+    const std::vector<std::pair<KeyType, ValueType>> &items) {
+  if (root_->count > 0) {
+    for (auto &item : items) {
+      Insert(item.first, item.second);
+    }
+    return;
+  }
+
+  BuildChildren(root_, items, 0, items.size(), 0);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+typename AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::Node *
+AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::BuildSubtree(
+    const std::vector<std::pair<KeyType, ValueType>> &items, size_t begin,
+    size_t end, size_t depth) {
+  // The range is sorted, so its first and last keys share the fewest bytes
+  const KeyType &first_key = items[begin].first;
+  const KeyType &last_key = items[end - 1].first;
+  if (KeyEqual(first_key, last_key)) {
+    std::vector<ValueType> values;
+    values.reserve(end - begin);
+    for (size_t item_itr = begin; item_itr < end; item_itr++) {
+      values.push_back(items[item_itr].second);
+    }
+    return MakeLeafReference(NewLeaf(first_key, std::move(values)));
+  }
+
+  size_t prefix_length = 0;
+  while (first_key.GetKeyByte(depth + prefix_length) ==
+         last_key.GetKeyByte(depth + prefix_length)) {
+    prefix_length++;
+  }
+
+  // Size the node for the number of distinct bytes it branches on
+  size_t child_count = 1;
+  size_t branch_depth = depth + prefix_length;
+  for (size_t item_itr = begin + 1; item_itr < end; item_itr++) {
+    if (items[item_itr].first.GetKeyByte(branch_depth) !=
+        items[item_itr - 1].first.GetKeyByte(branch_depth)) {
+      child_count++;
+    }
+  }
+
+  Node *node;
+  if (child_count <= 4) {
+    node = new Node4();
+  } else if (child_count <= 16) {
+    node = new Node16();
+  } else if (child_count <= 48) {
+    node = new Node48();
+  } else {
+    node = new Node256();
+  }
+  memory_footprint_ += GetNodeSize(node);
+
+  node->prefix_length = prefix_length;
+  for (size_t byte_itr = 0; byte_itr < prefix_length; byte_itr++) {
+    node->prefix[byte_itr] = first_key.GetKeyByte(depth + byte_itr);
+  }
+
+  BuildChildren(node, items, begin, end, branch_depth);
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::BuildChildren(
+    Node *node, const std::vector<std::pair<KeyType, ValueType>> &items,
+    size_t begin, size_t end, size_t depth) {
+  size_t child_begin = begin;
+  while (child_begin < end) {
+    uint8_t key_byte = items[child_begin].first.GetKeyByte(depth);
+    size_t child_end = child_begin + 1;
+    while (child_end < end &&
+           items[child_end].first.GetKeyByte(depth) == key_byte) {
+      child_end++;
+    }
+
+    AddChild(node, key_byte,
+             BuildSubtree(items, child_begin, child_end, depth + 1));
+    child_begin = child_end;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+bool AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::
+    ConditionalInsert(const KeyType &key, const ValueType &value,
+                      std::function<bool(const ValueType &)> predicate) {
+  return InsertHelper(key, value, &predicate);
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+bool AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::InsertHelper(
+    const KeyType &key, const ValueType &value,
+    std::function<bool(const ValueType &)> *predicate) {
+  BWTreeEpochGuard guard(epoch_manager_);
+
+restart:
+  Node *node = root_;
+  uint64_t node_version = node->latch.ReadLock();
+
+  Node *parent = nullptr;
+  uint64_t parent_version = 0;
+  uint8_t parent_key_byte = 0;
+  size_t depth = 0;
+
+  while (true) {
+    // A torn read of the prefix length; the version check will fail
+    size_t prefix_length = node->prefix_length;
+    if (depth + prefix_length >= KEY_LENGTH) {
+      goto restart;
+    }
+
+    size_t mismatch = 0;
+    while (mismatch < prefix_length &&
+           node->prefix[mismatch] == key.GetKeyByte(depth + mismatch)) {
+      mismatch++;
+    }
+
+    // The key leaves the compressed path: branch off where they differ
+    if (mismatch < prefix_length) {
+      PL_ASSERT(parent != nullptr);
+      if (parent->latch.Upgrade(parent_version) == false) {
+        goto restart;
+      }
+      if (node->latch.Upgrade(node_version) == false) {
+        parent->latch.WriteUnlock();
+        goto restart;
+      }
+
+      Node4 *branch = NewNode4();
+      branch->prefix_length = mismatch;
+      PL_MEMCPY(branch->prefix, node->prefix, mismatch);
+
+      Leaf *leaf = NewLeaf(key, std::vector<ValueType>(1, value));
+      AddChild(branch, node->prefix[mismatch], node);
+      AddChild(branch, key.GetKeyByte(depth + mismatch),
+               MakeLeafReference(leaf));
+
+      // The node keeps the bytes below the branch
+      node->prefix_length = prefix_length - mismatch - 1;
+      std::copy(node->prefix + mismatch + 1, node->prefix + prefix_length,
+                node->prefix);
+
+      ChangeChild(parent, parent_key_byte, branch);
+
+      node->latch.WriteUnlock();
+      parent->latch.WriteUnlock();
+      return true;
+    }
+
+    depth += prefix_length;
+    uint8_t key_byte = key.GetKeyByte(depth);
+    Node *child = FindChild(node, key_byte);
+
+    if (node->latch.Validate(node_version) == false) {
+      goto restart;
+    }
+
+    if (child == nullptr) {
+      if (IsFull(node)) {
+        // Replace the node with a larger copy
+        PL_ASSERT(parent != nullptr);
+        if (parent->latch.Upgrade(parent_version) == false) {
+          goto restart;
+        }
+        if (node->latch.Upgrade(node_version) == false) {
+          parent->latch.WriteUnlock();
+          goto restart;
+        }
+
+        Leaf *leaf = NewLeaf(key, std::vector<ValueType>(1, value));
+        Node *grown = Grow(node);
+        AddChild(grown, key_byte, MakeLeafReference(leaf));
+        ChangeChild(parent, parent_key_byte, grown);
+
+        node->latch.WriteUnlockObsolete();
+        parent->latch.WriteUnlock();
+        RetireNode(node);
+        return true;
+      }
+
+      if (node->latch.Upgrade(node_version) == false) {
+        goto restart;
+      }
+
+      Leaf *leaf = NewLeaf(key, std::vector<ValueType>(1, value));
+      AddChild(node, key_byte, MakeLeafReference(leaf));
+
+      node->latch.WriteUnlock();
+      return true;
+    }
+
+    if (IsLeaf(child)) {
+      if (node->latch.Upgrade(node_version) == false) {
+        goto restart;
+      }
+
+      Leaf *leaf = GetLeaf(child);
+      if (KeyEqual(leaf->key, key)) {
+        // The node latch covers the leaf, so the check and the insert are
+        // atomic
+        if (predicate != nullptr) {
+          for (auto &existing_value : leaf->values) {
+            if ((*predicate)(existing_value)) {
+              node->latch.WriteUnlock();
+              return false;
+            }
+          }
+        }
+
+        std::vector<ValueType> values;
+        values.reserve(leaf->values.size() + 1);
+        values.insert(values.end(), leaf->values.begin(), leaf->values.end());
+        values.push_back(value);
+
+        Leaf *new_leaf = NewLeaf(key, std::move(values));
+        ChangeChild(node, key_byte, MakeLeafReference(new_leaf));
+
+        node->latch.WriteUnlock();
+        RetireLeaf(leaf);
+        return true;
+      }
+
+      // Both keys share the path so far: branch where they differ
+      Node4 *branch = NewNode4();
+      size_t branch_depth = depth + 1;
+      size_t common_length = 0;
+      while (leaf->key.GetKeyByte(branch_depth + common_length) ==
+             key.GetKeyByte(branch_depth + common_length)) {
+        branch->prefix[common_length] = key.GetKeyByte(branch_depth +
+                                                       common_length);
+        common_length++;
+      }
+      branch->prefix_length = common_length;
+
+      Leaf *new_leaf = NewLeaf(key, std::vector<ValueType>(1, value));
+      AddChild(branch, leaf->key.GetKeyByte(branch_depth + common_length),
+               child);
+      AddChild(branch, key.GetKeyByte(branch_depth + common_length),
+               MakeLeafReference(new_leaf));
+      ChangeChild(node, key_byte, branch);
+
+      node->latch.WriteUnlock();
+      return true;
+    }
+
+    parent = node;
+    parent_version = node_version;
+    parent_key_byte = key_byte;
+
+    node = child;
+    node_version = node->latch.ReadLock();
+    if (parent->latch.Validate(parent_version) == false) {
+      goto restart;
+    }
+
+    depth++;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+bool AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::Delete(
+    const KeyType &key, const ValueType &value) {
+  BWTreeEpochGuard guard(epoch_manager_);
+
+restart:
+  Node *node = root_;
+  uint64_t node_version = node->latch.ReadLock();
+
+  Node *parent = nullptr;
+  uint64_t parent_version = 0;
+  uint8_t parent_key_byte = 0;
+  size_t depth = 0;
+
+  while (true) {
+    size_t prefix_length = node->prefix_length;
+    if (depth + prefix_length >= KEY_LENGTH) {
+      goto restart;
+    }
+
+    for (size_t byte_itr = 0; byte_itr < prefix_length; byte_itr++) {
+      if (node->prefix[byte_itr] != key.GetKeyByte(depth + byte_itr)) {
+        if (node->latch.Validate(node_version) == false) {
+          goto restart;
+        }
+        return false;
+      }
+    }
+
+    depth += prefix_length;
+    uint8_t key_byte = key.GetKeyByte(depth);
+    Node *child = FindChild(node, key_byte);
+
+    if (node->latch.Validate(node_version) == false) {
+      goto restart;
+    }
+
+    if (child == nullptr) {
+      return false;
+    }
+
+    if (IsLeaf(child)) {
+      Leaf *leaf = GetLeaf(child);
+      if (KeyEqual(leaf->key, key) == false) {
+        return false;
+      }
+
+      std::vector<ValueType> remaining_values;
+      for (auto &existing_value : leaf->values) {
+        if (value_equals_(existing_value, value) == false) {
+          remaining_values.push_back(existing_value);
+        }
+      }
+
+      if (remaining_values.size() == leaf->values.size()) {
+        return false;
+      }
+
+      if (remaining_values.empty() == false) {
+        if (node->latch.Upgrade(node_version) == false) {
+          goto restart;
+        }
+
+        Leaf *new_leaf = NewLeaf(key, std::move(remaining_values));
+        ChangeChild(node, key_byte, MakeLeafReference(new_leaf));
+
+        node->latch.WriteUnlock();
+        RetireLeaf(leaf);
+        return true;
+      }
+
+      // The node would be left with a single child: merge the two
+      if (parent != nullptr && node->count == 2) {
+        if (parent->latch.Upgrade(parent_version) == false) {
+          goto restart;
+        }
+        if (node->latch.Upgrade(node_version) == false) {
+          parent->latch.WriteUnlock();
+          goto restart;
+        }
+
+        uint8_t key_bytes[256];
+        Node *children[256];
+        GetChildren(node, key_bytes, children);
+        size_t other = (key_bytes[0] == key_byte) ? 1 : 0;
+        Node *sibling = children[other];
+
+        if (IsLeaf(sibling) == false) {
+          // The sibling takes over the path of the node
+          sibling->latch.WriteLock();
+
+          uint8_t prefix[KEY_LENGTH];
+          size_t sibling_prefix_length = node->prefix_length + 1 +
+                                         sibling->prefix_length;
+          PL_ASSERT(sibling_prefix_length < KEY_LENGTH);
+          PL_MEMCPY(prefix, node->prefix, node->prefix_length);
+          prefix[node->prefix_length] = key_bytes[other];
+          PL_MEMCPY(prefix + node->prefix_length + 1, sibling->prefix,
+                    sibling->prefix_length);
+
+          PL_MEMCPY(sibling->prefix, prefix, sibling_prefix_length);
+          sibling->prefix_length = sibling_prefix_length;
+
+          sibling->latch.WriteUnlock();
+        }
+
+        ChangeChild(parent, parent_key_byte, sibling);
+
+        node->latch.WriteUnlockObsolete();
+        parent->latch.WriteUnlock();
+        RetireNode(node);
+        RetireLeaf(leaf);
+        return true;
+      }
+
+      if (node->latch.Upgrade(node_version) == false) {
+        goto restart;
+      }
+
+      RemoveChild(node, key_byte);
+
+      node->latch.WriteUnlock();
+      RetireLeaf(leaf);
+      return true;
+    }
+
+    parent = node;
+    parent_version = node_version;
+    parent_key_byte = key_byte;
+
+    node = child;
+    node_version = node->latch.ReadLock();
+    if (parent->latch.Validate(parent_version) == false) {
+      goto restart;
+    }
+
+    depth++;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::GetValue(
+    const KeyType &key, std::vector<ValueType> &result) {
+  BWTreeEpochGuard guard(epoch_manager_);
+
+restart:
+  const Node *node = root_;
+  uint64_t node_version = node->latch.ReadLock();
+  size_t depth = 0;
+
+  while (true) {
+    size_t prefix_length = node->prefix_length;
+    if (depth + prefix_length >= KEY_LENGTH) {
+      goto restart;
+    }
+
+    for (size_t byte_itr = 0; byte_itr < prefix_length; byte_itr++) {
+      if (node->prefix[byte_itr] != key.GetKeyByte(depth + byte_itr)) {
+        if (node->latch.Validate(node_version) == false) {
+          goto restart;
+        }
+        return;
+      }
+    }
+
+    depth += prefix_length;
+    const Node *child = FindChild(node, key.GetKeyByte(depth));
+
+    if (node->latch.Validate(node_version) == false) {
+      goto restart;
+    }
+
+    if (child == nullptr) {
+      return;
+    }
+
+    // Linked leaves are never modified
+    if (IsLeaf(child)) {
+      const Leaf *leaf = GetLeaf(child);
+      if (KeyEqual(leaf->key, key)) {
+        result.insert(result.end(), leaf->values.begin(), leaf->values.end());
+      }
+      return;
+    }
+
+    uint64_t child_version = child->latch.ReadLock();
+    if (node->latch.Validate(node_version) == false) {
+      goto restart;
+    }
+
+    node = child;
+    node_version = child_version;
+    depth++;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::GetValues(
+    const std::vector<KeyType> &keys, std::vector<ValueType> &result) {
+  BWTreeEpochGuard guard(epoch_manager_);
+
+  std::vector<PathEntry> path;
+  const KeyType *previous_key = nullptr;
+
+  for (const auto &key : keys) {
+    // A node that starts at depth d was reached through the first d key
+    // bytes, so it is on the path of every key sharing them
+    size_t shared_length = 0;
+    if (previous_key != nullptr) {
+      while (shared_length < KEY_LENGTH &&
+             previous_key->GetKeyByte(shared_length) ==
+                 key.GetKeyByte(shared_length)) {
+        shared_length++;
+      }
+    }
+    previous_key = &key;
+
+    while (path.empty() == false && path.back().depth > shared_length) {
+      path.pop_back();
+    }
+
+  restart:
+    if (path.empty() == false &&
+        path.back().node->latch.Validate(path.back().version) == false) {
+      path.clear();
+    }
+
+    if (path.empty()) {
+      path.push_back({root_, root_->latch.ReadLock(), 0});
+    }
+
+    const Node *node = path.back().node;
+    uint64_t node_version = path.back().version;
+    size_t depth = path.back().depth;
+
+    while (true) {
+      size_t prefix_length = node->prefix_length;
+      if (depth + prefix_length >= KEY_LENGTH) {
+        path.clear();
+        goto restart;
+      }
+
+      bool prefix_matches = true;
+      for (size_t byte_itr = 0; byte_itr < prefix_length; byte_itr++) {
+        if (node->prefix[byte_itr] != key.GetKeyByte(depth + byte_itr)) {
+          prefix_matches = false;
+          break;
+        }
+      }
+
+      const Node *child = nullptr;
+      if (prefix_matches) {
+        child = FindChild(node, key.GetKeyByte(depth + prefix_length));
+      }
+
+      if (node->latch.Validate(node_version) == false) {
+        path.clear();
+        goto restart;
+      }
+
+      if (child == nullptr) {
+        break;
+      }
+
+      // Linked leaves are never modified
+      if (IsLeaf(child)) {
+        const Leaf *leaf = GetLeaf(child);
+        if (KeyEqual(leaf->key, key)) {
+          result.insert(result.end(), leaf->values.begin(),
+                        leaf->values.end());
+        }
+        break;
+      }
+
+      uint64_t child_version = child->latch.ReadLock();
+      if (node->latch.Validate(node_version) == false) {
+        path.clear();
+        goto restart;
+      }
+
+      node = child;
+      node_version = child_version;
+      depth += prefix_length + 1;
+      path.push_back({node, node_version, depth});
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+void AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::ScanRange(
+    const KeyType *low, const KeyType *high,
+    std::function<bool(const KeyType &, const ValueType &)> visitor) {
+  BWTreeEpochGuard guard(epoch_manager_);
+
+  ScanState state;
+  state.low = low;
+  state.high = high;
+  state.low_exclusive = false;
+  state.has_last_key = false;
+  state.visitor = &visitor;
+
+  while (true) {
+    state.restart = false;
+    ScanNode(root_, root_->latch.ReadLock(), 0, state.low != nullptr,
+             state.high != nullptr, state);
+
+    if (state.restart == false) {
+      return;
+    }
+
+    // Resume after the last key that was handed out
+    if (state.has_last_key) {
+      state.low = &state.last_key;
+      state.low_exclusive = true;
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename ValueEqualityChecker>
+bool AdaptiveRadixTree<KeyType, ValueType, ValueEqualityChecker>::ScanNode(
+    const Node *node, uint64_t node_version, size_t depth, bool low_tight,
+    bool high_tight, ScanState &state) {
+  // Take a consistent snapshot of the node
+  uint8_t prefix[KEY_LENGTH];
+  size_t prefix_length = node->prefix_length;
+  if (prefix_length > KEY_LENGTH) {
+    prefix_length = KEY_LENGTH;
+  }
+  PL_MEMCPY(prefix, node->prefix, prefix_length);
+
+  uint8_t key_bytes[256];
+  Node *children[256];
+  size_t count = GetChildren(node, key_bytes, children);
+
+  if (node->latch.Validate(node_version) == false ||
+      depth + prefix_length >= KEY_LENGTH) {
+    state.restart = true;
+    return false;
+  }
+
+  // While the path equals the prefix of a bound, the subtree may straddle
+  // it; once it differs, the whole subtree is on one side
+  for (size_t byte_itr = 0; byte_itr < prefix_length; byte_itr++) {
+    uint8_t key_byte = prefix[byte_itr];
+    if (low_tight) {
+      uint8_t low_byte = state.low->GetKeyByte(depth + byte_itr);
+      if (key_byte < low_byte) {
+        return true;
+      }
+      low_tight = (key_byte == low_byte);
+    }
+    if (high_tight) {
+      uint8_t high_byte = state.high->GetKeyByte(depth + byte_itr);
+      if (key_byte > high_byte) {
+        return false;
+      }
+      high_tight = (key_byte == high_byte);
+    }
+  }
+  depth += prefix_length;
+
+  for (size_t child_itr = 0; child_itr < count; child_itr++) {
+    uint8_t key_byte = key_bytes[child_itr];
+    bool child_low_tight = low_tight;
+    bool child_high_tight = high_tight;
+
+    if (child_low_tight) {
+      uint8_t low_byte = state.low->GetKeyByte(depth);
+      if (key_byte < low_byte) {
+        continue;
+      }
+      child_low_tight = (key_byte == low_byte);
+    }
+    if (child_high_tight) {
+      uint8_t high_byte = state.high->GetKeyByte(depth);
+      if (key_byte > high_byte) {
+        return false;
+      }
+      child_high_tight = (key_byte == high_byte);
+    }
+
+    Node *child = children[child_itr];
+
+    if (IsLeaf(child)) {
+      const Leaf *leaf = GetLeaf(child);
+
+      if (state.low != nullptr) {
+        int low_cmp = CompareKeys(leaf->key, *state.low);
+        if (low_cmp < 0 || (low_cmp == 0 && state.low_exclusive)) {
+          continue;
+        }
+      }
+      if (state.high != nullptr && CompareKeys(leaf->key, *state.high) > 0) {
+        return false;
+      }
+
+      state.has_last_key = true;
+      state.last_key = leaf->key;
+      for (auto &value : leaf->values) {
+        if ((*state.visitor)(leaf->key, value) == false) {
+          return false;
+        }
+      }
+      continue;
+    }
+
+    uint64_t child_version = child->latch.ReadLock();
+    if (node->latch.Validate(node_version) == false) {
+      state.restart = true;
+      return false;
+    }
+
+    if (ScanNode(child, child_version, depth + 1, child_low_tight,
+                 child_high_tight, state) == false) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // End index namespace
+}  // End peloton namespace
@@ -0,0 +1,355 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// art_index.cpp
+//
+// Identification: src/backend/index/art_index.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+
+#include "backend/common/logger.h"
+#include "backend/index/art_index.h"
+#include "backend/index/index_key.h"
+#include "backend/storage/tuple.h"
+
+namespace peloton {
+namespace index {
+
+template <typename KeyType, typename ValueType>
+ARTIndex<KeyType, ValueType>::ARTIndex(IndexMetadata *metadata)
+    : Index(metadata) {}
+
+template <typename KeyType, typename ValueType>
+ARTIndex<KeyType, ValueType>::~ARTIndex() {
+  // the location cells go away with the item pointer pool
+}
+
+template <typename KeyType, typename ValueType>
+bool ARTIndex<KeyType, ValueType>::InsertEntry(const storage::Tuple *key,
+                                               const ItemPointer &location) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  container.Insert(index_key, item_pointer_pool->Allocate(location));
+
+  return true;
+}
+
+template <typename KeyType, typename ValueType>
+bool ARTIndex<KeyType, ValueType>::DeleteEntry(const storage::Tuple *key,
+                                               const ItemPointer &location) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  std::vector<ItemPointer *> values;
+  container.GetValue(index_key, values);
+
+  // Delete every < key, location > pair
+  for (auto value : values) {
+    if ((value->block == location.block) &&
+        (value->offset == location.offset)) {
+      // Only the thread that unlinked the pointer may retire it
+      if (container.Delete(index_key, value)) {
+        item_pointer_pool->Retire(value);
+      }
+    }
+  }
+
+  return true;
+}
+
+template <typename KeyType, typename ValueType>
+bool ARTIndex<KeyType, ValueType>::CondInsertEntry(
+    const storage::Tuple *key, const ItemPointer &location,
+    std::function<bool(const ItemPointer &)> predicate) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  ItemPointer *value = item_pointer_pool->Allocate(location);
+  bool inserted = container.ConditionalInsert(
+      index_key, value, [&predicate](ItemPointer *const &item_pointer) {
+        // this key is already visible or dirty in the index
+        return predicate(*item_pointer);
+      });
+
+  if (inserted == false) {
+    item_pointer_pool->Deallocate(value);
+  }
+
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType>
+void ARTIndex<KeyType, ValueType>::BulkLoad(
+    const std::vector<const storage::Tuple *> &keys,
+    const std::vector<ItemPointer> &locations) {
+  PL_ASSERT(keys.size() == locations.size());
+  std::vector<std::pair<KeyType, ValueType>> entries(keys.size());
+  for (size_t entry_itr = 0; entry_itr < keys.size(); entry_itr++) {
+    entries[entry_itr].first.SetFromKey(keys[entry_itr]);
+    entries[entry_itr].second =
+        item_pointer_pool->Allocate(locations[entry_itr]);
+  }
+
+  // the tree is built bottom-up from the sorted entries
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const std::pair<KeyType, ValueType> &lhs,
+                      const std::pair<KeyType, ValueType> &rhs) {
+    return KeyLess(lhs.first, rhs.first);
+  });
+
+  container.BulkLoad(entries);
+}
+
+template <typename KeyType, typename ValueType>
+bool ARTIndex<KeyType, ValueType>::ScanHelper(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction, const KeyType *resume_key,
+    std::function<bool(const KeyType &, ItemPointer *)> visitor) {
+  if (scan_direction != SCAN_DIRECTION_TYPE_FORWARD &&
+      scan_direction != SCAN_DIRECTION_TYPE_BACKWARD) {
+    throw Exception("Invalid scan direction \n");
+  }
+
+  auto key_schema = metadata->GetKeySchema();
+
+  // Integer keys are unpacked into a key tuple for the comparison
+  storage::Tuple tuple(key_schema, true);
+
+  // Compare the current key in the scan with "values" based on
+  // "expression types"
+  // For instance, "5" EXPR_GREATER_THAN "2" is true
+  bool finished = true;
+  auto scan_visitor = [&](const KeyType &scan_current_key,
+                          ItemPointer *const &location) {
+    // the keys up to the resume key have been visited before
+    if (resume_key != nullptr &&
+        KeyLess(*resume_key, scan_current_key) == false) {
+      return true;
+    }
+
+    scan_current_key.GetKeyTuple(&tuple);
+    if (Compare(tuple, key_column_ids, expr_types, values) == true &&
+        visitor(scan_current_key, location) == false) {
+      finished = false;
+    }
+    return finished;
+  };
+
+  // SPECIAL CASE : see BTreeIndex::Scan
+  bool special_case = true;
+  for (auto expr_type : expr_types) {
+    if (expr_type == EXPRESSION_TYPE_COMPARE_NOTEQUAL ||
+        expr_type == EXPRESSION_TYPE_COMPARE_IN ||
+        expr_type == EXPRESSION_TYPE_COMPARE_LIKE ||
+        expr_type == EXPRESSION_TYPE_COMPARE_NOTLIKE) {
+      special_case = false;
+      break;
+    }
+  }
+
+  LOG_TRACE("Special case : %d ", special_case);
+
+  if (special_case == false || key_column_ids.size() == 0) {
+    container.ScanRange(resume_key, nullptr, scan_visitor);
+    return finished;
+  }
+
+  // Assumption: must have leading column, assume it's first one in
+  // key_column_ids.
+  PL_ASSERT(key_column_ids.size() > 0);
+  oid_t leading_column_id = key_column_ids[0];
+  std::vector<std::pair<Value, Value>> intervals;
+
+  ConstructIntervals(leading_column_id, values, key_column_ids, expr_types,
+                     intervals);
+
+  // For non-leading columns, find the max and min
+  std::map<oid_t, std::pair<Value, Value>> non_leading_columns;
+  FindMaxMinInColumns(leading_column_id, values, key_column_ids, expr_types,
+                      non_leading_columns);
+
+  for (auto key_column_id : key_schema->GetIndexedColumns()) {
+    if (non_leading_columns.find(key_column_id) == non_leading_columns.end()) {
+      auto type = key_schema->GetColumn(key_column_id).column_type;
+      std::pair<Value, Value> range(Value::GetMinValue(type),
+                                    Value::GetMaxValue(type));
+      non_leading_columns.insert(std::make_pair(key_column_id, range));
+    }
+  }
+
+  // Search each interval of leading_column.
+  for (const auto &interval : intervals) {
+    std::unique_ptr<storage::Tuple> start_key(
+        new storage::Tuple(key_schema, true));
+    std::unique_ptr<storage::Tuple> end_key(
+        new storage::Tuple(key_schema, true));
+
+    LOG_TRACE("left bound %s\t\t right bound %s\n",
+              interval.first.GetInfo().c_str(),
+              interval.second.GetInfo().c_str());
+
+    start_key->SetValue(leading_column_id, interval.first, GetPool());
+    end_key->SetValue(leading_column_id, interval.second, GetPool());
+
+    for (const auto &k_v : non_leading_columns) {
+      start_key->SetValue(k_v.first, k_v.second.first, GetPool());
+      end_key->SetValue(k_v.first, k_v.second.second, GetPool());
+    }
+
+    KeyType start_index_key;
+    KeyType end_index_key;
+    start_index_key.SetFromKey(start_key.get());
+    end_index_key.SetFromKey(end_key.get());
+
+    // skip what has been visited before the resume key
+    const KeyType *low_key = &start_index_key;
+    if (resume_key != nullptr) {
+      if (KeyLess(end_index_key, *resume_key)) continue;
+      if (KeyLess(start_index_key, *resume_key)) low_key = resume_key;
+    }
+
+    container.ScanRange(low_key, &end_index_key, scan_visitor);
+    if (finished == false) return false;
+  }
+
+  return true;
+}
+
+template <typename KeyType, typename ValueType>
+void ARTIndex<KeyType, ValueType>::Scan(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction, std::vector<ItemPointer> &result) {
+  ScanHelper(values, key_column_ids, expr_types, scan_direction, nullptr,
+             [&result](const KeyType &, ItemPointer *location) {
+    result.push_back(*location);
+    return true;
+  });
+}
+
+template <typename KeyType, typename ValueType>
+void ARTIndex<KeyType, ValueType>::ScanAllKeys(
+    std::vector<ItemPointer> &result) {
+  container.ScanRange(nullptr, nullptr,
+                      [&result](const KeyType &, ItemPointer *const &location) {
+    result.push_back(*location);
+    return true;
+  });
+}
+
+template <typename KeyType, typename ValueType>
+void ARTIndex<KeyType, ValueType>::ScanKey(const storage::Tuple *key,
+                                           std::vector<ItemPointer> &result) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  std::vector<ItemPointer *> locations;
+  container.GetValue(index_key, locations);
+
+  for (auto location : locations) {
+    result.push_back(*location);
+  }
+}
+
+template <typename KeyType, typename ValueType>
+void ARTIndex<KeyType, ValueType>::Scan(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction,
+    std::vector<ItemPointer *> &result) {
+  ScanHelper(values, key_column_ids, expr_types, scan_direction, nullptr,
+             [&result](const KeyType &, ItemPointer *location) {
+    result.push_back(location);
+    return true;
+  });
+}
+
+template <typename KeyType, typename ValueType>
+void ARTIndex<KeyType, ValueType>::ScanAllKeys(
+    std::vector<ItemPointer *> &result) {
+  container.ScanRange(nullptr, nullptr,
+                      [&result](const KeyType &, ItemPointer *const &location) {
+    result.push_back(location);
+    return true;
+  });
+}
+
+/**
+ * @brief Return all locations related to this key.
+ */
+template <typename KeyType, typename ValueType>
+void ARTIndex<KeyType, ValueType>::ScanKey(
+    const storage::Tuple *key, std::vector<ItemPointer *> &result) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  container.GetValue(index_key, result);
+}
+
+template <typename KeyType, typename ValueType>
+void ARTIndex<KeyType, ValueType>::ScanKeys(
+    const std::vector<const storage::Tuple *> &keys,
+    std::vector<ItemPointer *> &result) {
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t key_itr = 0; key_itr < keys.size(); key_itr++) {
+    index_keys[key_itr].SetFromKey(keys[key_itr]);
+  }
+
+  // consecutive keys in key order share most of their path
+  std::sort(index_keys.begin(), index_keys.end(), KeyLess);
+
+  container.GetValues(index_keys, result);
+}
+
+template <typename KeyType, typename ValueType>
+std::unique_ptr<IndexScanCursor> ARTIndex<KeyType, ValueType>::OpenScan(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction) {
+  // the cursor rescans from its resume key, so it keeps its own copy of the
+  // predicate
+  auto scan = [=](const KeyType *resume_key,
+                  typename KeyOrderScanCursor<KeyType>::Visitor visitor) {
+    return ScanHelper(values, key_column_ids, expr_types, scan_direction,
+                      resume_key, visitor);
+  };
+
+  auto equals = [](const KeyType &lhs, const KeyType &rhs) {
+    return KeyLess(lhs, rhs) == false && KeyLess(rhs, lhs) == false;
+  };
+
+  return std::unique_ptr<IndexScanCursor>(
+      new KeyOrderScanCursor<KeyType>(scan, equals));
+}
+
+template <typename KeyType, typename ValueType>
+bool ARTIndex<KeyType, ValueType>::KeyLess(const KeyType &lhs,
+                                           const KeyType &rhs) {
+  for (size_t byte_itr = 0; byte_itr < sizeof(KeyType); byte_itr++) {
+    if (lhs.GetKeyByte(byte_itr) != rhs.GetKeyByte(byte_itr)) {
+      return lhs.GetKeyByte(byte_itr) < rhs.GetKeyByte(byte_itr);
+    }
+  }
+  return false;
+}
+
+template <typename KeyType, typename ValueType>
+std::string ARTIndex<KeyType, ValueType>::GetTypeName() const {
+  return "ART";
+}
+
+// Explicit template instantiation
+template class ARTIndex<IntsKey<1>, ItemPointer *>;
+template class ARTIndex<IntsKey<2>, ItemPointer *>;
+template class ARTIndex<IntsKey<3>, ItemPointer *>;
+template class ARTIndex<IntsKey<4>, ItemPointer *>;
+
+}  // End index namespace
+}  // End peloton namespace
@@ -10,11 +10,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "backend/index/btree_index.h"
 #include "backend/index/index_key.h"
 #include "backend/common/logger.h"
 #include "backend/storage/tuple.h"
 
+// Entries walked from the previous key of a ScanKeys batch before searching
+// from the root again
+#define BTREE_SCAN_KEYS_MAX_STEPS 16
+
 namespace peloton {
 namespace index {
 
@@ -32,15 +38,7 @@ template <typename KeyType, typename ValueType, class KeyComparator,
           class KeyEqualityChecker>
 BTreeIndex<KeyType, ValueType, KeyComparator,
            KeyEqualityChecker>::~BTreeIndex() {
-  // we should not rely on shared_ptr to reclaim memory.
-  // this is because the underlying index can split or merge leaf nodes,
-  // which invokes data data copy and deletes.
-  // as the underlying index is unaware of shared_ptr,
-  // memory allocated should be managed carefully by programmers.
-  for (auto entry = container.begin(); entry != container.end(); ++entry) {
-    delete entry->second;
-    entry->second = nullptr;
-  }
+  // the location cells go away with the item pointer pool
 }
 
 template <typename KeyType, typename ValueType, class KeyComparator,
@@ -51,7 +49,8 @@ bool BTreeIndex<KeyType, ValueType, KeyComparator,
   KeyType index_key;
 
   index_key.SetFromKey(key);
-  std::pair<KeyType, ValueType> entry(index_key, new ItemPointer(location));
+  std::pair<KeyType, ValueType> entry(index_key,
+                                      item_pointer_pool->Allocate(location));
 
   {
     index_lock.WriteLock();
@@ -90,8 +89,7 @@ bool BTreeIndex<KeyType, ValueType, KeyComparator,
 
         if ((value.block == location.block) &&
             (value.offset == location.offset)) {
-          delete iterator->second;
-          iterator->second = nullptr;
+          item_pointer_pool->Retire(iterator->second);
           container.erase(iterator);
           // Set try again
           try_again = true;
@@ -130,8 +128,8 @@ bool BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::
     }
 
     // Insert the key, val pair
-    container.insert(
-        std::pair<KeyType, ValueType>(index_key, new ItemPointer(location)));
+    container.insert(std::pair<KeyType, ValueType>(
+        index_key, item_pointer_pool->Allocate(location)));
 
     index_lock.Unlock();
   }
@@ -141,10 +139,104 @@ bool BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::
 
 template <typename KeyType, typename ValueType, class KeyComparator,
           class KeyEqualityChecker>
-void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
-    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
-    const std::vector<ExpressionType> &expr_types,
-    const ScanDirectionType &scan_direction, std::vector<ItemPointer> &result) {
+void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::
+    BulkLoad(const std::vector<const storage::Tuple *> &keys,
+             const std::vector<ItemPointer> &locations) {
+  PL_ASSERT(keys.size() == locations.size());
+  std::vector<std::pair<KeyType, ValueType>> entries(keys.size());
+  for (size_t entry_itr = 0; entry_itr < keys.size(); entry_itr++) {
+    entries[entry_itr].first.SetFromKey(keys[entry_itr]);
+    entries[entry_itr].second =
+        item_pointer_pool->Allocate(locations[entry_itr]);
+  }
+
+  std::stable_sort(entries.begin(), entries.end(),
+                   [this](const std::pair<KeyType, ValueType> &lhs,
+                          const std::pair<KeyType, ValueType> &rhs) {
+    return comparator(lhs.first, rhs.first);
+  });
+
+  {
+    index_lock.WriteLock();
+
+    // Fill the leaves bottom-up if there is nothing to merge with
+    if (container.empty()) {
+      container.bulk_load(entries.begin(), entries.end());
+    } else {
+      for (auto &entry : entries) {
+        container.insert(entry);
+      }
+    }
+
+    index_lock.Unlock();
+  }
+}
+
+template <typename KeyType, typename ValueType, class KeyComparator,
+          class KeyEqualityChecker>
+void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::
+    DeleteEntries(const std::vector<const storage::Tuple *> &keys,
+                  const std::vector<ItemPointer> &locations) {
+  PL_ASSERT(keys.size() == locations.size());
+  std::vector<std::pair<KeyType, ItemPointer>> entries(keys.size());
+  for (size_t entry_itr = 0; entry_itr < keys.size(); entry_itr++) {
+    entries[entry_itr].first.SetFromKey(keys[entry_itr]);
+    entries[entry_itr].second = locations[entry_itr];
+  }
+
+  // consecutive keys in key order share most of their path
+  std::sort(entries.begin(), entries.end(),
+            [this](const std::pair<KeyType, ItemPointer> &lhs,
+                   const std::pair<KeyType, ItemPointer> &rhs) {
+    return comparator(lhs.first, rhs.first);
+  });
+
+  {
+    index_lock.WriteLock();
+
+    // Delete the < key, location > pairs under a single lock
+    for (auto &entry : entries) {
+      auto &location = entry.second;
+
+      // Erasing invalidates the iterators, so look the key up again
+      bool try_again = true;
+      while (try_again == true) {
+        try_again = false;
+
+        auto key_entries = container.equal_range(entry.first);
+        for (auto iterator = key_entries.first;
+             iterator != key_entries.second; iterator++) {
+          ItemPointer value = *(iterator->second);
+
+          if ((value.block == location.block) &&
+              (value.offset == location.offset)) {
+            item_pointer_pool->Retire(iterator->second);
+            container.erase(iterator);
+            try_again = true;
+            break;
+          }
+        }
+      }
+    }
+
+    index_lock.Unlock();
+  }
+}
+
+template <typename KeyType, typename ValueType, class KeyComparator,
+          class KeyEqualityChecker>
+bool BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::
+    ScanHelper(const std::vector<Value> &values,
+               const std::vector<oid_t> &key_column_ids,
+               const std::vector<ExpressionType> &expr_types,
+               const ScanDirectionType &scan_direction,
+               const KeyType *resume_key,
+               std::function<bool(const KeyType &, ItemPointer *)> visitor) {
+  if (scan_direction != SCAN_DIRECTION_TYPE_FORWARD &&
+      scan_direction != SCAN_DIRECTION_TYPE_BACKWARD) {
+    throw Exception("Invalid scan direction \n");
+  }
+
   // Check if we have leading (leftmost) column equality
   // refer : http://www.postgresql.org/docs/8.2/static/indexes-multicolumn.html
   //  oid_t leading_column_id = 0;
@@ -159,7 +251,7 @@ void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
   // Aligned example: A > 0, B >= 15, c > 4
   // Not Aligned example: A >= 15, B < 30
 
-  bool special_case = true;
+  bool special_case = key_column_ids.size() > 0;
   for (auto key_column_ids_itr = key_column_ids.begin();
        key_column_ids_itr != key_column_ids.end(); key_column_ids_itr++) {
     auto offset = std::distance(key_column_ids.begin(), key_column_ids_itr);
@@ -175,6 +267,29 @@ void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
 
   LOG_TRACE("Special case : %d ", special_case);
 
+  // Visit the entries in [scan_begin_itr, scan_end_itr) that match, returns
+  // false if the visitor stopped
+  auto scan_entries = [&](typename MapType::iterator scan_begin_itr,
+                          typename MapType::iterator scan_end_itr) {
+    for (auto scan_itr = scan_begin_itr; scan_itr != scan_end_itr;
+         scan_itr++) {
+      auto scan_current_key = scan_itr->first;
+      auto tuple =
+          scan_current_key.GetTupleForComparison(metadata->GetKeySchema());
+
+      // Compare the current key in the scan with "values" based on
+      // "expression types"
+      // For instance, "5" EXPR_GREATER_THAN "2" is true
+      if (Compare(tuple, key_column_ids, expr_types, values) == true &&
+          visitor(scan_itr->first, scan_itr->second) == false) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  bool finished = true;
+
   {
     index_lock.ReadLock();
 
@@ -182,7 +297,6 @@ void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
     if (special_case == true) {
       // Assumption: must have leading column, assume it's first one in
       // key_column_ids.
-      assert(key_column_ids.size() > 0);
       oid_t leading_column_id = key_column_ids[0];
       std::vector<std::pair<Value, Value>> intervals;
 
@@ -209,8 +323,6 @@ void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
 
       // Search each interval of leading_column.
       for (const auto &interval : intervals) {
-        auto scan_begin_itr = container.begin();
-        auto scan_end_itr = container.end();
         std::unique_ptr<storage::Tuple> start_key;
         std::unique_ptr<storage::Tuple> end_key;
         start_key.reset(new storage::Tuple(metadata->GetKeySchema(), true));
@@ -236,68 +348,47 @@ void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
         start_index_key.SetFromKey(start_key.get());
         end_index_key.SetFromKey(end_key.get());
 
-        scan_begin_itr = container.equal_range(start_index_key).first;
-        scan_end_itr = container.equal_range(end_index_key).second;
-
-        switch (scan_direction) {
-          case SCAN_DIRECTION_TYPE_FORWARD:
-          case SCAN_DIRECTION_TYPE_BACKWARD: {
-            // Scan the index entries in forward direction
-            for (auto scan_itr = scan_begin_itr; scan_itr != scan_end_itr;
-                 scan_itr++) {
-              auto scan_current_key = scan_itr->first;
-              auto tuple = scan_current_key.GetTupleForComparison(
-                  metadata->GetKeySchema());
-
-              // Compare the current key in the scan with "values" based on
-              // "expression types"
-              // For instance, "5" EXPR_GREATER_THAN "2" is true
-              if (Compare(tuple, key_column_ids, expr_types, values) == true) {
-                ItemPointer location_header = *(scan_itr->second);
-                result.push_back(location_header);
-              }
-            }
-          } break;
-
-          case SCAN_DIRECTION_TYPE_INVALID:
-          default:
-            throw Exception("Invalid scan direction \n");
-            break;
+        auto scan_begin_itr = container.equal_range(start_index_key).first;
+        auto scan_end_itr = container.equal_range(end_index_key).second;
+
+        // skip what has been visited before the resume key
+        if (resume_key != nullptr) {
+          if (comparator(end_index_key, *resume_key)) continue;
+          if (comparator(start_index_key, *resume_key)) {
+            scan_begin_itr = container.upper_bound(*resume_key);
+          }
         }
+
+        finished = scan_entries(scan_begin_itr, scan_end_itr);
+        if (finished == false) break;
       }
 
     } else {
       auto scan_begin_itr = container.begin();
-
-      switch (scan_direction) {
-        case SCAN_DIRECTION_TYPE_FORWARD:
-        case SCAN_DIRECTION_TYPE_BACKWARD: {
-          // Scan the index entries in forward direction
-          for (auto scan_itr = scan_begin_itr; scan_itr != container.end();
-               scan_itr++) {
-            auto scan_current_key = scan_itr->first;
-            auto tuple = scan_current_key.GetTupleForComparison(
-                metadata->GetKeySchema());
-
-            // Compare the current key in the scan with "values" based on
-            // "expression types"
-            // For instance, "5" EXPR_GREATER_THAN "2" is true
-            if (Compare(tuple, key_column_ids, expr_types, values) == true) {
-              ItemPointer location_header = *(scan_itr->second);
-              result.push_back(location_header);
-            }
-          }
-        } break;
-
-        case SCAN_DIRECTION_TYPE_INVALID:
-        default:
-          throw Exception("Invalid scan direction \n");
-          break;
+      if (resume_key != nullptr) {
+        scan_begin_itr = container.upper_bound(*resume_key);
       }
+
+      finished = scan_entries(scan_begin_itr, container.end());
     }
 
     index_lock.Unlock();
   }
+
+  return finished;
+}
+
+template <typename KeyType, typename ValueType, class KeyComparator,
+          class KeyEqualityChecker>
+void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction, std::vector<ItemPointer> &result) {
+  ScanHelper(values, key_column_ids, expr_types, scan_direction, nullptr,
+             [&result](const KeyType &, ItemPointer *location) {
+    result.push_back(*location);
+    return true;
+  });
 }
 
 template <typename KeyType, typename ValueType, class KeyComparator,
@@ -344,145 +435,6 @@ void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::ScanKey(
   }
 }
 
-template <typename KeyType, typename ValueType, class KeyComparator,
-          class KeyEqualityChecker>
-void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::
-    ConstructIntervals(oid_t leading_column_id,
-                       const std::vector<Value> &values,
-                       const std::vector<oid_t> &key_column_ids,
-                       const std::vector<ExpressionType> &expr_types,
-                       std::vector<std::pair<Value, Value>> &intervals) {
-  // Find all contrains of leading column.
-  // Equal --> > < num
-  // > >= --->  > num
-  // < <= ----> < num
-  std::vector<std::pair<peloton::Value, int>> nums;
-  for (size_t i = 0; i < key_column_ids.size(); i++) {
-    if (key_column_ids[i] != leading_column_id) {
-      continue;
-    }
-
-    // If leading column
-    if (IfForwardExpression(expr_types[i])) {
-      nums.push_back(std::pair<Value, int>(values[i], -1));
-    } else if (IfBackwardExpression(expr_types[i])) {
-      nums.push_back(std::pair<Value, int>(values[i], 1));
-    } else {
-      assert(expr_types[i] == EXPRESSION_TYPE_COMPARE_EQUAL);
-      nums.push_back(std::pair<Value, int>(values[i], -1));
-      nums.push_back(std::pair<Value, int>(values[i], 1));
-    }
-  }
-
-  // Have merged all constraints in a single line, sort this line.
-  std::sort(nums.begin(), nums.end(), Index::ValuePairComparator);
-  assert(nums.size() > 0);
-
-  // Build intervals.
-  Value cur;
-  size_t i = 0;
-  if (nums[0].second < 0) {
-    cur = nums[0].first;
-    i++;
-  } else {
-    cur = Value::GetMinValue(nums[0].first.GetValueType());
-  }
-
-  while (i < nums.size()) {
-    if (nums[i].second > 0) {
-      if (i + 1 < nums.size() && nums[i + 1].second < 0) {
-        // right value
-        intervals.push_back(std::pair<Value, Value>(cur, nums[i].first));
-        cur = nums[i + 1].first;
-      } else if (i + 1 == nums.size()) {
-        // Last value while right value
-        intervals.push_back(std::pair<Value, Value>(cur, nums[i].first));
-        cur = Value::GetNullValue(nums[0].first.GetValueType());
-      }
-    }
-    i++;
-  }
-
-  if (cur.IsNull() == false) {
-    intervals.push_back(std::pair<Value, Value>(
-        cur, Value::GetMaxValue(nums[0].first.GetValueType())));
-  }
-
-  // Finish invtervals building.
-};
-
-template <typename KeyType, typename ValueType, class KeyComparator,
-          class KeyEqualityChecker>
-void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::
-    FindMaxMinInColumns(
-        oid_t leading_column_id, const std::vector<Value> &values,
-        const std::vector<oid_t> &key_column_ids,
-        const std::vector<ExpressionType> &expr_types,
-        std::map<oid_t, std::pair<Value, Value>> &non_leading_columns) {
-  // find extreme nums on each column.
-  LOG_TRACE("FindMinMax leading column %d\n", leading_column_id);
-  for (size_t i = 0; i < key_column_ids.size(); i++) {
-    oid_t column_id = key_column_ids[i];
-    if (column_id == leading_column_id) {
-      continue;
-    }
-
-    if (non_leading_columns.find(column_id) == non_leading_columns.end()) {
-      auto type = values[i].GetValueType();
-      //std::pair<Value, Value> *range = new std::pair<Value, Value>(Value::GetMaxValue(type),
-      //                                            Value::GetMinValue(type));
-      // std::pair<oid_t, std::pair<Value, Value>> key_value(column_id, range);
-       non_leading_columns.insert(std::pair<oid_t, std::pair<Value, Value>>(
-                                         column_id, std::pair<Value, Value>(
-                                         Value::GetNullValue(type),
-                                         Value::GetNullValue(type))));
-      //  non_leading_columns[column_id] = *range;
-      // delete range;
-      LOG_TRACE("Insert a init bounds\tleft size %lu\t right description %s\n",
-                non_leading_columns[column_id].first.GetInfo().size(),
-                non_leading_columns[column_id].second.GetInfo().c_str());
-    }
-
-    if (IfForwardExpression(expr_types[i]) ||
-        expr_types[i] == EXPRESSION_TYPE_COMPARE_EQUAL) {
-      LOG_TRACE("min cur %lu compare with %s\n",
-                non_leading_columns[column_id].first.GetInfo().size(),
-                values[i].GetInfo().c_str());
-      if (non_leading_columns[column_id].first.IsNull() ||
-          non_leading_columns[column_id].first.Compare(values[i]) == VALUE_COMPARE_GREATERTHAN) {
-        LOG_TRACE("Update min\n");
-        non_leading_columns[column_id].first = ValueFactory::Clone(values[i], nullptr);
-      }
-    }
-
-    if (IfBackwardExpression(expr_types[i]) ||
-        expr_types[i] == EXPRESSION_TYPE_COMPARE_EQUAL) {
-      LOG_TRACE("max cur %s compare with %s\n",
-                non_leading_columns[column_id].second.GetInfo().c_str(),
-                values[i].GetInfo().c_str());
-      if (non_leading_columns[column_id].first.IsNull() ||
-          non_leading_columns[column_id].second.Compare(values[i]) == VALUE_COMPARE_LESSTHAN) {
-        LOG_TRACE("Update max\n");
-        non_leading_columns[column_id].second = ValueFactory::Clone(values[i], nullptr);
-      }
-    }
-  }
-
-  // check if min value is right bound or max value is left bound, if so, update
-  for (const auto &k_v : non_leading_columns) {
-    if (k_v.second.first.IsNull()) {
-      non_leading_columns[k_v.first].first =
-          Value::GetMinValue(k_v.second.first.GetValueType());
-    }
-    if (k_v.second.second.IsNull()) {
-      non_leading_columns[k_v.first].second =
-          Value::GetMaxValue(k_v.second.second.GetValueType());
-    }
-  }
-};
-
-///////////////////////////////////////////////////////////////////////
-
 template <typename KeyType, typename ValueType, class KeyComparator,
           class KeyEqualityChecker>
 void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
@@ -490,160 +442,11 @@ void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::Scan(
     const std::vector<ExpressionType> &expr_types,
     const ScanDirectionType &scan_direction,
     std::vector<ItemPointer *> &result) {
-  // Check if we have leading (leftmost) column equality
-  // refer : http://www.postgresql.org/docs/8.2/static/indexes-multicolumn.html
-  //  oid_t leading_column_id = 0;
-  //  auto key_column_ids_itr = std::find(key_column_ids.begin(),
-  //                                      key_column_ids.end(),
-  //                                      leading_column_id);
-
-  // SPECIAL CASE : leading column id is one of the key column ids
-  // and is involved in a equality constraint
-  // Currently special case only includes EXPRESSION_TYPE_COMPARE_EQUAL
-  // There are two more types, one is aligned, another is not aligned.
-  // Aligned example: A > 0, B >= 15, c > 4
-  // Not Aligned example: A >= 15, B < 30
-
-  bool special_case = true;
-  for (auto key_column_ids_itr = key_column_ids.begin();
-       key_column_ids_itr != key_column_ids.end(); key_column_ids_itr++) {
-    auto offset = std::distance(key_column_ids.begin(), key_column_ids_itr);
-
-    if (expr_types[offset] == EXPRESSION_TYPE_COMPARE_NOTEQUAL ||
-        expr_types[offset] == EXPRESSION_TYPE_COMPARE_IN ||
-        expr_types[offset] == EXPRESSION_TYPE_COMPARE_LIKE ||
-        expr_types[offset] == EXPRESSION_TYPE_COMPARE_NOTLIKE) {
-      special_case = false;
-      break;
-    }
-  }
-
-  LOG_TRACE("Special case : %d ", special_case);
-
-  {
-    index_lock.ReadLock();
-
-    // If it is a special case, we can figure out the range to scan in the index
-    if (special_case == true) {
-      // Assumption: must have leading column, assume it's first one in
-      // key_column_ids.
-      assert(key_column_ids.size() > 0);
-      oid_t leading_column_id = key_column_ids[0];
-      std::vector<std::pair<Value, Value>> intervals;
-
-      ConstructIntervals(leading_column_id, values, key_column_ids, expr_types,
-                         intervals);
-
-      // For non-leading columns, find the max and min
-      std::map<oid_t, std::pair<Value, Value>> non_leading_columns;
-      FindMaxMinInColumns(leading_column_id, values, key_column_ids, expr_types,
-                          non_leading_columns);
-
-      for (auto key_column_id : metadata->GetKeySchema()->GetIndexedColumns()) {
-        if (non_leading_columns.find(key_column_id) ==
-            non_leading_columns.end()) {
-          auto type =
-              metadata->GetKeySchema()->GetColumn(key_column_id).column_type;
-          std::pair<Value, Value> range(Value::GetMinValue(type),
-                                        Value::GetMaxValue(type));
-          std::pair<oid_t, std::pair<Value, Value>> key_value(key_column_id,
-                                                              range);
-          non_leading_columns.insert(key_value);
-        }
-      }
-
-      assert(intervals.size() != 0);
-      // Search each interval of leading_column.
-      for (const auto &interval : intervals) {
-        auto scan_begin_itr = container.begin();
-        auto scan_end_itr = container.end();
-        std::unique_ptr<storage::Tuple> start_key;
-        std::unique_ptr<storage::Tuple> end_key;
-        start_key.reset(new storage::Tuple(metadata->GetKeySchema(), true));
-        end_key.reset(new storage::Tuple(metadata->GetKeySchema(), true));
-
-        LOG_TRACE("%s", "Constructing start/end keys\n");
-
-        LOG_TRACE("left bound %s\t\t right bound %s\n", interval.first.GetInfo().c_str(),
-                  interval.second.GetInfo().c_str());
-
-        start_key->SetValue(leading_column_id, interval.first, GetPool());
-        end_key->SetValue(leading_column_id, interval.second, GetPool());
-
-        for (const auto &k_v : non_leading_columns) {
-          start_key->SetValue(k_v.first, k_v.second.first, GetPool());
-          end_key->SetValue(k_v.first, k_v.second.second, GetPool());
-          LOG_TRACE("left bound %s\t\t right bound %s\n",
-                    k_v.second.first.GetInfo().c_str(), k_v.second.second.GetInfo().c_str());
-        }
-
-        KeyType start_index_key;
-        KeyType end_index_key;
-        start_index_key.SetFromKey(start_key.get());
-        end_index_key.SetFromKey(end_key.get());
-
-        scan_begin_itr = container.equal_range(start_index_key).first;
-        scan_end_itr = container.equal_range(end_index_key).second;
-
-        switch (scan_direction) {
-          case SCAN_DIRECTION_TYPE_FORWARD:
-          case SCAN_DIRECTION_TYPE_BACKWARD: {
-            // Scan the index entries in forward direction
-            for (auto scan_itr = scan_begin_itr; scan_itr != scan_end_itr;
-                 scan_itr++) {
-              auto scan_current_key = scan_itr->first;
-              auto tuple = scan_current_key.GetTupleForComparison(
-                  metadata->GetKeySchema());
-
-              // Compare the current key in the scan with "values" based on
-              // "expression types"
-              // For instance, "5" EXPR_GREATER_THAN "2" is true
-              if (Compare(tuple, key_column_ids, expr_types, values) == true) {
-                ItemPointer *location_header = scan_itr->second;
-                result.push_back(location_header);
-              }
-            }
-          } break;
-
-          case SCAN_DIRECTION_TYPE_INVALID:
-          default:
-            throw Exception("Invalid scan direction \n");
-            break;
-        }
-      }
-
-    } else {
-      auto scan_begin_itr = container.begin();
-
-      switch (scan_direction) {
-        case SCAN_DIRECTION_TYPE_FORWARD:
-        case SCAN_DIRECTION_TYPE_BACKWARD: {
-          // Scan the index entries in forward direction
-          for (auto scan_itr = scan_begin_itr; scan_itr != container.end();
-               scan_itr++) {
-            auto scan_current_key = scan_itr->first;
-            auto tuple = scan_current_key.GetTupleForComparison(
-                metadata->GetKeySchema());
-
-            // Compare the current key in the scan with "values" based on
-            // "expression types"
-            // For instance, "5" EXPR_GREATER_THAN "2" is true
-            if (Compare(tuple, key_column_ids, expr_types, values) == true) {
-              ItemPointer *location_header = scan_itr->second;
-              result.push_back(location_header);
-            }
-          }
-        } break;
-
-        case SCAN_DIRECTION_TYPE_INVALID:
-        default:
-          throw Exception("Invalid scan direction \n");
-          break;
-      }
-    }
-
-    index_lock.Unlock();
-  }
+  ScanHelper(values, key_column_ids, expr_types, scan_direction, nullptr,
+             [&result](const KeyType &, ItemPointer *location) {
+    result.push_back(location);
+    return true;
+  });
 }
 
 template <typename KeyType, typename ValueType, class KeyComparator,
@@ -690,8 +493,72 @@ void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::ScanKey(
   }
 }
 
+/**
+ * @brief Return all locations related to a batch of keys.
+ * The keys are probed in key order under one read lock, and a key close to
+ * the previous one is reached by walking the entries in between.
+ */
+template <typename KeyType, typename ValueType, class KeyComparator,
+          class KeyEqualityChecker>
+void BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::
+    ScanKeys(const std::vector<const storage::Tuple *> &keys,
+             std::vector<ItemPointer *> &result) {
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t key_itr = 0; key_itr < keys.size(); key_itr++) {
+    index_keys[key_itr].SetFromKey(keys[key_itr]);
+  }
+  std::sort(index_keys.begin(), index_keys.end(), comparator);
+
+  {
+    index_lock.ReadLock();
+
+    auto scan_itr = container.end();
+    for (const auto &index_key : index_keys) {
+      size_t step_count = 0;
+      while (scan_itr != container.end() &&
+             comparator(scan_itr->first, index_key) &&
+             step_count < BTREE_SCAN_KEYS_MAX_STEPS) {
+        scan_itr++;
+        step_count++;
+      }
+
+      if (scan_itr == container.end() ||
+          comparator(scan_itr->first, index_key)) {
+        scan_itr = container.lower_bound(index_key);
+      }
+
+      // find the <key, location> pairs
+      for (; scan_itr != container.end() && equals(scan_itr->first, index_key);
+           scan_itr++) {
+        result.push_back(scan_itr->second);
+      }
+    }
+
+    index_lock.Unlock();
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 
+template <typename KeyType, typename ValueType, class KeyComparator,
+          class KeyEqualityChecker>
+std::unique_ptr<IndexScanCursor>
+BTreeIndex<KeyType, ValueType, KeyComparator, KeyEqualityChecker>::OpenScan(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction) {
+  // the cursor rescans from its resume key, so it keeps its own copy of the
+  // predicate
+  auto scan = [=](const KeyType *resume_key,
+                  typename KeyOrderScanCursor<KeyType>::Visitor visitor) {
+    return ScanHelper(values, key_column_ids, expr_types, scan_direction,
+                      resume_key, visitor);
+  };
+
+  return std::unique_ptr<IndexScanCursor>(
+      new KeyOrderScanCursor<KeyType>(scan, equals));
+}
+
 template <typename KeyType, typename ValueType, class KeyComparator,
           class KeyEqualityChecker>
 std::string BTreeIndex<KeyType, ValueType, KeyComparator,
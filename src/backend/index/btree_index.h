@@ -20,6 +20,8 @@
 #include "backend/common/platform.h"
 #include "backend/common/types.h"
 #include "backend/index/index.h"
+#include "backend/index/item_pointer_pool.h"
+#include "backend/index/index_scan_cursor.h"
 
 #include "stx/btree_multimap.h"
 
@@ -51,6 +53,12 @@ class BTreeIndex : public Index {
   bool CondInsertEntry(const storage::Tuple *key, const ItemPointer &location,
                        std::function<bool(const ItemPointer &)> predicate);
 
+  void BulkLoad(const std::vector<const storage::Tuple *> &keys,
+                const std::vector<ItemPointer> &locations);
+
+  void DeleteEntries(const std::vector<const storage::Tuple *> &keys,
+                     const std::vector<ItemPointer> &locations);
+
   void Scan(const std::vector<Value> &values,
             const std::vector<oid_t> &key_column_ids,
             const std::vector<ExpressionType> &expr_types,
@@ -71,24 +79,24 @@ class BTreeIndex : public Index {
 
   void ScanKey(const storage::Tuple *key, std::vector<ItemPointer *> &result);
 
+  void ScanKeys(const std::vector<const storage::Tuple *> &keys,
+                std::vector<ItemPointer *> &result);
+
+  std::unique_ptr<IndexScanCursor> OpenScan(
+      const std::vector<Value> &values,
+      const std::vector<oid_t> &key_column_ids,
+      const std::vector<ExpressionType> &expr_types,
+      const ScanDirectionType &scan_direction);
+
   std::string GetTypeName() const;
 
   bool Cleanup() { return true; }
 
-  size_t GetMemoryFootprint() { return container.GetMemoryFootprint(); }
-
-  void ConstructIntervals(oid_t leading_column_id,
-                          const std::vector<Value> &values,
-                          const std::vector<oid_t> &key_column_ids,
-                          const std::vector<ExpressionType> &expr_types,
-                          std::vector<std::pair<Value, Value>> &intervals);
+  size_t GetMemoryFootprint() {
+    return container.GetMemoryFootprint() +
+           item_pointer_pool->GetMemoryFootprint();
+  }
 
-  void FindMaxMinInColumns(
-      oid_t leading_column_id, const std::vector<Value> &values,
-      const std::vector<oid_t> &key_column_ids,
-      const std::vector<ExpressionType> &expr_types,
-      std::map<oid_t, std::pair<Value, Value>> &non_leading_columns);
-  
   // Get the indexed tile group offset
   virtual int GetIndexedTileGroupOff() {
     return indexed_tile_group_offset_.load();
@@ -100,6 +108,16 @@ class BTreeIndex : public Index {
   }
   
  protected:
+  // Visit the locations matching the predicate in key order, starting
+  // after the resume key if there is one, until the visitor returns false.
+  // Returns false if the visitor stopped the scan.
+  bool ScanHelper(const std::vector<Value> &values,
+                  const std::vector<oid_t> &key_column_ids,
+                  const std::vector<ExpressionType> &expr_types,
+                  const ScanDirectionType &scan_direction,
+                  const KeyType *resume_key,
+                  std::function<bool(const KeyType &, ItemPointer *)> visitor);
+
   MapType container;
 
   // equality checker and comparator
@@ -10,12 +10,164 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <thread>
+
 #include "backend/index/bwtree.h"
 
 namespace peloton {
 namespace index {
 
-// Add your function definitions here
+//===--------------------------------------------------------------------===//
+// Thread slots
+//===--------------------------------------------------------------------===//
+
+// Slot ownership, shared by all epoch managers
+static std::atomic<bool> thread_slot_owned[BWTREE_MAX_THREAD_COUNT];
+
+// Claims a slot on the first use by a thread and releases it at thread exit
+struct BWTreeThreadSlot {
+  BWTreeThreadSlot() : slot_id(0) {
+    while (true) {
+      for (size_t slot_itr = 0; slot_itr < BWTREE_MAX_THREAD_COUNT;
+           slot_itr++) {
+        bool expected = false;
+        if (thread_slot_owned[slot_itr].compare_exchange_strong(expected,
+                                                                true)) {
+          slot_id = slot_itr;
+          return;
+        }
+      }
+
+      // All slots taken; wait for some thread to exit
+      std::this_thread::yield();
+    }
+  }
+
+  ~BWTreeThreadSlot() { thread_slot_owned[slot_id].store(false); }
+
+  size_t slot_id;
+};
+
+static size_t GetThreadSlot() {
+  static thread_local BWTreeThreadSlot thread_slot;
+  return thread_slot.slot_id;
+}
+
+//===--------------------------------------------------------------------===//
+// Epoch Manager
+//===--------------------------------------------------------------------===//
+
+BWTreeEpochManager::BWTreeEpochManager()
+    : global_epoch_(0),
+      garbage_list_(nullptr),
+      garbage_count_(0),
+      gc_running_(false) {
+  for (size_t slot_itr = 0; slot_itr < BWTREE_MAX_THREAD_COUNT; slot_itr++) {
+    thread_epochs_[slot_itr].epoch.store(IDLE_EPOCH);
+    thread_epochs_[slot_itr].depth = 0;
+  }
+}
+
+BWTreeEpochManager::~BWTreeEpochManager() {
+  GarbageNode *garbage = garbage_list_.exchange(nullptr);
+
+  while (garbage != nullptr) {
+    GarbageNode *next = garbage->next;
+    garbage->deleter(garbage->object);
+    delete garbage;
+    garbage = next;
+  }
+}
+
+void BWTreeEpochManager::EnterEpoch() {
+  ThreadEpoch &thread_epoch = thread_epochs_[GetThreadSlot()];
+  if (thread_epoch.depth++ > 0) {
+    return;
+  }
+
+  // Announce an epoch that is still current after the announcement is
+  // visible, so that a concurrent reclamation pass cannot miss us
+  uint64_t epoch = global_epoch_.load();
+  while (true) {
+    thread_epoch.epoch.store(epoch);
+
+    uint64_t current_epoch = global_epoch_.load();
+    if (current_epoch == epoch) {
+      break;
+    }
+    epoch = current_epoch;
+  }
+}
+
+void BWTreeEpochManager::ExitEpoch() {
+  ThreadEpoch &thread_epoch = thread_epochs_[GetThreadSlot()];
+  PL_ASSERT(thread_epoch.depth > 0);
+
+  if (--thread_epoch.depth == 0) {
+    thread_epoch.epoch.store(IDLE_EPOCH);
+  }
+}
+
+void BWTreeEpochManager::Retire(void *object, Deleter deleter) {
+  GarbageNode *garbage =
+      new GarbageNode{object, deleter, global_epoch_.load(), nullptr};
+
+  garbage->next = garbage_list_.load();
+  while (!garbage_list_.compare_exchange_weak(garbage->next, garbage))
+    ;
+
+  if ((garbage_count_.fetch_add(1) + 1) % BWTREE_GC_THRESHOLD == 0) {
+    PerformGarbageCollection();
+  }
+}
+
+void BWTreeEpochManager::PerformGarbageCollection() {
+  bool expected = false;
+  if (!gc_running_.compare_exchange_strong(expected, true)) {
+    return;
+  }
+
+  // Objects retired before the bump are tagged with an older epoch than
+  // anything a thread entering from now on can announce
+  uint64_t min_epoch = global_epoch_.fetch_add(1) + 1;
+  for (size_t slot_itr = 0; slot_itr < BWTREE_MAX_THREAD_COUNT; slot_itr++) {
+    uint64_t epoch = thread_epochs_[slot_itr].epoch.load();
+    if (epoch < min_epoch) {
+      min_epoch = epoch;
+    }
+  }
+
+  GarbageNode *garbage = garbage_list_.exchange(nullptr);
+  GarbageNode *survivors = nullptr;
+  size_t freed_count = 0;
+
+  while (garbage != nullptr) {
+    GarbageNode *next = garbage->next;
+
+    if (garbage->epoch < min_epoch) {
+      garbage->deleter(garbage->object);
+      delete garbage;
+      freed_count++;
+    } else {
+      garbage->next = survivors;
+      survivors = garbage;
+    }
+
+    garbage = next;
+  }
+
+  // Put back what is still visible
+  while (survivors != nullptr) {
+    GarbageNode *next = survivors->next;
+    survivors->next = garbage_list_.load();
+    while (!garbage_list_.compare_exchange_weak(survivors->next, survivors))
+      ;
+    survivors = next;
+  }
+
+  garbage_count_ -= freed_count;
+  gc_running_.store(false);
+}
 
 }  // End index namespace
-}  // End peloton namespace
\ No newline at end of file
+}  // End peloton namespace
@@ -12,16 +12,1757 @@
 
 #pragma once
 
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include "backend/common/exception.h"
+#include "backend/common/macros.h"
+#include "backend/common/platform.h"
+
 namespace peloton {
 namespace index {
 
-// Look up the stx btree interface for background.
-// peloton/third_party/stx/btree.h
+//===--------------------------------------------------------------------===//
+// Epoch-based reclamation
+//===--------------------------------------------------------------------===//
+
+// Maximum number of threads that can operate on a tree at the same time
+#define BWTREE_MAX_THREAD_COUNT 256
+
+// Number of retired objects after which a reclamation pass is attempted
+#define BWTREE_GC_THRESHOLD 1024
+
+/**
+ * Epoch manager used by the latch-free index structures.
+ *
+ * Every thread announces the global epoch it observed when it enters an
+ * operation, in a slot padded to a cache line. Unlinked objects are
+ * tagged with the global epoch at retirement and freed once every active
+ * thread has announced a later epoch.
+ */
+class BWTreeEpochManager {
+  BWTreeEpochManager(const BWTreeEpochManager &) = delete;
+  BWTreeEpochManager &operator=(const BWTreeEpochManager &) = delete;
+
+ public:
+  typedef void (*Deleter)(void *object);
+
+  BWTreeEpochManager();
+
+  ~BWTreeEpochManager();
+
+  // Announce the calling thread. Calls may nest.
+  void EnterEpoch();
+
+  void ExitEpoch();
+
+  // Hand over an object that is no longer reachable from the structure.
+  void Retire(void *object, Deleter deleter);
+
+  // Free whatever no running thread can still observe.
+  void PerformGarbageCollection();
+
+ private:
+  struct GarbageNode {
+    void *object;
+    Deleter deleter;
+    uint64_t epoch;
+    GarbageNode *next;
+  };
+
+  // The manager lives in heap-allocated indexes, so it is padded with bytes
+  // instead of over-aligned members that a C++11 new would not honor
+  struct ThreadEpoch {
+    std::atomic<uint64_t> epoch;
+    uint64_t depth;
+    char padding[CACHELINE_SIZE - 2 * sizeof(uint64_t)];
+  };
+
+  // epoch announced by idle threads
+  static const uint64_t IDLE_EPOCH = UINT64_MAX;
+
+  char global_epoch_padding_[CACHELINE_SIZE];
+  std::atomic<uint64_t> global_epoch_;
+  char garbage_list_padding_[CACHELINE_SIZE];
+  std::atomic<GarbageNode *> garbage_list_;
+  std::atomic<size_t> garbage_count_;
+  std::atomic<bool> gc_running_;
+  char thread_epochs_padding_[CACHELINE_SIZE];
+
+  ThreadEpoch thread_epochs_[BWTREE_MAX_THREAD_COUNT];
+};
+
+// Scoped epoch protection
+class BWTreeEpochGuard {
+ public:
+  BWTreeEpochGuard(BWTreeEpochManager &manager) : manager_(manager) {
+    manager_.EnterEpoch();
+  }
+
+  ~BWTreeEpochGuard() { manager_.ExitEpoch(); }
+
+ private:
+  BWTreeEpochManager &manager_;
+};
+
+//===--------------------------------------------------------------------===//
+// BWTree
+//===--------------------------------------------------------------------===//
+
+/**
+ * Latch-free B+tree (Levandoski et al., ICDE 2013).
+ *
+ * Nodes are addressed through a mapping table of logical node ids. All
+ * modifications prepend a delta record to a node and install it with a
+ * single CAS on the node's mapping table slot; delta chains are periodically
+ * consolidated into a new base node. Structure modifications (split and
+ * merge) are broken into several CAS steps that any thread can help finish.
+ *
+ * The tree is a multimap: the same <key, value> pair may be stored more
+ * than once and Delete() removes all of its copies. All values of a key
+ * always live in a single leaf.
+ *
+ * Look up the stx btree interface for background.
+ * peloton/third_party/stx/btree.h
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator,
-          typename KeyEqualityChecker>
+          typename KeyEqualityChecker,
+          typename ValueEqualityChecker = std::equal_to<ValueType>>
 class BWTree {
-  // Add your declarations here
+  BWTree(const BWTree &) = delete;
+  BWTree &operator=(const BWTree &) = delete;
+
+ public:
+  typedef uint64_t NodeID;
+
+  typedef std::pair<KeyType, ValueType> KeyValuePair;
+
+  BWTree(KeyComparator comparator, KeyEqualityChecker key_equals,
+         ValueEqualityChecker value_equals = ValueEqualityChecker());
+
+  ~BWTree();
+
+  //===--------------------------------------------------------------------===//
+  // Mutators
+  //===--------------------------------------------------------------------===//
+
+  void Insert(const KeyType &key, const ValueType &value);
+
+  // Insert <key, value> unless one of the values already stored under key
+  // satisfies the predicate. The check and the insert are atomic.
+  bool ConditionalInsert(const KeyType &key, const ValueType &value,
+                         std::function<bool(const ValueType &)> predicate);
+
+  // Remove every copy of <key, value>. Returns false if there was none.
+  bool Delete(const KeyType &key, const ValueType &value);
+
+  // Build an empty tree bottom-up from pairs sorted on key, with full
+  // leaves. Must not run concurrently with other operations. Falls back to
+  // inserting the pairs if the tree is not empty.
+  void BulkLoad(const std::vector<KeyValuePair> &items);
+
+  //===--------------------------------------------------------------------===//
+  // Accessors
+  //===--------------------------------------------------------------------===//
+
+  void GetValue(const KeyType &key, std::vector<ValueType> &result);
+
+  // GetValue for a batch of keys sorted in key order, in one epoch. A key
+  // that falls into the leaf of the previous key is looked up in that leaf
+  // without descending from the root again.
+  void GetValues(const std::vector<KeyType> &keys,
+                 std::vector<ValueType> &result);
+
+  // Visit the pairs with low <= key <= high in key order. A null bound
+  // leaves that side of the range open. The scan stops as soon as the
+  // visitor returns false.
+  void ScanRange(const KeyType *low, const KeyType *high,
+                 std::function<bool(const KeyType &, const ValueType &)>
+                     visitor);
+
+  //===--------------------------------------------------------------------===//
+  // Memory management
+  //===--------------------------------------------------------------------===//
+
+  // Free an object once no concurrent reader of the tree can observe it.
+  template <typename ObjectType>
+  void RetireObject(ObjectType *object) {
+    epoch_manager_.Retire(object, &DeleteObject<ObjectType>);
+  }
+
+  void PerformGarbageCollection() {
+    epoch_manager_.PerformGarbageCollection();
+  }
+
+  size_t GetMemoryFootprint() const { return memory_footprint_.load(); }
+
+  // Highest node id handed out so far; ids of merged nodes are reused
+  size_t GetNodeIDHighWaterMark() const { return next_node_id_.load() - 1; }
+
+ private:
+  //===--------------------------------------------------------------------===//
+  // Nodes
+  //===--------------------------------------------------------------------===//
+
+  enum NodeType {
+    NODE_TYPE_LEAF = 0,
+    NODE_TYPE_INNER = 1,
+
+    NODE_TYPE_LEAF_INSERT = 2,
+    NODE_TYPE_LEAF_DELETE = 3,
+    NODE_TYPE_INNER_INSERT = 4,
+    NODE_TYPE_INNER_DELETE = 5,
+
+    // structure modifications
+    NODE_TYPE_SPLIT = 6,
+    NODE_TYPE_REMOVE = 7,
+    NODE_TYPE_MERGE = 8
+  };
+
+  // Key range [low_key, high_key) and right sibling of a logical node
+  struct NodeMetaData {
+    KeyType low_key;
+    KeyType high_key;
+    bool low_key_infinite;
+    bool high_key_infinite;
+    NodeID next_id;
+  };
+
+  struct BaseNode {
+    BaseNode(NodeType type, bool is_leaf, size_t depth,
+             const NodeMetaData *meta)
+        : type(type), is_leaf(is_leaf), depth(depth), meta(meta) {}
+
+    virtual ~BaseNode() {}
+
+    bool IsDelta() const {
+      return type != NODE_TYPE_LEAF && type != NODE_TYPE_INNER;
+    }
+
+    NodeType type;
+
+    bool is_leaf;
+
+    // number of delta records on top of the base node
+    size_t depth;
+
+    // range of the logical node as seen from this record downwards
+    const NodeMetaData *meta;
+  };
+
+  struct LeafNode : public BaseNode {
+    LeafNode(const NodeMetaData &metadata)
+        : BaseNode(NODE_TYPE_LEAF, true, 0, &own_meta), own_meta(metadata) {}
+
+    NodeMetaData own_meta;
+
+    // sorted on key
+    std::vector<KeyValuePair> items;
+  };
+
+  struct InnerNode : public BaseNode {
+    InnerNode(const NodeMetaData &metadata)
+        : BaseNode(NODE_TYPE_INNER, false, 0, &own_meta), own_meta(metadata) {}
+
+    NodeMetaData own_meta;
+
+    // sorted separators; items[i].second covers [items[i].first,
+    // items[i + 1].first). The first key equals the node's low key.
+    std::vector<std::pair<KeyType, NodeID>> items;
+  };
+
+  struct DeltaNode : public BaseNode {
+    DeltaNode(NodeType type, BaseNode *child)
+        : BaseNode(type, child->is_leaf, child->depth + 1, child->meta),
+          child(child) {}
+
+    BaseNode *child;
+  };
+
+  struct LeafInsertNode : public DeltaNode {
+    LeafInsertNode(BaseNode *child, const KeyType &key, const ValueType &value)
+        : DeltaNode(NODE_TYPE_LEAF_INSERT, child), key(key), value(value) {}
+
+    KeyType key;
+    ValueType value;
+  };
+
+  struct LeafDeleteNode : public DeltaNode {
+    LeafDeleteNode(BaseNode *child, const KeyType &key, const ValueType &value)
+        : DeltaNode(NODE_TYPE_LEAF_DELETE, child), key(key), value(value) {}
+
+    KeyType key;
+    ValueType value;
+  };
+
+  struct InnerInsertNode : public DeltaNode {
+    InnerInsertNode(BaseNode *child, const KeyType &key, NodeID child_id)
+        : DeltaNode(NODE_TYPE_INNER_INSERT, child),
+          key(key),
+          child_id(child_id) {}
+
+    KeyType key;
+    NodeID child_id;
+  };
+
+  struct InnerDeleteNode : public DeltaNode {
+    InnerDeleteNode(BaseNode *child, const KeyType &key, NodeID child_id)
+        : DeltaNode(NODE_TYPE_INNER_DELETE, child),
+          key(key),
+          child_id(child_id) {}
+
+    KeyType key;
+    NodeID child_id;
+  };
+
+  // Half split: keys >= split_key moved to sibling_id
+  struct SplitNode : public DeltaNode {
+    SplitNode(BaseNode *child, const KeyType &split_key, NodeID sibling_id)
+        : DeltaNode(NODE_TYPE_SPLIT, child),
+          own_meta(*child->meta),
+          split_key(split_key),
+          sibling_id(sibling_id) {
+      own_meta.high_key = split_key;
+      own_meta.high_key_infinite = false;
+      own_meta.next_id = sibling_id;
+      this->meta = &own_meta;
+    }
+
+    NodeMetaData own_meta;
+    KeyType split_key;
+    NodeID sibling_id;
+  };
+
+  // The node is being merged into its left sibling and takes no more updates
+  struct RemoveNode : public DeltaNode {
+    RemoveNode(BaseNode *child) : DeltaNode(NODE_TYPE_REMOVE, child) {}
+  };
+
+  // Left sibling absorbing a removed node; keys >= merge_key are found in
+  // right_branch, the removed node's former contents
+  struct MergeNode : public DeltaNode {
+    MergeNode(BaseNode *child, BaseNode *right_branch)
+        : DeltaNode(NODE_TYPE_MERGE, child),
+          own_meta(*child->meta),
+          merge_key(right_branch->meta->low_key),
+          right_branch(right_branch) {
+      own_meta.high_key = right_branch->meta->high_key;
+      own_meta.high_key_infinite = right_branch->meta->high_key_infinite;
+      own_meta.next_id = right_branch->meta->next_id;
+      this->meta = &own_meta;
+      this->depth = child->depth + right_branch->depth + 1;
+    }
+
+    NodeMetaData own_meta;
+    KeyType merge_key;
+    BaseNode *right_branch;
+  };
+
+  // An inner node visited on the way down
+  struct PathEntry {
+    NodeID id;
+    BaseNode *node;
+  };
+
+  //===--------------------------------------------------------------------===//
+  // Tuning knobs
+  //===--------------------------------------------------------------------===//
+
+  static const size_t MAX_DELTA_CHAIN_LENGTH = 8;
+  static const size_t LEAF_MAX_SIZE = 128;
+  static const size_t LEAF_MIN_SIZE = 16;
+  static const size_t INNER_MAX_SIZE = 128;
+  static const size_t INNER_MIN_SIZE = 8;
+
+  // mapping table layout: a directory of lazily allocated chunks
+  static const size_t MAPPING_TABLE_CHUNK_SIZE = 1 << 12;
+  static const size_t MAPPING_TABLE_CHUNK_COUNT = 1 << 12;
+
+  static const NodeID INVALID_NODE_ID = 0;
+
+  //===--------------------------------------------------------------------===//
+  // Mapping table
+  //===--------------------------------------------------------------------===//
+
+  std::atomic<BaseNode *> &GetSlot(NodeID id);
+
+  BaseNode *GetNode(NodeID id) { return GetSlot(id).load(); }
+
+  bool InstallNode(NodeID id, BaseNode *expected, BaseNode *desired) {
+    return GetSlot(id).compare_exchange_strong(expected, desired);
+  }
+
+  NodeID AllocateNodeID(BaseNode *node);
+
+  // Put an id whose slot is clear and unreachable back for reuse
+  void RecycleNodeID(NodeID id);
+
+  // Give back the id of an unlinked node once no running thread can still
+  // hold the id
+  void RetireNodeID(NodeID id);
+
+  struct RetiredNodeID {
+    BWTree *tree;
+    NodeID id;
+  };
+
+  static void DeleteRetiredNodeID(void *object) {
+    auto retired_id = static_cast<RetiredNodeID *>(object);
+    retired_id->tree->RecycleNodeID(retired_id->id);
+    delete retired_id;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Key helpers
+  //===--------------------------------------------------------------------===//
+
+  bool KeyLess(const KeyType &lhs, const KeyType &rhs) const {
+    return comparator_(lhs, rhs);
+  }
+
+  bool KeyEqual(const KeyType &lhs, const KeyType &rhs) const {
+    return key_equals_(lhs, rhs);
+  }
+
+  // key == nullptr stands for negative infinity
+  bool KeyInNode(const KeyType *key, const NodeMetaData &meta) const;
+
+  bool KeyAboveNode(const KeyType *key, const NodeMetaData &meta) const;
+
+  //===--------------------------------------------------------------------===//
+  // Traversal
+  //===--------------------------------------------------------------------===//
+
+  // Descend to the leaf covering key, finishing any incomplete structure
+  // modification met on the way. Returns the leaf id, its chain head and
+  // the inner nodes visited.
+  NodeID Traverse(const KeyType *key, BaseNode **leaf,
+                  std::vector<PathEntry> &path);
+
+  NodeID FindChild(const BaseNode *node, const KeyType *key) const;
+
+  bool FindMaxSeparator(const BaseNode *node, const KeyType *key,
+                        std::vector<const KeyType *> &deleted,
+                        const KeyType *&best_key, NodeID &best_id) const;
+
+  bool HasSeparator(const BaseNode *node, const KeyType &key,
+                    NodeID child_id) const;
+
+  void CollectValues(const BaseNode *node, const KeyType &key,
+                     std::vector<ValueType> &result) const;
+
+  bool HasValue(const BaseNode *node, const KeyType &key,
+                const ValueType &value) const;
+
+  //===--------------------------------------------------------------------===//
+  // Consolidation and structure modifications
+  //===--------------------------------------------------------------------===//
+
+  void CollectLeafItems(const BaseNode *node,
+                        std::vector<KeyValuePair> &items) const;
+
+  void CollectInnerItems(const BaseNode *node,
+                         std::vector<std::pair<KeyType, NodeID>> &items) const;
+
+  void Consolidate(NodeID id, BaseNode *node, std::vector<PathEntry> &path);
+
+  void Split(NodeID id, BaseNode *node, std::vector<PathEntry> &path);
+
+  void TryRemove(NodeID id, BaseNode *node, std::vector<PathEntry> &path);
+
+  // Post the index term <separator, right_id> in the parent of left_id
+  void PostSeparator(std::vector<PathEntry> &path, NodeID left_id,
+                     const KeyType &separator, NodeID right_id);
+
+  // Push a removed node through the remaining steps of a merge. Returns
+  // once the node is no longer in the way of the caller.
+  void HelpMerge(NodeID id, BaseNode *node, std::vector<PathEntry> &path,
+                 size_t recursion_depth);
+
+  // Give ids to the nodes of a level built by BulkLoad and link them.
+  // Returns the separators of the nodes for the level above.
+  template <typename LevelNodeType>
+  std::vector<std::pair<KeyType, NodeID>> LinkLevel(
+      const std::vector<LevelNodeType *> &nodes);
+
+  void RetireChain(BaseNode *node);
+
+  static void FreeChain(BaseNode *node);
+
+  static void DeleteChain(void *node) {
+    FreeChain(static_cast<BaseNode *>(node));
+  }
+
+  static void DeleteSingleNode(void *node) {
+    delete static_cast<BaseNode *>(node);
+  }
+
+  template <typename ObjectType>
+  static void DeleteObject(void *object) {
+    delete static_cast<ObjectType *>(object);
+  }
+
+  size_t GetNodeSize(const BaseNode *node) const;
+
+  //===--------------------------------------------------------------------===//
+  // Data members
+  //===--------------------------------------------------------------------===//
+
+  KeyComparator comparator_;
+  KeyEqualityChecker key_equals_;
+  ValueEqualityChecker value_equals_;
+
+  std::atomic<NodeID> root_id_;
+
+  std::atomic<NodeID> next_node_id_;
+
+  // ids released by merges, handed out again before new ones
+  std::vector<NodeID> free_node_ids_;
+
+  Spinlock free_node_ids_lock_;
+
+  std::atomic<std::atomic<BaseNode *> *> *mapping_table_;
+
+  std::atomic<size_t> memory_footprint_;
+
+  BWTreeEpochManager epoch_manager_;
 };
 
+//===--------------------------------------------------------------------===//
+// BWTree implementation
+//===--------------------------------------------------------------------===//
+
+#define BWTREE_TEMPLATE_ARGUMENTS                                     \
+  template <typename KeyType, typename ValueType, typename KeyComparator, \
+            typename KeyEqualityChecker, typename ValueEqualityChecker>
+#define BWTREE_TYPE                                              \
+  BWTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker, \
+         ValueEqualityChecker>
+
+//===--------------------------------------------------------------------===//
+// Construction / Destruction
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+BWTREE_TYPE::BWTree(KeyComparator comparator, KeyEqualityChecker key_equals,
+                    ValueEqualityChecker value_equals)
+    : comparator_(comparator),
+      key_equals_(key_equals),
+      value_equals_(value_equals),
+      root_id_(INVALID_NODE_ID),
+      next_node_id_(INVALID_NODE_ID + 1),
+      mapping_table_(new std::atomic<std::atomic<BaseNode *> *>
+                         [MAPPING_TABLE_CHUNK_COUNT]),
+      memory_footprint_(0) {
+  for (size_t chunk_itr = 0; chunk_itr < MAPPING_TABLE_CHUNK_COUNT;
+       chunk_itr++) {
+    mapping_table_[chunk_itr].store(nullptr);
+  }
+
+  // The tree starts out as a single empty leaf covering the whole key space
+  NodeMetaData meta;
+  meta.low_key_infinite = true;
+  meta.high_key_infinite = true;
+  meta.next_id = INVALID_NODE_ID;
+
+  LeafNode *root = new LeafNode(meta);
+  memory_footprint_ += GetNodeSize(root);
+  root_id_ = AllocateNodeID(root);
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+BWTREE_TYPE::~BWTree() {
+  // No thread can be operating on the tree any more
+  for (size_t chunk_itr = 0; chunk_itr < MAPPING_TABLE_CHUNK_COUNT;
+       chunk_itr++) {
+    std::atomic<BaseNode *> *chunk = mapping_table_[chunk_itr].load();
+    if (chunk == nullptr) {
+      continue;
+    }
+
+    for (size_t slot_itr = 0; slot_itr < MAPPING_TABLE_CHUNK_SIZE;
+         slot_itr++) {
+      BaseNode *node = chunk[slot_itr].load();
+      if (node != nullptr) {
+        FreeChain(node);
+      }
+    }
+
+    delete[] chunk;
+  }
+
+  delete[] mapping_table_;
+}
+
+//===--------------------------------------------------------------------===//
+// Mapping table
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+std::atomic<typename BWTREE_TYPE::BaseNode *> &BWTREE_TYPE::GetSlot(
+    NodeID id) {
+  auto &chunk_slot = mapping_table_[id / MAPPING_TABLE_CHUNK_SIZE];
+  std::atomic<BaseNode *> *chunk = chunk_slot.load();
+
+  if (chunk == nullptr) {
+    auto new_chunk = new std::atomic<BaseNode *>[MAPPING_TABLE_CHUNK_SIZE];
+    for (size_t slot_itr = 0; slot_itr < MAPPING_TABLE_CHUNK_SIZE;
+         slot_itr++) {
+      new_chunk[slot_itr].store(nullptr);
+    }
+
+    if (chunk_slot.compare_exchange_strong(chunk, new_chunk)) {
+      chunk = new_chunk;
+    } else {
+      delete[] new_chunk;
+    }
+  }
+
+  return chunk[id % MAPPING_TABLE_CHUNK_SIZE];
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+typename BWTREE_TYPE::NodeID BWTREE_TYPE::AllocateNodeID(BaseNode *node) {
+  NodeID id = INVALID_NODE_ID;
+
+  free_node_ids_lock_.Lock();
+  if (free_node_ids_.empty() == false) {
+    id = free_node_ids_.back();
+    free_node_ids_.pop_back();
+  }
+  free_node_ids_lock_.Unlock();
+
+  if (id == INVALID_NODE_ID) {
+    id = next_node_id_.fetch_add(1);
+    // Only reached with that many nodes alive at once
+    if (id >= MAPPING_TABLE_CHUNK_SIZE * MAPPING_TABLE_CHUNK_COUNT) {
+      throw IndexException("BWTree mapping table is full");
+    }
+  }
+
+  GetSlot(id).store(node);
+  return id;
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::RecycleNodeID(NodeID id) {
+  free_node_ids_lock_.Lock();
+  free_node_ids_.push_back(id);
+  free_node_ids_lock_.Unlock();
+}
+
+/**
+ * The slot of an unlinked node is cleared right away, but stale readers may
+ * still hold its id. Recycling the id through the epoch manager keeps them
+ * from reaching an unrelated node under it: until then they find the null
+ * slot and restart.
+ */
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::RetireNodeID(NodeID id) {
+  GetSlot(id).store(nullptr);
+
+  auto retired_id = new RetiredNodeID();
+  retired_id->tree = this;
+  retired_id->id = id;
+  epoch_manager_.Retire(retired_id, &DeleteRetiredNodeID);
+}
+
+//===--------------------------------------------------------------------===//
+// Key helpers
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+bool BWTREE_TYPE::KeyInNode(const KeyType *key,
+                            const NodeMetaData &meta) const {
+  if (key == nullptr) {
+    return meta.low_key_infinite;
+  }
+
+  if (meta.low_key_infinite == false && KeyLess(*key, meta.low_key)) {
+    return false;
+  }
+
+  if (meta.high_key_infinite == false && !KeyLess(*key, meta.high_key)) {
+    return false;
+  }
+
+  return true;
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+bool BWTREE_TYPE::KeyAboveNode(const KeyType *key,
+                               const NodeMetaData &meta) const {
+  if (key == nullptr || meta.high_key_infinite) {
+    return false;
+  }
+
+  return !KeyLess(*key, meta.high_key);
+}
+
+//===--------------------------------------------------------------------===//
+// Traversal
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+typename BWTREE_TYPE::NodeID BWTREE_TYPE::Traverse(
+    const KeyType *key, BaseNode **leaf, std::vector<PathEntry> &path) {
+  while (true) {
+    path.clear();
+    NodeID id = root_id_.load();
+    BaseNode *node = GetNode(id);
+
+    while (true) {
+      // Released by a merge after we read its id
+      if (node == nullptr) {
+        break;
+      }
+
+      if (node->type == NODE_TYPE_REMOVE) {
+        HelpMerge(id, node, path, 0);
+        break;
+      }
+
+      const NodeMetaData &meta = *node->meta;
+
+      // The node split and the key moved to its right sibling. Follow the
+      // side link and make sure the parent learns about the new node.
+      if (KeyAboveNode(key, meta)) {
+        if (meta.next_id == INVALID_NODE_ID) {
+          break;
+        }
+
+        NodeID next_id = meta.next_id;
+        PostSeparator(path, id, meta.high_key, next_id);
+        id = next_id;
+        node = GetNode(id);
+        continue;
+      }
+
+      // Routed through a stale parent
+      if (KeyInNode(key, meta) == false) {
+        break;
+      }
+
+      if (node->depth > MAX_DELTA_CHAIN_LENGTH) {
+        Consolidate(id, node, path);
+        node = GetNode(id);
+        continue;
+      }
+
+      if (node->is_leaf) {
+        *leaf = node;
+        return id;
+      }
+
+      path.push_back({id, node});
+      id = FindChild(node, key);
+      node = GetNode(id);
+    }
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+typename BWTREE_TYPE::NodeID BWTREE_TYPE::FindChild(const BaseNode *node,
+                                                    const KeyType *key) const {
+  std::vector<const KeyType *> deleted;
+  const KeyType *best_key = nullptr;
+  NodeID best_id = INVALID_NODE_ID;
+
+  UNUSED_ATTRIBUTE bool found =
+      FindMaxSeparator(node, key, deleted, best_key, best_id);
+  PL_ASSERT(found);
+
+  return best_id;
+}
+
+/**
+ * @brief Find the largest separator <= key in the logical inner node.
+ * best_key is set to nullptr when the match is the node's infinite low key.
+ * @return false if the chain holds no live separator <= key.
+ */
+BWTREE_TEMPLATE_ARGUMENTS
+bool BWTREE_TYPE::FindMaxSeparator(const BaseNode *node, const KeyType *key,
+                                   std::vector<const KeyType *> &deleted,
+                                   const KeyType *&best_key,
+                                   NodeID &best_id) const {
+  auto is_deleted = [this, &deleted](const KeyType &separator) {
+    for (auto deleted_key : deleted) {
+      if (KeyEqual(*deleted_key, separator)) return true;
+    }
+    return false;
+  };
+
+  // Entries left behind by a split of this node are out of range
+  const NodeMetaData *range = node->meta;
+  auto in_range = [this, &range](const KeyType &separator) {
+    return range->high_key_infinite || KeyLess(separator, range->high_key);
+  };
+
+  bool found = false;
+
+  while (true) {
+    switch (node->type) {
+      case NODE_TYPE_INNER_INSERT: {
+        auto insert = static_cast<const InnerInsertNode *>(node);
+        if (key != nullptr && !KeyLess(*key, insert->key) &&
+            in_range(insert->key) && !is_deleted(insert->key)) {
+          if (!found || best_key == nullptr ||
+              KeyLess(*best_key, insert->key)) {
+            best_key = &insert->key;
+            best_id = insert->child_id;
+            found = true;
+          }
+        }
+        node = insert->child;
+      } break;
+
+      case NODE_TYPE_INNER_DELETE: {
+        auto remove = static_cast<const InnerDeleteNode *>(node);
+        deleted.push_back(&remove->key);
+        node = remove->child;
+      } break;
+
+      case NODE_TYPE_SPLIT:
+      case NODE_TYPE_REMOVE:
+        node = static_cast<const DeltaNode *>(node)->child;
+        break;
+
+      case NODE_TYPE_MERGE: {
+        auto merge = static_cast<const MergeNode *>(node);
+
+        // Separators in the right branch dominate the left ones
+        if (key != nullptr && !KeyLess(*key, merge->merge_key)) {
+          const KeyType *right_key = nullptr;
+          NodeID right_id = INVALID_NODE_ID;
+          if (FindMaxSeparator(merge->right_branch, key, deleted, right_key,
+                               right_id)) {
+            if (!found || best_key == nullptr ||
+                KeyLess(*best_key, *right_key)) {
+              best_key = right_key;
+              best_id = right_id;
+            }
+            return true;
+          }
+        }
+
+        node = merge->child;
+        range = node->meta;
+      } break;
+
+      case NODE_TYPE_INNER: {
+        auto inner = static_cast<const InnerNode *>(node);
+        auto &items = inner->items;
+
+        // Last entry <= key among the ones still in range. The first entry
+        // stands for the low key and always qualifies.
+        size_t index = 0;
+        if (key != nullptr) {
+          auto upper = std::upper_bound(
+              items.begin() + 1, items.end(), *key,
+              [this](const KeyType &lhs, const std::pair<KeyType, NodeID> &rhs) {
+                return KeyLess(lhs, rhs.first);
+              });
+          index = std::distance(items.begin(), upper) - 1;
+        }
+
+        while (index > 0 &&
+               (!in_range(items[index].first) ||
+                is_deleted(items[index].first))) {
+          index--;
+        }
+
+        if (index == 0 && inner->meta->low_key_infinite == false &&
+            is_deleted(items[0].first)) {
+          return found;
+        }
+
+        const KeyType *base_key =
+            (index == 0 && inner->meta->low_key_infinite)
+                ? nullptr
+                : &items[index].first;
+
+        if (!found ||
+            (best_key != nullptr && base_key != nullptr &&
+             KeyLess(*best_key, *base_key))) {
+          best_key = base_key;
+          best_id = items[index].second;
+        }
+        return true;
+      }
+
+      default:
+        PL_ASSERT(false);
+        return found;
+    }
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+bool BWTREE_TYPE::HasSeparator(const BaseNode *node, const KeyType &key,
+                               NodeID child_id) const {
+  std::vector<const KeyType *> deleted;
+  const KeyType *best_key = nullptr;
+  NodeID best_id = INVALID_NODE_ID;
+
+  if (FindMaxSeparator(node, &key, deleted, best_key, best_id) == false) {
+    return false;
+  }
+
+  return best_id == child_id && best_key != nullptr &&
+         KeyEqual(*best_key, key);
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::CollectValues(const BaseNode *node, const KeyType &key,
+                                std::vector<ValueType> &result) const {
+  std::vector<const ValueType *> deleted;
+  auto is_deleted = [this, &deleted](const ValueType &value) {
+    for (auto deleted_value : deleted) {
+      if (value_equals_(*deleted_value, value)) return true;
+    }
+    return false;
+  };
+
+  while (true) {
+    switch (node->type) {
+      case NODE_TYPE_LEAF_INSERT: {
+        auto insert = static_cast<const LeafInsertNode *>(node);
+        if (KeyEqual(key, insert->key) && !is_deleted(insert->value)) {
+          result.push_back(insert->value);
+        }
+        node = insert->child;
+      } break;
+
+      case NODE_TYPE_LEAF_DELETE: {
+        auto remove = static_cast<const LeafDeleteNode *>(node);
+        if (KeyEqual(key, remove->key)) {
+          deleted.push_back(&remove->value);
+        }
+        node = remove->child;
+      } break;
+
+      case NODE_TYPE_SPLIT:
+      case NODE_TYPE_REMOVE:
+        node = static_cast<const DeltaNode *>(node)->child;
+        break;
+
+      case NODE_TYPE_MERGE: {
+        auto merge = static_cast<const MergeNode *>(node);
+        node = KeyLess(key, merge->merge_key) ? merge->child
+                                              : merge->right_branch;
+      } break;
+
+      case NODE_TYPE_LEAF: {
+        auto &items = static_cast<const LeafNode *>(node)->items;
+        auto lower = std::lower_bound(
+            items.begin(), items.end(), key,
+            [this](const KeyValuePair &lhs, const KeyType &rhs) {
+              return KeyLess(lhs.first, rhs);
+            });
+
+        for (auto itr = lower; itr != items.end() && KeyEqual(itr->first, key);
+             itr++) {
+          if (!is_deleted(itr->second)) {
+            result.push_back(itr->second);
+          }
+        }
+        return;
+      }
+
+      default:
+        PL_ASSERT(false);
+        return;
+    }
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+bool BWTREE_TYPE::HasValue(const BaseNode *node, const KeyType &key,
+                           const ValueType &value) const {
+  std::vector<ValueType> values;
+  CollectValues(node, key, values);
+
+  for (auto &existing_value : values) {
+    if (value_equals_(existing_value, value)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//===--------------------------------------------------------------------===//
+// Mutators
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::Insert(const KeyType &key, const ValueType &value) {
+  BWTreeEpochGuard guard(epoch_manager_);
+  std::vector<PathEntry> path;
+
+  while (true) {
+    BaseNode *leaf = nullptr;
+    NodeID id = Traverse(&key, &leaf, path);
+
+    auto delta = new LeafInsertNode(leaf, key, value);
+    if (InstallNode(id, leaf, delta)) {
+      memory_footprint_ += sizeof(LeafInsertNode);
+      if (delta->depth > MAX_DELTA_CHAIN_LENGTH) {
+        Consolidate(id, delta, path);
+      }
+      return;
+    }
+
+    delete delta;
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+bool BWTREE_TYPE::ConditionalInsert(
+    const KeyType &key, const ValueType &value,
+    std::function<bool(const ValueType &)> predicate) {
+  BWTreeEpochGuard guard(epoch_manager_);
+  std::vector<PathEntry> path;
+  std::vector<ValueType> values;
+
+  while (true) {
+    BaseNode *leaf = nullptr;
+    NodeID id = Traverse(&key, &leaf, path);
+
+    // All values of the key are in this chain; installing on top of the
+    // exact chain we checked makes check and insert atomic.
+    values.clear();
+    CollectValues(leaf, key, values);
+    for (auto &existing_value : values) {
+      if (predicate(existing_value)) {
+        return false;
+      }
+    }
+
+    auto delta = new LeafInsertNode(leaf, key, value);
+    if (InstallNode(id, leaf, delta)) {
+      memory_footprint_ += sizeof(LeafInsertNode);
+      if (delta->depth > MAX_DELTA_CHAIN_LENGTH) {
+        Consolidate(id, delta, path);
+      }
+      return true;
+    }
+
+    delete delta;
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+bool BWTREE_TYPE::Delete(const KeyType &key, const ValueType &value) {
+  BWTreeEpochGuard guard(epoch_manager_);
+  std::vector<PathEntry> path;
+
+  while (true) {
+    BaseNode *leaf = nullptr;
+    NodeID id = Traverse(&key, &leaf, path);
+
+    if (HasValue(leaf, key, value) == false) {
+      return false;
+    }
+
+    auto delta = new LeafDeleteNode(leaf, key, value);
+    if (InstallNode(id, leaf, delta)) {
+      memory_footprint_ += sizeof(LeafDeleteNode);
+      if (delta->depth > MAX_DELTA_CHAIN_LENGTH) {
+        Consolidate(id, delta, path);
+      }
+      return true;
+    }
+
+    delete delta;
+  }
+}
+
+//===--------------------------------------------------------------------===//
+// Accessors
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::BulkLoad(const std::vector<KeyValuePair> &items) {
+  NodeID old_root_id = root_id_.load();
+  BaseNode *old_root = GetNode(old_root_id);
+  if (old_root->type != NODE_TYPE_LEAF ||
+      static_cast<LeafNode *>(old_root)->items.empty() == false) {
+    for (auto &item : items) {
+      Insert(item.first, item.second);
+    }
+    return;
+  }
+
+  if (items.empty()) {
+    return;
+  }
+
+  NodeMetaData meta;
+  meta.high_key_infinite = true;
+  meta.next_id = INVALID_NODE_ID;
+
+  // Full leaves, keeping all values of a key in the same leaf
+  std::vector<LeafNode *> leaves;
+  size_t item_itr = 0;
+  while (item_itr < items.size()) {
+    size_t leaf_end = std::min(item_itr + LEAF_MAX_SIZE, items.size());
+    while (leaf_end < items.size() &&
+           KeyEqual(items[leaf_end].first, items[leaf_end - 1].first)) {
+      leaf_end++;
+    }
+
+    meta.low_key = items[item_itr].first;
+    meta.low_key_infinite = leaves.empty();
+    auto leaf = new LeafNode(meta);
+    leaf->items.assign(items.begin() + item_itr, items.begin() + leaf_end);
+    leaves.push_back(leaf);
+
+    item_itr = leaf_end;
+  }
+
+  auto separators = LinkLevel(leaves);
+
+  // Full inner nodes up to a single root
+  while (separators.size() > 1) {
+    std::vector<InnerNode *> inners;
+    for (size_t separator_itr = 0; separator_itr < separators.size();
+         separator_itr += INNER_MAX_SIZE) {
+      size_t inner_end =
+          std::min(separator_itr + INNER_MAX_SIZE, separators.size());
+
+      meta.low_key = separators[separator_itr].first;
+      meta.low_key_infinite = inners.empty();
+      auto inner = new InnerNode(meta);
+      inner->items.assign(separators.begin() + separator_itr,
+                          separators.begin() + inner_end);
+      inners.push_back(inner);
+    }
+
+    separators = LinkLevel(inners);
+  }
+
+  root_id_.store(separators.front().second);
+  RetireNodeID(old_root_id);
+  RetireChain(old_root);
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+template <typename LevelNodeType>
+std::vector<std::pair<KeyType, typename BWTREE_TYPE::NodeID>>
+BWTREE_TYPE::LinkLevel(const std::vector<LevelNodeType *> &nodes) {
+  std::vector<std::pair<KeyType, NodeID>> separators;
+  for (auto node : nodes) {
+    separators.push_back(
+        std::make_pair(node->own_meta.low_key, AllocateNodeID(node)));
+    memory_footprint_ += GetNodeSize(node);
+  }
+
+  for (size_t node_itr = 0; node_itr + 1 < nodes.size(); node_itr++) {
+    auto &meta = nodes[node_itr]->own_meta;
+    meta.high_key = separators[node_itr + 1].first;
+    meta.high_key_infinite = false;
+    meta.next_id = separators[node_itr + 1].second;
+  }
+
+  return separators;
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::GetValue(const KeyType &key,
+                           std::vector<ValueType> &result) {
+  BWTreeEpochGuard guard(epoch_manager_);
+  std::vector<PathEntry> path;
+
+  BaseNode *leaf = nullptr;
+  Traverse(&key, &leaf, path);
+  CollectValues(leaf, key, result);
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::GetValues(const std::vector<KeyType> &keys,
+                            std::vector<ValueType> &result) {
+  BWTreeEpochGuard guard(epoch_manager_);
+  std::vector<PathEntry> path;
+
+  NodeID leaf_id = INVALID_NODE_ID;
+  BaseNode *leaf = nullptr;
+
+  for (const auto &key : keys) {
+    // Reuse the leaf unless it changed or does not cover the key
+    if (leaf == nullptr || GetNode(leaf_id) != leaf ||
+        KeyInNode(&key, *leaf->meta) == false) {
+      leaf_id = Traverse(&key, &leaf, path);
+    }
+
+    CollectValues(leaf, key, result);
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::ScanRange(
+    const KeyType *low, const KeyType *high,
+    std::function<bool(const KeyType &, const ValueType &)> visitor) {
+  BWTreeEpochGuard guard(epoch_manager_);
+  std::vector<PathEntry> path;
+  std::vector<KeyValuePair> items;
+
+  // Leaves are visited one logical node at a time by re-descending with
+  // the previous leaf's high key, which stays correct across concurrent
+  // splits and merges.
+  KeyType cursor;
+  const KeyType *cursor_ptr = low;
+
+  while (true) {
+    BaseNode *leaf = nullptr;
+    Traverse(cursor_ptr, &leaf, path);
+
+    items.clear();
+    CollectLeafItems(leaf, items);
+
+    for (auto &item : items) {
+      if (cursor_ptr != nullptr && KeyLess(item.first, *cursor_ptr)) {
+        continue;
+      }
+
+      if (high != nullptr && KeyLess(*high, item.first)) {
+        return;
+      }
+
+      if (visitor(item.first, item.second) == false) {
+        return;
+      }
+    }
+
+    const NodeMetaData &meta = *leaf->meta;
+    if (meta.high_key_infinite ||
+        (high != nullptr && KeyLess(*high, meta.high_key))) {
+      return;
+    }
+
+    cursor = meta.high_key;
+    cursor_ptr = &cursor;
+  }
+}
+
+//===--------------------------------------------------------------------===//
+// Consolidation
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::CollectLeafItems(const BaseNode *node,
+                                   std::vector<KeyValuePair> &items) const {
+  const NodeMetaData *range = node->meta;
+
+  std::vector<const BaseNode *> deltas;
+  while (node->IsDelta() && node->type != NODE_TYPE_MERGE) {
+    deltas.push_back(node);
+    node = static_cast<const DeltaNode *>(node)->child;
+  }
+
+  if (node->type == NODE_TYPE_MERGE) {
+    auto merge = static_cast<const MergeNode *>(node);
+    std::vector<KeyValuePair> right_items;
+    CollectLeafItems(merge->child, items);
+    CollectLeafItems(merge->right_branch, right_items);
+    items.insert(items.end(), right_items.begin(), right_items.end());
+  } else {
+    auto &base_items = static_cast<const LeafNode *>(node)->items;
+    items.insert(items.end(), base_items.begin(), base_items.end());
+  }
+
+  // Replay the deltas, oldest first
+  for (auto itr = deltas.rbegin(); itr != deltas.rend(); itr++) {
+    const BaseNode *delta = *itr;
+
+    if (delta->type == NODE_TYPE_LEAF_INSERT) {
+      auto insert = static_cast<const LeafInsertNode *>(delta);
+      auto position = std::upper_bound(
+          items.begin(), items.end(), insert->key,
+          [this](const KeyType &lhs, const KeyValuePair &rhs) {
+            return KeyLess(lhs, rhs.first);
+          });
+      items.insert(position, KeyValuePair(insert->key, insert->value));
+    } else if (delta->type == NODE_TYPE_LEAF_DELETE) {
+      auto remove = static_cast<const LeafDeleteNode *>(delta);
+      items.erase(std::remove_if(items.begin(), items.end(),
+                                 [this, remove](const KeyValuePair &item) {
+                   return KeyEqual(item.first, remove->key) &&
+                          value_equals_(item.second, remove->value);
+                 }),
+                  items.end());
+    }
+  }
+
+  // Drop what an earlier split moved to the sibling
+  if (range->high_key_infinite == false) {
+    auto upper = std::lower_bound(
+        items.begin(), items.end(), range->high_key,
+        [this](const KeyValuePair &lhs, const KeyType &rhs) {
+          return KeyLess(lhs.first, rhs);
+        });
+    items.erase(upper, items.end());
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::CollectInnerItems(
+    const BaseNode *node,
+    std::vector<std::pair<KeyType, NodeID>> &items) const {
+  const NodeMetaData *range = node->meta;
+
+  std::vector<const BaseNode *> deltas;
+  while (node->IsDelta() && node->type != NODE_TYPE_MERGE) {
+    deltas.push_back(node);
+    node = static_cast<const DeltaNode *>(node)->child;
+  }
+
+  if (node->type == NODE_TYPE_MERGE) {
+    auto merge = static_cast<const MergeNode *>(node);
+    std::vector<std::pair<KeyType, NodeID>> right_items;
+    CollectInnerItems(merge->child, items);
+    CollectInnerItems(merge->right_branch, right_items);
+    items.insert(items.end(), right_items.begin(), right_items.end());
+  } else {
+    auto &base_items = static_cast<const InnerNode *>(node)->items;
+    items.insert(items.end(), base_items.begin(), base_items.end());
+  }
+
+  auto find_separator = [this, &items](const KeyType &key) {
+    return std::lower_bound(
+        items.begin() + 1, items.end(), key,
+        [this](const std::pair<KeyType, NodeID> &lhs, const KeyType &rhs) {
+          return KeyLess(lhs.first, rhs);
+        });
+  };
+
+  for (auto itr = deltas.rbegin(); itr != deltas.rend(); itr++) {
+    const BaseNode *delta = *itr;
+
+    if (delta->type == NODE_TYPE_INNER_INSERT) {
+      auto insert = static_cast<const InnerInsertNode *>(delta);
+      auto position = find_separator(insert->key);
+      if (position != items.end() && KeyEqual(position->first, insert->key)) {
+        position->second = insert->child_id;
+      } else {
+        items.insert(position, std::make_pair(insert->key, insert->child_id));
+      }
+    } else if (delta->type == NODE_TYPE_INNER_DELETE) {
+      auto remove = static_cast<const InnerDeleteNode *>(delta);
+      auto position = find_separator(remove->key);
+      if (position != items.end() && KeyEqual(position->first, remove->key)) {
+        items.erase(position);
+      }
+    }
+  }
+
+  if (range->high_key_infinite == false) {
+    items.erase(find_separator(range->high_key), items.end());
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::Consolidate(NodeID id, BaseNode *node,
+                              std::vector<PathEntry> &path) {
+  // A removed node is consolidated as part of its left sibling
+  if (node->type == NODE_TYPE_REMOVE) {
+    return;
+  }
+
+  BaseNode *new_node = nullptr;
+  size_t item_count = 0;
+
+  if (node->is_leaf) {
+    auto leaf = new LeafNode(*node->meta);
+    CollectLeafItems(node, leaf->items);
+    item_count = leaf->items.size();
+    new_node = leaf;
+  } else {
+    auto inner = new InnerNode(*node->meta);
+    CollectInnerItems(node, inner->items);
+    item_count = inner->items.size();
+    new_node = inner;
+  }
+
+  if (InstallNode(id, node, new_node) == false) {
+    delete new_node;
+    return;
+  }
+
+  memory_footprint_ += GetNodeSize(new_node);
+  RetireChain(node);
+
+  size_t max_size = node->is_leaf ? LEAF_MAX_SIZE : INNER_MAX_SIZE;
+  size_t min_size = node->is_leaf ? LEAF_MIN_SIZE : INNER_MIN_SIZE;
+
+  if (item_count > max_size) {
+    Split(id, new_node, path);
+  } else if (item_count < min_size) {
+    TryRemove(id, new_node, path);
+  }
+}
+
+//===--------------------------------------------------------------------===//
+// Structure modifications
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::Split(NodeID id, BaseNode *node,
+                        std::vector<PathEntry> &path) {
+  NodeMetaData sibling_meta = *node->meta;
+  BaseNode *sibling = nullptr;
+
+  if (node->is_leaf) {
+    auto &items = static_cast<LeafNode *>(node)->items;
+
+    // Keep all values of a key on the same side
+    size_t split_position = items.size() / 2;
+    while (split_position < items.size() &&
+           KeyEqual(items[split_position].first,
+                    items[split_position - 1].first)) {
+      split_position++;
+    }
+
+    if (split_position == items.size()) {
+      split_position = items.size() / 2;
+      while (split_position > 0 &&
+             KeyEqual(items[split_position].first,
+                      items[split_position - 1].first)) {
+        split_position--;
+      }
+
+      // A single key with many values
+      if (split_position == 0) {
+        return;
+      }
+    }
+
+    sibling_meta.low_key = items[split_position].first;
+    sibling_meta.low_key_infinite = false;
+
+    auto leaf = new LeafNode(sibling_meta);
+    leaf->items.assign(items.begin() + split_position, items.end());
+    sibling = leaf;
+  } else {
+    auto &items = static_cast<InnerNode *>(node)->items;
+    size_t split_position = items.size() / 2;
+
+    sibling_meta.low_key = items[split_position].first;
+    sibling_meta.low_key_infinite = false;
+
+    auto inner = new InnerNode(sibling_meta);
+    inner->items.assign(items.begin() + split_position, items.end());
+    sibling = inner;
+  }
+
+  NodeID sibling_id = AllocateNodeID(sibling);
+  auto split = new SplitNode(node, sibling_meta.low_key, sibling_id);
+
+  if (InstallNode(id, node, split) == false) {
+    GetSlot(sibling_id).store(nullptr);
+    RecycleNodeID(sibling_id);
+    delete split;
+    delete sibling;
+    return;
+  }
+
+  memory_footprint_ += GetNodeSize(sibling) + sizeof(SplitNode);
+
+  PostSeparator(path, id, sibling_meta.low_key, sibling_id);
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::PostSeparator(std::vector<PathEntry> &path, NodeID left_id,
+                                const KeyType &separator, NodeID right_id) {
+  // Parent first: once it is read, the checks on the children below can
+  // only be invalidated by changes that also make our CAS on it fail.
+  BaseNode *parent = nullptr;
+  if (path.empty() == false) {
+    parent = GetNode(path.back().id);
+    if (parent == nullptr || parent->type == NODE_TYPE_REMOVE) {
+      return;
+    }
+
+    // The separator now belongs to a sibling of the parent
+    if (KeyInNode(&separator, *parent->meta) == false) {
+      return;
+    }
+
+    // Already posted, or the left node is not known to the parent yet
+    if (FindChild(parent, &separator) != left_id) {
+      return;
+    }
+  } else if (root_id_.load() != left_id) {
+    // Nodes at the root level besides the root are linked in once the
+    // root grows
+    return;
+  }
+
+  BaseNode *left = GetNode(left_id);
+  if (left == nullptr || left->type == NODE_TYPE_REMOVE) {
+    return;
+  }
+
+  const NodeMetaData &left_meta = *left->meta;
+  if (left_meta.high_key_infinite || left_meta.next_id != right_id ||
+      !KeyEqual(left_meta.high_key, separator)) {
+    return;
+  }
+
+  BaseNode *right = GetNode(right_id);
+  if (right == nullptr || right->type == NODE_TYPE_REMOVE) {
+    return;
+  }
+
+  if (parent != nullptr) {
+    auto delta = new InnerInsertNode(parent, separator, right_id);
+    if (InstallNode(path.back().id, parent, delta)) {
+      memory_footprint_ += sizeof(InnerInsertNode);
+      path.back().node = delta;
+    } else {
+      delete delta;
+    }
+    return;
+  }
+
+  // Root split: grow the tree by one level
+  NodeMetaData root_meta;
+  root_meta.low_key_infinite = true;
+  root_meta.high_key_infinite = true;
+  root_meta.next_id = INVALID_NODE_ID;
+
+  auto root = new InnerNode(root_meta);
+  root->items.push_back(std::make_pair(left_meta.low_key, left_id));
+  root->items.push_back(std::make_pair(separator, right_id));
+
+  NodeID root_id = AllocateNodeID(root);
+  NodeID expected = left_id;
+  if (root_id_.compare_exchange_strong(expected, root_id)) {
+    memory_footprint_ += GetNodeSize(root);
+  } else {
+    GetSlot(root_id).store(nullptr);
+    RecycleNodeID(root_id);
+    delete root;
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::TryRemove(NodeID id, BaseNode *node,
+                            std::vector<PathEntry> &path) {
+  const NodeMetaData &meta = *node->meta;
+
+  // The root and the leftmost node of every level are never removed
+  if (path.empty() || meta.low_key_infinite) {
+    return;
+  }
+
+  BaseNode *parent = GetNode(path.back().id);
+  if (parent == nullptr || parent->type == NODE_TYPE_REMOVE) {
+    return;
+  }
+
+  const NodeMetaData &parent_meta = *parent->meta;
+  if (KeyInNode(&meta.low_key, parent_meta) == false) {
+    return;
+  }
+
+  // Only merge with a left sibling under the same parent
+  if (parent_meta.low_key_infinite == false &&
+      KeyEqual(parent_meta.low_key, meta.low_key)) {
+    return;
+  }
+
+  if (HasSeparator(parent, meta.low_key, id) == false) {
+    return;
+  }
+
+  auto remove = new RemoveNode(node);
+  if (InstallNode(id, node, remove) == false) {
+    delete remove;
+    return;
+  }
+
+  memory_footprint_ += sizeof(RemoveNode);
+  HelpMerge(id, remove, path, 0);
+}
+
+/**
+ * A removed node R is merged in two steps: its index term is first deleted
+ * from the parent, which serializes the merge with splits of the parent,
+ * then its left sibling absorbs it with a merge delta. Until the second step
+ * completes, lookups routed to the left sibling reach R over the side link
+ * and help here.
+ */
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::HelpMerge(NodeID id, BaseNode *node,
+                            std::vector<PathEntry> &path,
+                            size_t recursion_depth) {
+  if (path.empty() || recursion_depth > MAX_DELTA_CHAIN_LENGTH) {
+    return;
+  }
+
+  auto remove = static_cast<RemoveNode *>(node);
+  const KeyType &low_key = remove->meta->low_key;
+
+  PathEntry &parent_entry = path.back();
+  BaseNode *parent = GetNode(parent_entry.id);
+  if (parent == nullptr || parent->type == NODE_TYPE_REMOVE ||
+      KeyInNode(&low_key, *parent->meta) == false) {
+    return;
+  }
+
+  // Step 1 : delete the index term from the parent
+  if (HasSeparator(parent, low_key, id)) {
+    const NodeMetaData &parent_meta = *parent->meta;
+
+    // The parent split right at this node before the index term was
+    // deleted, so the left sibling is under another parent. Undo the remove.
+    if (parent_meta.low_key_infinite == false &&
+        KeyEqual(parent_meta.low_key, low_key)) {
+      if (InstallNode(id, remove, remove->child)) {
+        memory_footprint_ -= sizeof(RemoveNode);
+        epoch_manager_.Retire(remove, &DeleteSingleNode);
+      }
+      return;
+    }
+
+    auto delta = new InnerDeleteNode(parent, low_key, id);
+    if (InstallNode(parent_entry.id, parent, delta) == false) {
+      delete delta;
+      return;
+    }
+
+    memory_footprint_ += sizeof(InnerDeleteNode);
+    parent_entry.node = delta;
+    parent = delta;
+  }
+
+  // Step 2 : merge into the left sibling, now in charge of the key range
+  NodeID left_id = FindChild(parent, &low_key);
+
+  for (size_t hop_itr = 0; left_id != INVALID_NODE_ID && left_id != id;
+       hop_itr++) {
+    BaseNode *left = GetNode(left_id);
+    if (left == nullptr) {
+      return;
+    }
+
+    if (left->type == NODE_TYPE_REMOVE) {
+      HelpMerge(left_id, left, path, recursion_depth + 1);
+      return;
+    }
+
+    const NodeMetaData &left_meta = *left->meta;
+    if (left_meta.next_id == id) {
+      if (left_meta.high_key_infinite ||
+          !KeyEqual(left_meta.high_key, low_key)) {
+        return;
+      }
+
+      auto merge = new MergeNode(left, remove->child);
+      if (InstallNode(left_id, left, merge) == false) {
+        delete merge;
+        return;
+      }
+
+      memory_footprint_ += sizeof(MergeNode) - sizeof(RemoveNode);
+
+      // Nothing leads to the removed node any more
+      RetireNodeID(id);
+      epoch_manager_.Retire(remove, &DeleteSingleNode);
+      return;
+    }
+
+    // Already merged
+    if (left_meta.high_key_infinite || KeyLess(low_key, left_meta.high_key)) {
+      return;
+    }
+
+    left_id = left_meta.next_id;
+  }
+}
+
+//===--------------------------------------------------------------------===//
+// Memory management
+//===--------------------------------------------------------------------===//
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::RetireChain(BaseNode *node) {
+  size_t chain_size = 0;
+
+  std::vector<const BaseNode *> pending = {node};
+  while (pending.empty() == false) {
+    const BaseNode *current = pending.back();
+    pending.pop_back();
+
+    while (current != nullptr) {
+      chain_size += GetNodeSize(current);
+      if (current->IsDelta() == false) {
+        break;
+      }
+
+      if (current->type == NODE_TYPE_MERGE) {
+        pending.push_back(static_cast<const MergeNode *>(current)->right_branch);
+      }
+      current = static_cast<const DeltaNode *>(current)->child;
+    }
+  }
+
+  memory_footprint_ -= chain_size;
+  epoch_manager_.Retire(node, &DeleteChain);
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+void BWTREE_TYPE::FreeChain(BaseNode *node) {
+  while (node != nullptr) {
+    BaseNode *next = nullptr;
+
+    if (node->IsDelta()) {
+      next = static_cast<DeltaNode *>(node)->child;
+      if (node->type == NODE_TYPE_MERGE) {
+        FreeChain(static_cast<MergeNode *>(node)->right_branch);
+      }
+    }
+
+    delete node;
+    node = next;
+  }
+}
+
+BWTREE_TEMPLATE_ARGUMENTS
+size_t BWTREE_TYPE::GetNodeSize(const BaseNode *node) const {
+  switch (node->type) {
+    case NODE_TYPE_LEAF:
+      return sizeof(LeafNode) +
+             static_cast<const LeafNode *>(node)->items.capacity() *
+                 sizeof(KeyValuePair);
+    case NODE_TYPE_INNER:
+      return sizeof(InnerNode) +
+             static_cast<const InnerNode *>(node)->items.capacity() *
+                 sizeof(std::pair<KeyType, NodeID>);
+    case NODE_TYPE_LEAF_INSERT:
+      return sizeof(LeafInsertNode);
+    case NODE_TYPE_LEAF_DELETE:
+      return sizeof(LeafDeleteNode);
+    case NODE_TYPE_INNER_INSERT:
+      return sizeof(InnerInsertNode);
+    case NODE_TYPE_INNER_DELETE:
+      return sizeof(InnerDeleteNode);
+    case NODE_TYPE_SPLIT:
+      return sizeof(SplitNode);
+    case NODE_TYPE_REMOVE:
+      return sizeof(RemoveNode);
+    case NODE_TYPE_MERGE:
+      return sizeof(MergeNode);
+  }
+  return 0;
+}
+
+#undef BWTREE_TEMPLATE_ARGUMENTS
+#undef BWTREE_TYPE
+
 }  // End index namespace
-}  // End peloton namespace
\ No newline at end of file
+}  // End peloton namespace
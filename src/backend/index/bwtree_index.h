@@ -20,6 +20,8 @@
 #include "backend/common/platform.h"
 #include "backend/common/types.h"
 #include "backend/index/index.h"
+#include "backend/index/item_pointer_pool.h"
+#include "backend/index/index_scan_cursor.h"
 
 #include "backend/index/bwtree.h"
 
@@ -29,6 +31,10 @@ namespace index {
 /**
  * BW tree-based index implementation.
  *
+ * The underlying tree is latch-free, so the index takes no locks. Location
+ * cells removed from the tree are retired to the item pointer pool, as
+ * concurrent transactions may still be dereferencing them.
+ *
  * @see Index
  */
 template <typename KeyType, typename ValueType, typename KeyComparator,
@@ -50,6 +56,9 @@ class BWTreeIndex : public Index {
   bool CondInsertEntry(const storage::Tuple *key, const ItemPointer &location,
                        std::function<bool(const ItemPointer &)> predicate);
 
+  void BulkLoad(const std::vector<const storage::Tuple *> &keys,
+                const std::vector<ItemPointer> &locations);
+
   void Scan(const std::vector<Value> &values,
             const std::vector<oid_t> &key_column_ids,
             const std::vector<ExpressionType> &expr_types,
@@ -71,24 +80,44 @@ class BWTreeIndex : public Index {
   void ScanKey(const storage::Tuple *key,
                std::vector<ItemPointer *> &result);
 
+  void ScanKeys(const std::vector<const storage::Tuple *> &keys,
+                std::vector<ItemPointer *> &result);
+
+  std::unique_ptr<IndexScanCursor> OpenScan(
+      const std::vector<Value> &values,
+      const std::vector<oid_t> &key_column_ids,
+      const std::vector<ExpressionType> &expr_types,
+      const ScanDirectionType &scan_direction);
+
   std::string GetTypeName() const;
 
-  // TODO: Implement this
-  bool Cleanup() { return true; }
+  bool Cleanup() {
+    container.PerformGarbageCollection();
+    return true;
+  }
 
-  // TODO: Implement this
-  size_t GetMemoryFootprint() { return 0; }
+  size_t GetMemoryFootprint() {
+    return container.GetMemoryFootprint() +
+           item_pointer_pool->GetMemoryFootprint();
+  }
 
  protected:
+  // Visit the locations matching the predicate in key order, starting
+  // after the resume key if there is one, until the visitor returns false.
+  // Returns false if the visitor stopped the scan.
+  bool ScanHelper(const std::vector<Value> &values,
+                  const std::vector<oid_t> &key_column_ids,
+                  const std::vector<ExpressionType> &expr_types,
+                  const ScanDirectionType &scan_direction,
+                  const KeyType *resume_key,
+                  std::function<bool(const KeyType &, ItemPointer *)> visitor);
+
   // container
   MapType container;
 
   // equality checker and comparator
   KeyEqualityChecker equals;
   KeyComparator comparator;
-
-  // synch helper
-  RWLock index_lock;
 };
 
 }  // End index namespace
@@ -0,0 +1,331 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// hash_index.cpp
+//
+// Identification: src/backend/index/hash_index.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "backend/index/hash_index.h"
+#include "backend/index/index_key.h"
+#include "backend/common/logger.h"
+#include "backend/storage/tuple.h"
+
+namespace peloton {
+namespace index {
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::HashIndex(
+    IndexMetadata *metadata)
+    : Index(metadata),
+      container(KeyHasher(metadata), KeyEqualityChecker(metadata),
+                HASH_INDEX_INITIAL_SIZE),
+      equals(metadata),
+      hasher(metadata) {}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::~HashIndex() {
+  // the location cells go away with the item pointer pool
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+bool HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::InsertEntry(
+    const storage::Tuple *key, const ItemPointer &location) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  ValueType value = item_pointer_pool->Allocate(location);
+
+  // Append to the values of the key, or add the key
+  container.upsert(index_key,
+                   [value](std::vector<ValueType> &existing_values) {
+                     existing_values.push_back(value);
+                   },
+                   std::vector<ValueType>(1, value));
+
+  return true;
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+bool HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::DeleteEntry(
+    const storage::Tuple *key, const ItemPointer &location) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  // Delete the < key, location > pairs, and the key once it has no values
+  container.erase_fn(index_key, [this, &location](
+                                    std::vector<ValueType> &existing_values) {
+    auto itr = existing_values.begin();
+    while (itr != existing_values.end()) {
+      if (((*itr)->block == location.block) &&
+          ((*itr)->offset == location.offset)) {
+        item_pointer_pool->Retire(*itr);
+        itr = existing_values.erase(itr);
+      } else {
+        itr++;
+      }
+    }
+    return existing_values.empty();
+  });
+
+  return true;
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+bool HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::
+    CondInsertEntry(const storage::Tuple *key, const ItemPointer &location,
+                    std::function<bool(const ItemPointer &)> predicate) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  ValueType value = item_pointer_pool->Allocate(location);
+  bool inserted = true;
+
+  // The check runs with the key's buckets locked
+  container.upsert(index_key,
+                   [value, &predicate, &inserted](
+                       std::vector<ValueType> &existing_values) {
+                     for (auto existing_value : existing_values) {
+                       if (predicate(*existing_value)) {
+                         // this key is already visible or dirty in the index
+                         inserted = false;
+                         return;
+                       }
+                     }
+
+                     inserted = true;
+                     existing_values.push_back(value);
+                   },
+                   std::vector<ValueType>(1, value));
+
+  if (inserted == false) {
+    item_pointer_pool->Deallocate(value);
+  }
+
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+void HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::BulkLoad(
+    const std::vector<const storage::Tuple *> &keys,
+    const std::vector<ItemPointer> &locations) {
+  PL_ASSERT(keys.size() == locations.size());
+
+  // Size the table up front rather than growing it step by step
+  size_t expected_size = container.size() + keys.size();
+  if (expected_size > container.bucket_count() * MapType::slot_per_bucket) {
+    container.reserve(expected_size);
+  }
+
+  for (size_t entry_itr = 0; entry_itr < keys.size(); entry_itr++) {
+    KeyType index_key;
+    index_key.SetFromKey(keys[entry_itr]);
+
+    ValueType value = item_pointer_pool->Allocate(locations[entry_itr]);
+    container.upsert(index_key,
+                     [value](std::vector<ValueType> &existing_values) {
+                       existing_values.push_back(value);
+                     },
+                     std::vector<ValueType>(1, value));
+  }
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+void HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::ScanHelper(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction,
+    std::function<void(ItemPointer *)> visitor) {
+  if (scan_direction != SCAN_DIRECTION_TYPE_FORWARD &&
+      scan_direction != SCAN_DIRECTION_TYPE_BACKWARD) {
+    throw Exception("Invalid scan direction \n");
+  }
+
+  auto key_schema = metadata->GetKeySchema();
+
+  // SPECIAL CASE : every key column is bound by an equality constraint
+  std::unique_ptr<storage::Tuple> probe_key(
+      new storage::Tuple(key_schema, true));
+  bool all_constraints_equal = ConstructLowerBoundTuple(
+      probe_key.get(), values, key_column_ids, expr_types);
+
+  LOG_TRACE("All constraints equal : %d ", all_constraints_equal);
+
+  if (all_constraints_equal == true) {
+    // Other constraints may remain on the same columns
+    if (Compare(*probe_key, key_column_ids, expr_types, values) == false) {
+      return;
+    }
+
+    KeyType index_key;
+    index_key.SetFromKey(probe_key.get());
+
+    std::vector<ValueType> locations;
+    container.find(index_key, locations);
+    for (auto location : locations) {
+      visitor(location);
+    }
+    return;
+  }
+
+  // Otherwise, go over the whole table
+  auto locked_container = container.lock_table();
+
+  for (const auto &entry : locked_container) {
+    auto tuple = entry.first.GetTupleForComparison(key_schema);
+
+    if (Compare(tuple, key_column_ids, expr_types, values) == true) {
+      for (auto location : entry.second) {
+        visitor(location);
+      }
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+void HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::Scan(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction, std::vector<ItemPointer> &result) {
+  ScanHelper(values, key_column_ids, expr_types, scan_direction,
+             [&result](ItemPointer *location) { result.push_back(*location); });
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+void HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::ScanAllKeys(
+    std::vector<ItemPointer> &result) {
+  auto locked_container = container.lock_table();
+
+  // scan all entries
+  for (const auto &entry : locked_container) {
+    for (auto location : entry.second) {
+      result.push_back(*location);
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+void HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::ScanKey(
+    const storage::Tuple *key, std::vector<ItemPointer> &result) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  std::vector<ValueType> locations;
+  container.find(index_key, locations);
+
+  for (auto location : locations) {
+    result.push_back(*location);
+  }
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+void HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::Scan(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction,
+    std::vector<ItemPointer *> &result) {
+  ScanHelper(values, key_column_ids, expr_types, scan_direction,
+             [&result](ItemPointer *location) { result.push_back(location); });
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+void HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::ScanAllKeys(
+    std::vector<ItemPointer *> &result) {
+  auto locked_container = container.lock_table();
+
+  // scan all entries
+  for (const auto &entry : locked_container) {
+    result.insert(result.end(), entry.second.begin(), entry.second.end());
+  }
+}
+
+/**
+ * @brief Return all locations related to this key.
+ */
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+void HashIndex<KeyType, ValueType, KeyHasher, KeyEqualityChecker>::ScanKey(
+    const storage::Tuple *key, std::vector<ItemPointer *> &result) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  std::vector<ValueType> locations;
+  container.find(index_key, locations);
+
+  result.insert(result.end(), locations.begin(), locations.end());
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+std::string HashIndex<KeyType, ValueType, KeyHasher,
+                      KeyEqualityChecker>::GetTypeName() const {
+  return "Hash";
+}
+
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+size_t HashIndex<KeyType, ValueType, KeyHasher,
+                 KeyEqualityChecker>::GetMemoryFootprint() {
+  // Slots of the table plus the out-of-line value vectors and cells
+  size_t slot_size = sizeof(KeyType) + sizeof(std::vector<ValueType>);
+  return container.bucket_count() * MapType::slot_per_bucket * slot_size +
+         container.size() * sizeof(ValueType) +
+         item_pointer_pool->GetMemoryFootprint();
+}
+
+// Explicit template instantiation
+template class HashIndex<IntsKey<1>, ItemPointer *, IntsHasher<1>,
+                         IntsEqualityChecker<1>>;
+template class HashIndex<IntsKey<2>, ItemPointer *, IntsHasher<2>,
+                         IntsEqualityChecker<2>>;
+template class HashIndex<IntsKey<3>, ItemPointer *, IntsHasher<3>,
+                         IntsEqualityChecker<3>>;
+template class HashIndex<IntsKey<4>, ItemPointer *, IntsHasher<4>,
+                         IntsEqualityChecker<4>>;
+
+template class HashIndex<GenericKey<4>, ItemPointer *, GenericHasher<4>,
+                         GenericEqualityChecker<4>>;
+template class HashIndex<GenericKey<8>, ItemPointer *, GenericHasher<8>,
+                         GenericEqualityChecker<8>>;
+template class HashIndex<GenericKey<12>, ItemPointer *, GenericHasher<12>,
+                         GenericEqualityChecker<12>>;
+template class HashIndex<GenericKey<16>, ItemPointer *, GenericHasher<16>,
+                         GenericEqualityChecker<16>>;
+template class HashIndex<GenericKey<24>, ItemPointer *, GenericHasher<24>,
+                         GenericEqualityChecker<24>>;
+template class HashIndex<GenericKey<32>, ItemPointer *, GenericHasher<32>,
+                         GenericEqualityChecker<32>>;
+template class HashIndex<GenericKey<48>, ItemPointer *, GenericHasher<48>,
+                         GenericEqualityChecker<48>>;
+template class HashIndex<GenericKey<64>, ItemPointer *, GenericHasher<64>,
+                         GenericEqualityChecker<64>>;
+template class HashIndex<GenericKey<96>, ItemPointer *, GenericHasher<96>,
+                         GenericEqualityChecker<96>>;
+template class HashIndex<GenericKey<128>, ItemPointer *, GenericHasher<128>,
+                         GenericEqualityChecker<128>>;
+template class HashIndex<GenericKey<256>, ItemPointer *, GenericHasher<256>,
+                         GenericEqualityChecker<256>>;
+template class HashIndex<GenericKey<512>, ItemPointer *, GenericHasher<512>,
+                         GenericEqualityChecker<512>>;
+
+template class HashIndex<TupleKey, ItemPointer *, TupleKeyHasher,
+                         TupleKeyEqualityChecker>;
+
+}  // End index namespace
+}  // End peloton namespace
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// hash_index.h
+//
+// Identification: src/backend/index/hash_index.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "backend/catalog/manager.h"
+#include "backend/common/platform.h"
+#include "backend/common/types.h"
+#include "backend/index/index.h"
+#include "backend/index/item_pointer_pool.h"
+
+#include "libcuckoo/cuckoohash_map.hh"
+
+namespace peloton {
+namespace index {
+
+// Number of keys the table is sized for initially; it grows on demand
+#define HASH_INDEX_INITIAL_SIZE 1024
+
+/**
+ * Cuckoo hash table-based index implementation.
+ *
+ * All values of a key are kept together in one slot of the table, and
+ * every operation only locks the two buckets the key can live in. The index
+ * only answers point lookups directly: Scan() probes the table if all key
+ * columns are bound by equality, and otherwise falls back to a full
+ * (unordered) pass over the table.
+ *
+ * @see Index
+ */
+template <typename KeyType, typename ValueType, class KeyHasher,
+          class KeyEqualityChecker>
+class HashIndex : public Index {
+  friend class IndexFactory;
+
+  // Define the container type
+  typedef cuckoohash_map<KeyType, std::vector<ValueType>, KeyHasher,
+                         KeyEqualityChecker> MapType;
+
+ public:
+  HashIndex(IndexMetadata *metadata);
+
+  ~HashIndex();
+
+  bool InsertEntry(const storage::Tuple *key, const ItemPointer &location);
+
+  bool DeleteEntry(const storage::Tuple *key, const ItemPointer &location);
+
+  bool CondInsertEntry(const storage::Tuple *key, const ItemPointer &location,
+                       std::function<bool(const ItemPointer &)> predicate);
+
+  void BulkLoad(const std::vector<const storage::Tuple *> &keys,
+                const std::vector<ItemPointer> &locations);
+
+  void Scan(const std::vector<Value> &values,
+            const std::vector<oid_t> &key_column_ids,
+            const std::vector<ExpressionType> &expr_types,
+            const ScanDirectionType &scan_direction,
+            std::vector<ItemPointer> &);
+
+  void ScanAllKeys(std::vector<ItemPointer> &);
+
+  void ScanKey(const storage::Tuple *key, std::vector<ItemPointer> &);
+
+  void Scan(const std::vector<Value> &values,
+            const std::vector<oid_t> &key_column_ids,
+            const std::vector<ExpressionType> &exprs,
+            const ScanDirectionType &scan_direction,
+            std::vector<ItemPointer *> &result);
+
+  void ScanAllKeys(std::vector<ItemPointer *> &result);
+
+  void ScanKey(const storage::Tuple *key, std::vector<ItemPointer *> &result);
+
+  std::string GetTypeName() const;
+
+  bool Cleanup() { return true; }
+
+  size_t GetMemoryFootprint();
+
+ protected:
+  // Visit the locations matching the predicate
+  void ScanHelper(const std::vector<Value> &values,
+                  const std::vector<oid_t> &key_column_ids,
+                  const std::vector<ExpressionType> &expr_types,
+                  const ScanDirectionType &scan_direction,
+                  std::function<void(ItemPointer *)> visitor);
+
+  MapType container;
+
+  // equality checker and hasher
+  KeyEqualityChecker equals;
+  KeyHasher hasher;
+};
+
+}  // End index namespace
+}  // End peloton namespace
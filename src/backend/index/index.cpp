@@ -11,13 +11,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "backend/index/index.h"
+#include "backend/index/item_pointer_pool.h"
+#include "backend/index/index_scan_cursor.h"
 #include "backend/common/exception.h"
 #include "backend/common/logger.h"
 #include "backend/common/pool.h"
+#include "backend/common/value_factory.h"
 #include "backend/catalog/schema.h"
 #include "backend/catalog/manager.h"
 #include "backend/storage/tuple.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace peloton {
@@ -29,6 +33,9 @@ Index::~Index() {
 
   // clean up pool
   delete pool;
+
+  // clean up location cells
+  delete item_pointer_pool;
 }
 
 IndexMetadata::~IndexMetadata() {
@@ -147,6 +154,57 @@ bool Index::Compare(const AbstractTuple &index_key,
   return true;
 }
 
+void Index::BulkLoad(const std::vector<const storage::Tuple *> &keys,
+                     const std::vector<ItemPointer> &locations) {
+  PL_ASSERT(keys.size() == locations.size());
+  for (size_t entry_itr = 0; entry_itr < keys.size(); entry_itr++) {
+    InsertEntry(keys[entry_itr], locations[entry_itr]);
+  }
+}
+
+void Index::DeleteEntries(const std::vector<const storage::Tuple *> &keys,
+                          const std::vector<ItemPointer> &locations) {
+  PL_ASSERT(keys.size() == locations.size());
+  for (size_t entry_itr = 0; entry_itr < keys.size(); entry_itr++) {
+    DeleteEntry(keys[entry_itr], locations[entry_itr]);
+  }
+}
+
+void Index::ScanKeys(const std::vector<const storage::Tuple *> &keys,
+                     std::vector<ItemPointer *> &result) {
+  for (auto key : keys) {
+    ScanKey(key, result);
+  }
+}
+
+std::unique_ptr<IndexScanCursor> Index::OpenScan(
+    const std::vector<Value> &values, const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &exprs,
+    const ScanDirectionType &scan_direction) {
+  std::vector<ItemPointer *> locations;
+
+  if (key_column_ids.size() == 0) {
+    ScanAllKeys(locations);
+  } else {
+    Scan(values, key_column_ids, exprs, scan_direction, locations);
+  }
+
+  return std::unique_ptr<IndexScanCursor>(
+      new MaterializedScanCursor(std::move(locations)));
+}
+
+bool MaterializedScanCursor::Next(size_t batch_size,
+                                  std::vector<ItemPointer *> &result) {
+  if (offset == locations.size()) return false;
+
+  size_t batch_end = std::min(offset + batch_size, locations.size());
+  result.insert(result.end(), locations.begin() + offset,
+                locations.begin() + batch_end);
+  offset = batch_end;
+
+  return true;
+}
+
 bool Index::IfForwardExpression(ExpressionType e) {
   if (e == EXPRESSION_TYPE_COMPARE_GREATERTHAN ||
       e == EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO) {
@@ -171,6 +229,137 @@ bool Index::ValuePairComparator(const std::pair<peloton::Value, int> &i,
   return i.first.Compare(j.first) == VALUE_COMPARE_LESSTHAN;
 }
 
+void Index::ConstructIntervals(oid_t leading_column_id,
+                               const std::vector<Value> &values,
+                               const std::vector<oid_t> &key_column_ids,
+                               const std::vector<ExpressionType> &expr_types,
+                               std::vector<std::pair<Value, Value>> &intervals) {
+  // Find all contrains of leading column.
+  // Equal --> > < num
+  // > >= --->  > num
+  // < <= ----> < num
+  std::vector<std::pair<peloton::Value, int>> nums;
+  for (size_t i = 0; i < key_column_ids.size(); i++) {
+    if (key_column_ids[i] != leading_column_id) {
+      continue;
+    }
+
+    // If leading column
+    if (IfForwardExpression(expr_types[i])) {
+      nums.push_back(std::pair<Value, int>(values[i], -1));
+    } else if (IfBackwardExpression(expr_types[i])) {
+      nums.push_back(std::pair<Value, int>(values[i], 1));
+    } else {
+      assert(expr_types[i] == EXPRESSION_TYPE_COMPARE_EQUAL);
+      nums.push_back(std::pair<Value, int>(values[i], -1));
+      nums.push_back(std::pair<Value, int>(values[i], 1));
+    }
+  }
+
+  // Have merged all constraints in a single line, sort this line.
+  std::sort(nums.begin(), nums.end(), Index::ValuePairComparator);
+  assert(nums.size() > 0);
+
+  // Build intervals.
+  Value cur;
+  size_t i = 0;
+  if (nums[0].second < 0) {
+    cur = nums[0].first;
+    i++;
+  } else {
+    cur = Value::GetMinValue(nums[0].first.GetValueType());
+  }
+
+  while (i < nums.size()) {
+    if (nums[i].second > 0) {
+      if (i + 1 < nums.size() && nums[i + 1].second < 0) {
+        // right value
+        intervals.push_back(std::pair<Value, Value>(cur, nums[i].first));
+        cur = nums[i + 1].first;
+      } else if (i + 1 == nums.size()) {
+        // Last value while right value
+        intervals.push_back(std::pair<Value, Value>(cur, nums[i].first));
+        cur = Value::GetNullValue(nums[0].first.GetValueType());
+      }
+    }
+    i++;
+  }
+
+  if (cur.IsNull() == false) {
+    intervals.push_back(std::pair<Value, Value>(
+        cur, Value::GetMaxValue(nums[0].first.GetValueType())));
+  }
+
+  // Finish invtervals building.
+}
+
+void Index::FindMaxMinInColumns(
+    oid_t leading_column_id, const std::vector<Value> &values,
+    const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    std::map<oid_t, std::pair<Value, Value>> &non_leading_columns) {
+  // find extreme nums on each column.
+  LOG_TRACE("FindMinMax leading column %d\n", leading_column_id);
+  for (size_t i = 0; i < key_column_ids.size(); i++) {
+    oid_t column_id = key_column_ids[i];
+    if (column_id == leading_column_id) {
+      continue;
+    }
+
+    if (non_leading_columns.find(column_id) == non_leading_columns.end()) {
+      auto type = values[i].GetValueType();
+      //std::pair<Value, Value> *range = new std::pair<Value, Value>(Value::GetMaxValue(type),
+      //                                            Value::GetMinValue(type));
+      // std::pair<oid_t, std::pair<Value, Value>> key_value(column_id, range);
+       non_leading_columns.insert(std::pair<oid_t, std::pair<Value, Value>>(
+                                         column_id, std::pair<Value, Value>(
+                                         Value::GetNullValue(type),
+                                         Value::GetNullValue(type))));
+      //  non_leading_columns[column_id] = *range;
+      // delete range;
+      LOG_TRACE("Insert a init bounds\tleft size %lu\t right description %s\n",
+                non_leading_columns[column_id].first.GetInfo().size(),
+                non_leading_columns[column_id].second.GetInfo().c_str());
+    }
+
+    if (IfForwardExpression(expr_types[i]) ||
+        expr_types[i] == EXPRESSION_TYPE_COMPARE_EQUAL) {
+      LOG_TRACE("min cur %lu compare with %s\n",
+                non_leading_columns[column_id].first.GetInfo().size(),
+                values[i].GetInfo().c_str());
+      if (non_leading_columns[column_id].first.IsNull() ||
+          non_leading_columns[column_id].first.Compare(values[i]) == VALUE_COMPARE_GREATERTHAN) {
+        LOG_TRACE("Update min\n");
+        non_leading_columns[column_id].first = ValueFactory::Clone(values[i], nullptr);
+      }
+    }
+
+    if (IfBackwardExpression(expr_types[i]) ||
+        expr_types[i] == EXPRESSION_TYPE_COMPARE_EQUAL) {
+      LOG_TRACE("max cur %s compare with %s\n",
+                non_leading_columns[column_id].second.GetInfo().c_str(),
+                values[i].GetInfo().c_str());
+      if (non_leading_columns[column_id].first.IsNull() ||
+          non_leading_columns[column_id].second.Compare(values[i]) == VALUE_COMPARE_LESSTHAN) {
+        LOG_TRACE("Update max\n");
+        non_leading_columns[column_id].second = ValueFactory::Clone(values[i], nullptr);
+      }
+    }
+  }
+
+  // check if min value is right bound or max value is left bound, if so, update
+  for (const auto &k_v : non_leading_columns) {
+    if (k_v.second.first.IsNull()) {
+      non_leading_columns[k_v.first].first =
+          Value::GetMinValue(k_v.second.first.GetValueType());
+    }
+    if (k_v.second.second.IsNull()) {
+      non_leading_columns[k_v.first].second =
+          Value::GetMaxValue(k_v.second.second.GetValueType());
+    }
+  }
+}
+
 bool Index::ConstructLowerBoundTuple(
     storage::Tuple *index_key, const std::vector<peloton::Value> &values,
     const std::vector<oid_t> &key_column_ids,
@@ -228,6 +417,8 @@ Index::Index(IndexMetadata *metadata) : metadata(metadata) {
 
   // initialize pool
   pool = new VarlenPool(BACKEND_TYPE_MM);
+
+  item_pointer_pool = new ItemPointerPool();
 }
 
 const std::string Index::GetInfo() const {
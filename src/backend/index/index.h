@@ -14,6 +14,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <functional>
 #include <memory>
 
@@ -31,6 +32,9 @@ namespace storage { class Tuple; }
 
 namespace index {
 
+class ItemPointerPool;
+class IndexScanCursor;
+
 //===--------------------------------------------------------------------===//
 // IndexMetadata
 //===--------------------------------------------------------------------===//
@@ -128,6 +132,17 @@ class Index : public Printable {
       const storage::Tuple *key, const ItemPointer &location,
       std::function<bool(const ItemPointer &)> predicate) = 0;
 
+  // insert a batch of entries, e.g. all the tuples of a table when the index
+  // is built or recovered. The keys need not be sorted. Must not run
+  // concurrently with other operations on the index.
+  virtual void BulkLoad(const std::vector<const storage::Tuple *> &keys,
+                        const std::vector<ItemPointer> &locations);
+
+  // delete a batch of entries, e.g. those of the versions reclaimed by the
+  // garbage collector
+  virtual void DeleteEntries(const std::vector<const storage::Tuple *> &keys,
+                             const std::vector<ItemPointer> &locations);
+
   //===--------------------------------------------------------------------===//
   // Accessors
   //===--------------------------------------------------------------------===//
@@ -157,6 +172,19 @@ class Index : public Printable {
   virtual void ScanKey(const storage::Tuple *key,
                        std::vector<ItemPointer *> &result) = 0;
 
+  // probe a batch of distinct keys, e.g. the values of an IN list, and
+  // append the locations of all of them
+  virtual void ScanKeys(const std::vector<const storage::Tuple *> &keys,
+                        std::vector<ItemPointer *> &result);
+
+  // open a cursor over the locations that Scan would return, or over all
+  // locations if there are no key columns. The values are copied.
+  virtual std::unique_ptr<IndexScanCursor> OpenScan(
+      const std::vector<Value> &values,
+      const std::vector<oid_t> &key_column_ids,
+      const std::vector<ExpressionType> &exprs,
+      const ScanDirectionType &scan_direction);
+
   //===--------------------------------------------------------------------===//
   // STATS
   //===--------------------------------------------------------------------===//
@@ -218,6 +246,20 @@ class Index : public Printable {
   bool static ValuePairComparator(const std::pair<peloton::Value, int> &i,
                            const std::pair<peloton::Value, int> &j);
 
+  // Split the constraints on the leading key column into disjoint intervals
+  void ConstructIntervals(oid_t leading_column_id,
+                          const std::vector<Value> &values,
+                          const std::vector<oid_t> &key_column_ids,
+                          const std::vector<ExpressionType> &expr_types,
+                          std::vector<std::pair<Value, Value>> &intervals);
+
+  // Tightest [min, max] bounds implied on each non-leading key column
+  void FindMaxMinInColumns(
+      oid_t leading_column_id, const std::vector<Value> &values,
+      const std::vector<oid_t> &key_column_ids,
+      const std::vector<ExpressionType> &expr_types,
+      std::map<oid_t, std::pair<Value, Value>> &non_leading_columns);
+
   // Get the indexed tile group offset
   virtual int GetIndexedTileGroupOff() {
     return -1;
@@ -262,6 +304,9 @@ class Index : public Printable {
 
   // pool
   VarlenPool *pool = nullptr;
+
+  // location cells referenced by the index entries
+  ItemPointerPool *item_pointer_pool = nullptr;
 };
 
 }  // End index namespace
@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// index_builder.cpp
+//
+// Identification: src/backend/index/index_builder.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+#include "backend/catalog/schema.h"
+#include "backend/common/logger.h"
+#include "backend/expression/container_tuple.h"
+#include "backend/index/index_builder.h"
+#include "backend/storage/data_table.h"
+#include "backend/storage/tile_group.h"
+#include "backend/storage/tile_group_header.h"
+#include "backend/storage/tuple.h"
+
+namespace peloton {
+namespace index {
+
+namespace {
+
+// The (key, location) pairs one thread collected for one index
+struct IndexEntries {
+  std::vector<std::unique_ptr<storage::Tuple>> keys;
+  std::vector<ItemPointer> locations;
+};
+
+// Collect the entries of every thread_count-th tile group of the table,
+// starting from the given offset
+void ScanTileGroups(storage::DataTable *table,
+                    const std::vector<Index *> &indexes,
+                    const IndexBuilder::VisibilityPredicate &is_visible,
+                    size_t first_offset, size_t thread_count,
+                    std::vector<IndexEntries> &entries) {
+  size_t index_count = indexes.size();
+  std::vector<std::vector<oid_t>> indexed_columns(index_count);
+  for (size_t index_itr = 0; index_itr < index_count; index_itr++) {
+    indexed_columns[index_itr] =
+        indexes[index_itr]->GetKeySchema()->GetIndexedColumns();
+  }
+
+  size_t tile_group_count = table->GetTileGroupCount();
+  for (size_t offset = first_offset; offset < tile_group_count;
+       offset += thread_count) {
+    auto tile_group = table->GetTileGroup(offset);
+    // the tile group was compacted
+    if (tile_group == nullptr) {
+      continue;
+    }
+    auto tile_group_header = tile_group->GetHeader();
+    auto tile_group_id = tile_group->GetTileGroupId();
+
+    oid_t active_tuple_count = tile_group->GetNextTupleSlot();
+    for (oid_t tuple_id = 0; tuple_id < active_tuple_count; tuple_id++) {
+      if (is_visible(tile_group_header, tuple_id) == false) {
+        continue;
+      }
+
+      expression::ContainerTuple<storage::TileGroup> tuple(tile_group.get(),
+                                                           tuple_id);
+      for (size_t index_itr = 0; index_itr < index_count; index_itr++) {
+        auto index = indexes[index_itr];
+        auto &columns = indexed_columns[index_itr];
+
+        std::unique_ptr<storage::Tuple> key(
+            new storage::Tuple(index->GetKeySchema(), true));
+        for (oid_t column_itr = 0; column_itr < columns.size(); column_itr++) {
+          key->SetValue(column_itr, tuple.GetValue(columns[column_itr]),
+                        index->GetPool());
+        }
+
+        entries[index_itr].keys.push_back(std::move(key));
+        entries[index_itr].locations.push_back(
+            ItemPointer(tile_group_id, tuple_id));
+      }
+    }
+  }
+}
+
+// Hand all entries of an index to it in one batch
+void LoadIndex(Index *index, std::vector<IndexEntries> &thread_entries) {
+  size_t entry_count = 0;
+  for (auto &entries : thread_entries) {
+    entry_count += entries.locations.size();
+  }
+
+  std::vector<const storage::Tuple *> keys;
+  std::vector<ItemPointer> locations;
+  keys.reserve(entry_count);
+  locations.reserve(entry_count);
+  for (auto &entries : thread_entries) {
+    for (auto &key : entries.keys) {
+      keys.push_back(key.get());
+    }
+    locations.insert(locations.end(), entries.locations.begin(),
+                     entries.locations.end());
+  }
+
+  index->BulkLoad(keys, locations);
+  index->IncreaseNumberOfTuplesBy(entry_count);
+
+  LOG_TRACE("Loaded %lu entries into index %s", entry_count,
+            index->GetName().c_str());
+}
+
+}  // End anonymous namespace
+
+void IndexBuilder::Build(storage::DataTable *table,
+                         const std::vector<Index *> &indexes,
+                         VisibilityPredicate is_visible, size_t thread_count) {
+  PL_ASSERT(table);
+  if (indexes.empty()) {
+    return;
+  }
+
+  if (thread_count == 0) {
+    thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  thread_count = std::min(thread_count, (size_t)INDEX_BUILD_MAX_THREAD_COUNT);
+  thread_count = std::max(std::min(thread_count, table->GetTileGroupCount()),
+                          (size_t)1);
+
+  // entries[thread][index]
+  std::vector<std::vector<IndexEntries>> entries(thread_count);
+  for (auto &thread_entries : entries) {
+    thread_entries.resize(indexes.size());
+  }
+
+  // Scan phase: the calling thread takes the first share
+  std::vector<std::thread> scan_threads;
+  for (size_t thread_itr = 1; thread_itr < thread_count; thread_itr++) {
+    scan_threads.push_back(std::thread(
+        ScanTileGroups, table, std::cref(indexes), std::cref(is_visible),
+        thread_itr, thread_count, std::ref(entries[thread_itr])));
+  }
+  ScanTileGroups(table, indexes, is_visible, 0, thread_count, entries[0]);
+  for (auto &thread : scan_threads) {
+    thread.join();
+  }
+
+  // Load phase: the indexes are independent, so they load in parallel
+  size_t index_count = indexes.size();
+  auto load_indexes = [&](size_t first_index) {
+    for (size_t index_itr = first_index; index_itr < index_count;
+         index_itr += thread_count) {
+      std::vector<IndexEntries> index_entries;
+      for (auto &thread_entries : entries) {
+        index_entries.push_back(std::move(thread_entries[index_itr]));
+      }
+      LoadIndex(indexes[index_itr], index_entries);
+    }
+  };
+
+  std::vector<std::thread> load_threads;
+  for (size_t thread_itr = 1;
+       thread_itr < std::min(thread_count, index_count); thread_itr++) {
+    load_threads.push_back(std::thread(load_indexes, thread_itr));
+  }
+  load_indexes(0);
+  for (auto &thread : load_threads) {
+    thread.join();
+  }
+}
+
+}  // End index namespace
+}  // End peloton namespace
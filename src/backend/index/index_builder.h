@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// index_builder.h
+//
+// Identification: src/backend/index/index_builder.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "backend/index/index.h"
+
+namespace peloton {
+
+namespace storage {
+class DataTable;
+class TileGroupHeader;
+}
+
+namespace index {
+
+// Upper bound on the number of threads that scan a table for a build
+#define INDEX_BUILD_MAX_THREAD_COUNT 16
+
+//===--------------------------------------------------------------------===//
+// IndexBuilder
+//===--------------------------------------------------------------------===//
+
+/**
+ * Builds indexes over the tuples already stored in a table, e.g. for
+ * CREATE INDEX and after recovery.
+ *
+ * The tile groups are scanned in parallel, every thread collecting the
+ * (key, location) pairs of its own tile groups. Each index then gets all of
+ * its pairs in a single Index::BulkLoad call, which lets the ordered
+ * indexes sort them once and build full nodes bottom-up.
+ */
+class IndexBuilder {
+ public:
+  // Whether a tuple slot of a tile group holds a version to be indexed
+  typedef std::function<bool(const storage::TileGroupHeader *, oid_t)>
+      VisibilityPredicate;
+
+  // Load the visible tuples of the table into the indexes, which must not
+  // be used concurrently until the build is done. A thread count of zero
+  // picks one from the hardware.
+  static void Build(storage::DataTable *table,
+                    const std::vector<Index *> &indexes,
+                    VisibilityPredicate is_visible, size_t thread_count = 0);
+};
+
+}  // End index namespace
+}  // End peloton namespace
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <iostream>
+#include <algorithm>
 
 #include "backend/common/types.h"
 #include "backend/common/logger.h"
@@ -18,7 +19,10 @@
 #include "backend/index/index_factory.h"
 #include "backend/index/index_key.h"
 #include "backend/index/bwtree_index.h"
+#include "backend/index/olc_btree_index.h"
+#include "backend/index/art_index.h"
 #include "backend/index/btree_index.h"
+#include "backend/index/hash_index.h"
 
 namespace peloton {
 namespace index {
@@ -27,7 +31,10 @@ Index *IndexFactory::GetInstance(IndexMetadata *metadata) {
   bool ints_only = false;
 
   LOG_TRACE("Creating index %s", metadata->GetName().c_str());
-  const auto key_size = metadata->key_schema->GetLength();
+  // normalized generic keys can be longer than the key tuple
+  const auto key_size =
+      std::max<size_t>(metadata->key_schema->GetLength(),
+                       KeyNormalizer::GetNormalizedLength(metadata->key_schema));
 
   auto index_type = metadata->GetIndexMethodType();
   LOG_TRACE("Index type : %d", index_type);
@@ -195,6 +202,173 @@ Index *IndexFactory::GetInstance(IndexMetadata *metadata) {
     }
   }
 
+  if (ints_only && (index_type == INDEX_TYPE_OLCBTREE)) {
+    if (key_size <= sizeof(uint64_t)) {
+      return new OLCBTreeIndex<IntsKey<1>, ItemPointer *,
+                               IntsComparator<1>, IntsEqualityChecker<1>>(
+          metadata);
+    } else if (key_size <= sizeof(int64_t) * 2) {
+      return new OLCBTreeIndex<IntsKey<2>, ItemPointer *,
+                               IntsComparator<2>, IntsEqualityChecker<2>>(
+          metadata);
+    } else if (key_size <= sizeof(int64_t) * 3) {
+      return new OLCBTreeIndex<IntsKey<3>, ItemPointer *,
+                               IntsComparator<3>, IntsEqualityChecker<3>>(
+          metadata);
+    } else if (key_size <= sizeof(int64_t) * 4) {
+      return new OLCBTreeIndex<IntsKey<4>, ItemPointer *,
+                               IntsComparator<4>, IntsEqualityChecker<4>>(
+          metadata);
+    } else {
+      throw IndexException("We currently only support tree index on non-unique "
+                           "integer keys of size 32 bytes or smaller...");
+    }
+  }
+
+  if (index_type == INDEX_TYPE_OLCBTREE) {
+    if (key_size <= 4) {
+      return new OLCBTreeIndex<GenericKey<4>, ItemPointer *,
+                               GenericComparator<4>, GenericEqualityChecker<4>>(
+          metadata);
+    } else if (key_size <= 8) {
+      return new OLCBTreeIndex<GenericKey<8>, ItemPointer *,
+                               GenericComparator<8>, GenericEqualityChecker<8>>(
+          metadata);
+    } else if (key_size <= 12) {
+      return new OLCBTreeIndex<GenericKey<12>, ItemPointer *,
+                               GenericComparator<12>,
+                               GenericEqualityChecker<12>>(metadata);
+    } else if (key_size <= 16) {
+      return new OLCBTreeIndex<GenericKey<16>, ItemPointer *,
+                               GenericComparator<16>,
+                               GenericEqualityChecker<16>>(metadata);
+    } else if (key_size <= 24) {
+      return new OLCBTreeIndex<GenericKey<24>, ItemPointer *,
+                               GenericComparator<24>,
+                               GenericEqualityChecker<24>>(metadata);
+    } else if (key_size <= 32) {
+      return new OLCBTreeIndex<GenericKey<32>, ItemPointer *,
+                               GenericComparator<32>,
+                               GenericEqualityChecker<32>>(metadata);
+    } else if (key_size <= 48) {
+      return new OLCBTreeIndex<GenericKey<48>, ItemPointer *,
+                               GenericComparator<48>,
+                               GenericEqualityChecker<48>>(metadata);
+    } else if (key_size <= 64) {
+      return new OLCBTreeIndex<GenericKey<64>, ItemPointer *,
+                               GenericComparator<64>,
+                               GenericEqualityChecker<64>>(metadata);
+    } else if (key_size <= 96) {
+      return new OLCBTreeIndex<GenericKey<96>, ItemPointer *,
+                               GenericComparator<96>,
+                               GenericEqualityChecker<96>>(metadata);
+    } else if (key_size <= 128) {
+      return new OLCBTreeIndex<GenericKey<128>, ItemPointer *,
+                               GenericComparator<128>,
+                               GenericEqualityChecker<128>>(metadata);
+    } else if (key_size <= 256) {
+      return new OLCBTreeIndex<GenericKey<256>, ItemPointer *,
+                               GenericComparator<256>,
+                               GenericEqualityChecker<256>>(metadata);
+    } else if (key_size <= 512) {
+      return new OLCBTreeIndex<GenericKey<512>, ItemPointer *,
+                               GenericComparator<512>,
+                               GenericEqualityChecker<512>>(metadata);
+    } else {
+      return new OLCBTreeIndex<TupleKey, ItemPointer *,
+                               TupleKeyComparator, TupleKeyEqualityChecker>(
+          metadata);
+    }
+  }
+
+  // The radix tree needs the byte-comparable integer keys
+  if (index_type == INDEX_TYPE_ART) {
+    bool ints_key = true;
+    for (auto &column : metadata->key_schema->GetColumns()) {
+      if (column.column_type != VALUE_TYPE_BIGINT &&
+          column.column_type != VALUE_TYPE_INTEGER &&
+          column.column_type != VALUE_TYPE_SMALLINT &&
+          column.column_type != VALUE_TYPE_TINYINT) {
+        ints_key = false;
+      }
+    }
+
+    if (ints_key && key_size <= sizeof(uint64_t)) {
+      return new ARTIndex<IntsKey<1>, ItemPointer *>(metadata);
+    } else if (ints_key && key_size <= sizeof(int64_t) * 2) {
+      return new ARTIndex<IntsKey<2>, ItemPointer *>(metadata);
+    } else if (ints_key && key_size <= sizeof(int64_t) * 3) {
+      return new ARTIndex<IntsKey<3>, ItemPointer *>(metadata);
+    } else if (ints_key && key_size <= sizeof(int64_t) * 4) {
+      return new ARTIndex<IntsKey<4>, ItemPointer *>(metadata);
+    } else {
+      throw IndexException("We currently only support ART index on "
+                           "integer keys of size 32 bytes or smaller...");
+    }
+  }
+
+  if (ints_only && (index_type == INDEX_TYPE_HASH)) {
+    if (key_size <= sizeof(uint64_t)) {
+      return new HashIndex<IntsKey<1>, ItemPointer *, IntsHasher<1>,
+                           IntsEqualityChecker<1>>(metadata);
+    } else if (key_size <= sizeof(int64_t) * 2) {
+      return new HashIndex<IntsKey<2>, ItemPointer *, IntsHasher<2>,
+                           IntsEqualityChecker<2>>(metadata);
+    } else if (key_size <= sizeof(int64_t) * 3) {
+      return new HashIndex<IntsKey<3>, ItemPointer *, IntsHasher<3>,
+                           IntsEqualityChecker<3>>(metadata);
+    } else if (key_size <= sizeof(int64_t) * 4) {
+      return new HashIndex<IntsKey<4>, ItemPointer *, IntsHasher<4>,
+                           IntsEqualityChecker<4>>(metadata);
+    } else {
+      throw IndexException("We currently only support hash index on non-unique "
+                           "integer keys of size 32 bytes or smaller...");
+    }
+  }
+
+  if (index_type == INDEX_TYPE_HASH) {
+    if (key_size <= 4) {
+      return new HashIndex<GenericKey<4>, ItemPointer *, GenericHasher<4>,
+                           GenericEqualityChecker<4>>(metadata);
+    } else if (key_size <= 8) {
+      return new HashIndex<GenericKey<8>, ItemPointer *, GenericHasher<8>,
+                           GenericEqualityChecker<8>>(metadata);
+    } else if (key_size <= 12) {
+      return new HashIndex<GenericKey<12>, ItemPointer *, GenericHasher<12>,
+                           GenericEqualityChecker<12>>(metadata);
+    } else if (key_size <= 16) {
+      return new HashIndex<GenericKey<16>, ItemPointer *, GenericHasher<16>,
+                           GenericEqualityChecker<16>>(metadata);
+    } else if (key_size <= 24) {
+      return new HashIndex<GenericKey<24>, ItemPointer *, GenericHasher<24>,
+                           GenericEqualityChecker<24>>(metadata);
+    } else if (key_size <= 32) {
+      return new HashIndex<GenericKey<32>, ItemPointer *, GenericHasher<32>,
+                           GenericEqualityChecker<32>>(metadata);
+    } else if (key_size <= 48) {
+      return new HashIndex<GenericKey<48>, ItemPointer *, GenericHasher<48>,
+                           GenericEqualityChecker<48>>(metadata);
+    } else if (key_size <= 64) {
+      return new HashIndex<GenericKey<64>, ItemPointer *, GenericHasher<64>,
+                           GenericEqualityChecker<64>>(metadata);
+    } else if (key_size <= 96) {
+      return new HashIndex<GenericKey<96>, ItemPointer *, GenericHasher<96>,
+                           GenericEqualityChecker<96>>(metadata);
+    } else if (key_size <= 128) {
+      return new HashIndex<GenericKey<128>, ItemPointer *, GenericHasher<128>,
+                           GenericEqualityChecker<128>>(metadata);
+    } else if (key_size <= 256) {
+      return new HashIndex<GenericKey<256>, ItemPointer *, GenericHasher<256>,
+                           GenericEqualityChecker<256>>(metadata);
+    } else if (key_size <= 512) {
+      return new HashIndex<GenericKey<512>, ItemPointer *, GenericHasher<512>,
+                           GenericEqualityChecker<512>>(metadata);
+    } else {
+      return new HashIndex<TupleKey, ItemPointer *, TupleKeyHasher,
+                           TupleKeyEqualityChecker>(metadata);
+    }
+  }
+
   throw IndexException("Unsupported index scheme.");
   return NULL;
 }
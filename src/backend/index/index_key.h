@@ -14,12 +14,15 @@
 
 #include <iostream>
 #include <sstream>
+#include <cstring>
 
+#include "backend/common/value_factory.h"
 #include "backend/common/value_peeker.h"
 #include "backend/common/logger.h"
 #include "backend/common/macros.h"
 #include "backend/storage/tuple.h"
 #include "backend/index/index.h"
+#include "backend/index/normalized_key.h"
 
 #include <boost/functional/hash.hpp>
 
@@ -163,11 +166,80 @@ template <std::size_t KeySize> class IntsKey {
     return retval;
   }
 
-  const storage::Tuple GetTupleForComparison(UNUSED_ATTRIBUTE const
-                                             catalog::Schema *key_schema) {
+  const storage::Tuple GetTupleForComparison(
+      UNUSED_ATTRIBUTE const catalog::Schema *key_schema) const {
     throw IndexException("Tuple conversion not supported");
   }
 
+  /*
+   * Byte of the key at the given offset. The words are read most significant
+   * byte first, so keys compare like their byte strings.
+   */
+  inline uint8_t GetKeyByte(std::size_t byte_offset) const {
+    const std::size_t intra_key_offset =
+        sizeof(uint64_t) - 1 - byte_offset % sizeof(uint64_t);
+    return 0xFF & (data[byte_offset / sizeof(uint64_t)] >>
+                   (intra_key_offset * 8));
+  }
+
+  /*
+   * Inverse of SetFromKey. The tuple must have the key schema.
+   */
+  inline void GetKeyTuple(storage::Tuple *tuple) const {
+    const catalog::Schema *key_schema = tuple->GetSchema();
+    const int GetColumnCount = key_schema->GetColumnCount();
+    int key_offset = 0;
+    int intra_key_offset = sizeof(uint64_t) - 1;
+    for (int ii = 0; ii < GetColumnCount; ii++) {
+      switch (key_schema->GetColumn(ii).column_type) {
+        case VALUE_TYPE_BIGINT: {
+          const uint64_t key_value =
+              ExtractKeyValue<uint64_t>(key_offset, intra_key_offset);
+          tuple->SetValue(
+              ii, ValueFactory::GetBigIntValue(
+                      ConvertUnsignedValueToSignedValue<int64_t, INT64_MAX>(
+                          key_value)),
+              nullptr);
+          break;
+        }
+        case VALUE_TYPE_INTEGER: {
+          const uint64_t key_value =
+              ExtractKeyValue<uint32_t>(key_offset, intra_key_offset);
+          tuple->SetValue(
+              ii, ValueFactory::GetIntegerValue(
+                      ConvertUnsignedValueToSignedValue<int32_t, INT32_MAX>(
+                          key_value)),
+              nullptr);
+          break;
+        }
+        case VALUE_TYPE_SMALLINT: {
+          const uint64_t key_value =
+              ExtractKeyValue<uint16_t>(key_offset, intra_key_offset);
+          tuple->SetValue(
+              ii, ValueFactory::GetSmallIntValue(
+                      ConvertUnsignedValueToSignedValue<int16_t, INT16_MAX>(
+                          key_value)),
+              nullptr);
+          break;
+        }
+        case VALUE_TYPE_TINYINT: {
+          const uint64_t key_value =
+              ExtractKeyValue<uint8_t>(key_offset, intra_key_offset);
+          tuple->SetValue(
+              ii, ValueFactory::GetTinyIntValue(
+                      ConvertUnsignedValueToSignedValue<int8_t, INT8_MAX>(
+                          key_value)),
+              nullptr);
+          break;
+        }
+        default:
+          throw IndexException("We currently only support a specific set of "
+                               "column index sizes...");
+          break;
+      }
+    }
+  }
+
   std::string Debug(const catalog::Schema *key_schema) const {
     std::ostringstream buffer;
     int key_offset = 0;
@@ -392,20 +464,31 @@ struct IntsHasher : std::unary_function<IntsKey<KeySize>, std::size_t> {
 
 /**
  * Key object for indexes of mixed types.
- * Using storage::Tuple to store columns.
+ * Keys that KeyNormalizer supports are stored in their binary-comparable
+ * form, others use storage::Tuple to store columns.
  */
 template <std::size_t KeySize> class GenericKey {
  public:
   inline void SetFromKey(const storage::Tuple *tuple) {
     PL_ASSERT(tuple);
-    PL_MEMCPY(data, tuple->GetData(), KeySize);
+    auto normalized_length =
+        KeyNormalizer::GetNormalizedLength(tuple->GetSchema());
+    if (normalized_length != 0) {
+      PL_ASSERT(normalized_length <= KeySize);
+      PL_MEMSET(data, 0, KeySize);
+      KeyNormalizer::Normalize(tuple, data);
+    } else {
+      PL_MEMCPY(data, tuple->GetData(), KeySize);
+    }
   }
 
-  const storage::Tuple GetTupleForComparison(
-      const catalog::Schema *key_schema) {
-    return storage::Tuple(key_schema, data);
+  const GenericKeyTuple GetTupleForComparison(
+      const catalog::Schema *key_schema) const {
+    return GenericKeyTuple(key_schema, data,
+                           KeyNormalizer::GetNormalizedLength(key_schema) != 0);
   }
 
+  // Only for keys in the tuple format
   inline const Value ToValueFast(const catalog::Schema *schema,
                                  int column_id) const {
     const ValueType column_type = schema->GetType(column_id);
@@ -428,10 +511,15 @@ template <std::size_t KeySize> class GenericComparator {
  public:
   /** Type information passed to the constuctor as it's not in the key itself */
   GenericComparator(index::IndexMetadata *metadata)
-      : schema(metadata->GetKeySchema()) {}
+      : schema(metadata->GetKeySchema()),
+        normalized(KeyNormalizer::GetNormalizedLength(schema) != 0) {}
 
   inline bool operator()(const GenericKey<KeySize> &lhs,
                          const GenericKey<KeySize> &rhs) const {
+    if (normalized) {
+      return memcmp(lhs.data, rhs.data, KeySize) < 0;
+    }
+
     /*
     storage::Tuple lhTuple(schema);
     lhTuple.MoveToTuple(reinterpret_cast<const void *>(&lhs));
@@ -459,6 +547,9 @@ template <std::size_t KeySize> class GenericComparator {
   }
 
   const catalog::Schema *schema;
+
+  // keys are in their binary-comparable form
+  bool normalized;
 };
 
 /**
@@ -468,10 +559,15 @@ template <std::size_t KeySize> class GenericEqualityChecker {
  public:
   /** Type information passed to the constuctor as it's not in the key itself */
   GenericEqualityChecker(index::IndexMetadata *metadata)
-      : schema(metadata->GetKeySchema()) {}
+      : schema(metadata->GetKeySchema()),
+        normalized(KeyNormalizer::GetNormalizedLength(schema) != 0) {}
 
   inline bool operator()(const GenericKey<KeySize> &lhs,
                          const GenericKey<KeySize> &rhs) const {
+    if (normalized) {
+      return memcmp(lhs.data, rhs.data, KeySize) == 0;
+    }
+
     storage::Tuple lhTuple(schema);
     lhTuple.MoveToTuple(reinterpret_cast<const void *>(&lhs));
     storage::Tuple rhTuple(schema);
@@ -480,6 +576,9 @@ template <std::size_t KeySize> class GenericEqualityChecker {
   }
 
   const catalog::Schema *schema;
+
+  // keys are in their binary-comparable form
+  bool normalized;
 };
 
 /**
@@ -489,16 +588,24 @@ template <std::size_t KeySize>
 struct GenericHasher : std::unary_function<GenericKey<KeySize>, std::size_t> {
   /** Type information passed to the constuctor as it's not in the key itself */
   GenericHasher(index::IndexMetadata *metadata)
-      : schema(metadata->GetKeySchema()) {}
+      : schema(metadata->GetKeySchema()),
+        normalized(KeyNormalizer::GetNormalizedLength(schema) != 0) {}
 
   /** Generate a 64-bit number for the key value */
   inline size_t operator()(GenericKey<KeySize> const &p) const {
+    if (normalized) {
+      return boost::hash_range(p.data, p.data + KeySize);
+    }
+
     storage::Tuple pTuple(schema);
     pTuple.MoveToTuple(reinterpret_cast<const void *>(&p));
     return pTuple.HashCode();
   }
 
   const catalog::Schema *schema;
+
+  // keys are in their binary-comparable form
+  bool normalized;
 };
 
 /*
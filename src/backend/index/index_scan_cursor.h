@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// index_scan_cursor.h
+//
+// Identification: src/backend/index/index_scan_cursor.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "backend/common/macros.h"
+#include "backend/common/types.h"
+
+namespace peloton {
+namespace index {
+
+//===--------------------------------------------------------------------===//
+// Index Scan Cursor
+//===--------------------------------------------------------------------===//
+
+/**
+ * Cursor over the locations matching an index scan, handed out in batches
+ * so that the consumer can stop before the end of the range.
+ *
+ * @see Index::OpenScan
+ */
+class IndexScanCursor {
+ public:
+  virtual ~IndexScanCursor() {}
+
+  // Append the next batch of about batch_size locations to result.
+  // Returns false once the scan is exhausted.
+  virtual bool Next(size_t batch_size, std::vector<ItemPointer *> &result) = 0;
+};
+
+/**
+ * Cursor over locations that were collected up front, for indexes that
+ * cannot resume a scan.
+ */
+class MaterializedScanCursor : public IndexScanCursor {
+ public:
+  MaterializedScanCursor(std::vector<ItemPointer *> &&locations)
+      : locations(std::move(locations)) {}
+
+  bool Next(size_t batch_size, std::vector<ItemPointer *> &result);
+
+ private:
+  std::vector<ItemPointer *> locations;
+
+  size_t offset = 0;
+};
+
+/**
+ * Cursor of the ordered indexes.
+ *
+ * Every batch is a fresh scan that starts after the last key of the
+ * previous batch, so no latch or epoch is held between two batches. A
+ * batch only ends where the key changes: the locations of one key are
+ * never split across batches.
+ */
+template <typename KeyType>
+class KeyOrderScanCursor : public IndexScanCursor {
+ public:
+  typedef std::function<bool(const KeyType &, ItemPointer *)> Visitor;
+
+  // Visit the matching entries after the resume key, or all of them if it
+  // is null, until the visitor returns false. Returns false if stopped.
+  typedef std::function<bool(const KeyType *, Visitor)> ScanFunction;
+
+  typedef std::function<bool(const KeyType &, const KeyType &)> KeyEquality;
+
+  KeyOrderScanCursor(ScanFunction scan, KeyEquality equals)
+      : scan(scan), equals(equals) {}
+
+  bool Next(size_t batch_size, std::vector<ItemPointer *> &result) {
+    PL_ASSERT(batch_size > 0);
+    if (exhausted) return false;
+
+    size_t batch_start = result.size();
+    KeyType last_key = KeyType();
+    exhausted = scan(has_resume_key ? &resume_key : nullptr,
+                     [&](const KeyType &key, ItemPointer *location) {
+      if (result.size() - batch_start >= batch_size &&
+          equals(key, last_key) == false) {
+        return false;
+      }
+      result.push_back(location);
+      last_key = key;
+      return true;
+    });
+
+    // a stopped scan has filled the batch
+    if (exhausted == false) {
+      resume_key = last_key;
+      has_resume_key = true;
+    }
+
+    return result.size() > batch_start;
+  }
+
+ private:
+  ScanFunction scan;
+
+  KeyEquality equals;
+
+  // the last key handed out
+  KeyType resume_key;
+
+  bool has_resume_key = false;
+
+  bool exhausted = false;
+};
+
+}  // End index namespace
+}  // End peloton namespace
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// item_pointer_pool.cpp
+//
+// Identification: src/backend/index/item_pointer_pool.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+
+#include "backend/index/item_pointer_pool.h"
+#include "backend/common/logger.h"
+#include "backend/concurrency/transaction_manager_factory.h"
+
+namespace peloton {
+namespace index {
+
+// Threads are spread over the stripes in the order they first allocate
+static std::atomic<size_t> next_stripe_id(0);
+
+ItemPointerPool::ItemPointerPool() {}
+
+ItemPointerPool::~ItemPointerPool() {
+  for (auto &stripe : stripes_) {
+    for (auto slab : stripe.slabs) {
+      delete[] slab;
+    }
+  }
+}
+
+ItemPointerPool::Stripe &ItemPointerPool::GetStripe() {
+  static thread_local size_t stripe_id =
+      next_stripe_id.fetch_add(1) % ITEM_POINTER_POOL_STRIPE_COUNT;
+  return stripes_[stripe_id];
+}
+
+void ItemPointerPool::PushFreeCell(Stripe &stripe, Cell *cell) {
+  cell->next_free = stripe.free_list;
+  stripe.free_list = cell;
+}
+
+ItemPointer *ItemPointerPool::Allocate(const ItemPointer &location) {
+  Stripe &stripe = GetStripe();
+  Cell *cell = nullptr;
+
+  stripe.stripe_lock.Lock();
+
+  if (stripe.free_list == nullptr && stripe.retired_cells.empty() == false) {
+    ReclaimRetiredCells(stripe);
+  }
+
+  if (stripe.free_list != nullptr) {
+    cell = stripe.free_list;
+    stripe.free_list = cell->next_free;
+  } else {
+    if (stripe.slab_offset == ITEM_POINTER_SLAB_SIZE) {
+      stripe.slabs.push_back(new Cell[ITEM_POINTER_SLAB_SIZE]);
+      stripe.slab_offset = 0;
+      LOG_TRACE("Item pointer slab count : %lu", stripe.slabs.size());
+    }
+    cell = stripe.slabs.back() + stripe.slab_offset++;
+  }
+
+  stripe.stripe_lock.Unlock();
+
+  cell->location = location;
+  return &cell->location;
+}
+
+void ItemPointerPool::Deallocate(ItemPointer *cell) {
+  Stripe &stripe = GetStripe();
+
+  stripe.stripe_lock.Lock();
+  PushFreeCell(stripe, GetCell(cell));
+  stripe.stripe_lock.Unlock();
+}
+
+void ItemPointerPool::Retire(ItemPointer *cell) {
+  Stripe &stripe = GetStripe();
+
+  // Transactions starting from now on can no longer find the cell
+  cid_t retire_cid = concurrency::TransactionManagerFactory::GetInstance()
+                         .GetCurrentCommitId();
+
+  stripe.stripe_lock.Lock();
+  stripe.retired_cells.emplace_back(retire_cid, GetCell(cell));
+  stripe.stripe_lock.Unlock();
+}
+
+void ItemPointerPool::ReclaimRetiredCells(Stripe &stripe) {
+  auto max_cid = concurrency::TransactionManagerFactory::GetInstance()
+                     .GetMaxCommittedCid();
+
+  while (stripe.retired_cells.empty() == false &&
+         stripe.retired_cells.front().first <= max_cid) {
+    PushFreeCell(stripe, stripe.retired_cells.front().second);
+    stripe.retired_cells.pop_front();
+  }
+}
+
+size_t ItemPointerPool::GetMemoryFootprint() {
+  size_t slab_count = 0;
+
+  for (auto &stripe : stripes_) {
+    stripe.stripe_lock.Lock();
+    slab_count += stripe.slabs.size();
+    stripe.stripe_lock.Unlock();
+  }
+
+  return slab_count * ITEM_POINTER_SLAB_SIZE * sizeof(Cell);
+}
+
+}  // End index namespace
+}  // End peloton namespace
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// item_pointer_pool.h
+//
+// Identification: src/backend/index/item_pointer_pool.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "backend/common/platform.h"
+#include "backend/common/types.h"
+
+namespace peloton {
+namespace index {
+
+// Number of location cells carved out of one slab
+#define ITEM_POINTER_SLAB_SIZE 4096
+
+// Number of independently locked stripes of a pool
+#define ITEM_POINTER_POOL_STRIPE_COUNT 16
+
+//===--------------------------------------------------------------------===//
+// Item Pointer Pool
+//===--------------------------------------------------------------------===//
+
+/**
+ * Slab allocator for the location cells that an index hands out.
+ *
+ * The version chain protocol swaps the location stored in an index entry
+ * through the pointer returned by the scan (see AtomicUpdateItemPointer),
+ * so every entry needs a cell whose address does not change while the
+ * underlying container moves its entries around. The cells are carved out
+ * of large slabs owned by the index instead of being allocated one by one
+ * on the heap.
+ *
+ * A cell that was removed from the index may still be read and updated by
+ * transactions that found it earlier. Retired cells are therefore tagged
+ * with the current commit id and only reused once every transaction that
+ * may have seen them is gone, just like the GC does for tuple slots.
+ * All cells are released at once when the pool is destroyed.
+ */
+class ItemPointerPool {
+  ItemPointerPool(const ItemPointerPool &) = delete;
+  ItemPointerPool &operator=(const ItemPointerPool &) = delete;
+
+ public:
+  ItemPointerPool();
+
+  ~ItemPointerPool();
+
+  // Get a cell holding the given location
+  ItemPointer *Allocate(const ItemPointer &location);
+
+  // Give back a cell that was never published in the index
+  void Deallocate(ItemPointer *cell);
+
+  // Give back a cell that was removed from the index; it is reused once no
+  // running transaction can reach it anymore
+  void Retire(ItemPointer *cell);
+
+  // Get the memory footprint of the slabs
+  size_t GetMemoryFootprint();
+
+ private:
+  // A cell holds a location while it is handed out, and links to the next
+  // reusable cell while it is free
+  union Cell {
+    Cell() : location() {}
+
+    ItemPointer location;
+
+    Cell *next_free;
+  };
+
+  struct Stripe {
+    Stripe() : slab_offset(ITEM_POINTER_SLAB_SIZE), free_list(nullptr) {}
+
+    Spinlock stripe_lock;
+
+    // slabs owned by this stripe, the last one is being carved
+    std::vector<Cell *> slabs;
+
+    // next uncarved cell in the last slab
+    size_t slab_offset;
+
+    // reusable cells, chained through the cells themselves
+    Cell *free_list;
+
+    // cells waiting for the transactions that may see them, oldest first
+    std::deque<std::pair<cid_t, Cell *>> retired_cells;
+  };
+
+  Stripe &GetStripe();
+
+  // Move the retired cells that are no longer visible to the free list
+  void ReclaimRetiredCells(Stripe &stripe);
+
+  static void PushFreeCell(Stripe &stripe, Cell *cell);
+
+  // The location is the first member of its cell
+  static Cell *GetCell(ItemPointer *location) {
+    return reinterpret_cast<Cell *>(location);
+  }
+
+  Stripe stripes_[ITEM_POINTER_POOL_STRIPE_COUNT];
+};
+
+}  // End index namespace
+}  // End peloton namespace
@@ -0,0 +1,231 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// normalized_key.cpp
+//
+// Identification: src/backend/index/normalized_key.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "backend/index/normalized_key.h"
+
+#include "backend/catalog/schema.h"
+#include "backend/common/exception.h"
+#include "backend/common/value_factory.h"
+#include "backend/common/value_peeker.h"
+#include "backend/storage/tuple.h"
+
+namespace peloton {
+namespace index {
+
+// Marker bytes of a VARCHAR column
+#define NORMALIZED_KEY_NULL_STRING 0
+#define NORMALIZED_KEY_STRING 1
+
+size_t KeyNormalizer::GetColumnLength(const catalog::Schema *key_schema,
+                                      oid_t column_id) {
+  switch (key_schema->GetType(column_id)) {
+    case VALUE_TYPE_TINYINT:
+      return sizeof(int8_t);
+    case VALUE_TYPE_SMALLINT:
+      return sizeof(int16_t);
+    case VALUE_TYPE_INTEGER:
+    case VALUE_TYPE_DATE:
+      return sizeof(int32_t);
+    case VALUE_TYPE_BIGINT:
+    case VALUE_TYPE_TIMESTAMP:
+    case VALUE_TYPE_DOUBLE:
+      return sizeof(int64_t);
+    case VALUE_TYPE_VARCHAR: {
+      auto max_length = key_schema->GetColumn(column_id).GetLength();
+      if (max_length > NORMALIZED_KEY_MAX_VARCHAR_LENGTH) return 0;
+      // marker byte, length byte and the padded characters
+      return 2 + max_length;
+    }
+    default:
+      return 0;
+  }
+}
+
+size_t KeyNormalizer::GetNormalizedLength(const catalog::Schema *key_schema) {
+  size_t length = 0;
+
+  for (oid_t column_itr = 0; column_itr < key_schema->GetColumnCount();
+       column_itr++) {
+    auto column_length = GetColumnLength(key_schema, column_itr);
+    if (column_length == 0) return 0;
+    length += column_length;
+  }
+
+  return length;
+}
+
+void KeyNormalizer::Normalize(const storage::Tuple *tuple, char *data) {
+  auto key_schema = tuple->GetSchema();
+  auto tuple_data = tuple->GetData();
+  size_t offset = 0;
+
+  for (oid_t column_itr = 0; column_itr < key_schema->GetColumnCount();
+       column_itr++) {
+    auto column_type = key_schema->GetType(column_itr);
+    auto column_length = GetColumnLength(key_schema, column_itr);
+    const char *storage = tuple_data + key_schema->GetOffset(column_itr);
+    char *output = data + offset;
+    uint64_t bits = 0;
+
+    switch (column_type) {
+      case VALUE_TYPE_TINYINT:
+        bits = static_cast<uint8_t>(*reinterpret_cast<const int8_t *>(storage));
+        bits ^= 0x80;
+        break;
+      case VALUE_TYPE_SMALLINT:
+        bits =
+            static_cast<uint16_t>(*reinterpret_cast<const int16_t *>(storage));
+        bits ^= 0x8000;
+        break;
+      case VALUE_TYPE_INTEGER:
+      case VALUE_TYPE_DATE:
+        bits =
+            static_cast<uint32_t>(*reinterpret_cast<const int32_t *>(storage));
+        bits ^= 0x80000000;
+        break;
+      case VALUE_TYPE_BIGINT:
+      case VALUE_TYPE_TIMESTAMP:
+        bits = static_cast<uint64_t>(*reinterpret_cast<const int64_t *>(storage));
+        bits ^= 0x8000000000000000;
+        break;
+      case VALUE_TYPE_DOUBLE: {
+        double value = *reinterpret_cast<const double *>(storage);
+        if (value <= DOUBLE_NULL) {
+          bits = 0;
+        } else if (value != value) {
+          // NaN sorts after NULL and before every number
+          bits = 1;
+        } else {
+          PL_MEMCPY(&bits, &value, sizeof(bits));
+          if (bits & 0x8000000000000000) {
+            bits = ~bits;
+          } else {
+            bits ^= 0x8000000000000000;
+          }
+        }
+      } break;
+      case VALUE_TYPE_VARCHAR: {
+        PL_MEMSET(output, 0, column_length);
+
+        Value value = tuple->GetValue(column_itr);
+        if (value.IsNull()) {
+          output[0] = NORMALIZED_KEY_NULL_STRING;
+          break;
+        }
+
+        output[0] = NORMALIZED_KEY_STRING;
+
+        // Longer strings, like the upper bound of range scans, come after
+        // every string that fits in the column. They keep no characters.
+        size_t max_length = column_length - 2;
+        size_t length = ValuePeeker::PeekObjectLengthWithoutNull(value);
+        if (length > max_length) {
+          output[1] = static_cast<char>(max_length + 1);
+          break;
+        }
+
+        output[1] = static_cast<char>(length);
+        PL_MEMCPY(output + 2, ValuePeeker::PeekObjectValueWithoutNull(value),
+                  length);
+      } break;
+      default:
+        throw IndexException("Cannot normalize key column of type " +
+                             ValueTypeToString(column_type));
+    }
+
+    // fixed-width columns are stored most significant byte first
+    if (column_type != VALUE_TYPE_VARCHAR) {
+      for (size_t byte_itr = 0; byte_itr < column_length; byte_itr++) {
+        output[byte_itr] = static_cast<char>(
+            bits >> (8 * (column_length - byte_itr - 1)));
+      }
+    }
+
+    offset += column_length;
+  }
+}
+
+Value KeyNormalizer::GetValue(const catalog::Schema *key_schema,
+                              const char *data, oid_t column_id) {
+  size_t offset = 0;
+  for (oid_t column_itr = 0; column_itr < column_id; column_itr++) {
+    offset += GetColumnLength(key_schema, column_itr);
+  }
+
+  auto column_type = key_schema->GetType(column_id);
+  auto column_length = GetColumnLength(key_schema, column_id);
+  auto input = reinterpret_cast<const uint8_t *>(data + offset);
+
+  if (column_type == VALUE_TYPE_VARCHAR) {
+    if (input[0] == NORMALIZED_KEY_NULL_STRING) {
+      return ValueFactory::GetNullValueByType(VALUE_TYPE_VARCHAR);
+    }
+    // the length byte and the characters have the inlined string layout
+    return Value::InitFromTupleStorage(input + 1, VALUE_TYPE_VARCHAR, true);
+  }
+
+  uint64_t bits = 0;
+  for (size_t byte_itr = 0; byte_itr < column_length; byte_itr++) {
+    bits = (bits << 8) | input[byte_itr];
+  }
+
+  switch (column_type) {
+    case VALUE_TYPE_TINYINT: {
+      int8_t value = static_cast<int8_t>(bits ^ 0x80);
+      return Value::InitFromTupleStorage(&value, column_type, true);
+    }
+    case VALUE_TYPE_SMALLINT: {
+      int16_t value = static_cast<int16_t>(bits ^ 0x8000);
+      return Value::InitFromTupleStorage(&value, column_type, true);
+    }
+    case VALUE_TYPE_INTEGER:
+    case VALUE_TYPE_DATE: {
+      int32_t value = static_cast<int32_t>(bits ^ 0x80000000);
+      return Value::InitFromTupleStorage(&value, column_type, true);
+    }
+    case VALUE_TYPE_BIGINT:
+    case VALUE_TYPE_TIMESTAMP: {
+      int64_t value = static_cast<int64_t>(bits ^ 0x8000000000000000);
+      return Value::InitFromTupleStorage(&value, column_type, true);
+    }
+    case VALUE_TYPE_DOUBLE: {
+      double value;
+      if (bits == 0) {
+        value = DOUBLE_NULL;
+      } else if (bits == 1) {
+        value = std::numeric_limits<double>::quiet_NaN();
+      } else {
+        if (bits & 0x8000000000000000) {
+          bits ^= 0x8000000000000000;
+        } else {
+          bits = ~bits;
+        }
+        PL_MEMCPY(&value, &bits, sizeof(value));
+      }
+      return Value::InitFromTupleStorage(&value, column_type, true);
+    }
+    default:
+      throw IndexException("Cannot decode normalized key column of type " +
+                           ValueTypeToString(column_type));
+  }
+}
+
+Value GenericKeyTuple::GetValue(oid_t column_id) const {
+  if (normalized == false) {
+    return storage::Tuple(key_schema, GetData()).GetValue(column_id);
+  }
+
+  return KeyNormalizer::GetValue(key_schema, data, column_id);
+}
+
+}  // End index namespace
+}  // End peloton namespace
@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// normalized_key.h
+//
+// Identification: src/backend/index/normalized_key.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "backend/common/abstract_tuple.h"
+#include "backend/common/types.h"
+#include "backend/common/value.h"
+
+namespace peloton {
+
+namespace catalog {
+class Schema;
+}
+
+namespace storage {
+class Tuple;
+}
+
+namespace index {
+
+// Longest VARCHAR column that is stored inline in a normalized key; the
+// length byte must stay below the null bit of an inlined string
+#define NORMALIZED_KEY_MAX_VARCHAR_LENGTH 62
+
+//===--------------------------------------------------------------------===//
+// Key Normalizer
+//===--------------------------------------------------------------------===//
+
+/**
+ * Binary-comparable encoding of index keys.
+ *
+ * The normalized form of a key is a byte string whose memcmp order is the
+ * order of Value::Compare on its columns, so that indexes can compare and
+ * hash keys without constructing a Value per column.
+ *
+ * - Integers, dates and timestamps are stored big-endian with the sign bit
+ *   flipped. The NULL sentinel is the minimum of the type, so NULLs come
+ *   first just like in Value::Compare.
+ * - Doubles are stored big-endian with the sign bit flipped if positive and
+ *   all bits flipped if negative. NULL is all zero bytes and NaN is one,
+ *   ahead of every number.
+ * - VARCHARs take a NULL marker byte, the length byte and the characters
+ *   padded with zero bytes. Value::Compare orders strings by length first,
+ *   so a length byte up front takes the place of a terminator.
+ *
+ * Keys with any other column type or with longer VARCHARs are not
+ * normalized and keep the tuple format.
+ */
+class KeyNormalizer {
+ public:
+  // Length of the normalized form of keys with the given schema, or 0 if
+  // they cannot be normalized
+  static size_t GetNormalizedLength(const catalog::Schema *key_schema);
+
+  // Write the normalized form of a key-schema tuple
+  static void Normalize(const storage::Tuple *tuple, char *data);
+
+  // Get a column of a normalized key back. VARCHARs refer to the key bytes.
+  static Value GetValue(const catalog::Schema *key_schema, const char *data,
+                        oid_t column_id);
+
+ private:
+  static size_t GetColumnLength(const catalog::Schema *key_schema,
+                                oid_t column_id);
+};
+
+//===--------------------------------------------------------------------===//
+// Generic Key Tuple
+//===--------------------------------------------------------------------===//
+
+/**
+ * Read-only key-schema tuple over the bytes of a GenericKey, normalized or
+ * not, for evaluating scan predicates on index keys.
+ */
+class GenericKeyTuple : public AbstractTuple {
+ public:
+  GenericKeyTuple(const catalog::Schema *key_schema, const char *data,
+                  bool normalized)
+      : key_schema(key_schema), data(data), normalized(normalized) {}
+
+  Value GetValue(oid_t column_id) const;
+
+  char *GetData() const { return const_cast<char *>(data); }
+
+ private:
+  const catalog::Schema *key_schema;
+
+  const char *data;
+
+  bool normalized;
+};
+
+}  // End index namespace
+}  // End peloton namespace
@@ -0,0 +1,828 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// olc_btree.h
+//
+// Identification: src/backend/index/olc_btree.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include "backend/common/macros.h"
+#include "backend/common/platform.h"
+#include "backend/index/olc_latch.h"
+
+namespace peloton {
+namespace index {
+
+// Target size of a tree node in bytes
+#define OLC_BTREE_NODE_SIZE 4096
+
+//===--------------------------------------------------------------------===//
+// OLCBTree
+//===--------------------------------------------------------------------===//
+
+/**
+ * B+tree with optimistic lock coupling (Leis et al., DaMoN 2016).
+ *
+ * Every node carries a version latch. Lookups and scans read the nodes
+ * without writing to shared memory and restart if a version changed under
+ * them. Writers latch only the leaf they modify, plus the parent when the
+ * node has to be split. Full inner nodes are split on the way down, so a
+ * split never propagates more than one level up.
+ *
+ * The tree is a multimap: the values of a key are stored in insertion order
+ * and may span several leaves, which are chained left to right for scans.
+ * Nodes are never merged or freed before the tree itself, so an optimistic
+ * reader can always follow a pointer it read, even if it turns out to be
+ * stale. Keys are compared before the read is validated, so comparators
+ * must not rely on anything but the key bytes.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker,
+          typename ValueEqualityChecker = std::equal_to<ValueType>>
+class OLCBTree {
+  OLCBTree(const OLCBTree &) = delete;
+  OLCBTree &operator=(const OLCBTree &) = delete;
+
+ public:
+  OLCBTree(KeyComparator comparator, KeyEqualityChecker key_equals,
+           ValueEqualityChecker value_equals = ValueEqualityChecker());
+
+  ~OLCBTree();
+
+  // Add the <key, value> pair
+  void Insert(const KeyType &key, const ValueType &value);
+
+  // Build an empty tree bottom-up from pairs sorted on key, with full
+  // nodes. Must not run concurrently with other operations. Falls back to
+  // inserting the pairs if the tree is not empty.
+  void BulkLoad(const std::vector<std::pair<KeyType, ValueType>> &items);
+
+  // Add the <key, value> pair unless the predicate holds for a value that
+  // is already stored with the key. Return true if the pair was added.
+  bool ConditionalInsert(const KeyType &key, const ValueType &value,
+                         std::function<bool(const ValueType &)> predicate);
+
+  // Remove all copies of the <key, value> pair. Return true if any existed.
+  bool Delete(const KeyType &key, const ValueType &value);
+
+  // Append all values of the key
+  void GetValue(const KeyType &key, std::vector<ValueType> &result);
+
+  // Append all values of a batch of keys sorted in key order. A key that
+  // falls into the leaf of the previous key is looked up in that leaf
+  // without descending from the root again.
+  void GetValues(const std::vector<KeyType> &keys,
+                 std::vector<ValueType> &result);
+
+  // Visit the pairs with low <= key <= high in key order, until the visitor
+  // returns false. A null bound is unbounded.
+  void ScanRange(
+      const KeyType *low, const KeyType *high,
+      std::function<bool(const KeyType &, const ValueType &)> visitor);
+
+  size_t GetMemoryFootprint() const { return memory_footprint_.load(); }
+
+ private:
+  //===--------------------------------------------------------------------===//
+  // Nodes
+  //===--------------------------------------------------------------------===//
+
+  struct BaseNode {
+    BaseNode(bool is_leaf) : is_leaf(is_leaf), count(0) {}
+
+    OLCLatch latch;
+    const bool is_leaf;
+
+    // number of keys in the node
+    size_t count;
+  };
+
+  static const size_t INNER_CAPACITY =
+      (OLC_BTREE_NODE_SIZE - sizeof(BaseNode)) /
+                  (sizeof(KeyType) + sizeof(BaseNode *)) >
+              4
+          ? (OLC_BTREE_NODE_SIZE - sizeof(BaseNode)) /
+                (sizeof(KeyType) + sizeof(BaseNode *))
+          : 4;
+
+  static const size_t LEAF_CAPACITY =
+      (OLC_BTREE_NODE_SIZE - sizeof(BaseNode)) /
+                  (sizeof(KeyType) + sizeof(ValueType)) >
+              4
+          ? (OLC_BTREE_NODE_SIZE - sizeof(BaseNode)) /
+                (sizeof(KeyType) + sizeof(ValueType))
+          : 4;
+
+  // Child i holds the keys between separators i - 1 and i (both inclusive,
+  // as the values of a key may span several children)
+  struct InnerNode : public BaseNode {
+    InnerNode() : BaseNode(false) {}
+
+    KeyType keys[INNER_CAPACITY];
+    BaseNode *children[INNER_CAPACITY + 1];
+  };
+
+  struct LeafNode : public BaseNode {
+    LeafNode() : BaseNode(true), next(nullptr) {}
+
+    // right sibling
+    LeafNode *next;
+
+    KeyType keys[LEAF_CAPACITY];
+    ValueType values[LEAF_CAPACITY];
+  };
+
+  //===--------------------------------------------------------------------===//
+  // Helpers
+  //===--------------------------------------------------------------------===//
+
+  bool KeyLess(const KeyType &lhs, const KeyType &rhs) const {
+    return comparator_(lhs, rhs);
+  }
+
+  bool KeyEqual(const KeyType &lhs, const KeyType &rhs) const {
+    return key_equals_(lhs, rhs);
+  }
+
+  // Number of keys of a node that may be read concurrently with a writer
+  static size_t GetCount(const BaseNode *node, size_t capacity) {
+    return std::min(node->count, capacity);
+  }
+
+  // Position of the first key not less than the given key
+  size_t LowerBound(const KeyType *keys, size_t count,
+                    const KeyType &key) const;
+
+  // Position of the first key greater than the given key
+  size_t UpperBound(const KeyType *keys, size_t count,
+                    const KeyType &key) const;
+
+  // Find the leftmost leaf that may hold the key, or the leftmost leaf if
+  // there is no key. Returns the leaf with the version it was read at.
+  LeafNode *FindLeaf(const KeyType *key, uint64_t &leaf_version);
+
+  // Find the leaf the key has to be inserted into and write lock it.
+  // Splits the full nodes on the way.
+  LeafNode *FindLeafForInsert(const KeyType &key);
+
+  // Split a locked full node in two halves
+  InnerNode *SplitInner(InnerNode *inner, KeyType &separator);
+
+  LeafNode *SplitLeaf(LeafNode *leaf, KeyType &separator);
+
+  // Add a separator and its right child to a locked inner node
+  void InsertIntoInner(InnerNode *inner, size_t position,
+                       const KeyType &separator, BaseNode *right);
+
+  // Grow the tree by one level above the locked root
+  void GrowRoot(BaseNode *left, const KeyType &separator, BaseNode *right);
+
+  void InsertIntoLeaf(LeafNode *leaf, const KeyType &key,
+                      const ValueType &value);
+
+  // Append the values of the key found in a leaf and its right siblings
+  void CollectValues(LeafNode *leaf, uint64_t leaf_version,
+                     const KeyType &key, std::vector<ValueType> &result);
+
+  void FreeNode(BaseNode *node);
+
+  //===--------------------------------------------------------------------===//
+  // Data members
+  //===--------------------------------------------------------------------===//
+
+  std::atomic<BaseNode *> root_;
+
+  KeyComparator comparator_;
+  KeyEqualityChecker key_equals_;
+  ValueEqualityChecker value_equals_;
+
+  std::atomic<size_t> memory_footprint_;
+};
+
+//===--------------------------------------------------------------------===//
+// Implementation
+//===--------------------------------------------------------------------===//
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+         ValueEqualityChecker>::OLCBTree(KeyComparator comparator,
+                                         KeyEqualityChecker key_equals,
+                                         ValueEqualityChecker value_equals)
+    : root_(nullptr),
+      comparator_(comparator),
+      key_equals_(key_equals),
+      value_equals_(value_equals),
+      memory_footprint_(sizeof(LeafNode)) {
+  root_.store(new LeafNode());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+         ValueEqualityChecker>::~OLCBTree() {
+  FreeNode(root_.load());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::FreeNode(BaseNode *node) {
+  if (node->is_leaf) {
+    delete static_cast<LeafNode *>(node);
+    return;
+  }
+
+  InnerNode *inner = static_cast<InnerNode *>(node);
+  for (size_t child_itr = 0; child_itr <= inner->count; child_itr++) {
+    FreeNode(inner->children[child_itr]);
+  }
+  delete inner;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+size_t OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+                ValueEqualityChecker>::LowerBound(const KeyType *keys,
+                                                  size_t count,
+                                                  const KeyType &key) const {
+  size_t low = 0;
+  size_t high = count;
+
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (KeyLess(keys[mid], key)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+size_t OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+                ValueEqualityChecker>::UpperBound(const KeyType *keys,
+                                                  size_t count,
+                                                  const KeyType &key) const {
+  size_t low = 0;
+  size_t high = count;
+
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (KeyLess(key, keys[mid])) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+
+  return low;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+typename OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+                  ValueEqualityChecker>::LeafNode *
+OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+         ValueEqualityChecker>::FindLeaf(const KeyType *key,
+                                         uint64_t &leaf_version) {
+  while (true) {
+    BaseNode *node = root_.load();
+    uint64_t node_version = node->latch.ReadLock();
+    if (node != root_.load()) {
+      continue;
+    }
+
+    bool restart = false;
+    while (node->is_leaf == false) {
+      InnerNode *inner = static_cast<InnerNode *>(node);
+      size_t count = GetCount(inner, INNER_CAPACITY);
+      size_t position = (key == nullptr)
+                            ? 0
+                            : LowerBound(inner->keys, count, *key);
+      BaseNode *child = inner->children[position];
+
+      if (inner->latch.Validate(node_version) == false) {
+        restart = true;
+        break;
+      }
+
+      node = child;
+      node_version = node->latch.ReadLock();
+    }
+
+    if (restart == false) {
+      leaf_version = node_version;
+      return static_cast<LeafNode *>(node);
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+typename OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+                  ValueEqualityChecker>::LeafNode *
+OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+         ValueEqualityChecker>::FindLeafForInsert(const KeyType &key) {
+restart:
+  BaseNode *node = root_.load();
+  uint64_t node_version = node->latch.ReadLock();
+  if (node != root_.load()) {
+    goto restart;
+  }
+
+  InnerNode *parent = nullptr;
+  uint64_t parent_version = 0;
+  size_t position = 0;
+
+  while (true) {
+    size_t capacity = INNER_CAPACITY;
+    if (node->is_leaf) {
+      capacity = LEAF_CAPACITY;
+    }
+
+    // Split full nodes first, so that the parent always has room
+    if (node->count == capacity) {
+      if (parent != nullptr && parent->latch.Upgrade(parent_version) == false) {
+        goto restart;
+      }
+      if (node->latch.Upgrade(node_version) == false) {
+        if (parent != nullptr) {
+          parent->latch.WriteUnlock();
+        }
+        goto restart;
+      }
+      if (parent == nullptr && node != root_.load()) {
+        node->latch.WriteUnlock();
+        goto restart;
+      }
+
+      KeyType separator;
+      BaseNode *right;
+      if (node->is_leaf) {
+        right = SplitLeaf(static_cast<LeafNode *>(node), separator);
+      } else {
+        right = SplitInner(static_cast<InnerNode *>(node), separator);
+      }
+
+      if (parent != nullptr) {
+        InsertIntoInner(parent, position, separator, right);
+      } else {
+        GrowRoot(node, separator, right);
+      }
+
+      node->latch.WriteUnlock();
+      if (parent != nullptr) {
+        parent->latch.WriteUnlock();
+      }
+      goto restart;
+    }
+
+    if (node->is_leaf) {
+      break;
+    }
+
+    // The parent is no longer needed
+    if (parent != nullptr && parent->latch.Validate(parent_version) == false) {
+      goto restart;
+    }
+
+    InnerNode *inner = static_cast<InnerNode *>(node);
+    position = LowerBound(inner->keys, GetCount(inner, INNER_CAPACITY), key);
+    BaseNode *child = inner->children[position];
+
+    if (inner->latch.Validate(node_version) == false) {
+      goto restart;
+    }
+
+    parent = inner;
+    parent_version = node_version;
+    node = child;
+    node_version = node->latch.ReadLock();
+  }
+
+  // Lock the leaf, and make sure it is still the one the parent points to
+  if (node->latch.Upgrade(node_version) == false) {
+    goto restart;
+  }
+  if (parent != nullptr && parent->latch.Validate(parent_version) == false) {
+    node->latch.WriteUnlock();
+    goto restart;
+  }
+  if (parent == nullptr && node != root_.load()) {
+    node->latch.WriteUnlock();
+    goto restart;
+  }
+
+  return static_cast<LeafNode *>(node);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+typename OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+                  ValueEqualityChecker>::InnerNode *
+OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+         ValueEqualityChecker>::SplitInner(InnerNode *inner,
+                                           KeyType &separator) {
+  InnerNode *right = new InnerNode();
+  memory_footprint_ += sizeof(InnerNode);
+
+  // The middle key moves up
+  size_t mid = inner->count / 2;
+  separator = inner->keys[mid];
+
+  right->count = inner->count - mid - 1;
+  std::copy(inner->keys + mid + 1, inner->keys + inner->count, right->keys);
+  std::copy(inner->children + mid + 1, inner->children + inner->count + 1,
+            right->children);
+  inner->count = mid;
+
+  return right;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+typename OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+                  ValueEqualityChecker>::LeafNode *
+OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+         ValueEqualityChecker>::SplitLeaf(LeafNode *leaf, KeyType &separator) {
+  LeafNode *right = new LeafNode();
+  memory_footprint_ += sizeof(LeafNode);
+
+  // The largest key of the left half separates the halves
+  size_t mid = leaf->count / 2;
+  separator = leaf->keys[mid - 1];
+
+  right->count = leaf->count - mid;
+  std::copy(leaf->keys + mid, leaf->keys + leaf->count, right->keys);
+  std::copy(leaf->values + mid, leaf->values + leaf->count, right->values);
+  right->next = leaf->next;
+
+  leaf->next = right;
+  leaf->count = mid;
+
+  return right;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::InsertIntoInner(InnerNode *inner,
+                                                     size_t position,
+                                                     const KeyType &separator,
+                                                     BaseNode *right) {
+  PL_ASSERT(inner->count < INNER_CAPACITY);
+
+  std::copy_backward(inner->keys + position, inner->keys + inner->count,
+                     inner->keys + inner->count + 1);
+  std::copy_backward(inner->children + position + 1,
+                     inner->children + inner->count + 1,
+                     inner->children + inner->count + 2);
+  inner->keys[position] = separator;
+  inner->children[position + 1] = right;
+  inner->count++;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::GrowRoot(BaseNode *left,
+                                              const KeyType &separator,
+                                              BaseNode *right) {
+  InnerNode *root = new InnerNode();
+  memory_footprint_ += sizeof(InnerNode);
+
+  root->count = 1;
+  root->keys[0] = separator;
+  root->children[0] = left;
+  root->children[1] = right;
+
+  root_.store(root);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::InsertIntoLeaf(LeafNode *leaf,
+                                                    const KeyType &key,
+                                                    const ValueType &value) {
+  PL_ASSERT(leaf->count < LEAF_CAPACITY);
+
+  // Append after the existing values of the key
+  size_t position = UpperBound(leaf->keys, leaf->count, key);
+
+  std::copy_backward(leaf->keys + position, leaf->keys + leaf->count,
+                     leaf->keys + leaf->count + 1);
+  std::copy_backward(leaf->values + position, leaf->values + leaf->count,
+                     leaf->values + leaf->count + 1);
+  leaf->keys[position] = key;
+  leaf->values[position] = value;
+  leaf->count++;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::Insert(const KeyType &key,
+                                            const ValueType &value) {
+  LeafNode *leaf = FindLeafForInsert(key);
+
+  InsertIntoLeaf(leaf, key, value);
+
+  leaf->latch.WriteUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::
+    BulkLoad(const std::vector<std::pair<KeyType, ValueType>> &items) {
+  BaseNode *root = root_.load();
+  if (root->is_leaf == false || root->count > 0) {
+    for (auto &item : items) {
+      Insert(item.first, item.second);
+    }
+    return;
+  }
+
+  // Full leaves, starting with the empty root. Each node is paired with its
+  // last key, which separates it from its right sibling in the parent.
+  std::vector<std::pair<BaseNode *, KeyType>> level;
+  LeafNode *leaf = static_cast<LeafNode *>(root);
+  for (size_t item_itr = 0; item_itr < items.size(); item_itr++) {
+    if (leaf->count == LEAF_CAPACITY) {
+      level.push_back(std::make_pair(leaf, leaf->keys[leaf->count - 1]));
+      leaf->next = new LeafNode();
+      memory_footprint_ += sizeof(LeafNode);
+      leaf = leaf->next;
+    }
+
+    leaf->keys[leaf->count] = items[item_itr].first;
+    leaf->values[leaf->count] = items[item_itr].second;
+    leaf->count++;
+  }
+
+  if (level.empty()) {
+    return;
+  }
+  level.push_back(std::make_pair(leaf, leaf->keys[leaf->count - 1]));
+
+  // Full inner nodes up to a single root
+  while (level.size() > 1) {
+    std::vector<std::pair<BaseNode *, KeyType>> parents;
+    for (size_t child_itr = 0; child_itr < level.size();
+         child_itr += INNER_CAPACITY + 1) {
+      size_t child_end =
+          std::min(child_itr + INNER_CAPACITY + 1, level.size());
+
+      InnerNode *inner = new InnerNode();
+      memory_footprint_ += sizeof(InnerNode);
+      for (size_t position = 0; child_itr + position < child_end;
+           position++) {
+        inner->children[position] = level[child_itr + position].first;
+        if (child_itr + position + 1 < child_end) {
+          inner->keys[position] = level[child_itr + position].second;
+        }
+      }
+      inner->count = child_end - child_itr - 1;
+
+      parents.push_back(std::make_pair(inner, level[child_end - 1].second));
+    }
+
+    level.swap(parents);
+  }
+
+  root_.store(level.front().first);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+bool OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::
+    ConditionalInsert(const KeyType &key, const ValueType &value,
+                      std::function<bool(const ValueType &)> predicate) {
+  // Every insert of the key goes through this leaf, so holding its latch
+  // keeps the values of the key from growing while they are checked
+  LeafNode *leaf = FindLeafForInsert(key);
+
+  std::vector<ValueType> existing_values;
+  size_t position = LowerBound(leaf->keys, leaf->count, key);
+  for (; position < leaf->count && KeyEqual(leaf->keys[position], key);
+       position++) {
+    existing_values.push_back(leaf->values[position]);
+  }
+
+  // The values of the key may continue in the right siblings
+  LeafNode *next = leaf->next;
+  if (position == leaf->count && next != nullptr) {
+    CollectValues(next, next->latch.ReadLock(), key, existing_values);
+  }
+
+  for (auto &existing_value : existing_values) {
+    if (predicate(existing_value)) {
+      leaf->latch.WriteUnlock();
+      return false;
+    }
+  }
+
+  InsertIntoLeaf(leaf, key, value);
+
+  leaf->latch.WriteUnlock();
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+bool OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::Delete(const KeyType &key,
+                                            const ValueType &value) {
+  uint64_t leaf_version;
+  LeafNode *leaf = FindLeaf(&key, leaf_version);
+
+  // A stale leaf is to the left of the key, so it is only a detour
+  while (leaf->latch.Upgrade(leaf_version) == false) {
+    leaf_version = leaf->latch.ReadLock();
+  }
+
+  bool deleted = false;
+  while (true) {
+    size_t position = LowerBound(leaf->keys, leaf->count, key);
+    size_t write_position = position;
+
+    for (; position < leaf->count && KeyEqual(leaf->keys[position], key);
+         position++) {
+      if (value_equals_(leaf->values[position], value)) {
+        deleted = true;
+        continue;
+      }
+      leaf->keys[write_position] = leaf->keys[position];
+      leaf->values[write_position] = leaf->values[position];
+      write_position++;
+    }
+
+    bool last_leaf = (position < leaf->count || leaf->next == nullptr);
+
+    if (write_position != position) {
+      std::copy(leaf->keys + position, leaf->keys + leaf->count,
+                leaf->keys + write_position);
+      std::copy(leaf->values + position, leaf->values + leaf->count,
+                leaf->values + write_position);
+      leaf->count -= position - write_position;
+    }
+
+    if (last_leaf) {
+      leaf->latch.WriteUnlock();
+      return deleted;
+    }
+
+    // Couple the latches, so that no split can move pairs behind us
+    LeafNode *next = leaf->next;
+    next->latch.WriteLock();
+    leaf->latch.WriteUnlock();
+    leaf = next;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::CollectValues(LeafNode *leaf,
+                                                   uint64_t leaf_version,
+                                                   const KeyType &key,
+                                                   std::vector<ValueType> &
+                                                       result) {
+  std::vector<ValueType> leaf_values;
+
+  while (leaf != nullptr) {
+    leaf_values.clear();
+
+    size_t count = GetCount(leaf, LEAF_CAPACITY);
+    size_t position = LowerBound(leaf->keys, count, key);
+    for (; position < count && KeyEqual(leaf->keys[position], key);
+         position++) {
+      leaf_values.push_back(leaf->values[position]);
+    }
+    LeafNode *next = (position == count) ? leaf->next : nullptr;
+
+    if (leaf->latch.Validate(leaf_version) == false) {
+      leaf_version = leaf->latch.ReadLock();
+      continue;
+    }
+
+    result.insert(result.end(), leaf_values.begin(), leaf_values.end());
+
+    leaf = next;
+    if (leaf != nullptr) {
+      leaf_version = leaf->latch.ReadLock();
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::GetValue(const KeyType &key,
+                                              std::vector<ValueType> &result) {
+  uint64_t leaf_version;
+  LeafNode *leaf = FindLeaf(&key, leaf_version);
+
+  CollectValues(leaf, leaf_version, key, result);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::GetValues(const std::vector<KeyType> &keys,
+                                               std::vector<ValueType> &result) {
+  LeafNode *leaf = nullptr;
+  uint64_t leaf_version = 0;
+
+  for (const auto &key : keys) {
+    // The previous key is smaller, so the leaf is still the leftmost one
+    // that may hold this key as long as the key is not past its last key
+    bool same_leaf = false;
+    if (leaf != nullptr) {
+      size_t count = GetCount(leaf, LEAF_CAPACITY);
+      same_leaf = count > 0 && !KeyLess(leaf->keys[count - 1], key);
+      if (leaf->latch.Validate(leaf_version) == false) {
+        same_leaf = false;
+      }
+    }
+
+    if (same_leaf == false) {
+      leaf = FindLeaf(&key, leaf_version);
+    }
+
+    // The following keys are likely to be found in the right sibling
+    __builtin_prefetch(leaf->next);
+
+    CollectValues(leaf, leaf_version, key, result);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker, typename ValueEqualityChecker>
+void OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker,
+              ValueEqualityChecker>::
+    ScanRange(const KeyType *low, const KeyType *high,
+              std::function<bool(const KeyType &, const ValueType &)> visitor) {
+  uint64_t leaf_version;
+  LeafNode *leaf = FindLeaf(low, leaf_version);
+
+  std::vector<std::pair<KeyType, ValueType>> leaf_items;
+  bool first_leaf = true;
+
+  while (leaf != nullptr) {
+    leaf_items.clear();
+
+    size_t count = GetCount(leaf, LEAF_CAPACITY);
+    size_t position = (first_leaf && low != nullptr)
+                          ? LowerBound(leaf->keys, count, *low)
+                          : 0;
+    bool reached_high = false;
+    for (; position < count; position++) {
+      if (high != nullptr && KeyLess(*high, leaf->keys[position])) {
+        reached_high = true;
+        break;
+      }
+      leaf_items.emplace_back(leaf->keys[position], leaf->values[position]);
+    }
+    LeafNode *next = reached_high ? nullptr : leaf->next;
+
+    if (leaf->latch.Validate(leaf_version) == false) {
+      leaf_version = leaf->latch.ReadLock();
+      continue;
+    }
+
+    // Only hand out what was read consistently
+    for (auto &item : leaf_items) {
+      if (visitor(item.first, item.second) == false) {
+        return;
+      }
+    }
+
+    first_leaf = false;
+    leaf = next;
+    if (leaf != nullptr) {
+      leaf_version = leaf->latch.ReadLock();
+    }
+  }
+}
+
+}  // End index namespace
+}  // End peloton namespace
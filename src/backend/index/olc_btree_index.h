@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// olc_btree_index.h
+//
+// Identification: src/backend/index/olc_btree_index.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <map>
+
+#include "backend/catalog/manager.h"
+#include "backend/common/platform.h"
+#include "backend/common/types.h"
+#include "backend/index/index.h"
+#include "backend/index/item_pointer_pool.h"
+#include "backend/index/index_scan_cursor.h"
+
+#include "backend/index/olc_btree.h"
+
+namespace peloton {
+namespace index {
+
+/**
+ * Optimistic lock coupling B+tree-based index implementation.
+ *
+ * Unlike BTreeIndex there is no index-wide lock: lookups and scans do not
+ * write to shared memory, and writers only latch the nodes they modify.
+ *
+ * @see Index
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator,
+          typename KeyEqualityChecker>
+class OLCBTreeIndex : public Index {
+  friend class IndexFactory;
+
+  typedef OLCBTree<KeyType, ValueType, KeyComparator, KeyEqualityChecker>
+      MapType;
+
+ public:
+  OLCBTreeIndex(IndexMetadata *metadata);
+
+  ~OLCBTreeIndex();
+
+  bool InsertEntry(const storage::Tuple *key, const ItemPointer &location);
+
+  bool DeleteEntry(const storage::Tuple *key, const ItemPointer &location);
+
+  bool CondInsertEntry(const storage::Tuple *key, const ItemPointer &location,
+                       std::function<bool(const ItemPointer &)> predicate);
+
+  void BulkLoad(const std::vector<const storage::Tuple *> &keys,
+                const std::vector<ItemPointer> &locations);
+
+  void Scan(const std::vector<Value> &values,
+            const std::vector<oid_t> &key_column_ids,
+            const std::vector<ExpressionType> &expr_types,
+            const ScanDirectionType &scan_direction,
+            std::vector<ItemPointer> &);
+
+  void ScanAllKeys(std::vector<ItemPointer> &);
+
+  void ScanKey(const storage::Tuple *key, std::vector<ItemPointer> &);
+
+  void Scan(const std::vector<Value> &values,
+            const std::vector<oid_t> &key_column_ids,
+            const std::vector<ExpressionType> &exprs,
+            const ScanDirectionType &scan_direction,
+            std::vector<ItemPointer *> &result);
+
+  void ScanAllKeys(std::vector<ItemPointer *> &result);
+
+  void ScanKey(const storage::Tuple *key,
+               std::vector<ItemPointer *> &result);
+
+  void ScanKeys(const std::vector<const storage::Tuple *> &keys,
+                std::vector<ItemPointer *> &result);
+
+  std::unique_ptr<IndexScanCursor> OpenScan(
+      const std::vector<Value> &values,
+      const std::vector<oid_t> &key_column_ids,
+      const std::vector<ExpressionType> &expr_types,
+      const ScanDirectionType &scan_direction);
+
+  std::string GetTypeName() const;
+
+  bool Cleanup() { return true; }
+
+  size_t GetMemoryFootprint() {
+    return container.GetMemoryFootprint() +
+           item_pointer_pool->GetMemoryFootprint();
+  }
+
+ protected:
+  // Visit the locations matching the predicate in key order, starting
+  // after the resume key if there is one, until the visitor returns false.
+  // Returns false if the visitor stopped the scan.
+  bool ScanHelper(const std::vector<Value> &values,
+                  const std::vector<oid_t> &key_column_ids,
+                  const std::vector<ExpressionType> &expr_types,
+                  const ScanDirectionType &scan_direction,
+                  const KeyType *resume_key,
+                  std::function<bool(const KeyType &, ItemPointer *)> visitor);
+
+  // container
+  MapType container;
+
+  // equality checker and comparator
+  KeyEqualityChecker equals;
+  KeyComparator comparator;
+};
+
+}  // End index namespace
+}  // End peloton namespace
\ No newline at end of file
@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// olc_latch.h
+//
+// Identification: src/backend/index/olc_latch.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+
+#include "backend/common/platform.h"
+
+namespace peloton {
+namespace index {
+
+//===--------------------------------------------------------------------===//
+// Optimistic Latch
+//===--------------------------------------------------------------------===//
+
+/**
+ * Version latch of a tree node.
+ *
+ * Writers lock the node by setting the lock bit of the version and unlock it
+ * by bumping the version. Readers never write to the latch: they remember the
+ * version before reading the node and check that it is unchanged afterwards.
+ *
+ * A node that was replaced by another one is unlocked as obsolete. Its
+ * version never changes again, so readers have to check for the obsolete
+ * bit themselves and restart from a node that is still linked.
+ */
+class OLCLatch {
+ public:
+  OLCLatch() : version(0) {}
+
+  // Wait until the node is not locked and return its version
+  uint64_t ReadLock() const {
+    uint64_t current_version = version.load();
+    while (IsLocked(current_version)) {
+      _mm_pause();
+      current_version = version.load();
+    }
+    return current_version;
+  }
+
+  // Return false if the node changed since the version was read
+  bool Validate(uint64_t read_version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version.load() == read_version;
+  }
+
+  // Lock the node if it did not change since the version was read
+  bool Upgrade(uint64_t read_version) {
+    if (IsObsolete(read_version)) {
+      return false;
+    }
+    return version.compare_exchange_strong(read_version,
+                                           read_version + LOCKED_BIT);
+  }
+
+  void WriteLock() {
+    while (Upgrade(ReadLock()) == false)
+      ;
+  }
+
+  void WriteUnlock() { version.fetch_add(VERSION_STEP - LOCKED_BIT); }
+
+  // Unlock a node that is no longer reachable from the tree
+  void WriteUnlockObsolete() {
+    version.fetch_add(VERSION_STEP - LOCKED_BIT + OBSOLETE_BIT);
+  }
+
+  static bool IsObsolete(uint64_t version) {
+    return (version & OBSOLETE_BIT) == OBSOLETE_BIT;
+  }
+
+ private:
+  static const uint64_t LOCKED_BIT = 1;
+  static const uint64_t OBSOLETE_BIT = 2;
+  static const uint64_t VERSION_STEP = 4;
+
+  static bool IsLocked(uint64_t version) {
+    return (version & LOCKED_BIT) == LOCKED_BIT;
+  }
+
+  std::atomic<uint64_t> version;
+};
+
+}  // End index namespace
+}  // End peloton namespace
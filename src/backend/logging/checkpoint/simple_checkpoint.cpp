@@ -233,6 +233,12 @@ void SimpleCheckpoint::Scan(storage::DataTable *target_table,
     // Retrieve a tile group
     auto tile_group = target_table->GetTileGroup(current_tile_group_offset);
 
+    // the tile group was compacted
+    if (tile_group == nullptr) {
+      current_tile_group_offset++;
+      continue;
+    }
+
     // Retrieve a logical tile
     std::unique_ptr<executor::LogicalTile> logical_tile(
         scanner.Scan(tile_group, column_ids, start_commit_id_));
@@ -42,7 +42,7 @@ std::unique_ptr<executor::LogicalTile> CheckpointTileScanner::Scan(
   // Construct logical tile.
   std::unique_ptr<executor::LogicalTile> logical_tile(
       executor::LogicalTileFactory::GetTile());
-  logical_tile->AddColumns(tile_group, column_ids);
+  logical_tile->AddColumns(tile_group.get(), column_ids);
   logical_tile->AddPositionList(std::move(position_list));
 
   return std::move(logical_tile);
@@ -39,6 +39,7 @@
 #include "backend/storage/tuple.h"
 #include "backend/common/logger.h"
 #include "backend/index/index.h"
+#include "backend/index/index_builder.h"
 #include "backend/executor/executor_context.h"
 #include "backend/planner/seq_scan_plan.h"
 #include "backend/bridge/dml/mapper/mapper.h"
@@ -412,80 +413,24 @@ void WriteAheadFrontendLogger::RecoverIndex() {
 
 bool WriteAheadFrontendLogger::RecoverTableIndexHelper(
     storage::DataTable *target_table, cid_t start_cid) {
-  auto schema = target_table->GetSchema();
-  PL_ASSERT(schema);
-  std::vector<oid_t> column_ids;
-  column_ids.resize(schema->GetColumnCount());
-  std::iota(column_ids.begin(), column_ids.end(), 0);
-
-  oid_t current_tile_group_offset = START_OID;
-  auto table_tile_group_count = target_table->GetTileGroupCount();
-  CheckpointTileScanner scanner;
-
-  while (current_tile_group_offset < table_tile_group_count) {
-    // Retrieve a tile group
-    auto tile_group = target_table->GetTileGroup(current_tile_group_offset);
-
-    // Retrieve a logical tile
-    std::unique_ptr<executor::LogicalTile> logical_tile(
-        scanner.Scan(tile_group, column_ids, start_cid));
-
-    // Empty result
-    if (!logical_tile) {
-      current_tile_group_offset++;
-      continue;
-    }
+  std::vector<index::Index *> indexes;
+  for (oid_t index_itr = 0; index_itr < target_table->GetIndexCount();
+       index_itr++) {
+    indexes.push_back(target_table->GetIndex(index_itr));
+  }
 
-    auto tile_group_id = logical_tile->GetColumnInfo(0)
-                             .base_tile->GetTileGroup()
-                             ->GetTileGroupId();
-    LOG_TRACE("Retrieved tile group %u", tile_group_id);
-
-    // Go over the logical tile
-    for (oid_t tuple_id : *logical_tile) {
-      expression::ContainerTuple<executor::LogicalTile> cur_tuple(
-          logical_tile.get(), tuple_id);
-
-      // Index update
-      {
-        // construct a physical tuple from the logical tuple
-        std::unique_ptr<storage::Tuple> tuple(new storage::Tuple(schema, true));
-        for (auto column_id : column_ids) {
-          tuple->SetValue(column_id, cur_tuple.GetValue(column_id),
-                          recovery_pool);
-        }
+  // Rebuild all indexes of the table from one parallel scan
+  CheckpointTileScanner scanner;
+  index::IndexBuilder::Build(
+      target_table, indexes,
+      [&scanner, start_cid](const storage::TileGroupHeader *tile_group_header,
+                            oid_t tuple_id) {
+        return scanner.IsVisible(tile_group_header, tuple_id, start_cid);
+      });
 
-        ItemPointer location(tile_group_id, tuple_id);
-        InsertIndexEntry(tuple.get(), target_table, location);
-      }
-    }
-    current_tile_group_offset++;
-  }
   return true;
 }
 
-void WriteAheadFrontendLogger::InsertIndexEntry(storage::Tuple *tuple,
-                                                storage::DataTable *table,
-                                                ItemPointer target_location) {
-  PL_ASSERT(tuple);
-  PL_ASSERT(table);
-  auto index_count = table->GetIndexCount();
-  LOG_TRACE("Insert tuple (%u, %u) into %u indexes", target_location.block,
-            target_location.offset, index_count);
-
-  for (int index_itr = index_count - 1; index_itr >= 0; --index_itr) {
-    auto index = table->GetIndex(index_itr);
-    auto index_schema = index->GetKeySchema();
-    auto indexed_columns = index_schema->GetIndexedColumns();
-    std::unique_ptr<storage::Tuple> key(new storage::Tuple(index_schema, true));
-    key->SetFromTuple(tuple, indexed_columns, index->GetPool());
-
-    index->InsertEntry(key.get(), target_location);
-    // Increase the indexes' number of tuples by 1 as well
-    index->IncreaseNumberOfTuplesBy(1);
-  }
-}
-
 /**
  * @brief Add new txn to recovery table
  */
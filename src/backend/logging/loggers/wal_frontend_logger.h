@@ -111,9 +111,6 @@ class WriteAheadFrontendLogger : public FrontendLogger {
   bool RecoverTableIndexHelper(storage::DataTable *target_table,
                                cid_t start_cid);
 
-  void InsertIndexEntry(storage::Tuple *tuple, storage::DataTable *table,
-                        ItemPointer target_location);
-
   //===--------------------------------------------------------------------===//
   // Member Variables
   //===--------------------------------------------------------------------===//
@@ -62,6 +62,10 @@ DataTable::DataTable(catalog::Schema *schema, const std::string &table_name,
     default_partition_[col_itr] = std::make_pair(0, col_itr);
   }
 
+  for (auto &segment : tile_group_segments_) {
+    segment = nullptr;
+  }
+
   // Create a tile group.
   AddDefaultTileGroup();
 }
@@ -71,13 +75,19 @@ DataTable::~DataTable() {
   oid_t tile_group_count = GetTileGroupCount();
   for (oid_t tile_group_itr = 0; tile_group_itr < tile_group_count;
        tile_group_itr++) {
-    tile_group_lock_.ReadLock();
-    auto tile_group_id = tile_groups_.at(tile_group_itr);
-    tile_group_lock_.Unlock();
+    auto tile_group_id =
+        GetTileGroupSlot(tile_group_itr)->tile_group_id.load();
+    if (tile_group_id == INVALID_OID) {
+      continue;
+    }
 
     catalog::Manager::GetInstance().DropTileGroup(tile_group_id);
   }
 
+  for (auto &segment : tile_group_segments_) {
+    delete[] segment.load();
+  }
+
   // clean up indices
   for (auto index : indexes_) {
     delete index;
@@ -139,20 +149,33 @@ ItemPointer DataTable::GetEmptyTupleSlot(const storage::Tuple *tuple,
   //=============== garbage collection==================
   // check if there are recycled tuple slots
   auto &gc_manager = gc::GCManagerFactory::GetInstance();
-  auto free_item_pointer = gc_manager.ReturnFreeSlot(this->table_oid);
-  if (free_item_pointer.IsNull() == false) {
+  while (true) {
+    auto free_item_pointer = gc_manager.ReturnFreeSlot(this->table_oid);
+    if (free_item_pointer.IsNull() == true) {
+      break;
+    }
+    // the slot may be left over by a dropped table with the same oid
+    auto tile_group =
+        catalog::Manager::GetInstance().GetTileGroup(free_item_pointer.block);
+    if (tile_group == nullptr || tile_group->GetAbstractTable() != this) {
+      continue;
+    }
+    tile_group->CopyTuple(tuple, free_item_pointer.offset);
     return free_item_pointer;
   }
   //====================================================
 
-  std::shared_ptr<storage::TileGroup> tile_group;
+  storage::TileGroup *tile_group = nullptr;
   oid_t tuple_slot = INVALID_OID;
   oid_t tile_group_id = INVALID_OID;
 
   // get valid tuple.
   while (true) {
     // get the last tile group.
-    tile_group = GetTileGroup(tile_group_count_ - 1);
+    tile_group = GetTileGroupPointer(tile_group_count_ - 1);
+    if (tile_group == nullptr) {
+      continue;
+    }
 
     tuple_slot = tile_group->InsertTuple(tuple);
 
@@ -169,7 +192,7 @@ ItemPointer DataTable::GetEmptyTupleSlot(const storage::Tuple *tuple,
   }
 
   LOG_TRACE("tile group count: %lu, tile group id: %u, address: %p",
-            tile_group_count_.load(), tile_group->GetTileGroupId(), tile_group.get());
+            tile_group_count_.load(), tile_group->GetTileGroupId(), tile_group);
 
   // Set tuple location
   ItemPointer location(tile_group_id, tuple_slot);
@@ -546,24 +569,7 @@ oid_t DataTable::AddDefaultTileGroup() {
   tile_group_id = tile_group->GetTileGroupId();
 
   LOG_TRACE("Trying to add a tile group ");
-  {
-    LOG_TRACE("Added a tile group ");
-
-    tile_group_lock_.WriteLock();
-    tile_groups_.push_back(tile_group_id);
-    tile_group_lock_.Unlock();
-
-    // add tile group metadata in locator
-    catalog::Manager::GetInstance().AddTileGroup(tile_group_id, tile_group);
-
-    // we must guarantee that the compiler always add tile group before adding
-    // tile_group_count_.
-    COMPILER_MEMORY_FENCE;
-
-    tile_group_count_++;
-
-    LOG_TRACE("Recording tile group : %u ", tile_group_id);
-  }
+  AppendTileGroup(tile_group);
 
   return tile_group_id;
 }
@@ -586,58 +592,118 @@ void DataTable::AddTileGroupWithOidForRecovery(const oid_t &tile_group_id) {
       tuples_per_tilegroup_));
 
   tile_group_lock_.WriteLock();
-  if (std::find(tile_groups_.begin(), tile_groups_.end(),
-                tile_group->GetTileGroupId()) == tile_groups_.end()) {
-    tile_groups_.push_back(tile_group->GetTileGroupId());
-
-    LOG_TRACE("Added a tile group ");
-
-    // add tile group metadata in locator
-    catalog::Manager::GetInstance().AddTileGroup(tile_group_id, tile_group);
-
-    // we must guarantee that the compiler always add tile group before adding
-    // tile_group_count_.
-    COMPILER_MEMORY_FENCE;
-
-    tile_group_count_++;
-
-    LOG_TRACE("Recording tile group : %u ", tile_group_id);
+  bool is_added = false;
+  oid_t tile_group_count = GetTileGroupCount();
+  for (oid_t tile_group_itr = 0; tile_group_itr < tile_group_count;
+       tile_group_itr++) {
+    if (GetTileGroupSlot(tile_group_itr)->tile_group_id == tile_group_id) {
+      is_added = true;
+      break;
+    }
+  }
+  if (is_added == false) {
+    AppendTileGroup(tile_group);
   }
   tile_group_lock_.Unlock();
 }
 
 void DataTable::AddTileGroup(const std::shared_ptr<TileGroup> &tile_group) {
-  oid_t tile_group_id = tile_group->GetTileGroupId();
+  AppendTileGroup(tile_group);
+}
 
-  tile_group_lock_.WriteLock();
-  tile_groups_.push_back(tile_group_id);
-  tile_group_lock_.Unlock();
+void DataTable::AppendTileGroup(const std::shared_ptr<TileGroup> &tile_group) {
+  oid_t tile_group_id = tile_group->GetTileGroupId();
 
-  // add tile group in catalog
+  // add tile group in catalog, the catalog reference keeps it alive
   catalog::Manager::GetInstance().AddTileGroup(tile_group_id, tile_group);
 
-  // we must guarantee that the compiler always add tile group before adding
-  // tile_group_count_.
-  COMPILER_MEMORY_FENCE;
-
-  tile_group_count_++;
+  size_t tile_group_offset = tile_group_slot_count_.fetch_add(1);
+  auto tile_group_slot = GetTileGroupSlot(tile_group_offset, true);
+  tile_group_slot->tile_group_id = tile_group_id;
+  tile_group_slot->tile_group = tile_group.get();
+
+  // readers only look below the count, so it must not pass the offsets
+  // appends before us are still publishing
+  size_t expected_count = tile_group_offset;
+  while (tile_group_count_.compare_exchange_weak(
+             expected_count, tile_group_offset + 1) == false) {
+    expected_count = tile_group_offset;
+    _mm_pause();
+  }
 
   LOG_TRACE("Recording tile group : %u ", tile_group_id);
 }
 
+DataTable::TileGroupSlot *DataTable::GetTileGroupSlot(
+    const oid_t &tile_group_offset, bool allocate) const {
+  // segment k starts at offset FIRST_SEGMENT_SIZE * (2^k - 1)
+  size_t bucket =
+      tile_group_offset / TILE_GROUP_DIRECTORY_FIRST_SEGMENT_SIZE + 1;
+  size_t segment_itr = 63 - __builtin_clzll(bucket);
+  size_t slot_itr = tile_group_offset -
+                    TILE_GROUP_DIRECTORY_FIRST_SEGMENT_SIZE *
+                        ((1UL << segment_itr) - 1);
+  PL_ASSERT(segment_itr < TILE_GROUP_DIRECTORY_SEGMENT_COUNT);
+
+  auto segment = tile_group_segments_[segment_itr].load();
+  if (segment == nullptr && allocate == true) {
+    size_t segment_size = TILE_GROUP_DIRECTORY_FIRST_SEGMENT_SIZE
+                          << segment_itr;
+    auto new_segment = new TileGroupSlot[segment_size];
+    for (size_t itr = 0; itr < segment_size; itr++) {
+      new_segment[itr].tile_group_id = INVALID_OID;
+      new_segment[itr].tile_group = nullptr;
+    }
+
+    // another append may have allocated it meanwhile
+    if (tile_group_segments_[segment_itr].compare_exchange_strong(
+            segment, new_segment) == true) {
+      segment = new_segment;
+    } else {
+      delete[] new_segment;
+    }
+  }
+  PL_ASSERT(segment != nullptr);
+
+  return &segment[slot_itr];
+}
+
+void DataTable::UnlinkTileGroup(const oid_t &tile_group_id) {
+  oid_t tile_group_count = GetTileGroupCount();
+  for (oid_t tile_group_itr = 0; tile_group_itr < tile_group_count;
+       tile_group_itr++) {
+    auto tile_group_slot = GetTileGroupSlot(tile_group_itr);
+    if (tile_group_slot->tile_group_id == tile_group_id) {
+      tile_group_slot->tile_group = nullptr;
+      tile_group_slot->tile_group_id = INVALID_OID;
+      break;
+    }
+  }
+
+  LOG_TRACE("Unlinked tile group : %u ", tile_group_id);
+}
+
 size_t DataTable::GetTileGroupCount() const { return tile_group_count_; }
 
 std::shared_ptr<storage::TileGroup> DataTable::GetTileGroup(
     const oid_t &tile_group_offset) const {
   PL_ASSERT(tile_group_offset < GetTileGroupCount());
 
-  tile_group_lock_.ReadLock();
-  auto tile_group_id = tile_groups_.at(tile_group_offset);
-  tile_group_lock_.Unlock();
-
+  auto tile_group_id =
+      GetTileGroupSlot(tile_group_offset)->tile_group_id.load();
+  if (tile_group_id == INVALID_OID) {
+    return nullptr;
+  }
   return GetTileGroupById(tile_group_id);
 }
 
+storage::TileGroup *DataTable::GetTileGroupPointer(
+    const oid_t &tile_group_offset) const {
+  PL_ASSERT(tile_group_offset < GetTileGroupCount());
+
+  return GetTileGroupSlot(tile_group_offset)->tile_group.load();
+}
+
 std::shared_ptr<storage::TileGroup> DataTable::GetTileGroupById(
     const oid_t &tile_group_id) const {
   auto &manager = catalog::Manager::GetInstance();
@@ -645,14 +711,24 @@ std::shared_ptr<storage::TileGroup> DataTable::GetTileGroupById(
 }
 
 void DataTable::DropTileGroups() {
+  oid_t tile_group_count = GetTileGroupCount();
   tile_group_count_ = 0;
+  tile_group_slot_count_ = 0;
   auto &catalog_manager = catalog::Manager::GetInstance();
-  for (auto tile_group_id : tile_groups_) {
-    // add tile group in catalog
+  for (oid_t tile_group_itr = 0; tile_group_itr < tile_group_count;
+       tile_group_itr++) {
+    auto tile_group_slot = GetTileGroupSlot(tile_group_itr);
+    oid_t tile_group_id = tile_group_slot->tile_group_id;
+    tile_group_slot->tile_group = nullptr;
+    tile_group_slot->tile_group_id = INVALID_OID;
+    if (tile_group_id == INVALID_OID) {
+      continue;
+    }
+
+    // drop tile group in catalog
     catalog_manager.DropTileGroup(tile_group_id);
     LOG_TRACE("Dropping tile group : %u ", tile_group_id);
   }
-  tile_groups_.clear();
 }
 
 const std::string DataTable::GetInfo() const {
@@ -669,6 +745,9 @@ const std::string DataTable::GetInfo() const {
   for (oid_t tile_group_itr = 0; tile_group_itr < tile_group_count;
        tile_group_itr++) {
     auto tile_group = GetTileGroup(tile_group_itr);
+    if (tile_group == nullptr) {
+      continue;
+    }
     table_id = tile_group->GetTableId();
     auto tile_tuple_count = tile_group->GetNextTupleSlot();
 
@@ -850,16 +929,21 @@ void SetTransformedTileGroup(storage::TileGroup *orig_tile_group,
 storage::TileGroup *DataTable::TransformTileGroup(
     const oid_t &tile_group_offset, const double &theta) {
   // First, check if the tile group is in this table
-  if (tile_group_offset >= tile_groups_.size()) {
+  if (tile_group_offset >= GetTileGroupCount()) {
     LOG_ERROR("Tile group offset not found in table : %u ", tile_group_offset);
     return nullptr;
   }
 
-  auto tile_group_id = tile_groups_[tile_group_offset];
+  auto tile_group_slot = GetTileGroupSlot(tile_group_offset);
+  auto tile_group_id = tile_group_slot->tile_group_id.load();
 
   // Get orig tile group from catalog
   auto &catalog_manager = catalog::Manager::GetInstance();
   auto tile_group = catalog_manager.GetTileGroup(tile_group_id);
+  if (tile_group == nullptr) {
+    LOG_TRACE("Tile group at offset %u was compacted", tile_group_offset);
+    return nullptr;
+  }
   auto diff = tile_group->GetSchemaDifference(default_partition_);
 
   // Check threshold for transformation
@@ -882,9 +966,11 @@ storage::TileGroup *DataTable::TransformTileGroup(
   // Set the transformed tile group column-at-a-time
   SetTransformedTileGroup(tile_group.get(), new_tile_group.get());
 
-  // Set the location of the new tile group
-  // and clean up the orig tile group
+  // Set the location of the new tile group. Txns may still read the orig
+  // tile group through the directory, so the GC releases it later.
   catalog_manager.AddTileGroup(tile_group_id, new_tile_group);
+  tile_group_slot->tile_group = new_tile_group.get();
+  gc::GCManagerFactory::GetInstance().RetireTileGroup(tile_group);
 
   return new_tile_group.get();
 }
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <queue>
 #include <map>
@@ -72,6 +73,13 @@ namespace storage {
 class Tuple;
 class TileGroup;
 
+// The tile group directory of a table holds this many slots in its first
+// segment. Each further segment is twice as large as the one before.
+#define TILE_GROUP_DIRECTORY_FIRST_SEGMENT_SIZE 64
+
+// Enough segments for about 4 billion tile groups
+#define TILE_GROUP_DIRECTORY_SEGMENT_COUNT 26
+
 //===--------------------------------------------------------------------===//
 // DataTable
 //===--------------------------------------------------------------------===//
@@ -126,10 +134,20 @@ class DataTable : public AbstractTable {
   // add a tile group to table
   void AddTileGroup(const std::shared_ptr<TileGroup> &tile_group);
 
+  // remove a compacted tile group from the table. Its offset stays taken so
+  // that running scans do not skip tile groups.
+  void UnlinkTileGroup(const oid_t &tile_group_id);
+
   // Offset is a 0-based number local to the table
+  // Returns nullptr if the tile group at the offset was compacted
   std::shared_ptr<storage::TileGroup> GetTileGroup(
       const oid_t &tile_group_offset) const;
 
+  // Same as GetTileGroup, but without a catalog lookup or a reference. Tile
+  // groups are only released once the txns that could see them are gone, so
+  // the pointer stays valid until the calling txn ends.
+  storage::TileGroup *GetTileGroupPointer(const oid_t &tile_group_offset) const;
+
   // ID is the global identifier in the entire DBMS
   std::shared_ptr<storage::TileGroup> GetTileGroupById(
       const oid_t &tile_group_id) const;
@@ -243,6 +261,21 @@ class DataTable : public AbstractTable {
   // Drop all tile groups of the table. Used by recovery
   void DropTileGroups();
 
+  // Publish the tile group at the next offset of the directory
+  void AppendTileGroup(const std::shared_ptr<TileGroup> &tile_group);
+
+  // One offset of the tile group directory
+  struct TileGroupSlot {
+    std::atomic<oid_t> tile_group_id;
+
+    // nullptr once the tile group is compacted
+    std::atomic<TileGroup *> tile_group;
+  };
+
+  // Get the slot of the offset, allocating its segment if asked to
+  TileGroupSlot *GetTileGroupSlot(const oid_t &tile_group_offset,
+                                  bool allocate = false) const;
+
   //===--------------------------------------------------------------------===//
   // INDEX HELPERS
   //===--------------------------------------------------------------------===//
@@ -265,13 +298,20 @@ class DataTable : public AbstractTable {
   size_t tuples_per_tilegroup_;
 
   // TILE GROUPS
-  // set of tile groups
-  RWLock tile_group_lock_;
+  // Directory of the tile groups by offset. Slots are only appended, and
+  // segments never move, so readers take no lock.
+  mutable std::atomic<TileGroupSlot *>
+      tile_group_segments_[TILE_GROUP_DIRECTORY_SEGMENT_COUNT];
 
-  std::vector<oid_t> tile_groups_;
+  // offsets handed out to appends
+  std::atomic<size_t> tile_group_slot_count_ = ATOMIC_VAR_INIT(0);
 
+  // offsets whose slots are published, trails the slot count
   std::atomic<size_t> tile_group_count_ = ATOMIC_VAR_INIT(0);
 
+  // serializes recovery, which adds tile groups by id. Readers never take it.
+  RWLock tile_group_lock_;
+
   // tile group mutex
   // TODO: don't know why need this mutex --Yingjun
   std::mutex tile_group_mutex_;
@@ -51,6 +51,7 @@ RBSegType RollbackSegmentPool::CreateSegmentFromTuple(const catalog::Schema *sch
   // Fill in the header
   SetNextPtr(rb_seg, nullptr);
   SetTimeStamp(rb_seg, MAX_CID);
+  SetPool(rb_seg, this);
   SetColCount(rb_seg, col_count);
 
   // Fill in the col_id & offset pair and set the data field
@@ -46,6 +46,11 @@ typedef char* RBSegType;
 /* @brief per transaction rollback segment pool. Rollback segments genereted
  * by each transaction will be allocated from its own pool. The responsibility 
  * of the RollbackSegmentPool is data (de)allocation, and garbage collection.
+ *
+ * The pool counts the references to it: one of the transaction, and one of
+ * each of its segments that is linked into a rollback segment chain. Once
+ * they are all gone, no transaction that begins from then on can reach the
+ * segments, and the pool is handed to the GC.
  */
 class RollbackSegmentPool {
   RollbackSegmentPool(const RollbackSegmentPool&) = delete;
@@ -53,8 +58,9 @@ class RollbackSegmentPool {
 public:
   /**
     * Data layout:
-    * | next_seg_ptr (8 bytes) | timestamp (8 bytes) | column_count (8 bytes)
-    * | id_offset_pairs (column_count * 16 bytes) | segment data
+    * | next_seg_ptr (8 bytes) | timestamp (8 bytes) | pool_ptr (8 bytes)
+    * | column_count (8 bytes) | id_offset_pairs (column_count * 16 bytes)
+    * | segment data
     * 
     * Rollback segment is variable length byte buffer
     * - The first 8 byte field is a pointer to the next rollback segment on the
@@ -65,6 +71,8 @@ public:
     *  of a rollback segment is JUST the end timestamp of next rollback segment
     *  on the rollback segment chain. Everytime the timestamp of a rollback
     *  segment is copied from the coressponding tuple
+    * - The next 8 byte field is a pointer to the pool the segment is allocated
+    *  from
     * - The next 8 byte field is the number of columns in the rollback segment
     * - The next column_count * 16 bytes is a serious of pairs, the pairs map
     *  column id of the original tuple to the offset of value in the data area
@@ -73,18 +81,21 @@ public:
     */
   static const size_t next_ptr_offset_ = 0;
   static const size_t timestamp_offset_ = next_ptr_offset_ + sizeof(void*);
-  static const size_t col_count_offset_ = timestamp_offset_ + sizeof(cid_t);
+  static const size_t pool_ptr_offset_ = timestamp_offset_ + sizeof(cid_t);
+  static const size_t col_count_offset_ = pool_ptr_offset_ + sizeof(void*);
   static const size_t pairs_start_offset = col_count_offset_ + sizeof(size_t);
 
   RollbackSegmentPool(BackendType backend_type):
-    pool_(backend_type), tombstone_(false), timestamp_(MAX_CID) {}
+    pool_(backend_type), tombstone_(false), timestamp_(MAX_CID),
+    reference_count_(1) {}
 
   RollbackSegmentPool(BackendType backend_type,
                       uint64_t allocation_size,
                       uint64_t max_chunk_count)
                       : pool_(backend_type, allocation_size, max_chunk_count),
                         tombstone_(false),
-                        timestamp_(MAX_CID) {}
+                        timestamp_(MAX_CID),
+                        reference_count_(1) {}
 
   // pool_ will be deallocated here, so all space will be reclaimed
   ~RollbackSegmentPool() {}
@@ -104,6 +115,10 @@ public:
     return *(reinterpret_cast<cid_t*>(rb_seg + timestamp_offset_));
   }
 
+  inline static RollbackSegmentPool *GetPool(char *rb_seg) {
+    return *(reinterpret_cast<RollbackSegmentPool**>(rb_seg + pool_ptr_offset_));
+  }
+
   inline static size_t GetColCount(const char *rb_seg) {
     return *(reinterpret_cast<const size_t*>(rb_seg + col_count_offset_));
   }
@@ -122,6 +137,10 @@ public:
     return tombstone_;
   }
 
+  inline int64_t GetAllocatedMemory() {
+    return pool_.GetAllocatedMemory();
+  }
+
   inline static char * GetDataLocation(char *rb_seg) {
     size_t col_count = GetColCount(rb_seg);
     return rb_seg + pairs_start_offset + col_count * sizeof(ColIdOffsetPair);
@@ -156,6 +175,17 @@ public:
     tombstone_ = true;
   }
 
+  // A segment of the pool got linked into a rollback segment chain
+  inline void AddReference() {
+    reference_count_.fetch_add(1);
+  }
+
+  // A segment of the pool got unlinked, or the transaction ended. Return
+  // true if that was the last reference.
+  inline bool ReleaseReference() {
+    return reference_count_.fetch_sub(1) == 1;
+  }
+
   // Get a prepared rollback segment from a tuple
   // TODO: Return nullptr if there is no need to generate a new segment
   RBSegType CreateSegmentFromTuple(const catalog::Schema *schema,
@@ -177,6 +207,12 @@ private:
   // Transaction. When tombstone_ is true, timestamp_ is the time when the pool
   // is marked as garbage
   cid_t timestamp_;
+  // References of the transaction and of the linked segments
+  std::atomic<size_t> reference_count_;
+
+  inline static void SetPool(char *rb_seg, RollbackSegmentPool *pool) {
+    *(reinterpret_cast<RollbackSegmentPool**>(rb_seg + pool_ptr_offset_)) = pool;
+  }
 
   inline static void SetColCount(char *rb_seg, size_t col_count) {
     *(reinterpret_cast<size_t*>(rb_seg + col_count_offset_)) = col_count;
@@ -19,14 +19,17 @@
 #include "backend/common/serializer.h"
 #include "backend/common/types.h"
 #include "backend/common/macros.h"
+#include "backend/common/varlen.h"
 #include "backend/storage/tuple_iterator.h"
 #include "backend/storage/tuple.h"
 #include "backend/storage/storage_manager.h"
 #include "backend/storage/tile.h"
+#include "backend/storage/tile_group.h"
 #include "backend/storage/tile_group_header.h"
 #include "backend/storage/rollback_segment.h"
 #include "backend/concurrency/transaction_manager_factory.h"
 #include "backend/concurrency/optimistic_rb_txn_manager.h"
+#include "backend/gc/gc_manager_factory.h"
 
 namespace peloton {
 namespace storage {
@@ -42,7 +45,6 @@ Tile::Tile(BackendType backend_type, TileGroupHeader *tile_header,
       schema(tuple_schema),
       data(NULL),
       tile_group(tile_group),
-      pool(NULL),
       num_tuple_slots(tuple_count),
       column_count(tuple_schema.GetColumnCount()),
       tuple_length(tuple_schema.GetLength()),
@@ -64,7 +66,7 @@ Tile::Tile(BackendType backend_type, TileGroupHeader *tile_header,
   PL_MEMSET(data, 0, tile_size);
 
   // allocate pool for blob storage if schema not inlined
-  if (schema.IsInlined() == false) pool = new VarlenPool(backend_type);
+  if (schema.IsInlined() == false) pool.reset(new VarlenPool(backend_type));
 }
 
 Tile::~Tile() {
@@ -73,9 +75,9 @@ Tile::~Tile() {
   storage_manager.Release(backend_type, data);
   data = NULL;
 
-  // reclaim the tile memory (UNINLINED data)
-  if (schema.IsInlined() == false) delete pool;
-  pool = NULL;
+  // reclaim the tile memory (UNINLINED data), unless the GC still frees
+  // retired varlens into the pool
+  pool.reset();
 
   // clear any cached column headers
   if (column_header) delete column_header;
@@ -182,7 +184,7 @@ void Tile::SetValue(const Value &value, const oid_t tuple_offset,
 
   const bool is_in_bytes = false;
   value.SerializeToTupleStorageAllocateForObjects(
-      field_location, is_inlined, column_length, is_in_bytes, pool);
+      field_location, is_inlined, column_length, is_in_bytes, pool.get());
 }
 
 /*
@@ -201,7 +203,44 @@ void Tile::SetValueFast(const Value &value, const oid_t tuple_offset,
 
   const bool is_in_bytes = false;
   value.SerializeToTupleStorageAllocateForObjects(
-      field_location, is_inlined, column_length, is_in_bytes, pool);
+      field_location, is_inlined, column_length, is_in_bytes, pool.get());
+}
+
+void Tile::RetireUninlinedValue(const oid_t tuple_offset,
+                                const oid_t column_id) {
+  PL_ASSERT(tuple_offset < num_tuple_slots);
+  PL_ASSERT(column_id < schema.GetColumnCount());
+
+  if (schema.IsInlined(column_id) == true || tile_group == nullptr) {
+    return;
+  }
+
+  char *field_location = GetTupleLocation(tuple_offset) +
+                         schema.GetOffset(column_id);
+  auto varlen = *reinterpret_cast<Varlen **>(field_location);
+  if (varlen == nullptr) {
+    return;
+  }
+
+  gc::GCManagerFactory::GetInstance().RetireVarlen(pool, varlen);
+}
+
+void Tile::RetireUninlinedValues(const oid_t tuple_offset) {
+  if (pool == nullptr) {
+    return;
+  }
+
+  for (oid_t column_itr = 0; column_itr < column_count; column_itr++) {
+    if (schema.IsInlined(column_itr) == true) {
+      continue;
+    }
+
+    RetireUninlinedValue(tuple_offset, column_itr);
+
+    char *field_location = GetTupleLocation(tuple_offset) +
+                           schema.GetOffset(column_itr);
+    *reinterpret_cast<Varlen **>(field_location) = nullptr;
+  }
 }
 
 Tile *Tile::CopyTile(BackendType backend_type) {
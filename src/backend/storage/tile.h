@@ -18,6 +18,7 @@
 #include "backend/common/pool.h"
 #include "backend/common/printable.h"
 
+#include <memory>
 #include <mutex>
 
 namespace peloton {
@@ -101,6 +102,14 @@ class Tile : public Printable {
                     const size_t column_offset, const bool is_inlined,
                     const size_t column_length);
 
+  // Hand the uninlined value at the slot over to the GC before it gets
+  // overwritten. It is freed once no running txn can read it anymore.
+  void RetireUninlinedValue(const oid_t tuple_offset, const oid_t column_id);
+
+  // Hand all uninlined values of a tuple whose slot is reset over to the GC,
+  // and clear them, so the next version in the slot does not free them again
+  void RetireUninlinedValues(const oid_t tuple_offset);
+
   // Get tuple at location
   static Tuple *GetTuple(catalog::Manager *catalog,
                          const ItemPointer *tuple_location);
@@ -163,7 +172,7 @@ class Tile : public Printable {
   void DeserializeTuplesFromWithoutHeader(SerializeInputBE &input,
                                           VarlenPool *pool = nullptr);
 
-  VarlenPool *GetPool() { return (pool); }
+  VarlenPool *GetPool() { return (pool.get()); }
 
   char *GetTupleLocation(const oid_t tuple_offset) const;
 
@@ -193,8 +202,9 @@ class Tile : public Printable {
   // relevant tile group
   TileGroup *tile_group;
 
-  // storage pool for uninlined data
-  VarlenPool *pool;
+  // storage pool for uninlined data, shared with the GC while it holds
+  // retired varlens of the tile
+  std::shared_ptr<VarlenPool> pool;
 
   // number of tuple slots allocated
   oid_t num_tuple_slots;
@@ -118,6 +118,7 @@ void TileGroup::ApplyRollbackSegment(char *rb_seg, const oid_t &tuple_slot_id) {
 
     // Write the value to tuple
     auto tile_col_idx = GetTileColumnId(col_id);
+    tile->RetireUninlinedValue(tuple_slot_id, tile_col_idx);
     tile_tuple.SetValue(tile_col_idx, col_value, tile->GetPool());
   }
 }
@@ -147,8 +148,10 @@ void TileGroup::CopyTuple(const Tuple *tuple, const oid_t &tuple_slot_id) {
     // NOTE:: Only a tuple wrapper
     storage::Tuple tile_tuple(&schema, tile_tuple_location);
 
+    // the slot may hold a version that is overwritten in place
     for (oid_t tile_column_itr = 0; tile_column_itr < tile_column_count;
          tile_column_itr++) {
+      tile->RetireUninlinedValue(tuple_slot_id, tile_column_itr);
       tile_tuple.SetValue(tile_column_itr, tuple->GetValue(column_itr),
                           tile->GetPool());
       column_itr++;
@@ -34,9 +34,18 @@ TileGroupHeader::TileGroupHeader(const BackendType &backend_type,
       data(nullptr),
       num_tuple_slots(tuple_count),
       next_tuple_slot(0),
+      free_slot_count(0),
+      compaction_begin_cid(MAX_CID),
       tile_header_lock() {
   header_size = num_tuple_slots * header_entry_size;
 
+  // no slot is free for reuse yet
+  oid_t word_count = (num_tuple_slots + 63) / 64;
+  free_slot_bitmap.reset(new std::atomic<uint64_t>[word_count]);
+  for (oid_t word_itr = 0; word_itr < word_count; word_itr++) {
+    free_slot_bitmap[word_itr] = 0;
+  }
+
   // allocate storage space for header
   auto &storage_manager = storage::StorageManager::GetInstance();
   data = reinterpret_cast<char *>(
@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <iostream>
+#include <memory>
 #include <queue>
 #include <vector>
 #include <cstring>
@@ -83,6 +84,85 @@ class TileGroupHeader : public Printable {
     }
   }
 
+  //===--------------------------------------------------------------------===//
+  // Free tuple slots
+  //===--------------------------------------------------------------------===//
+
+  // Mark a reset tuple slot as free for reuse. Return true if the tile group
+  // had no free slot before, so the GC has to announce it.
+  bool FreeTupleSlot(const oid_t &tuple_slot_id) {
+    PL_ASSERT(tuple_slot_id < num_tuple_slots);
+    uint64_t bit = 1UL << (tuple_slot_id % 64);
+    // a slot may be recycled twice, e.g. by the compactor and an index scan
+    if ((free_slot_bitmap[tuple_slot_id / 64].fetch_or(
+             bit, std::memory_order_release) & bit) != 0) {
+      return false;
+    }
+    return free_slot_count.fetch_add(1, std::memory_order_acq_rel) == 0;
+  }
+
+  // Take a free tuple slot, if one exists and the tile group is not being
+  // compacted
+  oid_t TakeFreeTupleSlot() {
+    if (IsCompacting() == true) {
+      return INVALID_OID;
+    }
+
+    // reserve a slot first, a bit is set before the count is raised
+    oid_t free_count = free_slot_count.load(std::memory_order_acquire);
+    do {
+      if (free_count == 0) {
+        return INVALID_OID;
+      }
+    } while (free_slot_count.compare_exchange_weak(free_count, free_count - 1,
+                                                   std::memory_order_acq_rel) ==
+             false);
+
+    // then find the bit, other takers may get the first ones we see
+    oid_t word_count = (num_tuple_slots + 63) / 64;
+    while (true) {
+      for (oid_t word_itr = 0; word_itr < word_count; word_itr++) {
+        uint64_t word =
+            free_slot_bitmap[word_itr].load(std::memory_order_acquire);
+        while (word != 0) {
+          oid_t bit_offset = __builtin_ctzll(word);
+          uint64_t bit = 1UL << bit_offset;
+          if ((free_slot_bitmap[word_itr].fetch_and(
+                   ~bit, std::memory_order_acq_rel) & bit) != 0) {
+            return word_itr * 64 + bit_offset;
+          }
+          word &= ~bit;
+        }
+      }
+    }
+  }
+
+  // Whether the slot was reset and not taken again
+  bool IsFreeTupleSlot(const oid_t &tuple_slot_id) const {
+    PL_ASSERT(tuple_slot_id < num_tuple_slots);
+    uint64_t bit = 1UL << (tuple_slot_id % 64);
+    return (free_slot_bitmap[tuple_slot_id / 64].load(
+                std::memory_order_acquire) & bit) != 0;
+  }
+
+  oid_t GetFreeTupleSlotCount() const {
+    return free_slot_count.load(std::memory_order_relaxed);
+  }
+
+  // Stop handing out free slots, the compactor moves the tuples to other
+  // tile groups
+  void BeginCompaction(const cid_t &begin_cid) {
+    compaction_begin_cid.store(begin_cid, std::memory_order_release);
+  }
+
+  bool IsCompacting() const {
+    return compaction_begin_cid.load(std::memory_order_acquire) != MAX_CID;
+  }
+
+  cid_t GetCompactionBeginCid() const {
+    return compaction_begin_cid.load(std::memory_order_acquire);
+  }
+
   /**
    * Used by logging
    */
@@ -137,6 +217,13 @@ class TileGroupHeader : public Printable {
     return *((cid_t *)(TUPLE_HEADER_LOCATION + end_cid_offset));
   }
 
+  // Start loading the txn id and commit ids of the tuple into the cache,
+  // they may straddle two cache lines
+  inline void PrefetchTupleHeader(const oid_t &tuple_slot_id) const {
+    __builtin_prefetch(TUPLE_HEADER_LOCATION);
+    __builtin_prefetch(TUPLE_HEADER_LOCATION + end_cid_offset);
+  }
+
   inline ItemPointer GetNextItemPointer(const oid_t &tuple_slot_id) const {
     return *((ItemPointer *)(TUPLE_HEADER_LOCATION + next_pointer_offset));
   }
@@ -290,6 +377,16 @@ private:
   // IT MAY OUT OF BOUNDARY! ALWAYS CHECK IF IT EXCEEDS num_tuple_slots
   std::atomic<oid_t> next_tuple_slot;
 
+  // one bit per tuple slot that the GC has reset for reuse
+  std::unique_ptr<std::atomic<uint64_t>[]> free_slot_bitmap;
+
+  // number of bits set in the free slot bitmap
+  std::atomic<oid_t> free_slot_count;
+
+  // commit id at which the compaction of the tile group began, MAX_CID if it
+  // is not being compacted
+  std::atomic<cid_t> compaction_begin_cid;
+
   Spinlock tile_header_lock;
 };
 
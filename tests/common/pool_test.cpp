@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// pool_test.cpp
+//
+// Identification: tests/common/pool_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "harness.h"
+
+#include "backend/common/pool.h"
+#include "backend/common/varlen.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Pool Test
+//===--------------------------------------------------------------------===//
+
+class PoolTest : public PelotonTest {};
+
+TEST_F(PoolTest, FreeTest) {
+  VarlenPool pool(BACKEND_TYPE_MM);
+
+  // fill a few chunks
+  std::vector<Varlen *> varlens;
+  for (int i = 0; i < 20; i++) {
+    varlens.push_back(Varlen::Create(100, &pool));
+  }
+  auto allocated_memory = pool.GetAllocatedMemory();
+
+  // the freed chunks take the next varlens
+  for (int round = 0; round < 5; round++) {
+    for (auto varlen : varlens) {
+      Varlen::Destroy(varlen, &pool);
+    }
+    varlens.clear();
+
+    for (int i = 0; i < 20; i++) {
+      varlens.push_back(Varlen::Create(100, &pool));
+      PL_MEMSET(varlens.back()->Get(), i, 100);
+    }
+    EXPECT_EQ(allocated_memory, pool.GetAllocatedMemory());
+  }
+
+  for (int i = 0; i < 20; i++) {
+    EXPECT_EQ(i, varlens[i]->Get()[0]);
+    EXPECT_EQ(i, varlens[i]->Get()[99]);
+  }
+
+  // oversize blocks are released right away
+  auto oversize_varlen = Varlen::Create(10000, &pool);
+  EXPECT_LT(allocated_memory, pool.GetAllocatedMemory());
+  Varlen::Destroy(oversize_varlen, &pool);
+  EXPECT_EQ(allocated_memory, pool.GetAllocatedMemory());
+
+  // a purge still resets the pool
+  pool.Purge();
+  for (int i = 0; i < 20; i++) {
+    Varlen::Create(100, &pool);
+  }
+  EXPECT_EQ(allocated_memory, pool.GetAllocatedMemory());
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// epoch_manager_test.cpp
+//
+// Identification: tests/concurrency/epoch_manager_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "harness.h"
+
+#include "backend/concurrency/epoch_manager.h"
+
+namespace peloton {
+
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Epoch Manager Tests
+//===--------------------------------------------------------------------===//
+
+class EpochManagerTests : public PelotonTest {};
+
+// Long enough for the background thread to scan the local epochs twice
+static void WaitForEpochs() {
+  std::this_thread::sleep_for(4 * std::chrono::milliseconds(EPOCH_LENGTH));
+}
+
+TEST_F(EpochManagerTests, RegistrationTest) {
+  concurrency::EpochManager epoch_manager;
+  EXPECT_EQ(0u, epoch_manager.GetWorkerCount());
+
+  // Threads register on their first txn and deregister when they exit
+  std::vector<std::thread> threads;
+  for (size_t thread_itr = 0; thread_itr < 8; thread_itr++) {
+    threads.push_back(std::thread([&epoch_manager, thread_itr] {
+      auto worker_id = epoch_manager.EnterEpoch(thread_itr + 1);
+      EXPECT_EQ(worker_id, epoch_manager.EnterEpoch(thread_itr + 2));
+      epoch_manager.ExitEpoch(worker_id);
+      epoch_manager.ExitEpoch(worker_id);
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0u, epoch_manager.GetWorkerCount());
+
+  auto worker_id = epoch_manager.RegisterWorker();
+  EXPECT_EQ(worker_id, epoch_manager.RegisterWorker());
+  EXPECT_EQ(1u, epoch_manager.GetWorkerCount());
+
+  epoch_manager.DeregisterWorker();
+  EXPECT_EQ(0u, epoch_manager.GetWorkerCount());
+
+  // Deregistered workers still count towards the dead cids
+  WaitForEpochs();
+  EXPECT_EQ(9u, epoch_manager.GetMaxDeadTxnCid());
+}
+
+TEST_F(EpochManagerTests, MaxDeadTxnCidTest) {
+  concurrency::EpochManager epoch_manager;
+
+  auto worker_id = epoch_manager.EnterEpoch(10);
+
+  // A running txn on another thread holds back the max dead cid
+  std::thread worker([&epoch_manager] {
+    for (cid_t begin_cid = 11; begin_cid <= 20; begin_cid++) {
+      epoch_manager.ExitEpoch(epoch_manager.EnterEpoch(begin_cid));
+    }
+  });
+  worker.join();
+
+  WaitForEpochs();
+  EXPECT_EQ(9u, epoch_manager.GetMaxDeadTxnCid());
+
+  epoch_manager.ExitEpoch(worker_id);
+  WaitForEpochs();
+  EXPECT_EQ(20u, epoch_manager.GetMaxDeadTxnCid());
+
+  epoch_manager.Reset();
+  EXPECT_EQ(0u, epoch_manager.GetMaxDeadTxnCid());
+  epoch_manager.DeregisterWorker();
+}
+
+TEST_F(EpochManagerTests, CommitWaitTest) {
+  concurrency::EpochManager epoch_manager;
+
+  auto worker_id = epoch_manager.EnterEpoch(10);
+  epoch_manager.EnterCommit(worker_id, 15);
+
+  // Snapshots below the commit do not wait, those above it do
+  std::atomic<bool> is_waiting(true);
+  std::thread reader([&epoch_manager, &is_waiting] {
+    epoch_manager.WaitForCommitsBelow(15);
+    epoch_manager.WaitForCommitsBelow(20);
+    is_waiting = false;
+  });
+
+  WaitForEpochs();
+  EXPECT_TRUE(is_waiting);
+
+  epoch_manager.ExitCommit(worker_id);
+  reader.join();
+  EXPECT_FALSE(is_waiting);
+
+  epoch_manager.ExitEpoch(worker_id);
+  epoch_manager.DeregisterWorker();
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -446,6 +446,43 @@ TEST_F(IsolationLevelTest, SerializableTest) {
   }
 }
 
+// Write skew between two scans, each reading enough of the tile group to
+// lock it as a whole
+TEST_F(IsolationLevelTest, SIReadEscalationTest) {
+  concurrency::TransactionManagerFactory::Configure(CONCURRENCY_TYPE_SSI,
+                                                    ISOLATION_LEVEL_TYPE_FULL);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  const int num_key = SSI_SIREAD_ESCALATION_THRESHOLD + 8;
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable(num_key));
+
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Scan(0);
+    scheduler.Txn(1).Scan(0);
+    scheduler.Txn(0).Update(num_key - 1, 1);
+    scheduler.Txn(1).Update(num_key - 2, 1);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_FALSE(RESULT_SUCCESS == scheduler.schedules[0].txn_result &&
+                 RESULT_SUCCESS == scheduler.schedules[1].txn_result);
+  }
+
+  // The tile group locks are gone once the txns finished
+  {
+    TransactionScheduler scheduler(1, table.get(), &txn_manager);
+    scheduler.Txn(0).Update(num_key - 1, 2);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+  }
+}
+
 // FIXME: CONCURRENCY_TYPE_SPECULATIVE_READ can't pass it for now
 TEST_F(IsolationLevelTest, StressTest) {
   const int num_txn = 16;
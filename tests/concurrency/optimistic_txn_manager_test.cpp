@@ -29,5 +29,152 @@ TEST_F(OptimisticTxnManagerTests, Test) {
   EXPECT_TRUE(true);
 }
 
+// Concurrent ADDs to a tuple do not conflict, they are applied at commit
+TEST_F(OptimisticTxnManagerTests, EscrowAddTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_OPTIMISTIC);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  {
+    TransactionScheduler scheduler(3, table.get(), &txn_manager);
+    scheduler.Txn(0).Add(0, 1);
+    scheduler.Txn(1).Add(0, 2);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(2).Read(0);
+    scheduler.Txn(2).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[2].txn_result);
+    EXPECT_EQ(3, scheduler.schedules[2].results[0]);
+  }
+
+  {
+    // an ADD goes on top of a version committed after the txn began
+    TransactionScheduler scheduler(3, table.get(), &txn_manager);
+    scheduler.Txn(0).Add(1, 1);
+    scheduler.Txn(1).Update(1, 7);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(2).Read(1);
+    scheduler.Txn(2).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(8, scheduler.schedules[2].results[0]);
+  }
+
+  {
+    // an ADD goes into the version the txn wrote itself
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Update(2, 10);
+    scheduler.Txn(0).Add(2, 5);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).Read(2);
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(15, scheduler.schedules[1].results[0]);
+  }
+
+  {
+    // the txn reads its own ADDs
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Add(5, 5);
+    scheduler.Txn(0).Read(5);
+    scheduler.Txn(0).Add(5, 1);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).Read(5);
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(5, scheduler.schedules[0].results[0]);
+    EXPECT_EQ(6, scheduler.schedules[1].results[0]);
+  }
+
+  {
+    // an ADD whose predicate reads the column is a regular update
+    TransactionScheduler scheduler(4, table.get(), &txn_manager);
+    scheduler.Txn(0).Update(6, 50);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).AddByValue(50, 1);
+    scheduler.Txn(2).Update(6, 200);
+    scheduler.Txn(2).Commit();
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(3).Read(6);
+    scheduler.Txn(3).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[2].txn_result);
+    EXPECT_EQ(51, scheduler.schedules[3].results[0]);
+  }
+
+  {
+    // a txn that read the value still conflicts with the ADD
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(3);
+    scheduler.Txn(1).Add(3, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Update(4, 1);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[0].txn_result);
+  }
+}
+
+// A read set spanning several validation batches still catches a conflict
+// on its last tuples
+TEST_F(OptimisticTxnManagerTests, ReadSetValidationTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_OPTIMISTIC);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable(100));
+
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Scan(0);
+    scheduler.Txn(0).Update(0, 1);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).Scan(0);
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+  }
+
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Scan(0);
+    scheduler.Txn(1).Update(90, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Update(0, 2);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[0].txn_result);
+  }
+}
+
 }  // End test namespace
 }  // End peloton namespace
@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         PelotonDB
+//
+// partition_txn_manager_test.cpp
+//
+// Identification: tests/concurrency/partition_txn_manager_test.cpp
+//
+// Copyright (c) 2015, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "harness.h"
+#include "concurrency/transaction_tests_util.h"
+
+namespace peloton {
+
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Partition Transaction Manager Tests
+//===--------------------------------------------------------------------===//
+
+class PartitionTxnManagerTests : public PelotonTest {};
+
+// Txns on different partitions run at the same time, txns on the same
+// partition one after another
+TEST_F(PartitionTxnManagerTests, PartitionTest) {
+  concurrency::TransactionManagerFactory::Configure(CONCURRENCY_TYPE_PARTITION);
+  auto &txn_manager = concurrency::PartitionTxnManager::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  auto partition_0 = concurrency::PartitionTxnManager::GetPartition(0);
+  auto partition_1 = concurrency::PartitionTxnManager::GetPartition(1);
+  EXPECT_NE(partition_0, partition_1);
+
+  txn_manager.DeclarePartition(partition_0);
+  auto txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 0, 10));
+
+  // a txn on another partition does not wait
+  std::thread other_partition([&] {
+    txn_manager.DeclarePartition(partition_1);
+    auto txn = txn_manager.BeginTransaction();
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 1, 11));
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction());
+  });
+  other_partition.join();
+
+  // a txn on both partitions waits for the first txn
+  std::atomic<bool> done(false);
+  std::thread both_partitions([&] {
+    txn_manager.DeclarePartition(partition_1);
+    txn_manager.DeclarePartition(partition_0);
+    auto txn = txn_manager.BeginTransaction();
+    int result;
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 0, result));
+    EXPECT_EQ(10, result);
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 1, result));
+    EXPECT_EQ(11, result);
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction());
+    done = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(done.load());
+
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction());
+  both_partitions.join();
+  EXPECT_TRUE(done.load());
+}
+
+// A read-only txn waits for the txn holding its partition
+TEST_F(PartitionTxnManagerTests, ReadOnlyTest) {
+  concurrency::TransactionManagerFactory::Configure(CONCURRENCY_TYPE_PARTITION);
+  auto &txn_manager = concurrency::PartitionTxnManager::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  auto partition_0 = concurrency::PartitionTxnManager::GetPartition(0);
+
+  txn_manager.DeclarePartition(partition_0);
+  auto txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 0, 10));
+
+  std::atomic<bool> done(false);
+  std::thread reader([&] {
+    txn_manager.DeclarePartition(partition_0);
+    auto txn = txn_manager.BeginReadOnlyTransaction();
+    int result;
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 0, result));
+    EXPECT_EQ(10, result);
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction());
+    done = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(done.load());
+
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction());
+  reader.join();
+  EXPECT_TRUE(done.load());
+}
+
+// The writes of an aborted txn are undone before its partition is released
+TEST_F(PartitionTxnManagerTests, AbortTest) {
+  concurrency::TransactionManagerFactory::Configure(CONCURRENCY_TYPE_PARTITION);
+  auto &txn_manager = concurrency::PartitionTxnManager::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  std::vector<oid_t> partitions;
+  for (auto key : {0, 2, 100}) {
+    partitions.push_back(concurrency::PartitionTxnManager::GetPartition(key));
+  }
+
+  for (auto partition : partitions) {
+    txn_manager.DeclarePartition(partition);
+  }
+  auto txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 0, 10));
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteInsert(txn, table.get(), 100, 0));
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteDelete(txn, table.get(), 2));
+  EXPECT_EQ(RESULT_ABORTED, txn_manager.AbortTransaction());
+
+  for (auto partition : partitions) {
+    txn_manager.DeclarePartition(partition);
+  }
+  txn = txn_manager.BeginTransaction();
+  int result;
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 0, result));
+  EXPECT_EQ(0, result);
+  TransactionTestsUtil::ExecuteRead(txn, table.get(), 100, result);
+  EXPECT_EQ(-1, result);
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 2, result));
+  EXPECT_EQ(0, result);
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteDelete(txn, table.get(), 2));
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction());
+
+  // a txn that declares no partition holds all of them
+  txn = txn_manager.BeginTransaction();
+  TransactionTestsUtil::ExecuteRead(txn, table.get(), 2, result);
+  EXPECT_EQ(-1, result);
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction());
+}
+
+}  // End test namespace
+}  // End peloton namespace
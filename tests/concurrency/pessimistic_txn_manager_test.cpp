@@ -10,8 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <thread>
+
 #include "harness.h"
 #include "concurrency/transaction_tests_util.h"
+#include "backend/concurrency/lock_manager.h"
 
 namespace peloton {
 
@@ -29,5 +33,158 @@ TEST_F(PessimisticTxnManagerTests, Test) {
   EXPECT_TRUE(true);
 }
 
+static std::vector<DeadlockHandlingType> DEADLOCK_HANDLING_TYPES = {
+  DEADLOCK_HANDLING_TYPE_DETECTION,
+  DEADLOCK_HANDLING_TYPE_WAIT_DIE,
+  DEADLOCK_HANDLING_TYPE_WOUND_WAIT
+};
+
+TEST_F(PessimisticTxnManagerTests, LockWaitTest) {
+  auto &lock_manager = concurrency::LockManager::GetInstance();
+  lock_manager.Configure(DEADLOCK_HANDLING_TYPE_DETECTION);
+  ItemPointer location(1, 1);
+
+  // Shared locks are compatible, an exclusive one waits for them
+  EXPECT_TRUE(lock_manager.Lock(2, 20, location, concurrency::LOCK_MODE_SHARED));
+  EXPECT_TRUE(lock_manager.Lock(3, 30, location, concurrency::LOCK_MODE_SHARED));
+
+  std::atomic<bool> granted(false);
+  std::thread writer([&lock_manager, &location, &granted] {
+    EXPECT_TRUE(
+        lock_manager.Lock(4, 40, location, concurrency::LOCK_MODE_EXCLUSIVE));
+    granted = true;
+    lock_manager.Unlock(4, location);
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(granted);
+  lock_manager.Unlock(2, location);
+  lock_manager.Unlock(3, location);
+  writer.join();
+  EXPECT_TRUE(granted);
+
+  lock_manager.Configure(DEADLOCK_HANDLING_TYPE_NO_WAIT);
+}
+
+TEST_F(PessimisticTxnManagerTests, UpgradeDeadlockTest) {
+  auto &lock_manager = concurrency::LockManager::GetInstance();
+  ItemPointer location(1, 1);
+
+  // Two txns read the tuple and then both want to write it. Whatever the
+  // deadlock handling, the younger txn gives way to the older one.
+  for (auto deadlock_handling : DEADLOCK_HANDLING_TYPES) {
+    lock_manager.Configure(deadlock_handling);
+    std::atomic<int> readers(0);
+    bool upgraded[2];
+
+    std::vector<std::thread> threads;
+    for (int txn_itr = 0; txn_itr < 2; txn_itr++) {
+      threads.push_back(std::thread([&, txn_itr] {
+        txn_id_t txn_id = txn_itr + 1;
+        cid_t begin_cid = (txn_itr + 1) * 10;
+
+        EXPECT_TRUE(lock_manager.Lock(txn_id, begin_cid, location,
+                                      concurrency::LOCK_MODE_SHARED));
+        readers++;
+        while (readers != 2) {
+          std::this_thread::yield();
+        }
+
+        upgraded[txn_itr] = lock_manager.Lock(
+            txn_id, begin_cid, location, concurrency::LOCK_MODE_EXCLUSIVE);
+        lock_manager.Unlock(txn_id, location);
+        lock_manager.EndTransaction(txn_id);
+      }));
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    EXPECT_TRUE(upgraded[0]);
+    EXPECT_FALSE(upgraded[1]);
+  }
+
+  lock_manager.Configure(DEADLOCK_HANDLING_TYPE_NO_WAIT);
+}
+
+// Concurrent transfers between a few hot keys
+TEST_F(PessimisticTxnManagerTests, HotspotTest) {
+  const int num_round = 50;
+  const int num_txn = 8;
+  const int scale = 4;
+  const int num_key = 4;
+
+  // NO_WAIT goes first, as the baseline for the waiting policies
+  std::vector<DeadlockHandlingType> deadlock_handling_types = {
+      DEADLOCK_HANDLING_TYPE_NO_WAIT};
+  for (auto deadlock_handling : DEADLOCK_HANDLING_TYPES) {
+    deadlock_handling_types.push_back(deadlock_handling);
+  }
+  int no_wait_num_commit = 0;
+  for (auto deadlock_handling : deadlock_handling_types) {
+    concurrency::TransactionManagerFactory::Configure(
+        CONCURRENCY_TYPE_PESSIMISTIC, ISOLATION_LEVEL_TYPE_FULL,
+        deadlock_handling);
+    auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+    // every policy runs the same txns
+    srand(15721);
+    int num_commit = 0;
+    for (int round = 0; round < num_round; round++) {
+      std::unique_ptr<storage::DataTable> table(
+          TransactionTestsUtil::CreateTable(num_key));
+
+      TransactionScheduler scheduler(num_txn, table.get(), &txn_manager);
+      scheduler.SetConcurrent(true);
+      for (int i = 0; i < num_txn; i++) {
+        for (int j = 0; j < scale; j++) {
+          int key1 = rand() % num_key;
+          int key2 = rand() % num_key;
+          int delta = rand() % 1000;
+          scheduler.Txn(i).ReadStore(key1, -delta);
+          scheduler.Txn(i).Update(key1, TXN_STORED_VALUE);
+          scheduler.Txn(i).ReadStore(key2, delta);
+          scheduler.Txn(i).Update(key2, TXN_STORED_VALUE);
+        }
+        scheduler.Txn(i).Commit();
+      }
+      scheduler.Run();
+
+      for (auto &schedule : scheduler.schedules) {
+        if (schedule.txn_result == RESULT_SUCCESS) num_commit++;
+      }
+
+      // The sum should be zero
+      TransactionScheduler scheduler2(1, table.get(), &txn_manager);
+      for (int i = 0; i < num_key; i++) {
+        scheduler2.Txn(0).Read(i);
+      }
+      scheduler2.Txn(0).Commit();
+      scheduler2.Run();
+
+      EXPECT_EQ(RESULT_SUCCESS, scheduler2.schedules[0].txn_result);
+      int sum = 0;
+      for (auto result : scheduler2.schedules[0].results) {
+        sum += result;
+      }
+      EXPECT_EQ(0, sum);
+    }
+    LOG_INFO("deadlock handling %d: %d of %d txns commit",
+             (int)deadlock_handling, num_commit, num_round * num_txn);
+
+    // A txn that waits for a lock reads what the writer committed instead
+    // of aborting. Wait-die only lets older txns wait, so on a hot spot it
+    // aborts about as often as NO_WAIT.
+    if (deadlock_handling == DEADLOCK_HANDLING_TYPE_NO_WAIT) {
+      no_wait_num_commit = num_commit;
+    } else if (deadlock_handling != DEADLOCK_HANDLING_TYPE_WAIT_DIE) {
+      EXPECT_GT(num_commit, no_wait_num_commit);
+    }
+  }
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_PESSIMISTIC);
+}
+
 }  // End test namespace
 }  // End peloton namespace
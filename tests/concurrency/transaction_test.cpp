@@ -10,8 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <thread>
+
 #include "harness.h"
 #include "concurrency/transaction_tests_util.h"
+#include "backend/common/timer.h"
 
 namespace peloton {
 
@@ -230,5 +234,175 @@ TEST_F(TransactionTests, AbortTest) {
   }
 }
 
+TEST_F(TransactionTests, ReadWriteSetTest) {
+  concurrency::Transaction txn(START_TXN_ID, START_CID);
+
+  // Record accesses out of order, enough to need the hashed lookup
+  const oid_t tile_group_count = 5;
+  const oid_t tuple_count = 20;
+  for (oid_t tuple_id = tuple_count; tuple_id > 0; tuple_id--) {
+    for (oid_t tile_group_id = tile_group_count; tile_group_id > 0;
+         tile_group_id--) {
+      txn.RecordRead(ItemPointer(tile_group_id, tuple_id));
+    }
+  }
+  txn.RecordUpdate(ItemPointer(3, 7));
+  txn.RecordInsert(ItemPointer(6, 1));
+  EXPECT_TRUE(txn.RecordDelete(ItemPointer(6, 1)));
+
+  EXPECT_TRUE(txn.IsAccessed(3, 7));
+  EXPECT_FALSE(txn.IsAccessed(3, 21));
+
+  // Iteration is grouped by tile group, in tile group and tuple order
+  oid_t expected_tile_group_id = 1;
+  for (auto &tile_group_entry : txn.GetRWSet()) {
+    EXPECT_EQ(expected_tile_group_id, tile_group_entry.GetTileGroupId());
+
+    oid_t expected_tuple_id = 1;
+    for (auto &tuple_entry : tile_group_entry) {
+      EXPECT_EQ(expected_tile_group_id, tuple_entry.tile_group_id);
+      EXPECT_EQ(expected_tuple_id, tuple_entry.tuple_id);
+
+      if (expected_tile_group_id == 3 && expected_tuple_id == 7) {
+        EXPECT_EQ(concurrency::RW_TYPE_UPDATE, tuple_entry.type);
+      } else if (expected_tile_group_id == 6) {
+        EXPECT_EQ(concurrency::RW_TYPE_INS_DEL, tuple_entry.type);
+      } else {
+        EXPECT_EQ(concurrency::RW_TYPE_READ, tuple_entry.type);
+      }
+      expected_tuple_id++;
+    }
+    expected_tile_group_id++;
+  }
+  EXPECT_EQ(tile_group_count + 2, expected_tile_group_id);
+  EXPECT_EQ(tile_group_count * tuple_count + 1, txn.GetRWSet().GetSize());
+}
+
+TEST_F(TransactionTests, TransactionReuseTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_OPTIMISTIC);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // A finished txn object is reset in place for the next txn of the thread
+  auto txn = txn_manager.BeginTransaction();
+  auto txn_id = txn->GetTransactionId();
+  txn_manager.AbortTransaction();
+
+  auto next_txn = txn_manager.BeginTransaction();
+  EXPECT_EQ(txn, next_txn);
+  EXPECT_NE(txn_id, next_txn->GetTransactionId());
+  EXPECT_EQ(RESULT_SUCCESS, next_txn->GetResult());
+  EXPECT_EQ(MAX_CID, next_txn->GetEndCommitId());
+  EXPECT_EQ(0u, next_txn->GetRWSet().GetSize());
+  EXPECT_TRUE(next_txn->IsReadOnly());
+  txn_manager.CommitTransaction();
+}
+
+TEST_F(TransactionTests, ReadOnlyTransactionTest) {
+  for (auto test_type : TEST_TYPES) {
+    concurrency::TransactionManagerFactory::Configure(test_type);
+    auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+
+    // A read-only txn keeps reading its snapshot across a concurrent update
+    {
+      TransactionScheduler scheduler(2, table.get(), &txn_manager);
+      scheduler.Txn(0).ReadOnly();
+      scheduler.Txn(0).Read(0);
+      scheduler.Txn(1).Update(0, 100);
+      scheduler.Txn(1).Commit();
+      scheduler.Txn(0).Read(0);
+      scheduler.Txn(0).Commit();
+
+      scheduler.Run();
+
+      EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+      EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+      EXPECT_EQ(0, scheduler.schedules[0].results[0]);
+      EXPECT_EQ(0, scheduler.schedules[0].results[1]);
+    }
+
+    // A later read-only txn sees the update
+    {
+      TransactionScheduler scheduler(1, table.get(), &txn_manager);
+      scheduler.Txn(0).ReadOnly();
+      scheduler.Txn(0).Read(0);
+      scheduler.Txn(0).Commit();
+
+      scheduler.Run();
+
+      EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+      EXPECT_EQ(100, scheduler.schedules[0].results[0]);
+    }
+
+    // Protocols with the snapshot fast path record no reads
+    auto txn = txn_manager.BeginReadOnlyTransaction();
+    int result;
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 1, result));
+    EXPECT_EQ(0, result);
+    if (txn->IsReadOnlySnapshot()) {
+      EXPECT_EQ(0u, txn->GetRWSet().GetSize());
+    }
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction());
+  }
+}
+
+// Begin and commit empty txns, keeping the txn ids handed out
+void BeginCommitTest(concurrency::TransactionManager *txn_manager,
+                     size_t txn_count, std::vector<txn_id_t> *txn_ids) {
+  txn_ids->reserve(txn_count);
+  for (size_t txn_itr = 0; txn_itr < txn_count; txn_itr++) {
+    auto txn = txn_manager->BeginTransaction();
+    txn_ids->push_back(txn->GetTransactionId());
+    txn_manager->CommitTransaction();
+  }
+}
+
+// Microbenchmark of begin/commit throughput as the thread count grows
+TEST_F(TransactionTests, BeginCommitScalabilityTest) {
+  const size_t txn_count = 20000;
+  size_t max_thread_count =
+      std::max(std::thread::hardware_concurrency(), 2u);
+
+  for (auto test_type : TEST_TYPES) {
+    concurrency::TransactionManagerFactory::Configure(test_type);
+    auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+    for (size_t thread_count = 1; thread_count <= max_thread_count;
+         thread_count *= 2) {
+      std::vector<std::vector<txn_id_t>> txn_ids(thread_count);
+      std::vector<std::thread> threads;
+
+      Timer<std::milli> timer;
+      timer.Start();
+      for (size_t thread_itr = 0; thread_itr < thread_count; thread_itr++) {
+        threads.push_back(std::thread(BeginCommitTest, &txn_manager,
+                                      txn_count, &txn_ids[thread_itr]));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      timer.Stop();
+
+      LOG_INFO("protocol %d, %lu threads: %.0f txns/ms", (int)test_type,
+               thread_count,
+               (thread_count * txn_count) / std::max(timer.GetDuration(), 1.0));
+
+      // Txn ids must stay unique across the per-thread leases
+      std::vector<txn_id_t> all_txn_ids;
+      for (auto &thread_txn_ids : txn_ids) {
+        all_txn_ids.insert(all_txn_ids.end(), thread_txn_ids.begin(),
+                           thread_txn_ids.end());
+      }
+      std::sort(all_txn_ids.begin(), all_txn_ids.end());
+      EXPECT_TRUE(std::adjacent_find(all_txn_ids.begin(), all_txn_ids.end()) ==
+                  all_txn_ids.end());
+    }
+  }
+}
+
 }  // End test namespace
 }  // End peloton namespace
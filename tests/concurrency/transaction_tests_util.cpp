@@ -351,6 +351,47 @@ bool TransactionTestsUtil::ExecuteUpdate(concurrency::Transaction *transaction,
   return update_executor.Execute();
 }
 
+bool TransactionTestsUtil::ExecuteAdd(concurrency::Transaction *transaction,
+                                      storage::DataTable *table, int id,
+                                      int delta) {
+  std::unique_ptr<executor::ExecutorContext> context(
+      new executor::ExecutorContext(transaction));
+
+  Value delta_val = ValueFactory::GetIntegerValue(delta);
+
+  // ProjectInfo, value = value + delta
+  TargetList target_list;
+  DirectMapList direct_map_list;
+  target_list.emplace_back(
+      1, expression::ExpressionUtil::OperatorFactory(
+             EXPRESSION_TYPE_OPERATOR_PLUS, VALUE_TYPE_INTEGER,
+             expression::ExpressionUtil::TupleValueFactory(VALUE_TYPE_INTEGER,
+                                                           0, 1),
+             expression::ExpressionUtil::ConstantValueFactory(delta_val)));
+  direct_map_list.emplace_back(0, std::pair<oid_t, oid_t>(0, 0));
+
+  // Update plan
+  std::unique_ptr<const planner::ProjectInfo> project_info(
+      new planner::ProjectInfo(std::move(target_list),
+                               std::move(direct_map_list)));
+  planner::UpdatePlan update_node(table, std::move(project_info));
+
+  executor::UpdateExecutor update_executor(&update_node, context.get());
+
+  // Index scan
+  std::vector<oid_t> column_ids = {0};
+  std::unique_ptr<planner::IndexScanPlan> idx_scan_node(
+      new planner::IndexScanPlan(table, nullptr, column_ids, MakeIndexDesc(table, id)));
+  executor::IndexScanExecutor idx_scan_executor(idx_scan_node.get(),
+                                              context.get());
+
+  update_node.AddChild(std::move(idx_scan_node));
+  update_executor.AddChild(&idx_scan_executor);
+
+  EXPECT_TRUE(update_executor.Init());
+  return update_executor.Execute();
+}
+
 bool TransactionTestsUtil::ExecuteUpdateByValue(concurrency::Transaction *txn,
                                                 storage::DataTable *table,
                                                 int old_value,
@@ -396,6 +437,54 @@ bool TransactionTestsUtil::ExecuteUpdateByValue(concurrency::Transaction *txn,
   return update_executor.Execute();
 }
 
+bool TransactionTestsUtil::ExecuteAddByValue(concurrency::Transaction *txn,
+                                             storage::DataTable *table,
+                                             int value, int delta) {
+  std::unique_ptr<executor::ExecutorContext> context(
+      new executor::ExecutorContext(txn));
+
+  Value delta_val = ValueFactory::GetIntegerValue(delta);
+
+  // ProjectInfo, value = value + delta
+  TargetList target_list;
+  DirectMapList direct_map_list;
+  target_list.emplace_back(
+      1, expression::ExpressionUtil::OperatorFactory(
+             EXPRESSION_TYPE_OPERATOR_PLUS, VALUE_TYPE_INTEGER,
+             expression::ExpressionUtil::TupleValueFactory(VALUE_TYPE_INTEGER,
+                                                           0, 1),
+             expression::ExpressionUtil::ConstantValueFactory(delta_val)));
+  direct_map_list.emplace_back(0, std::pair<oid_t, oid_t>(0, 0));
+
+  // Update plan
+  std::unique_ptr<const planner::ProjectInfo> project_info(
+      new planner::ProjectInfo(std::move(target_list),
+                               std::move(direct_map_list)));
+  planner::UpdatePlan update_node(table, std::move(project_info));
+
+  executor::UpdateExecutor update_executor(&update_node, context.get());
+
+  // Predicate, WHERE `value`=value
+  auto tup_val_exp = new expression::TupleValueExpression(VALUE_TYPE_INTEGER, 0, 1);
+  auto const_val_exp = new expression::ConstantValueExpression(
+      ValueFactory::GetIntegerValue(value));
+  auto predicate = new expression::ComparisonExpression<expression::CmpEq>(
+      EXPRESSION_TYPE_COMPARE_EQUAL, tup_val_exp, const_val_exp);
+
+  // Seq scan
+  std::vector<oid_t> column_ids = {0, 1};
+  std::unique_ptr<planner::SeqScanPlan> seq_scan_node(
+      new planner::SeqScanPlan(table, predicate, column_ids));
+  executor::SeqScanExecutor seq_scan_executor(seq_scan_node.get(),
+                                              context.get());
+
+  update_node.AddChild(std::move(seq_scan_node));
+  update_executor.AddChild(&seq_scan_executor);
+
+  EXPECT_TRUE(update_executor.Init());
+  return update_executor.Execute();
+}
+
 bool TransactionTestsUtil::ExecuteScan(concurrency::Transaction *transaction,
                                        std::vector<int> &results,
                                        storage::DataTable *table, int id) {
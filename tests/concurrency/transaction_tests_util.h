@@ -35,6 +35,8 @@
  * * Read(key): Read value from DB, if the key does not exist, will read a value
  * *            of -1
  * * Update(key, value): Update the value of *key* to *value*
+ * * Add(key, delta): Add *delta* to the value of *key*
+ * * AddByValue(value, delta): Add *delta* to every tuple whose value is *value*
  * * Delete(key): delete tuple with key *key*
  * * Scan(key): Scan the table for key >= *key*, if nothing satisfies key >=
  * *            *key*, will scan a value of -1
@@ -107,7 +109,9 @@ enum txn_op_t {
   TXN_OP_ABORT,
   TXN_OP_COMMIT,
   TXN_OP_READ_STORE,
-  TXN_OP_UPDATE_BY_VALUE
+  TXN_OP_UPDATE_BY_VALUE,
+  TXN_OP_ADD,
+  TXN_OP_ADD_BY_VALUE
 };
 
 #define TXN_STORED_VALUE      -10000
@@ -139,8 +143,13 @@ class TransactionTestsUtil {
                             storage::DataTable *table, int id);
   static bool ExecuteUpdate(concurrency::Transaction *txn,
                             storage::DataTable *table, int id, int value);
+  static bool ExecuteAdd(concurrency::Transaction *txn,
+                         storage::DataTable *table, int id, int delta);
   static bool ExecuteUpdateByValue(concurrency::Transaction *txn,
                                    storage::DataTable *table, int old_value, int new_value);
+  static bool ExecuteAddByValue(concurrency::Transaction *txn,
+                                storage::DataTable *table, int value,
+                                int delta);
   static bool ExecuteScan(concurrency::Transaction *txn,
                           std::vector<int> &results, storage::DataTable *table,
                           int id);
@@ -170,7 +179,9 @@ struct TransactionSchedule {
   std::vector<int> results;
   int stored_value;
   int schedule_id;
-  TransactionSchedule(int schedule_id_) : txn_result(RESULT_FAILURE), stored_value(0), schedule_id(schedule_id_) {}
+  // whether the txn begins as a read-only snapshot txn
+  bool read_only;
+  TransactionSchedule(int schedule_id_) : txn_result(RESULT_FAILURE), stored_value(0), schedule_id(schedule_id_), read_only(false) {}
 };
 
 // A thread wrapper that runs a transaction
@@ -228,7 +239,13 @@ class TransactionThread {
     if (value == TXN_STORED_VALUE)
       value = schedule->stored_value;
 
-    if (cur_seq == 0) txn = txn_manager->BeginTransaction();
+    if (cur_seq == 0) {
+      if (schedule->read_only) {
+        txn = txn_manager->BeginReadOnlyTransaction();
+      } else {
+        txn = txn_manager->BeginTransaction();
+      }
+    }
     if (schedule->txn_result == RESULT_ABORTED) {
       cur_seq++;
       return;
@@ -264,6 +281,17 @@ class TransactionThread {
         LOG_INFO("Txn %d Update %d's value to %d, %d", schedule->schedule_id, id, value, execute_result);
         break;
       }
+      case TXN_OP_ADD: {
+        execute_result =
+            TransactionTestsUtil::ExecuteAdd(txn, table, id, value);
+        LOG_INFO("Txn %d Add %d to %d's value, %d", schedule->schedule_id, value, id, execute_result);
+        break;
+      }
+      case TXN_OP_ADD_BY_VALUE: {
+        execute_result =
+            TransactionTestsUtil::ExecuteAddByValue(txn, table, id, value);
+        break;
+      }
       case TXN_OP_SCAN: {
         LOG_TRACE("Execute Scan");
         execute_result = TransactionTestsUtil::ExecuteScan(
@@ -387,6 +415,15 @@ class TransactionScheduler {
     schedules[cur_txn_id].operations.emplace_back(TXN_OP_UPDATE, id, value);
     sequence[time++] = cur_txn_id;
   }
+  void Add(int id, int delta) {
+    schedules[cur_txn_id].operations.emplace_back(TXN_OP_ADD, id, delta);
+    sequence[time++] = cur_txn_id;
+  }
+  void AddByValue(int value, int delta) {
+    schedules[cur_txn_id].operations.emplace_back(TXN_OP_ADD_BY_VALUE, value,
+                                                  delta);
+    sequence[time++] = cur_txn_id;
+  }
   void Scan(int id) {
     schedules[cur_txn_id].operations.emplace_back(TXN_OP_SCAN, id, 0);
     sequence[time++] = cur_txn_id;
@@ -411,6 +448,11 @@ class TransactionScheduler {
     sequence[time++] = cur_txn_id;
   }
 
+  // Run the current txn as a read-only snapshot txn
+  void ReadOnly() {
+    schedules[cur_txn_id].read_only = true;
+  }
+
   void SetConcurrent(bool flag) {
     concurrent = flag;
   }
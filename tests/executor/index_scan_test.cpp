@@ -20,9 +20,14 @@
 #include "backend/executor/logical_tile.h"
 #include "backend/executor/logical_tile_factory.h"
 #include "backend/executor/index_scan_executor.h"
+#include "backend/index/index_builder.h"
+#include "backend/index/index_factory.h"
 #include "backend/storage/data_table.h"
+#include "backend/storage/tile_group.h"
+#include "backend/storage/tile_group_header.h"
 #include "backend/concurrency/transaction_manager_factory.h"
 #include "backend/common/value_factory.h"
+#include "backend/common/value_peeker.h"
 
 #include "executor/executor_tests_util.h"
 #include "harness.h"
@@ -162,5 +167,197 @@ TEST_F(IndexScanTests, MultiColumnPredicateTest) {
   txn_manager.CommitTransaction();
 }
 
+// Index scan that spans several batches of the index cursor.
+TEST_F(IndexScanTests, LargeScanTest) {
+  const int tuple_count = TESTS_TUPLES_PER_TILEGROUP;
+  const int scale_factor = 100;
+  std::unique_ptr<storage::DataTable> data_table(
+      ExecutorTestsUtil::CreateTable(tuple_count));
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  txn_manager.BeginTransaction();
+  ExecutorTestsUtil::PopulateTable(data_table.get(), tuple_count * scale_factor,
+                                   false, false, false);
+  txn_manager.CommitTransaction();
+
+  // Column ids to be added to logical tile after scan.
+  std::vector<oid_t> column_ids({0, 1, 3});
+
+  //===--------------------------------------------------------------------===//
+  // ATTR 0 >= 100
+  //===--------------------------------------------------------------------===//
+
+  auto index = data_table->GetIndex(0);
+  std::vector<oid_t> key_column_ids({0});
+  std::vector<ExpressionType> expr_types(
+      {ExpressionType::EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO});
+  std::vector<Value> values({ValueFactory::GetIntegerValue(100)});
+  std::vector<expression::AbstractExpression *> runtime_keys;
+
+  planner::IndexScanPlan::IndexScanDesc index_scan_desc(
+      index, key_column_ids, expr_types, values, runtime_keys);
+
+  expression::AbstractExpression *predicate = nullptr;
+
+  planner::IndexScanPlan node(data_table.get(), predicate, column_ids,
+                              index_scan_desc);
+
+  auto txn = txn_manager.BeginTransaction();
+  std::unique_ptr<executor::ExecutorContext> context(
+      new executor::ExecutorContext(txn));
+
+  executor::IndexScanExecutor executor(&node, context.get());
+
+  EXPECT_TRUE(executor.Init());
+
+  // The first ten tuples do not match
+  size_t result_tuple_count = 0;
+  while (executor.Execute()) {
+    std::unique_ptr<executor::LogicalTile> result_tile(executor.GetOutput());
+    EXPECT_THAT(result_tile, NotNull());
+    result_tuple_count += result_tile->GetTupleCount();
+  }
+
+  EXPECT_EQ(result_tuple_count, tuple_count * scale_factor - 10);
+
+  txn_manager.CommitTransaction();
+}
+
+// Index scan of table with an IN list on the primary and secondary index.
+TEST_F(IndexScanTests, InListPredicateTest) {
+  std::unique_ptr<storage::DataTable> data_table(
+      ExecutorTestsUtil::CreateAndPopulateTable());
+
+  std::vector<oid_t> column_ids({0, 1, 3});
+  std::vector<expression::AbstractExpression *> runtime_keys;
+  expression::AbstractExpression *predicate = nullptr;
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+  //===--------------------------------------------------------------------===//
+  // ATTR 0 IN (10, 30, 31, 200)
+  //===--------------------------------------------------------------------===//
+
+  std::vector<Value> list_values = {
+      ValueFactory::GetIntegerValue(10), ValueFactory::GetIntegerValue(30),
+      ValueFactory::GetIntegerValue(31), ValueFactory::GetIntegerValue(200)};
+  Value list = ValueFactory::GetArrayValueFromSizeAndType(list_values.size(),
+                                                         VALUE_TYPE_INTEGER);
+  list.SetArrayElements(list_values);
+
+  planner::IndexScanPlan::IndexScanDesc primary_scan_desc(
+      data_table->GetIndex(0), {0}, {EXPRESSION_TYPE_COMPARE_IN}, {list},
+      runtime_keys);
+  planner::IndexScanPlan primary_node(data_table.get(), predicate, column_ids,
+                                      primary_scan_desc);
+
+  //===--------------------------------------------------------------------===//
+  // ATTR 0 IN (10, 20, 30) AND ATTR 1 = 21
+  //===--------------------------------------------------------------------===//
+
+  list_values = {ValueFactory::GetIntegerValue(10),
+                 ValueFactory::GetIntegerValue(20),
+                 ValueFactory::GetIntegerValue(30)};
+  list = ValueFactory::GetArrayValueFromSizeAndType(list_values.size(),
+                                                    VALUE_TYPE_INTEGER);
+  list.SetArrayElements(list_values);
+
+  planner::IndexScanPlan::IndexScanDesc secondary_scan_desc(
+      data_table->GetIndex(1), {0, 1},
+      {EXPRESSION_TYPE_COMPARE_IN, EXPRESSION_TYPE_COMPARE_EQUAL},
+      {list, ValueFactory::GetIntegerValue(21)}, runtime_keys);
+  planner::IndexScanPlan secondary_node(data_table.get(), predicate,
+                                        column_ids, secondary_scan_desc);
+
+  std::vector<std::pair<planner::IndexScanPlan *, size_t>> scans = {
+      {&primary_node, 2}, {&secondary_node, 1}};
+  for (auto &scan : scans) {
+    auto txn = txn_manager.BeginTransaction();
+    std::unique_ptr<executor::ExecutorContext> context(
+        new executor::ExecutorContext(txn));
+
+    executor::IndexScanExecutor executor(scan.first, context.get());
+    EXPECT_TRUE(executor.Init());
+
+    size_t result_tuple_count = 0;
+    while (executor.Execute()) {
+      std::unique_ptr<executor::LogicalTile> result_tile(executor.GetOutput());
+      EXPECT_THAT(result_tile, NotNull());
+      result_tuple_count += result_tile->GetTupleCount();
+    }
+
+    EXPECT_EQ(result_tuple_count, scan.second);
+
+    txn_manager.CommitTransaction();
+  }
+}
+
+// Indexes built over the tuples already in a table.
+TEST_F(IndexScanTests, BuildIndexTest) {
+  const int tuple_count = TESTS_TUPLES_PER_TILEGROUP;
+  const int scale_factor = 100;
+  std::unique_ptr<storage::DataTable> data_table(
+      ExecutorTestsUtil::CreateTable(tuple_count, false));
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  txn_manager.BeginTransaction();
+  ExecutorTestsUtil::PopulateTable(data_table.get(), tuple_count * scale_factor,
+                                   false, false, false);
+  txn_manager.CommitTransaction();
+
+  // Tuples of a running transaction are not indexed
+  txn_manager.BeginTransaction();
+  ExecutorTestsUtil::PopulateTable(data_table.get(), tuple_count, false, false,
+                                   false);
+
+  auto tuple_schema = data_table->GetSchema();
+  std::vector<oid_t> key_attrs({0});
+  std::vector<index::Index *> indexes;
+  for (auto index_type : {INDEX_TYPE_BTREE, INDEX_TYPE_BWTREE,
+                          INDEX_TYPE_OLCBTREE, INDEX_TYPE_ART,
+                          INDEX_TYPE_HASH}) {
+    auto key_schema = catalog::Schema::CopySchema(tuple_schema, key_attrs);
+    key_schema->SetIndexedColumns(key_attrs);
+    auto index_metadata = new index::IndexMetadata(
+        "built_index", 130 + indexes.size(), index_type,
+        INDEX_CONSTRAINT_TYPE_DEFAULT, tuple_schema, key_schema, false);
+    indexes.push_back(index::IndexFactory::GetInstance(index_metadata));
+  }
+
+  index::IndexBuilder::Build(
+      data_table.get(), indexes,
+      [](const storage::TileGroupHeader *tile_group_header, oid_t tuple_id) {
+        return tile_group_header->GetBeginCommitId(tuple_id) != MAX_CID &&
+               tile_group_header->GetEndCommitId(tuple_id) == MAX_CID;
+      },
+      4);
+
+  txn_manager.CommitTransaction();
+
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  for (auto index : indexes) {
+    data_table->AddIndex(index);
+
+    std::vector<ItemPointer> locations;
+    index->ScanAllKeys(locations);
+    EXPECT_EQ(locations.size(), tuple_count * scale_factor);
+    EXPECT_EQ(index->GetNumberOfTuples(), tuple_count * scale_factor);
+    locations.clear();
+
+    storage::Tuple key(index->GetKeySchema(), true);
+    key.SetValue(
+        0, ValueFactory::GetIntegerValue(ExecutorTestsUtil::PopulatedValue(7, 0)),
+        pool);
+    index->ScanKey(&key, locations);
+    EXPECT_EQ(locations.size(), 1);
+    for (auto &location : locations) {
+      auto tile_group = data_table->GetTileGroupById(location.block);
+      EXPECT_EQ(
+          ValuePeeker::PeekInteger(tile_group->GetValue(location.offset, 0)),
+          ExecutorTestsUtil::PopulatedValue(7, 0));
+    }
+  }
+}
+
 }  // namespace test
 }  // namespace peloton
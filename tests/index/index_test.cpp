@@ -10,12 +10,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <set>
+
 #include "gtest/gtest.h"
 #include "harness.h"
 
 #include "backend/common/logger.h"
 #include "backend/common/platform.h"
+#include "backend/index/bwtree.h"
 #include "backend/index/index_factory.h"
+#include "backend/index/index_scan_cursor.h"
+#include "backend/index/normalized_key.h"
 #include "backend/storage/tuple.h"
 
 //#define ALLOW_UNIQUE_KEY
@@ -27,7 +32,8 @@ namespace test {
 // Index Tests
 //===--------------------------------------------------------------------===//
 
-class IndexTests : public PelotonTest {};
+class IndexTests : public PelotonTest,
+                   public ::testing::WithParamInterface<IndexType> {};
 
 catalog::Schema *key_schema = nullptr;
 catalog::Schema *tuple_schema = nullptr;
@@ -36,14 +42,11 @@ ItemPointer item0(120, 5);
 ItemPointer item1(120, 7);
 ItemPointer item2(123, 19);
 
-index::Index *BuildIndex(const bool unique_keys) {
+index::Index *BuildIndex(const bool unique_keys, const IndexType index_type) {
   // Build tuple and key schema
   std::vector<std::vector<std::string>> column_names;
   std::vector<catalog::Column> columns;
   std::vector<catalog::Schema *> schemas;
-  IndexType index_type = INDEX_TYPE_BTREE;
-  // FIXME: Try to use BWTREE
-  // index_type = INDEX_TYPE_BWTREE;
 
   catalog::Column column1(VALUE_TYPE_INTEGER, GetTypeSize(VALUE_TYPE_INTEGER),
                           "A", true);
@@ -78,12 +81,12 @@ index::Index *BuildIndex(const bool unique_keys) {
   return index;
 }
 
-TEST_F(IndexTests, BasicTest) {
+TEST_P(IndexTests, BasicTest) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(false));
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
 
   std::unique_ptr<storage::Tuple> key0(new storage::Tuple(key_schema, true));
 
@@ -249,12 +252,12 @@ void DeleteTest(index::Index *index, VarlenPool *pool, size_t scale_factor) {
   }
 }
 
-TEST_F(IndexTests, MultiMapInsertTest) {
+TEST_P(IndexTests, MultiMapInsertTest) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(false));
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
 
   // Single threaded test
   size_t scale_factor = 1;
@@ -286,12 +289,12 @@ TEST_F(IndexTests, MultiMapInsertTest) {
 }
 
 #ifdef ALLOW_UNIQUE_KEY
-TEST_F(IndexTests, UniqueKeyDeleteTest) {
+TEST_P(IndexTests, UniqueKeyDeleteTest) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(true));
+  std::unique_ptr<index::Index> index(BuildIndex(true, GetParam()));
 
   // Single threaded test
   size_t scale_factor = 1;
@@ -327,12 +330,12 @@ TEST_F(IndexTests, UniqueKeyDeleteTest) {
 }
 #endif
 
-TEST_F(IndexTests, NonUniqueKeyDeleteTest) {
+TEST_P(IndexTests, NonUniqueKeyDeleteTest) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(false));
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
 
   // Single threaded test
   size_t scale_factor = 1;
@@ -367,12 +370,12 @@ TEST_F(IndexTests, NonUniqueKeyDeleteTest) {
   delete tuple_schema;
 }
 
-TEST_F(IndexTests, MultiThreadedInsertTest) {
+TEST_P(IndexTests, MultiThreadedInsertTest) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(false));
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
 
   // Parallel Test
   size_t num_threads = 4;
@@ -406,12 +409,12 @@ TEST_F(IndexTests, MultiThreadedInsertTest) {
 }
 
 #ifdef ALLOW_UNIQUE_KEY
-TEST_F(IndexTests, UniqueKeyMultiThreadedTest) {
+TEST_P(IndexTests, UniqueKeyMultiThreadedTest) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(true));
+  std::unique_ptr<index::Index> index(BuildIndex(true, GetParam()));
 
   // Parallel Test
   size_t num_threads = 4;
@@ -496,12 +499,12 @@ TEST_F(IndexTests, UniqueKeyMultiThreadedTest) {
 // no key3
 // no key4
 
-TEST_F(IndexTests, NonUniqueKeyMultiThreadedTest) {
+TEST_P(IndexTests, NonUniqueKeyMultiThreadedTest) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(false));
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
 
   // Parallel Test
   size_t num_threads = 4;
@@ -669,12 +672,12 @@ TEST_F(IndexTests, NonUniqueKeyMultiThreadedTest) {
   delete tuple_schema;
 }
 
-TEST_F(IndexTests, NonUniqueKeyMultiThreadedStressTest) {
+TEST_P(IndexTests, NonUniqueKeyMultiThreadedStressTest) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(false));
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
 
   // Parallel Test
   size_t num_threads = 4;
@@ -714,12 +717,12 @@ TEST_F(IndexTests, NonUniqueKeyMultiThreadedStressTest) {
   delete tuple_schema;
 }
 
-TEST_F(IndexTests, NonUniqueKeyMultiThreadedStressTest2) {
+TEST_P(IndexTests, NonUniqueKeyMultiThreadedStressTest2) {
   auto pool = TestingHarness::GetInstance().GetTestingPool();
   std::vector<ItemPointer> locations;
 
   // INDEX
-  std::unique_ptr<index::Index> index(BuildIndex(false));
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
 
   // Parallel Test
   size_t num_threads = 15;
@@ -761,5 +764,839 @@ TEST_F(IndexTests, NonUniqueKeyMultiThreadedStressTest2) {
   delete tuple_schema;
 }
 
+// SPLIT / MERGE HELPER FUNCTION
+// Every thread inserts its own range of distinct keys, then deletes them
+void SplitMergeTest(index::Index *index, VarlenPool *pool, size_t scale_factor,
+                    std::atomic<size_t> *thread_counter) {
+  size_t thread_itr = thread_counter->fetch_add(1);
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+  key->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+
+  for (size_t key_itr = 0; key_itr < scale_factor; key_itr++) {
+    key->SetValue(
+        0, ValueFactory::GetIntegerValue(thread_itr * scale_factor + key_itr),
+        pool);
+    index->InsertEntry(key.get(), ItemPointer(thread_itr, key_itr));
+  }
+
+  for (size_t key_itr = 0; key_itr < scale_factor; key_itr++) {
+    key->SetValue(
+        0, ValueFactory::GetIntegerValue(thread_itr * scale_factor + key_itr),
+        pool);
+    index->DeleteEntry(key.get(), ItemPointer(thread_itr, key_itr));
+  }
+}
+
+TEST_P(IndexTests, SplitMergeStressTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer> locations;
+
+  // INDEX
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
+
+  // Interleave every kind of structure modification across threads
+  size_t num_threads = 4;
+  size_t scale_factor = 5000;
+  std::atomic<size_t> thread_counter(0);
+  LaunchParallelTest(num_threads, InsertTest, index.get(), pool, 100);
+  LaunchParallelTest(num_threads, SplitMergeTest, index.get(), pool,
+                     scale_factor, &thread_counter);
+
+  // Only the entries of InsertTest remain
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), 9 * num_threads * 100);
+  locations.clear();
+
+  std::vector<ItemPointer *> location_ptrs;
+  index->Scan({ValueFactory::GetIntegerValue(500)}, {0},
+              {EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO},
+              SCAN_DIRECTION_TYPE_FORWARD, location_ptrs);
+  // keys 100..500 of key0-key2, 400 of key3 and 500 of key4
+  EXPECT_EQ(location_ptrs.size(), (5 * 7 + 2) * num_threads);
+  location_ptrs.clear();
+
+  LaunchParallelTest(num_threads, DeleteTest, index.get(), pool, 100);
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), 3 * num_threads * 100);
+  locations.clear();
+
+  delete tuple_schema;
+}
+
+TEST_P(IndexTests, LocationCellTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer *> location_ptrs;
+  std::vector<ItemPointer> locations;
+
+  // INDEX
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
+
+  std::unique_ptr<storage::Tuple> key0(new storage::Tuple(key_schema, true));
+  key0->SetValue(0, ValueFactory::GetIntegerValue(100), pool);
+  key0->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+
+  index->InsertEntry(key0.get(), item0);
+
+  // The cell handed out by the index is what the version chain updates
+  index->ScanKey(key0.get(), location_ptrs);
+  EXPECT_EQ(location_ptrs.size(), 1);
+  AtomicUpdateItemPointer(location_ptrs[0], item2);
+  location_ptrs.clear();
+
+  // Entries moved around by later inserts keep the updated location
+  size_t scale_factor = 1000;
+  for (size_t scale_itr = 1; scale_itr <= scale_factor; scale_itr++) {
+    index->InsertEntry(key0.get(), ItemPointer(scale_itr, 0));
+  }
+
+  index->ScanKey(key0.get(), locations);
+  EXPECT_EQ(locations.size(), scale_factor + 1);
+  size_t updated_count = 0;
+  for (auto location : locations) {
+    if (location.block == item2.block && location.offset == item2.offset) {
+      updated_count++;
+    }
+  }
+  EXPECT_EQ(updated_count, 1);
+  locations.clear();
+
+  // Retired cells are no longer reachable
+  index->DeleteEntry(key0.get(), item2);
+  index->ScanKey(key0.get(), locations);
+  EXPECT_EQ(locations.size(), scale_factor);
+  locations.clear();
+
+  delete tuple_schema;
+}
+
+TEST_P(IndexTests, ScanCursorTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer *> location_ptrs;
+
+  // INDEX
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
+
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+
+  // Three locations per key
+  size_t scale_factor = 100;
+  size_t key_count = 3;
+  for (size_t scale_itr = 0; scale_itr < scale_factor; scale_itr++) {
+    key->SetValue(0, ValueFactory::GetIntegerValue(scale_itr), pool);
+    key->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+    for (size_t key_itr = 0; key_itr < key_count; key_itr++) {
+      index->InsertEntry(key.get(), ItemPointer(scale_itr, key_itr));
+    }
+  }
+
+  std::vector<Value> values = {ValueFactory::GetIntegerValue(10)};
+  std::vector<oid_t> key_column_ids = {0};
+  std::vector<ExpressionType> expr_types = {
+      EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO};
+
+  index->Scan(values, key_column_ids, expr_types, SCAN_DIRECTION_TYPE_FORWARD,
+              location_ptrs);
+  EXPECT_EQ(location_ptrs.size(), (scale_factor - 10) * key_count);
+  std::set<std::pair<oid_t, oid_t>> scanned;
+  for (auto location : location_ptrs) {
+    scanned.insert(
+        std::make_pair(oid_t(location->block), oid_t(location->offset)));
+  }
+  location_ptrs.clear();
+
+  // The batches add up to the same locations, each handed out once
+  auto cursor = index->OpenScan(values, key_column_ids, expr_types,
+                                SCAN_DIRECTION_TYPE_FORWARD);
+  size_t batch_size = 7;
+  std::set<std::pair<oid_t, oid_t>> batched;
+  size_t batched_count = 0;
+  while (cursor->Next(batch_size, location_ptrs)) {
+    // only the last batch may come up short
+    if (batched_count + location_ptrs.size() < scanned.size()) {
+      EXPECT_GE(location_ptrs.size(), batch_size);
+    }
+    for (auto location : location_ptrs) {
+      batched.insert(
+          std::make_pair(oid_t(location->block), oid_t(location->offset)));
+    }
+    batched_count += location_ptrs.size();
+    location_ptrs.clear();
+  }
+  EXPECT_EQ(batched_count, scanned.size());
+  EXPECT_TRUE(batched == scanned);
+
+  EXPECT_FALSE(cursor->Next(batch_size, location_ptrs));
+  EXPECT_EQ(location_ptrs.size(), 0);
+
+  delete tuple_schema;
+}
+
+TEST_P(IndexTests, ScanKeysTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer *> location_ptrs;
+
+  // INDEX
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
+
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+
+  // Two locations per key
+  size_t scale_factor = 1000;
+  for (size_t scale_itr = 0; scale_itr < scale_factor; scale_itr++) {
+    key->SetValue(0, ValueFactory::GetIntegerValue(scale_itr), pool);
+    key->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+    index->InsertEntry(key.get(), ItemPointer(scale_itr, 0));
+    index->InsertEntry(key.get(), ItemPointer(scale_itr, 1));
+  }
+
+  // Unsorted keys, some of them missing
+  std::vector<std::pair<int, std::string>> key_values = {
+      {997, "a"}, {3, "a"}, {500, "a"}, {2000, "a"}, {4, "a"}, {5, "b"}};
+  std::vector<std::unique_ptr<storage::Tuple>> keys;
+  std::vector<const storage::Tuple *> key_ptrs;
+  std::set<std::pair<oid_t, oid_t>> expected;
+  for (auto &key_value : key_values) {
+    keys.emplace_back(new storage::Tuple(key_schema, true));
+    keys.back()->SetValue(0, ValueFactory::GetIntegerValue(key_value.first),
+                          pool);
+    keys.back()->SetValue(1, ValueFactory::GetStringValue(key_value.second),
+                          pool);
+    key_ptrs.push_back(keys.back().get());
+
+    index->ScanKey(keys.back().get(), location_ptrs);
+    for (auto location : location_ptrs) {
+      expected.insert(
+          std::make_pair(oid_t(location->block), oid_t(location->offset)));
+    }
+    location_ptrs.clear();
+  }
+  EXPECT_EQ(expected.size(), 4 * 2);
+
+  index->ScanKeys(key_ptrs, location_ptrs);
+  EXPECT_EQ(location_ptrs.size(), expected.size());
+  std::set<std::pair<oid_t, oid_t>> scanned;
+  for (auto location : location_ptrs) {
+    scanned.insert(
+        std::make_pair(oid_t(location->block), oid_t(location->offset)));
+  }
+  EXPECT_TRUE(scanned == expected);
+
+  delete tuple_schema;
+}
+
+TEST_P(IndexTests, BulkLoadTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer> locations;
+
+  // INDEX
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
+
+  // Enough keys for several levels of nodes, handed over out of order
+  size_t key_count = 5000;
+  std::vector<std::unique_ptr<storage::Tuple>> keys;
+  std::vector<const storage::Tuple *> key_ptrs;
+  std::vector<ItemPointer> key_locations;
+  for (size_t key_itr = 0; key_itr < key_count; key_itr++) {
+    size_t key_value = (key_itr * 7919) % key_count;
+    keys.emplace_back(new storage::Tuple(key_schema, true));
+    keys.back()->SetValue(0, ValueFactory::GetIntegerValue(key_value), pool);
+    keys.back()->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+
+    // Three locations per key
+    for (oid_t offset = 0; offset < 3; offset++) {
+      key_ptrs.push_back(keys.back().get());
+      key_locations.push_back(ItemPointer(key_value, offset));
+    }
+  }
+
+  index->BulkLoad(key_ptrs, key_locations);
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), key_count * 3);
+  locations.clear();
+
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+  for (size_t key_value = 0; key_value < key_count; key_value += 499) {
+    key->SetValue(0, ValueFactory::GetIntegerValue(key_value), pool);
+    key->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+    index->ScanKey(key.get(), locations);
+    EXPECT_EQ(locations.size(), 3);
+    for (auto &location : locations) {
+      EXPECT_EQ(location.block, key_value);
+    }
+    locations.clear();
+  }
+
+  // The full nodes of the loaded index have to split on inserts
+  key->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+  for (size_t key_value = 0; key_value < key_count; key_value++) {
+    key->SetValue(0, ValueFactory::GetIntegerValue(key_value), pool);
+    index->InsertEntry(key.get(), ItemPointer(key_value, 3));
+    index->DeleteEntry(key.get(), ItemPointer(key_value, 0));
+  }
+
+  key->SetValue(0, ValueFactory::GetIntegerValue(1234), pool);
+  index->ScanKey(key.get(), locations);
+  EXPECT_EQ(locations.size(), 3);
+  locations.clear();
+
+  // Loading into an index that is not empty adds to it
+  index->BulkLoad(key_ptrs, key_locations);
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), key_count * 6);
+  locations.clear();
+
+  index->ScanKey(key.get(), locations);
+  EXPECT_EQ(locations.size(), 6);
+  locations.clear();
+
+  delete tuple_schema;
+}
+
+TEST_P(IndexTests, DeleteEntriesTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer> locations;
+
+  // INDEX
+  std::unique_ptr<index::Index> index(BuildIndex(false, GetParam()));
+
+  // Two versions per key, as left behind by updates
+  size_t key_count = 1000;
+  std::vector<std::unique_ptr<storage::Tuple>> keys;
+  for (size_t key_itr = 0; key_itr < key_count; key_itr++) {
+    keys.emplace_back(new storage::Tuple(key_schema, true));
+    keys.back()->SetValue(0, ValueFactory::GetIntegerValue(key_itr), pool);
+    keys.back()->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+    index->InsertEntry(keys.back().get(), ItemPointer(key_itr, 0));
+    index->InsertEntry(keys.back().get(), ItemPointer(key_itr, 1));
+  }
+
+  // Reclaim the old version of every key, in no particular order
+  std::vector<const storage::Tuple *> key_ptrs;
+  std::vector<ItemPointer> garbage;
+  for (size_t key_itr = 0; key_itr < key_count; key_itr++) {
+    size_t key_value = (key_itr * 7919) % key_count;
+    key_ptrs.push_back(keys[key_value].get());
+    garbage.push_back(ItemPointer(key_value, 0));
+  }
+  // a version that was never indexed
+  key_ptrs.push_back(keys[0].get());
+  garbage.push_back(ItemPointer(0, 2));
+
+  index->DeleteEntries(key_ptrs, garbage);
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), key_count);
+  for (auto &location : locations) {
+    EXPECT_EQ(location.offset, 1);
+  }
+  locations.clear();
+
+  index->ScanKey(keys[123].get(), locations);
+  EXPECT_EQ(locations.size(), 1);
+  locations.clear();
+
+  delete tuple_schema;
+}
+
+INSTANTIATE_TEST_CASE_P(IndexTypes, IndexTests,
+                        ::testing::Values(INDEX_TYPE_BTREE,
+                                          INDEX_TYPE_BWTREE,
+                                          INDEX_TYPE_HASH,
+                                          INDEX_TYPE_OLCBTREE));
+
+//===--------------------------------------------------------------------===//
+// BWTree Tests
+//===--------------------------------------------------------------------===//
+
+class BWTreeTests : public PelotonTest {};
+
+// Splits and merges that keep going must not run out of node ids
+TEST_F(BWTreeTests, NodeIDReuseTest) {
+  index::BWTree<int64_t, int64_t, std::less<int64_t>, std::equal_to<int64_t>>
+      tree{std::less<int64_t>(), std::equal_to<int64_t>()};
+  const int64_t key_count = 20000;
+  const size_t round_count = 20;
+  size_t first_round_ids = 0;
+
+  for (size_t round_itr = 0; round_itr < round_count; round_itr++) {
+    for (int64_t key = 0; key < key_count; key++) {
+      tree.Insert(key, key);
+    }
+
+    std::vector<int64_t> values;
+    tree.GetValue(key_count / 2, values);
+    EXPECT_EQ(values.size(), 1);
+
+    for (int64_t key = 0; key < key_count; key++) {
+      EXPECT_TRUE(tree.Delete(key, key));
+    }
+    tree.PerformGarbageCollection();
+
+    if (round_itr == 0) {
+      first_round_ids = tree.GetNodeIDHighWaterMark();
+    }
+  }
+
+  LOG_INFO("node ids : %lu after one round, %lu after %lu rounds",
+           first_round_ids, tree.GetNodeIDHighWaterMark(), round_count);
+  EXPECT_LT(tree.GetNodeIDHighWaterMark(), 2 * first_round_ids);
+
+  size_t visited = 0;
+  tree.ScanRange(nullptr, nullptr,
+                 [&visited](const int64_t &, const int64_t &) {
+                   visited++;
+                   return true;
+                 });
+  EXPECT_EQ(visited, 0);
+}
+
+//===--------------------------------------------------------------------===//
+// ART Index Tests
+//===--------------------------------------------------------------------===//
+
+class ARTIndexTests : public PelotonTest {};
+
+// The radix tree only takes integer keys
+index::Index *BuildIntsIndex(const IndexType index_type) {
+  std::vector<catalog::Column> columns;
+
+  catalog::Column column1(VALUE_TYPE_INTEGER, GetTypeSize(VALUE_TYPE_INTEGER),
+                          "A", true);
+  catalog::Column column2(VALUE_TYPE_BIGINT, GetTypeSize(VALUE_TYPE_BIGINT),
+                          "B", true);
+  catalog::Column column3(VALUE_TYPE_DOUBLE, GetTypeSize(VALUE_TYPE_DOUBLE),
+                          "C", true);
+
+  columns.push_back(column1);
+  columns.push_back(column2);
+
+  // INDEX KEY SCHEMA -- {column1, column2}
+  key_schema = new catalog::Schema(columns);
+  key_schema->SetIndexedColumns({0, 1});
+
+  columns.push_back(column3);
+
+  // TABLE SCHEMA -- {column1, column2, column3}
+  tuple_schema = new catalog::Schema(columns);
+
+  index::IndexMetadata *index_metadata = new index::IndexMetadata(
+      "test_index", 125, index_type, INDEX_CONSTRAINT_TYPE_DEFAULT,
+      tuple_schema, key_schema, false);
+
+  index::Index *index = index::IndexFactory::GetInstance(index_metadata);
+  EXPECT_TRUE(index != NULL);
+
+  return index;
+}
+
+TEST_F(ARTIndexTests, ARTIndexTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer> locations;
+
+  std::unique_ptr<index::Index> index(BuildIntsIndex(INDEX_TYPE_ART));
+  EXPECT_EQ(index->GetTypeName(), "ART");
+
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+
+  // Negative and positive values, sparse and dense key bytes, so that
+  // every node size and prefix split shows up
+  size_t scale_factor = 300;
+  for (int a_itr = -2; a_itr < 3; a_itr++) {
+    for (size_t b_itr = 0; b_itr < scale_factor; b_itr++) {
+      key->SetValue(0, ValueFactory::GetIntegerValue(a_itr * 1000), pool);
+      key->SetValue(1, ValueFactory::GetBigIntValue(b_itr * b_itr * 7), pool);
+      index->InsertEntry(key.get(), ItemPointer(a_itr + 2, b_itr));
+      index->InsertEntry(key.get(), ItemPointer(a_itr + 2, b_itr + 1));
+    }
+  }
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), 5 * scale_factor * 2);
+  locations.clear();
+
+  key->SetValue(0, ValueFactory::GetIntegerValue(-1000), pool);
+  key->SetValue(1, ValueFactory::GetBigIntValue(7 * 7 * 7), pool);
+  index->ScanKey(key.get(), locations);
+  EXPECT_EQ(locations.size(), 2);
+  EXPECT_EQ(locations[0].block, 1);
+  EXPECT_EQ(locations[0].offset, 7);
+  locations.clear();
+
+  // Equality on the leading column
+  index->Scan({ValueFactory::GetIntegerValue(0)}, {0},
+              {EXPRESSION_TYPE_COMPARE_EQUAL}, SCAN_DIRECTION_TYPE_FORWARD,
+              locations);
+  EXPECT_EQ(locations.size(), scale_factor * 2);
+  locations.clear();
+
+  // Range on both columns
+  index->Scan({ValueFactory::GetIntegerValue(-1000),
+               ValueFactory::GetIntegerValue(1000),
+               ValueFactory::GetBigIntValue(7 * 100)},
+              {0, 0, 1},
+              {EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO,
+               EXPRESSION_TYPE_COMPARE_LESSTHAN,
+               EXPRESSION_TYPE_COMPARE_LESSTHAN},
+              SCAN_DIRECTION_TYPE_FORWARD, locations);
+  // b_itr 0..9 for the values -1000 and 0
+  EXPECT_EQ(locations.size(), 2 * 10 * 2);
+  locations.clear();
+
+  // Same range through a cursor, two keys per batch
+  auto cursor = index->OpenScan({ValueFactory::GetIntegerValue(-1000),
+                                 ValueFactory::GetIntegerValue(1000),
+                                 ValueFactory::GetBigIntValue(7 * 100)},
+                                {0, 0, 1},
+                                {EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO,
+                                 EXPRESSION_TYPE_COMPARE_LESSTHAN,
+                                 EXPRESSION_TYPE_COMPARE_LESSTHAN},
+                                SCAN_DIRECTION_TYPE_FORWARD);
+  std::vector<ItemPointer *> location_ptrs;
+  size_t batch_count = 0;
+  while (cursor->Next(3, location_ptrs)) batch_count++;
+  EXPECT_EQ(location_ptrs.size(), 2 * 10 * 2);
+  EXPECT_EQ(batch_count, 10);
+  location_ptrs.clear();
+
+  // Batched lookups, sharing the path of their leading bytes
+  std::vector<std::unique_ptr<storage::Tuple>> keys;
+  std::vector<const storage::Tuple *> key_ptrs;
+  for (size_t b_itr = 0; b_itr < scale_factor; b_itr += 3) {
+    keys.emplace_back(new storage::Tuple(key_schema, true));
+    keys.back()->SetValue(0, ValueFactory::GetIntegerValue(1000), pool);
+    keys.back()->SetValue(1, ValueFactory::GetBigIntValue(b_itr * b_itr * 7),
+                          pool);
+    key_ptrs.push_back(keys.back().get());
+  }
+  // a missing key
+  key->SetValue(0, ValueFactory::GetIntegerValue(1000), pool);
+  key->SetValue(1, ValueFactory::GetBigIntValue(8), pool);
+  key_ptrs.push_back(key.get());
+
+  index->ScanKeys(key_ptrs, location_ptrs);
+  EXPECT_EQ(location_ptrs.size(), keys.size() * 2);
+
+  // Delete one location of every key, then the rest
+  for (int a_itr = -2; a_itr < 3; a_itr++) {
+    for (size_t b_itr = 0; b_itr < scale_factor; b_itr++) {
+      key->SetValue(0, ValueFactory::GetIntegerValue(a_itr * 1000), pool);
+      key->SetValue(1, ValueFactory::GetBigIntValue(b_itr * b_itr * 7), pool);
+      index->DeleteEntry(key.get(), ItemPointer(a_itr + 2, b_itr));
+    }
+  }
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), 5 * scale_factor);
+  locations.clear();
+
+  for (int a_itr = -2; a_itr < 3; a_itr++) {
+    for (size_t b_itr = 0; b_itr < scale_factor; b_itr++) {
+      key->SetValue(0, ValueFactory::GetIntegerValue(a_itr * 1000), pool);
+      key->SetValue(1, ValueFactory::GetBigIntValue(b_itr * b_itr * 7), pool);
+      index->DeleteEntry(key.get(), ItemPointer(a_itr + 2, b_itr + 1));
+    }
+  }
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), 0);
+  locations.clear();
+
+  delete tuple_schema;
+}
+
+TEST_F(ARTIndexTests, ARTBulkLoadTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer> locations;
+
+  std::unique_ptr<index::Index> index(BuildIntsIndex(INDEX_TYPE_ART));
+
+  // Sparse and dense key bytes, so that every node size is built
+  size_t scale_factor = 300;
+  std::vector<std::unique_ptr<storage::Tuple>> keys;
+  std::vector<const storage::Tuple *> key_ptrs;
+  std::vector<ItemPointer> key_locations;
+  for (size_t b_itr = scale_factor; b_itr-- > 0;) {
+    for (int a_itr = -2; a_itr < 3; a_itr++) {
+      keys.emplace_back(new storage::Tuple(key_schema, true));
+      keys.back()->SetValue(0, ValueFactory::GetIntegerValue(a_itr * 1000),
+                            pool);
+      keys.back()->SetValue(1, ValueFactory::GetBigIntValue(b_itr * b_itr * 7),
+                            pool);
+      key_ptrs.push_back(keys.back().get());
+      key_locations.push_back(ItemPointer(a_itr + 2, b_itr));
+      key_ptrs.push_back(keys.back().get());
+      key_locations.push_back(ItemPointer(a_itr + 2, b_itr + 1));
+    }
+  }
+
+  index->BulkLoad(key_ptrs, key_locations);
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), 5 * scale_factor * 2);
+  locations.clear();
+
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+  key->SetValue(0, ValueFactory::GetIntegerValue(-1000), pool);
+  key->SetValue(1, ValueFactory::GetBigIntValue(7 * 7 * 7), pool);
+  index->ScanKey(key.get(), locations);
+  EXPECT_EQ(locations.size(), 2);
+  EXPECT_EQ(locations[0].block, 1);
+  EXPECT_EQ(locations[0].offset, 7);
+  locations.clear();
+
+  // Range on both columns, in key order
+  index->Scan({ValueFactory::GetIntegerValue(-1000),
+               ValueFactory::GetIntegerValue(1000),
+               ValueFactory::GetBigIntValue(7 * 100)},
+              {0, 0, 1},
+              {EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO,
+               EXPRESSION_TYPE_COMPARE_LESSTHAN,
+               EXPRESSION_TYPE_COMPARE_LESSTHAN},
+              SCAN_DIRECTION_TYPE_FORWARD, locations);
+  EXPECT_EQ(locations.size(), 2 * 10 * 2);
+  EXPECT_EQ(locations.front().block, 1);
+  EXPECT_EQ(locations.back().block, 2);
+  locations.clear();
+
+  // The loaded tree takes inserts that split its compressed paths
+  key->SetValue(0, ValueFactory::GetIntegerValue(-1000), pool);
+  key->SetValue(1, ValueFactory::GetBigIntValue(8), pool);
+  index->InsertEntry(key.get(), ItemPointer(1, 8));
+  index->ScanKey(key.get(), locations);
+  EXPECT_EQ(locations.size(), 1);
+  locations.clear();
+
+  delete tuple_schema;
+}
+
+// ART HELPER FUNCTION
+// Every thread inserts and deletes its own keys, all sharing key bytes
+void ARTInsertDeleteTest(index::Index *index, VarlenPool *pool,
+                         size_t scale_factor,
+                         std::atomic<size_t> *thread_counter) {
+  size_t thread_itr = thread_counter->fetch_add(1);
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+  key->SetValue(0, ValueFactory::GetIntegerValue(1), pool);
+
+  for (size_t key_itr = 0; key_itr < scale_factor; key_itr++) {
+    key->SetValue(1, ValueFactory::GetBigIntValue(key_itr * 4 + thread_itr),
+                  pool);
+    index->InsertEntry(key.get(), ItemPointer(thread_itr, key_itr));
+  }
+
+  // Keep every other key
+  for (size_t key_itr = 0; key_itr < scale_factor; key_itr += 2) {
+    key->SetValue(1, ValueFactory::GetBigIntValue(key_itr * 4 + thread_itr),
+                  pool);
+    index->DeleteEntry(key.get(), ItemPointer(thread_itr, key_itr));
+  }
+}
+
+TEST_F(ARTIndexTests, ARTIndexMultiThreadedTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer> locations;
+
+  std::unique_ptr<index::Index> index(BuildIntsIndex(INDEX_TYPE_ART));
+
+  size_t num_threads = 4;
+  size_t scale_factor = 10000;
+  std::atomic<size_t> thread_counter(0);
+  LaunchParallelTest(num_threads, ARTInsertDeleteTest, index.get(), pool,
+                     scale_factor, &thread_counter);
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), num_threads * scale_factor / 2);
+  locations.clear();
+
+  index->Scan({ValueFactory::GetBigIntValue(4 * 100)}, {1},
+              {EXPRESSION_TYPE_COMPARE_LESSTHAN}, SCAN_DIRECTION_TYPE_FORWARD,
+              locations);
+  EXPECT_EQ(locations.size(), num_threads * 100 / 2);
+  locations.clear();
+
+  delete tuple_schema;
+}
+
+//===--------------------------------------------------------------------===//
+// Normalized Key Tests
+//===--------------------------------------------------------------------===//
+
+class NormalizedKeyTests : public PelotonTest,
+                           public ::testing::WithParamInterface<IndexType> {};
+
+// Short strings get normalized along with the integers
+index::Index *BuildShortStringIndex(const IndexType index_type) {
+  std::vector<catalog::Column> columns;
+
+  catalog::Column column1(VALUE_TYPE_VARCHAR, 16, "A", true);
+  catalog::Column column2(VALUE_TYPE_INTEGER, GetTypeSize(VALUE_TYPE_INTEGER),
+                          "B", true);
+  catalog::Column column3(VALUE_TYPE_DOUBLE, GetTypeSize(VALUE_TYPE_DOUBLE),
+                          "C", true);
+
+  columns.push_back(column1);
+  columns.push_back(column2);
+
+  // INDEX KEY SCHEMA -- {column1, column2}
+  key_schema = new catalog::Schema(columns);
+  key_schema->SetIndexedColumns({0, 1});
+
+  columns.push_back(column3);
+
+  // TABLE SCHEMA -- {column1, column2, column3}
+  tuple_schema = new catalog::Schema(columns);
+
+  index::IndexMetadata *index_metadata = new index::IndexMetadata(
+      "test_index", 125, index_type, INDEX_CONSTRAINT_TYPE_DEFAULT,
+      tuple_schema, key_schema, false);
+
+  index::Index *index = index::IndexFactory::GetInstance(index_metadata);
+  EXPECT_TRUE(index != NULL);
+
+  return index;
+}
+
+TEST_F(NormalizedKeyTests, OrderTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+
+  std::vector<catalog::Column> columns;
+  columns.push_back(catalog::Column(VALUE_TYPE_VARCHAR, 8, "A", true));
+  columns.push_back(catalog::Column(
+      VALUE_TYPE_DOUBLE, GetTypeSize(VALUE_TYPE_DOUBLE), "B", true));
+  columns.push_back(catalog::Column(
+      VALUE_TYPE_BIGINT, GetTypeSize(VALUE_TYPE_BIGINT), "C", true));
+  std::unique_ptr<catalog::Schema> schema(new catalog::Schema(columns));
+
+  auto length = index::KeyNormalizer::GetNormalizedLength(schema.get());
+  EXPECT_EQ(length, 2 + 8 + 8 + 8);
+
+  std::vector<Value> strings = {
+      ValueFactory::GetNullValueByType(VALUE_TYPE_VARCHAR),
+      ValueFactory::GetStringValue(""), ValueFactory::GetStringValue("b"),
+      ValueFactory::GetStringValue("ab"), ValueFactory::GetStringValue("ba"),
+      ValueFactory::GetStringValue("zzzzzzzz")};
+  std::vector<Value> doubles = {
+      ValueFactory::GetNullValueByType(VALUE_TYPE_DOUBLE),
+      ValueFactory::GetDoubleValue(-1e300), ValueFactory::GetDoubleValue(-0.5),
+      ValueFactory::GetDoubleValue(0), ValueFactory::GetDoubleValue(0.25),
+      ValueFactory::GetDoubleValue(1e300)};
+  std::vector<Value> bigints = {
+      ValueFactory::GetNullValueByType(VALUE_TYPE_BIGINT),
+      ValueFactory::GetBigIntValue(-100), ValueFactory::GetBigIntValue(0),
+      ValueFactory::GetBigIntValue(1), ValueFactory::GetBigIntValue(1 << 20)};
+
+  std::vector<std::unique_ptr<storage::Tuple>> keys;
+  for (auto &string : strings) {
+    for (auto &number : doubles) {
+      for (auto &bigint : bigints) {
+        keys.emplace_back(new storage::Tuple(schema.get(), true));
+        keys.back()->SetValue(0, string, pool);
+        keys.back()->SetValue(1, number, pool);
+        keys.back()->SetValue(2, bigint, pool);
+      }
+    }
+  }
+
+  std::vector<std::vector<char>> normalized_keys;
+  for (auto &key : keys) {
+    normalized_keys.emplace_back(length);
+    index::KeyNormalizer::Normalize(key.get(), normalized_keys.back().data());
+
+    // Every column decodes back to its value
+    for (oid_t column_itr = 0; column_itr < 3; column_itr++) {
+      Value value = index::KeyNormalizer::GetValue(
+          schema.get(), normalized_keys.back().data(), column_itr);
+      EXPECT_EQ(value.IsNull(), key->GetValue(column_itr).IsNull());
+      EXPECT_EQ(value.Compare(key->GetValue(column_itr)), 0);
+    }
+  }
+
+  // Byte order agrees with the order of the values
+  for (size_t lhs_itr = 0; lhs_itr < keys.size(); lhs_itr++) {
+    for (size_t rhs_itr = 0; rhs_itr < keys.size(); rhs_itr++) {
+      int expected = 0;
+      for (oid_t column_itr = 0; column_itr < 3 && expected == 0;
+           column_itr++) {
+        expected = keys[lhs_itr]->GetValue(column_itr).Compare(
+            keys[rhs_itr]->GetValue(column_itr));
+      }
+      int diff = memcmp(normalized_keys[lhs_itr].data(),
+                        normalized_keys[rhs_itr].data(), length);
+      EXPECT_EQ(diff < 0, expected < 0);
+      EXPECT_EQ(diff == 0, expected == 0);
+    }
+  }
+}
+
+TEST_P(NormalizedKeyTests, ShortStringKeyTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer> locations;
+
+  std::unique_ptr<index::Index> index(BuildShortStringIndex(GetParam()));
+
+  std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+
+  // Strings are ordered by length first
+  std::vector<std::string> strings = {"a", "b", "c", "aa", "bb", "cc",
+                                      "aaaaaaaaaaaaaaaa"};
+  for (size_t string_itr = 0; string_itr < strings.size(); string_itr++) {
+    for (int int_itr = -5; int_itr < 5; int_itr++) {
+      key->SetValue(0, ValueFactory::GetStringValue(strings[string_itr]),
+                    pool);
+      key->SetValue(1, ValueFactory::GetIntegerValue(int_itr), pool);
+      index->InsertEntry(key.get(), ItemPointer(string_itr, int_itr + 5));
+    }
+  }
+
+  index->ScanAllKeys(locations);
+  EXPECT_EQ(locations.size(), strings.size() * 10);
+  locations.clear();
+
+  key->SetValue(0, ValueFactory::GetStringValue("bb"), pool);
+  key->SetValue(1, ValueFactory::GetIntegerValue(-3), pool);
+  index->ScanKey(key.get(), locations);
+  EXPECT_EQ(locations.size(), 1);
+  EXPECT_EQ(locations[0].block, 4);
+  EXPECT_EQ(locations[0].offset, 2);
+  locations.clear();
+
+  // Equality on the leading column
+  index->Scan({ValueFactory::GetStringValue("c")}, {0},
+              {EXPRESSION_TYPE_COMPARE_EQUAL}, SCAN_DIRECTION_TYPE_FORWARD,
+              locations);
+  EXPECT_EQ(locations.size(), 10);
+  locations.clear();
+
+  // Range on both columns
+  index->Scan({ValueFactory::GetStringValue("b"),
+               ValueFactory::GetStringValue("bb"),
+               ValueFactory::GetIntegerValue(0)},
+              {0, 0, 1},
+              {EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO,
+               EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO,
+               EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO},
+              SCAN_DIRECTION_TYPE_FORWARD, locations);
+  // "b", "c", "aa" and "bb" with 0..4
+  EXPECT_EQ(locations.size(), 4 * 5);
+  locations.clear();
+
+  // A bound as long as the column
+  index->Scan({ValueFactory::GetStringValue("aaaaaaaaaaaaaaab")}, {0},
+              {EXPRESSION_TYPE_COMPARE_LESSTHAN}, SCAN_DIRECTION_TYPE_FORWARD,
+              locations);
+  EXPECT_EQ(locations.size(), strings.size() * 10);
+  locations.clear();
+
+  delete tuple_schema;
+}
+
+INSTANTIATE_TEST_CASE_P(IndexTypes, NormalizedKeyTests,
+                        ::testing::Values(INDEX_TYPE_BTREE,
+                                          INDEX_TYPE_BWTREE,
+                                          INDEX_TYPE_HASH,
+                                          INDEX_TYPE_OLCBTREE));
+
 }  // End test namespace
 }  // End peloton namespace
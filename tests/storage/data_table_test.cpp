@@ -10,8 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <set>
+
 #include "harness.h"
 
+#include "backend/catalog/manager.h"
 #include "backend/storage/data_table.h"
 #include "backend/storage/tile_group.h"
 #include "backend/concurrency/transaction_manager_factory.h"
@@ -66,7 +69,50 @@ TEST_F(DataTableTests, TransformTileGroupTest) {
   column_map[3] = std::make_pair(1, 2);
 
   // Transform the tile group
-  data_table->TransformTileGroup(0, theta);
+  auto tile_group = data_table->TransformTileGroup(0, theta);
+
+  // The directory hands out the transformed tile group
+  EXPECT_EQ(tile_group, data_table->GetTileGroupPointer(0));
+  EXPECT_EQ(tile_group, data_table->GetTileGroup(0).get());
+}
+
+void AddTileGroups(storage::DataTable *table) {
+  for (oid_t tile_group_itr = 0; tile_group_itr < 50; tile_group_itr++) {
+    std::shared_ptr<storage::TileGroup> tile_group(
+        table->GetTileGroupWithLayout(table->GetDefaultPartition()));
+    table->AddTileGroup(tile_group);
+  }
+}
+
+TEST_F(DataTableTests, TileGroupDirectoryTest) {
+  std::unique_ptr<storage::DataTable> data_table(
+      ExecutorTestsUtil::CreateTable(TESTS_TUPLES_PER_TILEGROUP, false));
+
+  // Spans the first few segments of the directory
+  LaunchParallelTest(8, AddTileGroups, data_table.get());
+
+  auto tile_group_count = data_table->GetTileGroupCount();
+  EXPECT_EQ(401, tile_group_count);
+
+  std::set<oid_t> tile_group_ids;
+  for (oid_t tile_group_itr = 0; tile_group_itr < tile_group_count;
+       tile_group_itr++) {
+    auto tile_group = data_table->GetTileGroupPointer(tile_group_itr);
+    EXPECT_TRUE(tile_group != nullptr);
+    EXPECT_EQ(tile_group, data_table->GetTileGroup(tile_group_itr).get());
+    tile_group_ids.insert(tile_group->GetTileGroupId());
+  }
+  EXPECT_EQ(tile_group_count, tile_group_ids.size());
+
+  // A compacted tile group keeps its offset
+  auto tile_group_id = data_table->GetTileGroup(100)->GetTileGroupId();
+  data_table->UnlinkTileGroup(tile_group_id);
+  catalog::Manager::GetInstance().DropTileGroup(tile_group_id);
+
+  EXPECT_EQ(tile_group_count, data_table->GetTileGroupCount());
+  EXPECT_TRUE(data_table->GetTileGroupPointer(100) == nullptr);
+  EXPECT_TRUE(data_table->GetTileGroup(100) == nullptr);
+  EXPECT_TRUE(data_table->GetTileGroupPointer(101) != nullptr);
 }
 
 }  // End test namespace
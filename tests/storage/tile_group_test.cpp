@@ -227,6 +227,52 @@ TEST_F(TileGroupTests, StressTest) {
   delete schema;
 }
 
+TEST_F(TileGroupTests, FreeTupleSlotTest) {
+  storage::TileGroupHeader header(BACKEND_TYPE_MM, 200);
+
+  EXPECT_EQ(INVALID_OID, header.TakeFreeTupleSlot());
+
+  // only the first free slot of the tile group is announced
+  EXPECT_TRUE(header.FreeTupleSlot(130));
+  EXPECT_FALSE(header.FreeTupleSlot(3));
+  EXPECT_FALSE(header.FreeTupleSlot(64));
+  EXPECT_EQ(3, header.GetFreeTupleSlotCount());
+
+  // slots are taken in order
+  EXPECT_EQ(3, header.TakeFreeTupleSlot());
+  EXPECT_EQ(64, header.TakeFreeTupleSlot());
+  EXPECT_EQ(130, header.TakeFreeTupleSlot());
+  EXPECT_EQ(INVALID_OID, header.TakeFreeTupleSlot());
+  EXPECT_EQ(0, header.GetFreeTupleSlotCount());
+
+  EXPECT_TRUE(header.FreeTupleSlot(199));
+
+  // every slot freed concurrently is taken exactly once
+  std::vector<std::atomic<int>> taken(200);
+  for (auto &count : taken) {
+    count = 0;
+  }
+  std::atomic<oid_t> thread_count(0);
+  LaunchParallelTest(4, [&header, &taken, &thread_count] {
+    oid_t thread_itr = thread_count++;
+    for (oid_t tuple_slot_id = thread_itr; tuple_slot_id < 199;
+         tuple_slot_id += 4) {
+      header.FreeTupleSlot(tuple_slot_id);
+      auto taken_slot = header.TakeFreeTupleSlot();
+      EXPECT_NE(INVALID_OID, taken_slot);
+      taken[taken_slot]++;
+    }
+  });
+
+  oid_t free_slot;
+  while ((free_slot = header.TakeFreeTupleSlot()) != INVALID_OID) {
+    taken[free_slot]++;
+  }
+  for (auto &count : taken) {
+    EXPECT_EQ(1, count.load());
+  }
+}
+
 // TEST_F(TileGroupTests, MVCCInsert) {
 //  std::vector<catalog::Column> columns;
 //  std::vector<std::string> tile_column_names;
@@ -517,6 +517,21 @@ public:
         return (st == ok);
     }
 
+    //! erase_fn searches for \p key and runs \p fn on its value while the
+    //! key is locked. If \p fn returns true, \p key and its value are removed
+    //! from the table. If \p key is not there, it returns false, otherwise it
+    //! returns true.
+    template <typename Eraser>
+    bool erase_fn(const key_type& key, Eraser fn) {
+        size_t hv = hashed_key(key);
+        auto b = snapshot_and_lock_two(hv);
+        const partial_t partial = partial_key(hv);
+        const bool found = (try_erase_bucket_fn(partial, key, fn, b.first) ||
+                            try_erase_bucket_fn(partial, key, fn, b.second));
+        unlock_two(b.first, b.second);
+        return found;
+    }
+
     //! update changes the value associated with \p key to \p val. If \p key is
     //! not there, it returns false, otherwise it returns true.
     template <typename V>
@@ -1367,6 +1382,31 @@ private:
         return false;
     }
 
+    // try_erase_bucket_fn will search the bucket for the given key, run the
+    // given function on its value, and set the slot of the key to empty if the
+    // function returns true.
+    template <typename Eraser>
+    bool try_erase_bucket_fn(const partial_t partial, const key_type &key,
+                             Eraser fn, const size_t i) {
+        for (size_t j = 0; j < slot_per_bucket; ++j) {
+            if (!buckets_[i].occupied(j)) {
+                continue;
+            }
+            if (!is_simple && buckets_[i].partial(j) != partial) {
+                continue;
+            }
+            if (eqfn()(buckets_[i].key(j), key)) {
+                if (fn(buckets_[i].val(j))) {
+                    buckets_[i].eraseKV(j);
+                    num_deletes_[get_counterid()].num.fetch_add(
+                        1, std::memory_order_relaxed);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
     // try_update_bucket will search the bucket for the given key and change its
     // associated value if it finds it.
     template <typename V>